@@ -0,0 +1,862 @@
+/******************************************************************************
+ * Потактовая модель прошивки dst40.v в Verilator.
+ *
+ * Программа обращается к регистрам dst40.v через мост Avalon-MM так же,
+ * как программа dst40 на HPS (см. адресную карту в dst40.v), сверяет
+ * найденные ключи с эталонным хэшем dst40hash() и меряет задержки
+ * в тактах PLL: от записи run до строба "найден ключ", заполнение
+ * конвеера, проверку на второй паре и пересинхронизацию в домен
+ * тактов Avalon-MM. Один прогон занимает секунды, а сборка прошивки
+ * в Quartus - четверть часа, поэтому любое изменение в source/ стоит
+ * сначала прогнать здесь.
+ *
+ * Тесты:
+ *
+ *  - id/caps: идентификатор и параметры образа;
+ *  - golden: ключи из README (0000260000 и 7991F53219);
+ *  - random: случайные ключи и запросы (--keys N);
+ *  - table: две метки с одним запросом в таблице ответов;
+ *  - hits: счётчики кандидатов всех ядер (регистры 24..24+NK-1)
+ *    после поиска ключей в младшей половине ядер;
+ *  - ring: запись найденного ключа в кольцевой буфер в памяти HPS
+ *    (записи порта FPGA-to-SDRAM снимаются с проб sim_top);
+ *  - queue: три задания с конечным ключом в очереди дескрипторов,
+ *    выполняемые подряд без участия программы;
+ *  - mask: перебор только свободных бит ключа (известные биты
+ *    в key_mask/key_value) и конец уменьшенного пространства;
+ *  - done: перебор конца диапазона без ключа, флаг "все ключи
+ *    перебраны", счётчики тактов и производительности.
+ *
+ * В конце выводится цена постоянных задержек (заполнение конвеера,
+ * проверка кандидата, пересинхронизация) для заданий разного размера.
+ *
+ * Сборка и запуск - make test в этой папке (см. Makefile).
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Vsim_top.h"
+#include "verilated.h"
+
+extern "C"
+{
+#include "dst40hash.h"
+#include "backend.h"                                            // Номера регистров и флаги - общие с программой dst40
+}
+
+
+#define SIM_MAX_FOUND     16                                    // Найденных ключей за один поиск
+
+#define SIM_RING_BASE     0x1000                                // Адрес кольцевого буфера в "памяти HPS"
+#define SIM_L2RING        3                                     // Логарифм количества записей буфера
+#define SIM_RING_WORDS    ( 4 << SIM_L2RING )                   // 64-битных слов в буфере
+
+
+typedef struct
+{
+  uint64_t key;                                                 // Полный ключ
+  uint32_t index;                                               // Строка таблицы ответов
+  uint64_t cycle;                                               // Такт PLL, на котором ключ прочитан из FIFO
+} SIM_FOUND;
+
+typedef struct
+{
+  uint64_t run;                                                 // Такты PLL: от записи run до run_o
+  uint64_t found;                                               // От run_o до первого строба key_found
+  uint64_t visible;                                             // От строба до флага в регистре 4 (такты PLL)
+  uint64_t done;                                                // От run_o до key_not_found
+} SIM_LATENCY;
+
+static struct
+{
+  VerilatedContext *context;
+  Vsim_top         *top;
+
+  uint64_t  half50_ps;                                          // Полупериоды тактов, пс
+  uint64_t  halfpll_ps;
+  uint64_t  next50_ps;                                          // Время следующего фронта
+  uint64_t  nextpll_ps;
+
+  uint64_t  pll_cycles;                                         // Такты PLL с начала моделирования
+  uint64_t  cycles50;                                           // Такты FPGA_CLK1_50
+
+  uint64_t  run_write;                                          // Такт PLL записи run = 1
+  uint64_t  run_cycle;                                          // Такт PLL, на котором run_o стал 1 (0 - ещё нет)
+  uint64_t  found_cycle;                                        // Первый строб key_found после запуска (0 - не было)
+  uint64_t  done_cycle;                                         // Первый такт key_not_found после запуска (0 - не было)
+  uint64_t  stop_cycles;                                        // Регистры cycles и position перед остановкой поиска
+  uint64_t  stop_position;                                      // (после остановки они сбрасываются к старту)
+
+  uint32_t  nk, l2nk, nr, depth, unroll, clock_mhz, version;    // Параметры образа
+  uint32_t  ring;                                               // Ключей в кольце свёрнутого ядра
+  bool      interleave;                                         // Номер ядра - младшие биты ключа (CAPS_INTERLEAVE)
+  uint64_t  mask, value;                                        // Известные биты в единицах key_reg (регистры 46, 47)
+
+  uint64_t  ddr[SIM_RING_WORDS];                                // Кольцевой буфер в "памяти HPS"
+  uint32_t  beat;                                               // Номер слова в пачке порта FPGA-to-SDRAM
+
+  uint32_t  passed, failed;
+} _sim;
+
+
+
+/******************************************************************************
+ * Один шаг моделирования: до ближайшего фронта любого из тактов.
+ *****************************************************************************/
+
+static void step( void )
+{
+  uint64_t t = _sim.next50_ps < _sim.nextpll_ps ? _sim.next50_ps : _sim.nextpll_ps;
+  bool     rise50 = false, risepll = false;
+
+  if( _sim.next50_ps == t )
+  {
+    _sim.top->clk50_i = !_sim.top->clk50_i;
+    _sim.next50_ps += _sim.half50_ps;
+    rise50 = _sim.top->clk50_i;
+  }
+
+  if( _sim.nextpll_ps == t )
+  {
+    _sim.top->clk_pll_i = !_sim.top->clk_pll_i;
+    _sim.nextpll_ps += _sim.halfpll_ps;
+    risepll = _sim.top->clk_pll_i;
+  }
+
+  if( rise50 && _sim.top->sdram_write_o )                       // Порт FPGA-to-SDRAM всегда готов: слово
+  {                                                             // принимается на этом фронте
+    uint64_t word = _sim.top->sdram_address_o + _sim.beat - SIM_RING_BASE / 8;
+
+    if( word < SIM_RING_WORDS )
+      _sim.ddr[word] = _sim.top->sdram_writedata_o;
+
+    _sim.beat = ( _sim.beat + 1 ) % 4;                          // Пачки по 4 слова, адрес - начала пачки
+  }
+
+  _sim.context->time( t );
+  _sim.top->eval();
+
+  if( rise50 )
+    _sim.cycles50++;
+
+  if( risepll )                                                 // Пробы смотрим после фронта PLL
+  {
+    _sim.pll_cycles++;
+
+    if( _sim.run_write && !_sim.run_cycle && _sim.top->run_o )
+      _sim.run_cycle = _sim.pll_cycles;
+
+    if( _sim.run_cycle && !_sim.found_cycle && _sim.top->key_found_o )
+      _sim.found_cycle = _sim.pll_cycles;
+
+    if( _sim.run_cycle && !_sim.done_cycle && _sim.top->key_not_found_o )
+      _sim.done_cycle = _sim.pll_cycles;
+  }
+}
+
+
+/******************************************************************************
+ * Один такт FPGA_CLK1_50 (до следующего переднего фронта включительно).
+ *****************************************************************************/
+
+static void clock50( void )
+{
+  uint64_t cycles = _sim.cycles50;
+
+  while( _sim.cycles50 == cycles )
+    step();
+}
+
+
+/******************************************************************************
+ * Запись/чтение 64-битного регистра через мост Avalon-MM: один такт
+ * FPGA_CLK1_50 на обращение, как у моста HPS-FPGA без задержек.
+ *****************************************************************************/
+
+static void avlWrite( uint32_t address, uint64_t value )
+{
+  _sim.top->address_i    = address;
+  _sim.top->writedata_i  = value;
+  _sim.top->byteenable_i = 0xFF;
+  _sim.top->write_i      = 1;
+  clock50();
+  _sim.top->write_i      = 0;
+  _sim.top->eval();
+}
+
+static uint64_t avlRead( uint32_t address )
+{
+  uint64_t value;
+
+  _sim.top->address_i = address;
+  _sim.top->read_i    = 1;
+  _sim.top->eval();
+  value = _sim.top->readdata_o;
+  clock50();
+  _sim.top->read_i    = 0;
+  _sim.top->eval();
+
+  return value;
+}
+
+
+/******************************************************************************
+ * Учёт результатов проверок.
+ *****************************************************************************/
+
+static bool check( bool ok, const char *name )
+{
+  printf( "  %-60s %s\n", name, ok ? "ok" : "FAILED" );
+
+  if( ok )
+    _sim.passed++;
+  else
+    _sim.failed++;
+
+  return ok;
+}
+
+
+/******************************************************************************
+ * Раскладка ключей по ядрам: значение счётчика перебора key_reg для ключа
+ * и полный ключ по key_reg и номеру ядра. При заданной маске key_reg -
+ * номер в уменьшенном пространстве: его биты по порядку стоят на местах
+ * свободных бит.
+ *****************************************************************************/
+
+static uint64_t simIndex( uint64_t key )
+{
+  uint64_t raw = _sim.interleave ? key >> _sim.l2nk : key & ( ( 1ULL << ( 40 - _sim.l2nk ) ) - 1 );
+  uint64_t low = 0;
+  uint32_t j, k;
+
+  for( j=0, k=0; j < 40 - _sim.l2nk; j++ )
+    if( !( ( _sim.mask >> j ) & 1 ) )
+      low |= ( ( raw >> j ) & 1 ) << k++;
+
+  return low;
+}
+
+static uint64_t simKey( uint64_t low, uint32_t kernel )
+{
+  uint64_t raw = _sim.value;
+  uint32_t j, k;
+
+  for( j=0, k=0; j < 40 - _sim.l2nk; j++ )
+    if( !( ( _sim.mask >> j ) & 1 ) )
+      raw |= ( ( low >> k++ ) & 1 ) << j;
+
+  return _sim.interleave ? ( raw << _sim.l2nk ) | kernel : ( (uint64_t) kernel << ( 40 - _sim.l2nk ) ) | raw;
+}
+
+
+/******************************************************************************
+ * Поиск: загрузка запросов и таблицы ответов, запуск с key_reg = start
+ * и чтение найденных ключей из FIFO до max ключей, флага "все ключи
+ * перебраны" или истечения timeout тактов PLL. Возвращает количество
+ * найденных ключей (все сверены с dst40hash), задержки - в latency,
+ * счётчики cycles и position перед остановкой - в _sim.stop_*.
+ *****************************************************************************/
+
+static uint32_t search( uint64_t c1, uint64_t c2, const uint32_t *r1, const uint32_t *r2, uint32_t rows,
+                        uint64_t start, SIM_FOUND *found, uint32_t max, uint64_t timeout, SIM_LATENCY *latency, bool *done )
+{
+  uint64_t flags, deadline, low, kernels;
+  uint64_t found_visible = 0;
+  uint32_t n = 0, i;
+  bool     wrong = false;
+
+  avlWrite( DST40_REG_CHALLENGE,  c1 );
+  avlWrite( DST40_REG_CHALLENGE2, c2 );
+
+  for( i=0; i < rows; i++ )
+    avlWrite( DST40_REG_TABLE + i, ( (uint64_t) r2[i] << 24 ) | r1[i] );
+
+  avlWrite( DST40_REG_COUNT, rows );
+  avlWrite( DST40_REG_START_KEY, start );
+
+  while( avlRead( DST40_REG_FLAGS ) & DST40_FLAG_FOUND )        // FIFO от прошлых запусков
+    avlWrite( DST40_REG_FIFO, 1 );
+
+  _sim.run_cycle   = 0;
+  _sim.found_cycle = 0;
+  _sim.done_cycle  = 0;
+  _sim.run_write   = _sim.pll_cycles;
+  avlWrite( DST40_REG_RUN, 1 );
+
+  deadline = _sim.pll_cycles + timeout;
+  *done    = false;
+
+  while( n < max && _sim.pll_cycles < deadline )
+  {
+    flags = avlRead( DST40_REG_FLAGS );
+
+    if( flags & DST40_FLAG_FOUND )
+    {
+      if( !found_visible )
+        found_visible = _sim.pll_cycles;
+
+      low     = avlRead( DST40_REG_KEY );
+      kernels = avlRead( DST40_REG_KERNELS );
+
+      found[n].index = (uint32_t) avlRead( DST40_REG_INDEX );
+      found[n].key   = simKey( low, __builtin_ctzll( kernels ) );
+      found[n].cycle = _sim.pll_cycles;
+      avlWrite( DST40_REG_FIFO, 1 );
+
+      if( found[n].index >= rows || dst40hash( c1, found[n].key ) != r1[found[n].index] ||
+          dst40hash( c2, found[n].key ) != r2[found[n].index] )
+      {
+        printf( "  key %010llX (row %u) does not match the golden hash\n", found[n].key, found[n].index );
+        wrong = true;
+      }
+
+      n++;
+      continue;
+    }
+
+    if( flags & DST40_FLAG_DONE )
+    {
+      *done = true;
+      break;
+    }
+  }
+
+  for( i=0; i < 8; i++ )                                        // Счётчики в коде Грея доходят до домена Avalon-MM
+    clock50();
+
+  _sim.stop_cycles   = avlRead( DST40_REG_CYCLES );             // В режиме ожидания они сбрасываются
+  _sim.stop_position = avlRead( DST40_REG_POSITION );           // к стартовому ключу, поэтому читаем до остановки
+
+  avlWrite( DST40_REG_RUN, 0 );
+
+  for( i=0; i < 8; i++ )                                        // Защёлкнутые счётчики доходят до домена Avalon-MM
+    clock50();
+
+  if( latency )
+  {
+    latency->run     = _sim.run_cycle ? _sim.run_cycle - _sim.run_write : 0;
+    latency->found   = _sim.found_cycle ? _sim.found_cycle - _sim.run_cycle : 0;
+    latency->visible = found_visible && _sim.found_cycle ? found_visible - _sim.found_cycle : 0;
+    latency->done    = _sim.done_cycle ? _sim.done_cycle - _sim.run_cycle : 0;
+  }
+
+  if( wrong )
+    _sim.failed++;
+
+  return n;
+}
+
+
+/******************************************************************************
+ * Тактов PLL на перебор keys ключей одним ядром.
+ *****************************************************************************/
+
+static uint64_t scanCycles( uint64_t keys )
+{
+  return keys * _sim.depth / _sim.ring;
+}
+
+
+/******************************************************************************
+ * Тест: идентификатор и параметры образа.
+ *****************************************************************************/
+
+static bool testId( void )
+{
+  uint64_t id   = avlRead( DST40_REG_ID );
+  uint64_t caps = avlRead( DST40_REG_CAPS );
+
+  printf( "\nid/caps\n" );
+
+  if( !check( ( id >> 24 ) == DST40_MAGIC, "id register holds \"DST40\"" ) )
+    return false;
+
+  _sim.nk        = caps & 0xFF;
+  _sim.l2nk      = ( caps >> 8 ) & 0xFF;
+  _sim.nr        = ( caps >> 16 ) & 0xFF;
+  _sim.depth     = ( caps >> 24 ) & 0xFF;
+  _sim.clock_mhz = ( caps >> 32 ) & 0xFFFF;
+  _sim.unroll    = ( id >> 16 ) & 0xFF;
+  _sim.version   = id & 0xFFFF;
+  _sim.ring      = _sim.depth * _sim.unroll / 64;
+  _sim.interleave = ( caps >> 48 ) & 0x80;
+
+  printf( "  image v%u: %u kernels%s, unroll %u, depth %u, %u tags, %u MHz\n",
+          _sim.version, _sim.nk, _sim.interleave ? " (interleaved)" : "", _sim.unroll, _sim.depth, _sim.nr, _sim.clock_mhz );
+
+  return check( _sim.nk == ( 1U << _sim.l2nk ) && _sim.depth && _sim.ring && _sim.nr >= 2, "caps register is consistent" );
+}
+
+
+/******************************************************************************
+ * Тест: поиск одного ключа, начиная за offset ключей до него.
+ *****************************************************************************/
+
+static void testKey( const char *name, uint64_t key, uint64_t c1, uint64_t c2, uint64_t offset )
+{
+  uint32_t    r1 = (uint32_t) dst40hash( c1, key );
+  uint32_t    r2 = (uint32_t) dst40hash( c2, key );
+  SIM_FOUND   found[SIM_MAX_FOUND];
+  SIM_LATENCY latency;
+  uint32_t    n, i;
+  bool        done, hit = false;
+  char        text[96];
+
+  if( offset > simIndex( key ) )
+    offset = simIndex( key );
+
+  printf( "\n%s: key %010llX, challenges %010llX/%010llX -> %06X/%06X, start %llu keys before\n",
+          name, key, c1, c2, r1, r2, offset );
+
+  n = search( c1, c2, &r1, &r2, 1, simIndex( key ) - offset, found, SIM_MAX_FOUND,
+              scanCycles( offset ) + 16 * _sim.depth + 1000, &latency, &done );
+
+  for( i=0; i < n; i++ )
+    hit |= ( found[i].key == key );
+
+  sprintf( text, "key found (%u in FIFO)", n );
+  check( hit, text );
+
+  if( hit )
+  {
+    printf( "  run write -> run in PLL domain: %llu cycles\n", latency.run );
+    printf( "  run -> key_found strobe:        %llu cycles (scan %llu + pipeline %u + verify ~%u)\n",
+            latency.found, scanCycles( offset ), _sim.depth, _sim.depth );
+    printf( "  key_found -> FIFO flag on bus:  %llu PLL cycles\n", latency.visible );
+  }
+}
+
+
+/******************************************************************************
+ * Тест: две метки с одним запросом в таблице ответов.
+ *****************************************************************************/
+
+static void testTable( uint64_t key, uint64_t distance, uint64_t c1, uint64_t c2 )
+{
+  uint64_t    key2 = key + distance;
+  uint32_t    r1[2], r2[2];
+  SIM_FOUND   found[SIM_MAX_FOUND];
+  uint32_t    n, i, seen = 0;
+  bool        done;
+
+  r1[0] = (uint32_t) dst40hash( c1, key  );  r2[0] = (uint32_t) dst40hash( c2, key  );
+  r1[1] = (uint32_t) dst40hash( c1, key2 );  r2[1] = (uint32_t) dst40hash( c2, key2 );
+
+  printf( "\ntable: keys %010llX (row 0) and %010llX (row 1)\n", key, key2 );
+
+  n = search( c1, c2, r1, r2, 2, simIndex( key ) - 100, found, SIM_MAX_FOUND,
+              scanCycles( distance + 100 ) + 32 * _sim.depth + 1000, NULL, &done );
+
+  for( i=0; i < n; i++ )
+  {
+    if( found[i].key == key && found[i].index == 0 )
+      seen |= 1;
+
+    if( found[i].key == key2 && found[i].index == 1 )
+      seen |= 2;
+  }
+
+  check( seen == 3, "both tags found with their row numbers" );
+}
+
+
+/******************************************************************************
+ * Тест: по ключу в каждом ядре младшей половины (своя строка таблицы
+ * ответов у каждого) - счётчики кандидатов этих ядер равны 1, остальных
+ * - 0. Несимметричная картина ловит сдвиг номера ядра при выборе
+ * счётчика по адресу (база 24 не кратна NK > 8).
+ *****************************************************************************/
+
+static void testHits( uint64_t low, uint64_t c1, uint64_t c2 )
+{
+  uint32_t    rows = ( _sim.nk + 1 ) / 2;
+  uint32_t    r1[SIM_MAX_FOUND], r2[SIM_MAX_FOUND];
+  SIM_FOUND   found[SIM_MAX_FOUND];
+  uint64_t    hits;
+  uint32_t    k, bad = 0;
+  bool        done;
+  char        text[96];
+
+  if( rows > _sim.nr )
+    rows = _sim.nr;
+
+  if( rows > SIM_MAX_FOUND )
+    rows = SIM_MAX_FOUND;
+
+  printf( "\nhits: one key in each of kernels 0..%u (rows 0..%u)\n", rows - 1, rows - 1 );
+
+  for( k=0; k < rows; k++ )
+  {
+    r1[k] = (uint32_t) dst40hash( c1, simKey( low + 7 * k, k ) );
+    r2[k] = (uint32_t) dst40hash( c2, simKey( low + 7 * k, k ) );
+  }
+
+  search( c1, c2, r1, r2, rows, low - 100, found, rows,
+          scanCycles( 100 + 7 * rows ) + 32 * _sim.depth * rows + 1000, NULL, &done );
+
+  for( k=0; k < _sim.nk; k++ )
+  {
+    hits = avlRead( DST40_REG_HITS + k );
+
+    if( hits != ( k < rows ) )
+    {
+      printf( "  kernel %u: %llu candidates\n", k, hits );
+      bad++;
+    }
+  }
+
+  sprintf( text, "hits registers of all %u kernels", _sim.nk );
+  check( !bad, text );
+}
+
+
+/******************************************************************************
+ * Тест: найденный ключ приходит записью кольцевого буфера, а не через
+ * регистры FIFO.
+ *****************************************************************************/
+
+static void testRing( uint64_t key, uint64_t c1, uint64_t c2, uint64_t offset )
+{
+  uint32_t r1 = (uint32_t) dst40hash( c1, key );
+  uint32_t r2 = (uint32_t) dst40hash( c2, key );
+  uint64_t deadline, full, *record;
+  uint32_t head, i;
+
+  if( offset > simIndex( key ) )
+    offset = simIndex( key );
+
+  printf( "\nring: key %010llX, %u records at %08X\n", key, 1U << SIM_L2RING, SIM_RING_BASE );
+
+  memset( _sim.ddr, 0, sizeof( _sim.ddr ) );
+
+  avlWrite( DST40_REG_CHALLENGE,  c1 );
+  avlWrite( DST40_REG_CHALLENGE2, c2 );
+  avlWrite( DST40_REG_TABLE,      ( (uint64_t) r2 << 24 ) | r1 );
+  avlWrite( DST40_REG_COUNT,      1 );
+  avlWrite( DST40_REG_START_KEY,      simIndex( key ) - offset );
+
+  while( avlRead( DST40_REG_FLAGS ) & DST40_FLAG_FOUND )        // FIFO от прошлых запусков
+    avlWrite( DST40_REG_FIFO, 1 );
+
+  head = (uint32_t) avlRead( DST40_REG_RING_HEAD );             // Голова не сбрасывается - хвост ставим на неё
+
+  avlWrite( DST40_REG_RING_TAIL, head );
+  avlWrite( DST40_REG_RING_BASE, SIM_RING_BASE );
+  avlWrite( DST40_REG_RING_CTL,      ( SIM_L2RING << 8 ) | 1 );
+  avlWrite( DST40_REG_RUN,       1 );
+
+  deadline = _sim.pll_cycles + scanCycles( offset ) + 16 * _sim.depth + 1000;
+
+  while( (uint32_t) avlRead( DST40_REG_RING_HEAD ) == head && _sim.pll_cycles < deadline )
+    ;
+
+  avlWrite( DST40_REG_RUN, 0 );
+
+  for( i=0; i < 8; i++ )
+    clock50();
+
+  record = &_sim.ddr[4 * ( head % ( 1U << SIM_L2RING ) )];
+  full   = simKey( record[0], __builtin_ctzll( record[1] | ( 1ULL << 32 ) ) );
+
+  check( (uint32_t) avlRead( DST40_REG_RING_HEAD ) == head + 1, "one record written, ring_head advanced" );
+  check( record[3] == head, "record number matches ring_head" );
+  check( full == key && ( record[1] >> 32 ) == 0, "record holds the key, its kernel and row 0" );
+  check( record[2] > 0 && record[2] < scanCycles( offset ) + 16 * _sim.depth + 1000, "record holds the cycle stamp" );
+  check( !( avlRead( DST40_REG_FLAGS ) & DST40_FLAG_FOUND ), "FIFO drained by the ring writer" );
+
+  printf( "  record: %016llX %016llX %016llX %016llX\n", record[0], record[1], record[2], record[3] );
+
+  avlWrite( DST40_REG_RING_TAIL, head + 1 );
+  avlWrite( DST40_REG_RING_CTL,      0 );
+}
+
+
+/******************************************************************************
+ * Тест: три задания в очереди дескрипторов - ключ в начале диапазона,
+ * диапазон без ключа и ключ в конце диапазона (конечный ключ сразу
+ * за ним). Задания выполняются подряд, ключи приходят в FIFO
+ * с номерами своих заданий.
+ *****************************************************************************/
+
+static void testQueue( uint64_t key, uint64_t key2, uint64_t c1, uint64_t c2, uint64_t offset )
+{
+  uint64_t start[3], end[3], resp[3], deadline, low, full;
+  uint32_t i, seen = 0;
+
+  if( offset > simIndex( key ) )
+    offset = simIndex( key );
+
+  if( offset > simIndex( key2 ) )
+    offset = simIndex( key2 );
+
+  printf( "\nqueue: keys %010llX (job 0) and %010llX (job 2), %llu keys per job\n", key, key2, 2 * offset );
+
+  start[0] = simIndex( key ) - 1;                               // Ключ сразу после начала
+  end[0]   = start[0] + 2 * offset;
+  resp[0]  = ( dst40hash( c2, key ) << 24 ) | dst40hash( c1, key );
+
+  start[1] = end[0];                                            // Ответов, которых почти наверняка нет
+  end[1]   = start[1] + 2 * offset;
+  resp[1]  = 0xFFFFFFFFFFFFULL;
+
+  start[2] = simIndex( key2 ) - 2 * offset + 1;                 // Ключ - последний в диапазоне
+  end[2]   = simIndex( key2 ) + 1;
+  resp[2]  = ( dst40hash( c2, key2 ) << 24 ) | dst40hash( c1, key2 );
+
+  while( avlRead( DST40_REG_FLAGS ) & DST40_FLAG_FOUND )        // FIFO от прошлых запусков
+    avlWrite( DST40_REG_FIFO, 1 );
+
+  avlWrite( DST40_REG_QUEUE, 1 );                               // Включаем очередь и кладём дескрипторы
+
+  for( i=0; i < 3; i++ )
+  {
+    avlWrite( DST40_REG_DESC,     c1 );
+    avlWrite( DST40_REG_DESC + 1, c2 );
+    avlWrite( DST40_REG_DESC + 2, resp[i] );
+    avlWrite( DST40_REG_DESC + 3, start[i] );
+    avlWrite( DST40_REG_DESC + 4, end[i] );
+    avlWrite( DST40_REG_QUEUE,    0x101 );
+  }
+
+  deadline = _sim.pll_cycles + 3 * ( scanCycles( 2 * offset ) + 16 * _sim.depth ) + 3000;
+
+  while( avlRead( DST40_REG_QUEUE_DONE ) < 3 && _sim.pll_cycles < deadline )
+  {
+    if( avlRead( DST40_REG_FLAGS ) & DST40_FLAG_FOUND )
+    {
+      low  = avlRead( DST40_REG_KEY );
+      full = simKey( low, __builtin_ctzll( avlRead( DST40_REG_KERNELS ) ) );
+
+      if( full == key && avlRead( DST40_REG_JOB ) == 0 )
+        seen |= 1;
+      else if( full == key2 && avlRead( DST40_REG_JOB ) == 2 )
+        seen |= 2;
+      else
+        seen |= 4;
+
+      avlWrite( DST40_REG_FIFO, 1 );
+    }
+  }
+
+  for( i=0; i < 8; i++ )
+    clock50();
+
+  check( avlRead( DST40_REG_QUEUE_DONE ) == 3, "three jobs completed" );
+  check( !( avlRead( DST40_REG_QUEUE ) & 0xFF0100 ), "queue is empty and idle" );
+  check( seen == 3, "both keys found with their job numbers, nothing else" );
+  check( avlRead( DST40_REG_POSITION ) == start[2], "idle position reloaded from the last job's start key" );
+
+  avlWrite( DST40_REG_QUEUE, 0 );
+}
+
+
+/******************************************************************************
+ * Тест: известны старшие биты key_reg и биты 11..8 - ключ находится
+ * по номеру в уменьшенном пространстве, а перебор его конца взводит
+ * флаг "все ключи перебраны" без конечного ключа.
+ *****************************************************************************/
+
+static void testMask( uint64_t key, uint64_t c1, uint64_t c2, uint64_t offset )
+{
+  uint64_t    width = 40 - _sim.l2nk;
+  uint64_t    range = 1ULL << 20;                               // Свободных бит: 24 - 4
+  uint32_t    r1 = 0xFFFFFF, r2 = 0xFFFFFF;
+  SIM_FOUND   found[SIM_MAX_FOUND];
+  bool        done;
+
+  _sim.mask  = ( ( ( 1ULL << width ) - 1 ) & ~0xFFFFFFULL ) | 0xF00;
+  _sim.value = ( _sim.interleave ? key >> _sim.l2nk : key ) & _sim.mask;
+
+  avlWrite( DST40_REG_KEY_MASK,  _sim.mask  );
+  avlWrite( DST40_REG_KEY_VALUE, _sim.value );
+
+  testKey( "mask", key, c1, c2, offset );
+
+  printf( "\nmask: last %llu of 2^20 keys of each kernel range\n", offset );
+
+  search( c1, c2, &r1, &r2, 1, range - offset, found, SIM_MAX_FOUND,
+          scanCycles( offset ) + 16 * _sim.depth + 1000, NULL, &done );
+
+  check( done, "done flag set at the end of the reduced range" );
+  check( _sim.stop_position >= range && _sim.stop_position < range + 2 * _sim.ring, "position stopped at 2^(free bits)" );
+
+  _sim.mask = _sim.value = 0;
+
+  avlWrite( DST40_REG_KEY_MASK,  0 );
+  avlWrite( DST40_REG_KEY_VALUE, 0 );
+}
+
+
+/******************************************************************************
+ * Тест: перебор последних keys ключей диапазона ядра без ответа.
+ * Возвращает постоянные издержки одного запуска в тактах PLL
+ * (сверх scanCycles( keys )).
+ *****************************************************************************/
+
+static uint64_t testDone( uint64_t keys, uint64_t c1, uint64_t c2 )
+{
+  uint64_t    range = 1ULL << ( 40 - _sim.l2nk );
+  uint32_t    r1 = 0xFFFFFF, r2 = 0xFFFFFF;                     // Ответы, которых почти наверняка нет
+  SIM_FOUND   found[SIM_MAX_FOUND];
+  SIM_LATENCY latency;
+  uint64_t    cycles, refill, busy, position, overhead;
+  uint32_t    restarts;
+  bool        done;
+  char        text[96];
+
+  printf( "\ndone: last %llu keys of each kernel range\n", keys );
+
+  restarts = (uint32_t) avlRead( DST40_REG_RESTARTS );
+
+  search( c1, c2, &r1, &r2, 1, range - keys, found, SIM_MAX_FOUND,
+          scanCycles( keys ) + 16 * _sim.depth + 1000, &latency, &done );
+
+  cycles   = _sim.stop_cycles;
+  refill   = avlRead( DST40_REG_REFILL );
+  busy     = avlRead( DST40_REG_BUSY );
+  position = _sim.stop_position;
+
+  check( done, "done flag set" );
+
+  sprintf( text, "refill counter = depth (%llu)", refill );
+  check( refill == _sim.depth, text );
+
+  sprintf( text, "position passed the end of range (%llX)", position );
+  check( position >= range, text );
+
+  sprintf( text, "restarts counter advanced (%u)", (uint32_t) avlRead( DST40_REG_RESTARTS ) );
+  check( (uint32_t) avlRead( DST40_REG_RESTARTS ) == restarts + 1, text );
+
+  overhead = cycles > scanCycles( keys ) ? cycles - scanCycles( keys ) : 0;
+
+  printf( "  cycles register: %llu (scan %llu + overhead %llu), busy %llu, done after %llu cycles of run\n",
+          cycles, scanCycles( keys ), overhead, busy, latency.done );
+
+  return overhead;
+}
+
+
+/******************************************************************************
+ * Цена постоянных издержек запуска для заданий разного размера.
+ *****************************************************************************/
+
+static void latencyTable( uint64_t overhead, uint64_t verify )
+{
+  static const uint32_t bits[] = { 12, 16, 20, 24, 28, 32 };
+  uint64_t keys, scan;
+  uint32_t i;
+
+  printf( "\nfixed cost per run: %llu cycles (refill + flush), per candidate: ~%llu cycles (verify)\n", overhead, verify );
+  printf( "  %12s %16s %10s\n", "keys/kernel", "scan cycles", "overhead" );
+
+  for( i=0; i < sizeof( bits ) / sizeof( bits[0] ); i++ )
+  {
+    keys = 1ULL << bits[i];
+    scan = scanCycles( keys );
+    printf( "  %12llu %16llu %9.3f%%\n", keys, scan, 100.0 * overhead / ( scan + overhead ) );
+  }
+}
+
+
+/******************************************************************************
+ * Случайное 40-битное число.
+ *****************************************************************************/
+
+static uint64_t random40( void )
+{
+  return ( ( (uint64_t) rand() << 30 ) ^ ( (uint64_t) rand() << 15 ) ^ rand() ) & 0xFFFFFFFFFFULL;
+}
+
+
+/******************************************************************************
+ * Точка входа.
+ *****************************************************************************/
+
+int main( int argc, char **argv )
+{
+  uint64_t offset = 1000, overhead;
+  uint32_t keys = 4, seed = 1, pll_mhz = 0, i;
+  char     name[32];
+
+  for( i=1; i < (uint32_t) argc; i++ )
+  {
+    if( !strcmp( argv[i], "--keys" ) && i + 1 < (uint32_t) argc )
+      keys = strtoul( argv[++i], NULL, 0 );
+    else if( !strcmp( argv[i], "--offset" ) && i + 1 < (uint32_t) argc )
+      offset = strtoull( argv[++i], NULL, 0 );
+    else if( !strcmp( argv[i], "--seed" ) && i + 1 < (uint32_t) argc )
+      seed = strtoul( argv[++i], NULL, 0 );
+    else if( !strcmp( argv[i], "--pll" ) && i + 1 < (uint32_t) argc )
+      pll_mhz = strtoul( argv[++i], NULL, 0 );
+    else if( argv[i][0] != '+' )                                // +verilator+... - аргументы Verilator
+    {
+      printf( "Usage: %s [--keys N] [--offset N] [--seed N] [--pll MHZ]\n", argv[0] );
+      return 2;
+    }
+  }
+
+  srand( seed );
+
+  _sim.context = new VerilatedContext;
+  _sim.context->commandArgs( argc, argv );
+  _sim.top = new Vsim_top( _sim.context );
+
+  _sim.half50_ps  = 10000;                                      // 50 МГц
+  _sim.halfpll_ps = 10000;                                      // До чтения caps - как 50 МГц
+  _sim.next50_ps  = _sim.half50_ps;
+  _sim.nextpll_ps = _sim.halfpll_ps;
+  _sim.top->eval();
+
+  for( i=0; i < 4; i++ )
+    clock50();
+
+  if( testId() )
+  {
+    if( !pll_mhz )
+      pll_mhz = _sim.clock_mhz;
+
+    _sim.halfpll_ps = 500000 / pll_mhz;
+    printf( "  PLL clock modelled at %u MHz\n", pll_mhz );
+
+    testKey( "golden", 0x0000260000ULL, 1, 2, offset );
+    testKey( "golden", 0x7991F53219ULL, 1, 2, offset );
+
+    check( dst40hash( 1, 0x0000260000ULL ) == 0x5CA1BA && dst40hash( 2, 0x0000260000ULL ) == 0x07F2C0,
+           "dst40hash() matches README vectors" );
+
+    for( i=0; i < keys; i++ )
+    {
+      sprintf( name, "random %u", i + 1 );
+      testKey( name, random40(), random40(), random40(), offset );
+    }
+
+    testTable( ( random40() & ~0xFFFFULL ) | 0x8000, 300, random40(), random40() );
+
+    testHits( ( random40() >> _sim.l2nk & ~0xFFFFULL ) | 0x8000, random40(), random40() );
+
+    if( avlRead( DST40_REG_CAPS ) & ( (uint64_t) DST40_CAPS_RING << 48 ) )  // Образ с кольцевым буфером
+      testRing( 0x0000260000ULL, 1, 2, offset );
+
+    if( avlRead( DST40_REG_CAPS ) & ( (uint64_t) DST40_CAPS_QUEUE << 48 ) )  // Образ с очередью дескрипторов
+      testQueue( 0x0000260000ULL, 0x7991F53219ULL, 1, 2, offset );
+
+    if( _sim.version >= 11 )                                    // Образ с маской известных бит ключа
+      testMask( 0x7991F53219ULL, 1, 2, offset );
+
+    overhead = testDone( offset, random40(), random40() );
+
+    latencyTable( overhead, _sim.depth );
+  }
+
+  printf( "\n%u passed, %u failed\n", _sim.passed, _sim.failed );
+
+  _sim.top->final();
+  delete _sim.top;
+  delete _sim.context;
+
+  return _sim.failed ? 1 : 0;
+}
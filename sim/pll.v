@@ -0,0 +1,19 @@
+/******************************************************************************
+
+  Заглушка PLL для моделирования: такты ядер приходят с входа
+  clk_pll_i верхнего модуля sim_top.
+
+******************************************************************************/
+
+/* verilator lint_off UNUSED */
+
+module pll
+(
+  input                 refclk,
+  input                 rst,
+  output                outclk_0
+);
+
+assign outclk_0 = sim_top.clk_pll_i;
+
+endmodule
@@ -0,0 +1,88 @@
+/******************************************************************************
+
+  Верхний модуль для моделирования dst40.v в Verilator (см. dst40sim.cpp).
+
+  Вместо HPS и PLL подставляются заглушки soc_system.v и pll.v из этой
+  папки: они берут такты PLL и сигналы моста Avalon-MM с входов этого
+  модуля, так что программа модели сама задаёт оба домена тактов
+  и обращается к регистрам dst40.v так же, как программа на HPS.
+
+  Выходы *_o, кроме readdata_o и irq_o, - пробы внутренних сигналов
+  для замеров задержек, в прошивке их нет.
+
+******************************************************************************/
+
+/* verilator lint_off PINMISSING */
+/* verilator lint_off UNUSED */
+
+module sim_top
+#(
+  parameter           NK     = 4,                               // Параметры dst40.v
+  parameter           UNROLL = 64,
+  parameter           RPS    = 3,
+  parameter           INTERLEAVE = 0
+)
+(
+  input               clk50_i,                                  // Такты FPGA_CLK1_50
+  input               clk_pll_i,                                // Такты PLL (ядра)
+
+  input         [6:0] address_i,                                // Мост Avalon-MM
+  input               write_i,
+  input               read_i,
+  input        [63:0] writedata_i,
+  input         [7:0] byteenable_i,
+  output       [63:0] readdata_o,
+  output              irq_o,
+
+  output              run_o,                                    // Пробы: run, синхронизированный с тактами PLL,
+  output              key_found_o,                              // строб "найден ключ" (такты PLL)
+  output              key_not_found_o,                          // и флаг "все ключи перебраны" (такты PLL)
+
+  output              sdram_write_o,                            // Запись в память HPS через порт FPGA-to-SDRAM
+  output       [28:0] sdram_address_o,                          // (такты FPGA_CLK1_50)
+  output       [63:0] sdram_writedata_o
+);
+
+
+
+//==============================================================//
+// Модуль прошивки
+//==============================================================//
+
+/* verilator lint_off UNDRIVEN */
+
+wire   [35:0] gpio0_w;                                          // Ножки платы: dst40.v держит их в Z
+wire   [35:0] gpio1_w;
+wire   [14:0] arduino_w;
+
+/* verilator lint_on UNDRIVEN */
+
+dst40
+#(
+  .NK               ( NK     ),
+  .UNROLL           ( UNROLL ),
+  .RPS              ( RPS    ),
+  .INTERLEAVE       ( INTERLEAVE )
+)
+DST40_INST
+(
+  .FPGA_CLK1_50     ( clk50_i   ),
+  .KEY              ( 2'b 11    ),
+  .SW               ( 4'b 0000  ),
+  .GPIO_0           ( gpio0_w   ),
+  .GPIO_1           ( gpio1_w   ),
+  .ARDUINO_IO       ( arduino_w )
+);
+
+assign readdata_o      = DST40_INST.mmb_readdata_w;
+assign irq_o           = DST40_INST.irq_reg;
+assign run_o           = DST40_INST.DST40_XX_INST.run_reg[1];
+assign key_found_o     = DST40_INST.key_found_w;
+assign key_not_found_o = DST40_INST.key_not_found_w;
+
+assign sdram_write_o     = DST40_INST.sdram_write_w;
+assign sdram_address_o   = DST40_INST.sdram_address_w;
+assign sdram_writedata_o = DST40_INST.sdram_writedata_w;
+
+
+endmodule
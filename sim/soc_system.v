@@ -0,0 +1,117 @@
+/******************************************************************************
+
+  Заглушка системы HPS (soc_system.qsys) для моделирования.
+
+  Ножки HPS никуда не подключены. Мост Avalon-MM управляется входами
+  верхнего модуля sim_top: программа модели выставляет адрес, данные
+  и стробы, а ответ dst40.v читает прямо с провода mmb_readdata_w.
+  Порт FPGA-to-SDRAM всегда готов (waitrequest = 0), записи в него
+  программа модели снимает с проб sim_top.
+
+******************************************************************************/
+
+/* verilator lint_off UNUSED */
+/* verilator lint_off UNDRIVEN */
+
+module soc_system
+(
+  input                 clk_clk,                                // Такты мостов
+  input                 reset_reset_n,                          // Сброс
+
+  // Ножки HPS (направления как в soc_system.qsys, не используются)
+  output         [14:0] memory_mem_a,
+  output          [2:0] memory_mem_ba,
+  output                memory_mem_ck,
+  output                memory_mem_ck_n,
+  output                memory_mem_cke,
+  output                memory_mem_cs_n,
+  output                memory_mem_ras_n,
+  output                memory_mem_cas_n,
+  output                memory_mem_we_n,
+  output                memory_mem_reset_n,
+  inout          [31:0] memory_mem_dq,
+  inout           [3:0] memory_mem_dqs,
+  inout           [3:0] memory_mem_dqs_n,
+  output                memory_mem_odt,
+  output          [3:0] memory_mem_dm,
+  input                 memory_oct_rzqin,
+  output                hps_0_hps_io_hps_io_emac1_inst_TX_CLK,
+  output                hps_0_hps_io_hps_io_emac1_inst_TXD0,
+  output                hps_0_hps_io_hps_io_emac1_inst_TXD1,
+  output                hps_0_hps_io_hps_io_emac1_inst_TXD2,
+  output                hps_0_hps_io_hps_io_emac1_inst_TXD3,
+  input                 hps_0_hps_io_hps_io_emac1_inst_RXD0,
+  inout                 hps_0_hps_io_hps_io_emac1_inst_MDIO,
+  output                hps_0_hps_io_hps_io_emac1_inst_MDC,
+  input                 hps_0_hps_io_hps_io_emac1_inst_RX_CTL,
+  output                hps_0_hps_io_hps_io_emac1_inst_TX_CTL,
+  input                 hps_0_hps_io_hps_io_emac1_inst_RX_CLK,
+  input                 hps_0_hps_io_hps_io_emac1_inst_RXD1,
+  input                 hps_0_hps_io_hps_io_emac1_inst_RXD2,
+  input                 hps_0_hps_io_hps_io_emac1_inst_RXD3,
+  inout                 hps_0_hps_io_hps_io_sdio_inst_CMD,
+  inout                 hps_0_hps_io_hps_io_sdio_inst_D0,
+  inout                 hps_0_hps_io_hps_io_sdio_inst_D1,
+  output                hps_0_hps_io_hps_io_sdio_inst_CLK,
+  inout                 hps_0_hps_io_hps_io_sdio_inst_D2,
+  inout                 hps_0_hps_io_hps_io_sdio_inst_D3,
+  inout                 hps_0_hps_io_hps_io_usb1_inst_D0,
+  inout                 hps_0_hps_io_hps_io_usb1_inst_D1,
+  inout                 hps_0_hps_io_hps_io_usb1_inst_D2,
+  inout                 hps_0_hps_io_hps_io_usb1_inst_D3,
+  inout                 hps_0_hps_io_hps_io_usb1_inst_D4,
+  inout                 hps_0_hps_io_hps_io_usb1_inst_D5,
+  inout                 hps_0_hps_io_hps_io_usb1_inst_D6,
+  inout                 hps_0_hps_io_hps_io_usb1_inst_D7,
+  input                 hps_0_hps_io_hps_io_usb1_inst_CLK,
+  output                hps_0_hps_io_hps_io_usb1_inst_STP,
+  input                 hps_0_hps_io_hps_io_usb1_inst_DIR,
+  input                 hps_0_hps_io_hps_io_usb1_inst_NXT,
+  output                hps_0_hps_io_hps_io_spim1_inst_CLK,
+  output                hps_0_hps_io_hps_io_spim1_inst_MOSI,
+  input                 hps_0_hps_io_hps_io_spim1_inst_MISO,
+  output                hps_0_hps_io_hps_io_spim1_inst_SS0,
+  input                 hps_0_hps_io_hps_io_uart0_inst_RX,
+  output                hps_0_hps_io_hps_io_uart0_inst_TX,
+  inout                 hps_0_hps_io_hps_io_i2c0_inst_SDA,
+  inout                 hps_0_hps_io_hps_io_i2c0_inst_SCL,
+  inout                 hps_0_hps_io_hps_io_i2c1_inst_SDA,
+  inout                 hps_0_hps_io_hps_io_i2c1_inst_SCL,
+  inout                 hps_0_hps_io_hps_io_gpio_inst_GPIO09,
+  inout                 hps_0_hps_io_hps_io_gpio_inst_GPIO35,
+  inout                 hps_0_hps_io_hps_io_gpio_inst_GPIO40,
+  inout                 hps_0_hps_io_hps_io_gpio_inst_GPIO53,
+  inout                 hps_0_hps_io_hps_io_gpio_inst_GPIO54,
+  inout                 hps_0_hps_io_hps_io_gpio_inst_GPIO61,
+
+  // Avalon Memory Mapped Bridge
+  input                 mm_bridge_waitrequest,
+  input          [63:0] mm_bridge_readdata,
+  input                 mm_bridge_readdatavalid,
+  output         [63:0] mm_bridge_writedata,
+  output          [6:0] mm_bridge_address,
+  output                mm_bridge_write,
+  output                mm_bridge_read,
+  output          [7:0] mm_bridge_byteenable,
+
+  // FPGA-to-SDRAM
+  input          [28:0] hps_0_f2h_sdram0_data_address,
+  input           [7:0] hps_0_f2h_sdram0_data_burstcount,
+  output                hps_0_f2h_sdram0_data_waitrequest,
+  input          [63:0] hps_0_f2h_sdram0_data_writedata,
+  input           [7:0] hps_0_f2h_sdram0_data_byteenable,
+  input                 hps_0_f2h_sdram0_data_write,
+
+  // IRQ
+  input          [31:0] irq0_irq
+);
+
+assign mm_bridge_address    = sim_top.address_i;
+assign mm_bridge_write      = sim_top.write_i;
+assign mm_bridge_read       = sim_top.read_i;
+assign mm_bridge_writedata  = sim_top.writedata_i;
+assign mm_bridge_byteenable = sim_top.byteenable_i;
+
+assign hps_0_f2h_sdram0_data_waitrequest = 1'b 0;
+
+endmodule
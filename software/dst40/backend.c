@@ -0,0 +1,845 @@
+/******************************************************************************
+ *
+ * Исполнители поиска (backend): настоящая FPGA и "пустой" исполнитель.
+ *
+ * mmap - регистры модуля DST40 маппятся из /dev/mem через мост
+ *        HPS-to-FPGA (0xC0000000), ожидание - по прерыванию IRQ0
+ *        (драйвер /dev/irq-ctrl) или циклическим опросом флагов.
+ *        С опцией --ring найденные ключи приходят не через регистры
+ *        FIFO, а через кольцевой буфер в памяти HPS (ring.c): буфер
+ *        тоже маппится из /dev/mem, поэтому его физическая память
+ *        должна быть скрыта от Linux (например, mem= в bootargs).
+ *
+ * null - ничего не ищет: перебор "заканчивается" сразу после запуска.
+ *        Нужен для замера накладных расходов управляющей программы
+ *        отдельно от скорости хэширования.
+ *
+ * Программная модель FPGA (sim) - в файле fpgasim.c.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#ifdef __arm__
+#include "hwlib.h"
+#include "socal/socal.h"
+#include "socal/hps.h"
+#endif
+#include "backend.h"
+#include "ring.h"
+
+
+//#############################################################################
+// ОПРЕДЕЛЕНИЯ
+
+// На хосте без HPS (x86) библиотеки hwlib нет - доступ к регистрам
+// описываем сами так же, как это сделано в socal/socal.h.
+
+#ifndef __arm__
+#define alt_write_dword(dest, src)  ( *(volatile uint64_t *)(dest) = (src) )
+#define alt_read_dword(src)         ( *(volatile uint64_t *)(src) )
+#endif
+
+// Адреса регистров в схеме DST40 (номера регистров - в backend.h)
+
+#define DST40_ADDR(reg)   ( _h2f_base + 8 * (reg) )
+
+#define DST40_CHALLENGE    DST40_ADDR( DST40_REG_CHALLENGE )
+#define DST40_RESPONSE     DST40_ADDR( DST40_REG_RESPONSE )
+#define DST40_START_KEY    DST40_ADDR( DST40_REG_START_KEY )
+#define DST40_RUN          DST40_ADDR( DST40_REG_RUN )
+#define DST40_FLAGS        DST40_ADDR( DST40_REG_FLAGS )
+#define DST40_KEY          DST40_ADDR( DST40_REG_KEY )
+#define DST40_KERNELS      DST40_ADDR( DST40_REG_KERNELS )
+#define DST40_FIFO         DST40_ADDR( DST40_REG_FIFO )
+#define DST40_CHALLENGE2   DST40_ADDR( DST40_REG_CHALLENGE2 )
+#define DST40_RESPONSE2    DST40_ADDR( DST40_REG_RESPONSE2 )
+#define DST40_INDEX        DST40_ADDR( DST40_REG_INDEX )
+#define DST40_COUNT        DST40_ADDR( DST40_REG_COUNT )
+#define DST40_POSITION     DST40_ADDR( DST40_REG_POSITION )
+#define DST40_CYCLES       DST40_ADDR( DST40_REG_CYCLES )
+#define DST40_IDREG        DST40_ADDR( DST40_REG_ID )
+#define DST40_CAPSREG      DST40_ADDR( DST40_REG_CAPS )
+#define DST40_BUSY         DST40_ADDR( DST40_REG_BUSY )
+#define DST40_STALL        DST40_ADDR( DST40_REG_STALL )
+#define DST40_HOLD         DST40_ADDR( DST40_REG_HOLD )
+#define DST40_REFILL       DST40_ADDR( DST40_REG_REFILL )
+#define DST40_RESTARTS     DST40_ADDR( DST40_REG_RESTARTS )
+#define DST40_RING_CTL     DST40_ADDR( DST40_REG_RING_CTL )
+#define DST40_END_KEY      DST40_ADDR( DST40_REG_END_KEY )
+#define DST40_KEY_MASK     DST40_ADDR( DST40_REG_KEY_MASK )
+#define DST40_KEY_VALUE    DST40_ADDR( DST40_REG_KEY_VALUE )
+#define DST40_JOBREG       DST40_ADDR( DST40_REG_JOB )
+#define DST40_DESC         DST40_ADDR( DST40_REG_DESC )
+#define DST40_QUEUE        DST40_ADDR( DST40_REG_QUEUE )
+#define DST40_QUEUE_DONE   DST40_ADDR( DST40_REG_QUEUE_DONE )
+#define DST40_HITS         DST40_ADDR( DST40_REG_HITS )
+#define DST40_TABLE        DST40_ADDR( DST40_REG_TABLE )
+
+#define DST40_H2F_ADDR    0xC0000000                            // Физический адрес моста HPS-to-FPGA
+#define DST40_H2F_SIZE    1024                                  // Размер окна регистров модуля DST40
+
+#define DST40_SDR_ADDR    0xFFC25000                            // Страница регистров контроллера SDRAM с fpgaportrst
+#define DST40_SDR_SIZE    0x1000
+#define DST40_SDR_PORTRST 0x80                                  // Смещение регистра fpgaportrst
+#define DST40_SDR_PORTS   0x3FFF                                // Биты сброса всех портов FPGA-to-SDRAM
+
+
+
+//#############################################################################
+// ГЛОБАЛЬНЫЕ ПЕРЕМЕННЫЕ
+
+// Параметры образа: до подключения - четырёхъядерный образ версии 6
+// (без регистров id и caps)
+
+DST40_CAPS _caps = { 4, 2, 16, 64, 150, DST40_CAPS_VERIFY | DST40_CAPS_TABLE | DST40_CAPS_POSITION, 4, 64, 0 };
+
+// Известные биты ключа: до backendMask() - нет
+
+DST40_KEYMASK _keymask = { 0, 0, 0 };
+
+static int   _dst40_regs_file = 0;
+static int   _irq_ctrl_file = 0;
+static void* _h2f_base = 0;
+
+uint32_t     _ring_base   = 0;                                  // Физический адрес кольцевого буфера
+uint32_t     _ring_l2size = 0;                                  // Логарифм количества записей буфера (0 - буфер не используется)
+
+static volatile DST40_RECORD *_ring_mem = 0;                    // Буфер, отображённый в память
+static bool  _ring_active = false;                              // Ключи текущего задания идут через буфер
+static bool  _queue_active = false;                             // Задания берутся из очереди дескрипторов
+
+
+
+static void mmapClose( void );
+
+
+
+/******************************************************************************
+ * mmap: подключение кольцевого буфера найденных ключей.
+ *
+ * Буфер маппится из /dev/mem по адресу из --ring. Порты FPGA-to-SDRAM
+ * после загрузки держатся в сбросе, пока его не снимет U-Boot
+ * (bridge_enable_handoff) - на всякий случай снимаем его здесь.
+ * Образ без буфера не ошибка: ключи тогда читаются через FIFO.
+ *****************************************************************************/
+
+static bool mmapRingOpen( void )
+{
+  void *sdr;
+
+  if( !( _caps.features & DST40_CAPS_RING ) )
+  {
+    printf( "\nWARNING: FPGA image has no candidate ring buffer: FIFO registers will be used\n" );
+    return true;
+  }
+
+  _ring_mem = mmap( NULL, sizeof(DST40_RECORD) << _ring_l2size, ( PROT_READ | PROT_WRITE ), MAP_SHARED, _dst40_regs_file, _ring_base );
+
+  if( _ring_mem == MAP_FAILED )
+  {
+    _ring_mem = 0;
+    perror( "\nERROR: mmap() of the ring buffer failed\n" );
+    return false;
+  }
+
+  sdr = mmap( NULL, DST40_SDR_SIZE, ( PROT_READ | PROT_WRITE ), MAP_SHARED, _dst40_regs_file, DST40_SDR_ADDR );
+
+  if( sdr == MAP_FAILED )
+  {
+    perror( "\nERROR: mmap() of the SDRAM controller failed\n" );
+    return false;
+  }
+
+  *(volatile uint32_t *)( sdr + DST40_SDR_PORTRST ) |= DST40_SDR_PORTS;  // Снимаем сброс с портов FPGA-to-SDRAM
+  munmap( sdr, DST40_SDR_SIZE );
+
+  printf( "\nCandidate ring buffer: %u records at 0x%08X\n", 1U << _ring_l2size, _ring_base );
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * mmap: доступ к регистрам по номеру для потока кольцевого буфера.
+ *****************************************************************************/
+
+static uint64_t mmapReadReg( uint32_t reg )
+{
+  return alt_read_dword( DST40_ADDR( reg ) );
+}
+
+static void mmapWriteReg( uint32_t reg, uint64_t value )
+{
+  alt_write_dword( DST40_ADDR( reg ), value );
+}
+
+
+
+/******************************************************************************
+ * mmap: подключение к FPGA.
+ *
+ * При ошибке всё, что успели открыть, закрывается.
+ *****************************************************************************/
+
+static bool mmapOpen( void )
+{
+  // Открываем файл драйвера IRQ
+
+  if( ( _irq_ctrl_file = open( "/dev/irq-ctrl", O_RDONLY ) ) == -1 )
+  {
+    _irq_ctrl_file = 0;
+    printf( "\nWARNING: IRQ-CTRL driver not found: Cyclic poll flags will be used\n" );
+  }
+
+  // Маппим регистры модуля DST40 в память
+
+  if( ( _dst40_regs_file = open( "/dev/mem", ( O_RDWR | O_SYNC ) ) ) == -1 )
+  {
+    _dst40_regs_file = 0;
+    perror( "\nERROR: could not open \"/dev/mem\"\n" );
+    mmapClose();
+    return false;
+  }
+
+  _h2f_base = mmap( NULL, DST40_H2F_SIZE, ( PROT_READ | PROT_WRITE ), MAP_SHARED, _dst40_regs_file, DST40_H2F_ADDR );
+
+  if( _h2f_base == MAP_FAILED )
+  {
+    _h2f_base = 0;
+    perror( "\nERROR: mmap() failed\n" );
+    mmapClose();
+    return false;
+  }
+
+  // Узнаём параметры загруженного образа
+
+  if( !backendCaps( alt_read_dword( DST40_IDREG ), alt_read_dword( DST40_CAPSREG ) ) )
+  {
+    mmapClose();
+    return false;
+  }
+
+  if( _caps.version )
+    printf( "\nFPGA image v%u: %u kernels (%u of 64 stages, depth %u), %u tags, %u MHz\n", _caps.version, DST40_NK, _caps.unroll, _caps.depth, DST40_NR, DST40_CLOCK_MHZ );
+  else
+    printf( "\nWARNING: FPGA image has no capability register: %u kernels assumed\n", DST40_NK );
+
+  if( _ring_l2size && !mmapRingOpen() )
+  {
+    mmapClose();
+    return false;
+  }
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * mmap: отключение от FPGA.
+ *****************************************************************************/
+
+static void mmapClose( void )
+{
+  ringStop();
+
+  if( _h2f_base )
+  {
+    alt_write_dword( DST40_RUN, 0 );                            // Останавливаем FPGA
+    alt_write_dword( DST40_RING_CTL, 0 );                       // и запись в кольцевой буфер
+
+    if( _queue_active )
+      alt_write_dword( DST40_QUEUE, 0 );                        // Выключаем очередь дескрипторов
+
+    if( munmap( _h2f_base, DST40_H2F_SIZE ) != 0 )              // Размапливаем регистры модуля DST40
+      printf( "\nERROR: munmap() failed...\n" );
+
+    _h2f_base = 0;
+  }
+
+  if( _ring_mem )
+  {
+    munmap( (void *) _ring_mem, sizeof(DST40_RECORD) << _ring_l2size );
+    _ring_mem = 0;
+  }
+
+  _ring_active  = false;
+  _queue_active = false;
+
+  if( _dst40_regs_file > 0 )                                    // Закрываем файл маппера,
+    close( _dst40_regs_file );                                  // если он был открыт
+
+  if( _irq_ctrl_file > 0 )                                      // Закрываем файл обработчика прерываний,
+    close( _irq_ctrl_file );                                    // если он был открыт
+
+  _dst40_regs_file = 0;
+  _irq_ctrl_file = 0;
+}
+
+
+
+/******************************************************************************
+ * mmap: загрузка задания.
+ *
+ * Перед загрузкой выбрасываются ключи, оставшиеся в FIFO от прошлого
+ * запуска. Запись в кольцевой буфер выключается до следующего запуска -
+ * ключи из FIFO снова читаются через регистры.
+ *****************************************************************************/
+
+static void mmapLoad( const DST40_JOB *job )
+{
+  uint32_t j;
+
+  alt_write_dword( DST40_RUN, 0 );
+
+  if( _ring_mem )
+    alt_write_dword( DST40_RING_CTL, 0 );
+
+  _ring_active = false;
+
+  while( alt_read_dword( DST40_FLAGS ) & DST40_FLAG_FOUND )
+    alt_write_dword( DST40_FIFO, 1 );
+
+  alt_write_dword( DST40_CHALLENGE,  job->challenge  );
+  alt_write_dword( DST40_CHALLENGE2, job->challenge2 );
+  alt_write_dword( DST40_START_KEY,  job->start_key  );
+  alt_write_dword( DST40_COUNT,      job->count      );
+
+  if( _caps.features & DST40_CAPS_QUEUE )
+    alt_write_dword( DST40_END_KEY,  job->end_key    );
+
+  if( _caps.version >= DST40_VERSION_MASK )                     // Маска пишется всегда - в регистрах может остаться чужая
+  {
+    alt_write_dword( DST40_KEY_MASK,  _keymask.mask  );
+    alt_write_dword( DST40_KEY_VALUE, _keymask.value );
+  }
+
+  for( j=0; j < job->count; j++ )
+    alt_write_dword( DST40_TABLE + j * 8, ( job->response2[j] << 24 ) | job->response[j] );
+}
+
+
+
+/******************************************************************************
+ * mmap: запуск и остановка поиска.
+ *
+ * Поток кольцевого буфера запускается до run и останавливается после
+ * остановки FPGA; ключи, которые он успел забрать, читаются методом
+ * result() и после остановки - до загрузки следующего задания.
+ *****************************************************************************/
+
+static void mmapRingStart( void )
+{
+  DST40_RING ring;
+
+  if( _ring_mem )
+  {
+    ring.records = _ring_mem;
+    ring.l2size  = _ring_l2size;
+    ring.base    = _ring_base;
+    ring.read    = mmapReadReg;
+    ring.write   = mmapWriteReg;
+
+    _ring_active = ringStart( &ring );
+  }
+}
+
+static void mmapStart( void )
+{
+  mmapRingStart();
+
+  alt_write_dword( DST40_RUN, 1 );
+}
+
+static void mmapStop( void )
+{
+  alt_write_dword( DST40_RUN, 0 );
+
+  if( _queue_active )                                           // Выключение очереди останавливает её задание
+    alt_write_dword( DST40_QUEUE, 0 );                          // и выбрасывает остальные
+
+  _queue_active = false;
+
+  ringStop();
+}
+
+
+
+/******************************************************************************
+ * mmap: задание в очередь дескрипторов.
+ *
+ * Очередь включается первым заданием после остановки: перед этим FIFO
+ * очищается и пишется маска, как при load(). Регистры 48..52 пишутся
+ * только при свободном месте - дескриптор, поданный в заполненную
+ * очередь, FPGA выбрасывает.
+ *****************************************************************************/
+
+static bool mmapPush( const DST40_JOB *job )
+{
+  uint64_t queue;
+
+  if( !_queue_active )
+  {
+    mmapLoad( job );
+    mmapRingStart();
+
+    alt_write_dword( DST40_QUEUE, 1 );
+    _queue_active = true;
+  }
+
+  queue = alt_read_dword( DST40_QUEUE );
+
+  if( ( ( queue >> 16 ) & 0xFF ) >= ( 1U << ( ( queue >> 24 ) & 0xFF ) ) )
+    return false;
+
+  alt_write_dword( DST40_DESC,      job->challenge  );
+  alt_write_dword( DST40_DESC + 8,  job->challenge2 );
+  alt_write_dword( DST40_DESC + 16, ( job->response2[0] << 24 ) | job->response[0] );
+  alt_write_dword( DST40_DESC + 24, job->start_key  );
+  alt_write_dword( DST40_DESC + 32, job->end_key    );
+
+  alt_write_dword( DST40_QUEUE, 0x101 );                        // Бит 8 - положить дескриптор, бит 0 - очередь остаётся включённой
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * mmap: количество выполненных заданий очереди.
+ *****************************************************************************/
+
+static uint32_t mmapCompleted( void )
+{
+  if( _ring_active )
+    return ringCompleted();
+
+  return alt_read_dword( DST40_QUEUE_DONE );
+}
+
+
+
+/******************************************************************************
+ * mmap: ожидание ключа в FIFO или конца перебора.
+ *
+ * Ожидание с ограничением по времени (timeout мс) выполняется опросом
+ * флагов раз в миллисекунду: из read() драйвера IRQ-CTRL по таймауту
+ * не выйти.
+ *****************************************************************************/
+
+static uint64_t mmapWait( uint32_t timeout )
+{
+  uint64_t flags;
+  char     buf[4];
+
+  if( _ring_active )                                            // Ключи - в очереди потока кольцевого буфера
+    return ringWait( timeout );
+
+  if( timeout )
+  {
+    struct timespec ts = { 0, 1000000 };                        // 1 мс
+
+    while( 1 )
+    {
+      flags = alt_read_dword( DST40_FLAGS );
+
+      if( ( flags & ( DST40_FLAG_FOUND | DST40_FLAG_DONE ) ) || !timeout-- )
+        return flags;
+
+      nanosleep( &ts, NULL );
+    }
+  }
+
+  if( _irq_ctrl_file > 0 )
+  {
+    // Засыпаем до момента прерывания
+    if( read( _irq_ctrl_file, buf, 1 ) < 0 )
+      perror( "\nERROR: read() from IRQ-CTRL failed\n" );
+
+    // Считываем флаги из FPGA
+    return alt_read_dword( DST40_FLAGS );
+  }
+
+  // Читаем флаги в цикле, пока не появится ключ или не будут
+  // перебраны все ключи - это приводит к полной загрузке одного ядра
+  // процессора.
+  do
+  {
+    flags = alt_read_dword( DST40_FLAGS );
+  }
+  while( !( flags & ( DST40_FLAG_FOUND | DST40_FLAG_DONE ) ) );
+
+  return flags;
+}
+
+
+
+/******************************************************************************
+ * mmap: чтение и удаление ключа из головы FIFO.
+ *****************************************************************************/
+
+static bool mmapResult( DST40_RESULT *result )
+{
+  if( _ring_active )
+    return ringResult( result );
+
+  if( !( alt_read_dword( DST40_FLAGS ) & DST40_FLAG_FOUND ) )
+    return false;
+
+  result->key     = alt_read_dword( DST40_KEY );
+  result->kernels = alt_read_dword( DST40_KERNELS );
+  result->index   = alt_read_dword( DST40_INDEX );
+  result->cycles  = 0;
+  result->job     = ( _caps.features & DST40_CAPS_QUEUE ) ? alt_read_dword( DST40_JOBREG ) : 0;
+
+  alt_write_dword( DST40_FIFO, 1 );                             // Удаляем ключ из FIFO
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * mmap: счётчик перебора.
+ *****************************************************************************/
+
+static uint64_t mmapPosition( void )
+{
+  if( _ring_active )
+    return ringPosition();
+
+  return alt_read_dword( DST40_POSITION );
+}
+
+
+
+/******************************************************************************
+ * mmap: счётчик тактов ядер от запуска.
+ *****************************************************************************/
+
+static uint64_t mmapCycles( void )
+{
+  return alt_read_dword( DST40_CYCLES );
+}
+
+
+
+/******************************************************************************
+ * mmap: счётчики производительности.
+ *
+ * Счётчики замирают через несколько тактов после записи 0 в run. Лишнее
+ * чтение регистра run перед ними гарантирует, что запись уже дошла
+ * до FPGA и счётчики больше не меняются.
+ *****************************************************************************/
+
+static bool mmapPerf( DST40_PERF *perf )
+{
+  uint32_t i;
+
+  if( !( _caps.features & DST40_CAPS_PERF ) )
+    return false;
+
+  alt_read_dword( DST40_RUN );
+
+  perf->busy     = alt_read_dword( DST40_BUSY );
+  perf->stall    = alt_read_dword( DST40_STALL );
+  perf->hold     = alt_read_dword( DST40_HOLD );
+  perf->refill   = alt_read_dword( DST40_REFILL );
+  perf->restarts = alt_read_dword( DST40_RESTARTS );
+
+  for( i=0; i < DST40_NK; i++ )
+    perf->hits[i] = alt_read_dword( DST40_HITS + 8 * i );
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * null: все методы - заглушки, перебор заканчивается сразу.
+ *****************************************************************************/
+
+static bool nullOpen( void )
+{
+  return true;
+}
+
+static void nullNothing( void )
+{
+}
+
+static void nullLoad( const DST40_JOB *job )
+{
+}
+
+static uint64_t nullWait( uint32_t timeout )
+{
+  return DST40_FLAG_DONE;
+}
+
+static bool nullResult( DST40_RESULT *result )
+{
+  return false;
+}
+
+static uint64_t nullCycles( void )
+{
+  return 0;
+}
+
+static bool nullPerf( DST40_PERF *perf )
+{
+  return false;
+}
+
+static uint64_t nullPosition( void )
+{
+  return DST40_KEYS;
+}
+
+
+
+//#############################################################################
+// ОПИСАТЕЛИ ИСПОЛНИТЕЛЕЙ
+
+const DST40_BACKEND backendMmap =
+{
+  "mmap", mmapOpen, mmapClose, mmapLoad, mmapStart, mmapStop, mmapWait, mmapResult, mmapCycles, mmapPerf, mmapPosition,
+  mmapPush, mmapCompleted
+};
+
+const DST40_BACKEND backendNull =
+{
+  "null", nullOpen, nullNothing, nullLoad, nullNothing, nullNothing, nullWait, nullResult, nullCycles, nullPerf, nullPosition,
+  NULL, NULL
+};
+
+
+
+/******************************************************************************
+ * Выбор исполнителя по названию.
+ *
+ * Возвращает NULL, если исполнителя с таким названием нет.
+ *****************************************************************************/
+
+const DST40_BACKEND *backendByName( const char *name )
+{
+  static const DST40_BACKEND *list[] = { &backendMmap, &backendSim, &backendNull };
+  uint32_t i;
+
+  for( i=0; i < sizeof(list) / sizeof(list[0]); i++ )
+    if( !strcmp( list[i]->name, name ) )
+      return list[i];
+
+  return NULL;
+}
+
+
+
+/******************************************************************************
+ * Разбор регистров id и caps образа в _caps.
+ *
+ * Если регистра id нет (старый образ читает 0), остаются параметры
+ * по умолчанию. Возвращает false (сообщение уже выведено), если
+ * параметры образа программой не поддерживаются.
+ *****************************************************************************/
+
+bool backendCaps( uint64_t id, uint64_t caps )
+{
+  DST40_CAPS c;
+
+  if( ( id >> 24 ) != DST40_MAGIC )
+    return true;
+
+  c.nk        = caps & 0xFF;
+  c.l2nk      = ( caps >> 8 ) & 0xFF;
+  c.nr        = ( caps >> 16 ) & 0xFF;
+  c.depth     = ( caps >> 24 ) & 0xFF;
+  c.clock_mhz = ( caps >> 32 ) & 0xFFFF;
+  c.features  = ( caps >> 48 ) & 0xFF;
+  c.l2fifo    = ( caps >> 56 ) & 0xFF;
+  c.unroll    = ( id >> 16 ) & 0xFF;
+  c.version   = id & 0xFFFF;
+
+  if( !c.unroll )                                               // Образы без свёрнутых ядер
+    c.unroll = 64;
+
+  if( c.nk < 1 || c.nk > DST40_MAX_NK || c.nk != ( 1U << c.l2nk ) || c.nr < 1 || c.nr > DST40_MAX_NR || !c.clock_mhz ||
+      c.unroll > 64 || 64 % c.unroll )
+  {
+    printf( "\nERROR: unsupported FPGA image (caps %016llX)\n", caps );
+    return false;
+  }
+
+  _caps = c;
+  return true;
+}
+
+
+
+/******************************************************************************
+ * Количество ядер для исполнителей без регистра caps: модели FPGA
+ * и координатора, который раздаёт работу платам с таким образом.
+ * Вызывается до подключения исполнителя.
+ *****************************************************************************/
+
+void backendKernels( uint32_t nk )
+{
+  _caps.nk   = nk;
+  _caps.l2nk = 0;
+
+  while( ( 1U << _caps.l2nk ) < nk )
+    _caps.l2nk++;
+}
+
+
+
+/******************************************************************************
+ * Раскладка ключей по ядрам для исполнителей без регистра caps (модели
+ * FPGA и координатора): true - номер ядра в младших битах ключа.
+ * Вызывается до подключения исполнителя.
+ *****************************************************************************/
+
+void backendInterleave( bool interleave )
+{
+  if( interleave )
+    _caps.features |= DST40_CAPS_INTERLEAVE;
+  else
+    _caps.features &= ~DST40_CAPS_INTERLEAVE;
+}
+
+
+
+/******************************************************************************
+ * Известные биты ключа: mask - маска известных бит полного 40-битного
+ * ключа, value - их значения (mask = 0 - все биты свободны).
+ *
+ * Маска переводится в единицы key_reg; известные биты номера ядра
+ * перебор не сокращают - эти ядра просто проверяют лишние ключи.
+ * Вызывается после подключения исполнителя: раскладка ключей и версия
+ * образа уже известны. Возвращает false (сообщение уже выведено), если
+ * образ маску не поддерживает.
+ *****************************************************************************/
+
+bool backendMask( uint64_t mask, uint64_t value )
+{
+  uint64_t kernel_bits;
+  uint32_t j;
+
+  mask  &= 0xFFFFFFFFFFULL;
+  value &= mask;
+
+  if( mask && _caps.version < DST40_VERSION_MASK )
+  {
+    printf( "\nERROR: FPGA image v%u has no key mask (v%u needed)\n", _caps.version, DST40_VERSION_MASK );
+    return false;
+  }
+
+  kernel_bits = DST40_INTERLEAVE ? mask & ( DST40_NK - 1 ) : mask >> ( 40 - DST40_L2NK );
+
+  if( kernel_bits )
+    printf( "\nNOTE: known key bits in kernel number are searched anyway\n" );
+
+  _keymask.mask  = DST40_INTERLEAVE ? mask >> DST40_L2NK : mask & ( ( 1ULL << ( 40 - DST40_L2NK ) ) - 1 );
+  _keymask.value = DST40_INTERLEAVE ? value >> DST40_L2NK : value & _keymask.mask;
+  _keymask.known = 0;
+
+  for( j=0; j < 40 - DST40_L2NK; j++ )
+    _keymask.known += ( _keymask.mask >> j ) & 1;
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * Биты index по порядку на места нулевых бит mask (в пределах 40-L2NK бит
+ * key_reg) - номер в уменьшенном пространстве в значение key_reg.
+ *****************************************************************************/
+
+uint64_t backendDeposit( uint64_t index, uint64_t mask )
+{
+  uint64_t result = 0;
+  uint32_t j, k;
+
+  for( j=0, k=0; j < 40 - DST40_L2NK; j++ )
+    if( !( ( mask >> j ) & 1 ) )
+      result |= ( ( index >> k++ ) & 1 ) << j;
+
+  return result;
+}
+
+
+
+/******************************************************************************
+ * Обратное backendDeposit(): биты key на местах нулевых бит mask по порядку.
+ *****************************************************************************/
+
+uint64_t backendExtract( uint64_t key, uint64_t mask )
+{
+  uint64_t result = 0;
+  uint32_t j, k;
+
+  for( j=0, k=0; j < 40 - DST40_L2NK; j++ )
+    if( !( ( mask >> j ) & 1 ) )
+      result |= ( ( key >> j ) & 1 ) << k++;
+
+  return result;
+}
+
+
+
+/******************************************************************************
+ * Значение счётчика перебора key_reg, на котором ядра проверяют ключ key
+ * (при заданной маске - номер ключа в уменьшенном пространстве; известные
+ * биты key при этом не учитываются).
+ *****************************************************************************/
+
+uint64_t backendIndex( uint64_t key )
+{
+  uint64_t index;
+
+  if( DST40_INTERLEAVE )
+    index = ( key & 0xFFFFFFFFFFULL ) >> DST40_L2NK;
+  else
+    index = key & ( ( 1ULL << ( 40 - DST40_L2NK ) ) - 1 );
+
+  return _keymask.mask ? backendExtract( index, _keymask.mask ) : index;
+}
+
+
+
+/******************************************************************************
+ * Ключ, который проверяет ядро kernel при значении счётчика перебора index.
+ *****************************************************************************/
+
+uint64_t backendKey( uint64_t index, uint32_t kernel )
+{
+  if( _keymask.mask )
+    index = backendDeposit( index, _keymask.mask ) | _keymask.value;
+
+  if( DST40_INTERLEAVE )
+    return ( index << DST40_L2NK ) | kernel;
+
+  return ( (uint64_t)kernel << ( 40 - DST40_L2NK ) ) | index;
+}
+
+
+
+/******************************************************************************
+ * Кольцевой буфер найденных ключей (ring.h): физический адрес буфера
+ * (кратен размеру страницы) и логарифм количества записей.
+ * Вызывается до подключения исполнителя.
+ *****************************************************************************/
+
+void backendRing( uint32_t base, uint32_t l2size )
+{
+  _ring_base   = base;
+  _ring_l2size = l2size;
+}
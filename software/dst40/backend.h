@@ -0,0 +1,239 @@
+#ifndef BACKEND_H_
+#define BACKEND_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// Параметры модуля DST40 читаются из регистров id и caps при подключении
+// исполнителя, поэтому программа работает с образами с любым количеством
+// ядер. До подключения (и для старых образов без регистра caps)
+// действуют параметры четырёхъядерного образа.
+
+#define DST40_MAGIC       0x4453543430ULL                       // "DST40" - биты 63..24 регистра id
+#define DST40_MAX_NK      16                                    // Наибольшее поддерживаемое количество ядер
+#define DST40_MAX_NR      64                                    // Наибольший поддерживаемый размер таблицы ответов
+
+#define DST40_CAPS_VERIFY    0x01                               // Проверка кандидатов на второй паре внутри FPGA
+#define DST40_CAPS_TABLE     0x02                               // Таблица ответов нескольких меток
+#define DST40_CAPS_POSITION  0x04                               // Счётчик перебора
+#define DST40_CAPS_CYCLES    0x08                               // Счётчик тактов
+#define DST40_CAPS_PERF      0x10                               // Счётчики производительности
+#define DST40_CAPS_RING      0x20                               // Кольцевой буфер найденных ключей в памяти HPS (ring.h)
+#define DST40_CAPS_QUEUE     0x40                               // Конечный ключ и очередь дескрипторов заданий
+#define DST40_CAPS_INTERLEAVE 0x80                              // Номер ядра - младшие биты ключа (ядро i: key_reg * NK + i)
+
+#define DST40_VERSION_MASK   11                                 // Версия образа, начиная с которой есть маска известных бит ключа
+
+typedef struct
+{
+  uint32_t nk;                                                  // Количество ядер
+  uint32_t l2nk;                                                // Логарифм по основанию 2 от количества ядер
+  uint32_t nr;                                                  // Размер таблицы ответов (меток за один проход)
+  uint32_t depth;                                               // Глубина конвеера, тактов
+  uint32_t clock_mhz;                                           // Частота тактов ядер (PLL), МГц
+  uint32_t features;                                            // DST40_CAPS_*
+  uint32_t l2fifo;                                              // Логарифм по основанию 2 от глубины FIFO
+  uint32_t unroll;                                              // Модулей Block64 в ядре (64 - ключ за такт, меньше - за 64 / unroll тактов)
+  uint32_t version;                                             // Версия образа (0 - регистра id нет)
+} DST40_CAPS;
+
+extern DST40_CAPS _caps;                                        // Параметры подключенного образа
+
+
+// Известные биты ключа (backendMask()). Счётчик перебора key_reg тогда
+// перебирает только свободные биты: ядра проверяют ключ, в котором
+// на месте свободных бит по порядку стоят биты key_reg, а на месте
+// известных - их значения. Стартовый и конечный ключи, счётчик перебора
+// и ключи из FIFO задаются номером в уменьшенном пространстве из
+// DST40_KEYS значений key_reg.
+
+typedef struct
+{
+  uint64_t mask;                                                // Маска известных бит в единицах key_reg (регистр key_mask)
+  uint64_t value;                                               // Значения известных бит (регистр key_value)
+  uint32_t known;                                               // Количество известных бит
+} DST40_KEYMASK;
+
+extern DST40_KEYMASK _keymask;                                  // Маска текущего поиска
+
+#define DST40_NK          ( _caps.nk )                          // Количество ядер
+#define DST40_L2NK        ( _caps.l2nk )                        // Логарифм по основанию 2 от количества ядер
+#define DST40_NR          ( _caps.nr )                          // Размер таблицы ответов (меток за один проход)
+#define DST40_CLOCK_MHZ   ( _caps.clock_mhz )                   // Частота тактов ядер (PLL), МГц
+#define DST40_KEYS        ( 1ULL << ( 40 - DST40_L2NK - _keymask.known ) )  // Количество ключей, перебираемых каждым ядром
+
+
+// Раскладка ключей по ядрам. Стартовый и конечный ключи, счётчик перебора
+// и ключи из FIFO задаются значениями счётчика перебора key_reg (0..DST40_KEYS),
+// одними для всех ядер. Обычно номер ядра - старшие биты ключа, а key_reg -
+// младшие; в образе с DST40_CAPS_INTERLEAVE наоборот: ядро i проверяет
+// ключ key_reg * DST40_NK + i, и любой непрерывный диапазон ключей
+// перебирают все ядра. backendIndex() переводит ключ в key_reg,
+// backendKey() собирает ключ из key_reg и номера ядра.
+
+#define DST40_INTERLEAVE  ( ( _caps.features & DST40_CAPS_INTERLEAVE ) != 0 )
+
+
+// Номера 64-битных регистров модуля DST40 (адрес / 8). Карта регистров
+// с разрядностями - в заголовке source/dst40.v.
+
+#define DST40_REG_CHALLENGE   0
+#define DST40_REG_RESPONSE    1
+#define DST40_REG_START_KEY   2
+#define DST40_REG_RUN         3
+#define DST40_REG_FLAGS       4
+#define DST40_REG_KEY         5
+#define DST40_REG_KERNELS     6
+#define DST40_REG_FIFO        7
+#define DST40_REG_CHALLENGE2  8
+#define DST40_REG_RESPONSE2   9
+#define DST40_REG_INDEX       10
+#define DST40_REG_COUNT       11
+#define DST40_REG_POSITION    12
+#define DST40_REG_CYCLES      13
+#define DST40_REG_ID          14
+#define DST40_REG_CAPS        15
+#define DST40_REG_BUSY        16
+#define DST40_REG_STALL       17
+#define DST40_REG_HOLD        18
+#define DST40_REG_REFILL      19
+#define DST40_REG_RESTARTS    20
+#define DST40_REG_HITS        24                                // 24 .. 24+NK-1
+#define DST40_REG_RING_BASE   40
+#define DST40_REG_RING_CTL    41
+#define DST40_REG_RING_HEAD   42
+#define DST40_REG_RING_TAIL   43
+#define DST40_REG_END_KEY     44
+#define DST40_REG_JOB         45
+#define DST40_REG_KEY_MASK    46
+#define DST40_REG_KEY_VALUE   47
+#define DST40_REG_DESC        48                                // 48..52: challenge, challenge2, responses, start_key, end_key
+#define DST40_REG_QUEUE       53
+#define DST40_REG_QUEUE_DONE  54
+#define DST40_REG_TABLE       64                                // 64 .. 64+NR-1
+
+
+// Флаги, возвращаемые методом wait() - совпадают с регистром флагов FPGA
+
+#define DST40_FLAG_FOUND     0x000001ULL                        // В FIFO есть найденный ключ
+#define DST40_FLAG_DONE      0x000100ULL                        // Все ключи перебраны и проверены
+#define DST40_FLAG_OVERFLOW  0x010000ULL                        // Перебор приостанавливался
+
+
+// Задание на поиск: два запроса и таблица ответов меток
+
+typedef struct
+{
+  uint64_t        challenge;                                    // Первый запрос
+  uint64_t        challenge2;                                   // Второй запрос
+  uint64_t        start_key;                                    // Ключ, с которого начинать поиск
+  uint64_t        end_key;                                      // Ключ, на котором закончить поиск (не включая его, 0 - до конца);
+                                                                // образы без DST40_CAPS_QUEUE его не знают - перебор идёт до конца
+  const uint64_t *response;                                     // Ответы меток на первый запрос
+  const uint64_t *response2;                                    // Ответы меток на второй запрос
+  uint32_t        count;                                        // Количество меток (1..DST40_NR)
+} DST40_JOB;
+
+
+// Ключ из головы FIFO найденных ключей
+
+typedef struct
+{
+  uint64_t key;                                                 // Младшие 40-L2NK бит ключа
+  uint32_t kernels;                                             // Биты ядер, нашедших ключ (старшие биты ключа)
+  uint32_t index;                                               // Номер метки в таблице ответов
+  uint64_t cycles;                                              // Такт ядер от запуска, на котором ключ найден (0 - неизвестно)
+  uint32_t job;                                                 // Номер задания очереди дескрипторов (младшие 16 бит, вне очереди - 0)
+} DST40_RESULT;
+
+
+// Счётчики производительности за последний проход (в тактах ядер)
+
+typedef struct
+{
+  uint64_t busy;                                                // Ядра хэшировали (включая заполнение конвеера)
+  uint64_t stall;                                               // Конвеер стоял из-за занятого регистра кандидата
+  uint64_t hold;                                                // Найденный ключ ждал места в FIFO (ждал программу)
+  uint64_t refill;                                              // Заполнение конвеера после запуска
+  uint64_t hits[DST40_MAX_NK];                                  // Кандидаты по первой паре по ядрам
+  uint64_t restarts;                                            // Количество запусков с момента конфигурации FPGA
+} DST40_PERF;
+
+
+// Описатель исполнителя поиска (backend).
+//
+// Программа управляет поиском только через эти методы, поэтому один
+// и тот же управляющий цикл работает и с настоящей FPGA, и с её
+// программной моделью, и с "пустым" исполнителем для замера накладных
+// расходов самой программы.
+
+typedef struct
+{
+  const char *name;                                             // Название ("mmap", "sim", "null")
+
+  bool      (*open)( void );                                    // Подключение (false - ошибка, сообщение уже выведено)
+  void      (*close)( void );                                   // Отключение (поиск при этом останавливается)
+
+  void      (*load)( const DST40_JOB * );                       // Загрузка задания (поиск должен быть остановлен)
+  void      (*start)( void );                                   // Запуск поиска
+  void      (*stop)( void );                                    // Остановка поиска
+
+  uint64_t  (*wait)( uint32_t );                                // Ожидание ключа в FIFO или конца перебора не дольше заданного
+                                                                // числа мс (0 - без ограничения), возвращает флаги
+  bool      (*result)( DST40_RESULT * );                        // Чтение и удаление ключа из головы FIFO (false - FIFO пусто)
+
+  uint64_t  (*cycles)( void );                                  // Количество тактов ядер с момента запуска до окончания перебора
+                                                                // (0 - неизвестно; после остановки поиска сбрасывается)
+  bool      (*perf)( DST40_PERF * );                            // Счётчики производительности за проход - читаются после остановки
+                                                                // (false - исполнитель их не знает)
+
+  // Текущее значение счётчика перебора: младшие 40-L2NK бит ключей,
+  // до которых дошёл перебор во всех ядрах (DST40_KEYS - перебор закончен).
+  // Ключи, меньшие position() - DST40_LAG, уже сравнены с ответами, и все
+  // найденные среди них ключи, подошедшие к обеим парам, уже лежат в FIFO.
+
+  uint64_t  (*position)( void );
+
+  // Очередь дескрипторов заданий (образы с DST40_CAPS_QUEUE; NULL -
+  // исполнитель её не знает). push() вместо load() и start(): первый
+  // push() после stop() включает очередь, и дальше FPGA сама запускает
+  // задания одно за другим. Задание из очереди - одна метка; оно
+  // заканчивается, только когда перебраны все его ключи, - найденный
+  // ключ его не останавливает. Задания нумеруются с нуля от включения
+  // очереди, номер задания найденного ключа - в DST40_RESULT.job.
+  // stop() выключает очередь, выбрасывая задания, которые ещё не начаты.
+  // position(), cycles() и perf() относятся к выполняемому заданию.
+  // Флаг DONE задания очереди держится один такт, поэтому wait() в этом
+  // режиме вызывается с ограничением времени, а окончание заданий
+  // узнаётся по completed().
+
+  bool      (*push)( const DST40_JOB * );                       // Положить задание в очередь (false - очередь заполнена)
+  uint32_t  (*completed)( void );                               // Количество выполненных заданий: все ключи этих заданий
+                                                                // уже в FIFO, как ключи до position() - DST40_LAG
+} DST40_BACKEND;
+
+
+// Отставание проверки от счётчика перебора: 64 такта конвеера плюс
+// кандидаты, ждущие проверки на второй паре (с запасом)
+
+#define DST40_LAG         0x1000
+
+
+extern const DST40_BACKEND backendMmap;
+extern const DST40_BACKEND backendSim;
+extern const DST40_BACKEND backendNull;
+
+const DST40_BACKEND *backendByName( const char * );
+bool backendCaps( uint64_t, uint64_t );
+void backendKernels( uint32_t );
+void backendRing( uint32_t, uint32_t );
+void backendInterleave( bool );
+bool backendMask( uint64_t, uint64_t );
+uint64_t backendIndex( uint64_t );
+uint64_t backendKey( uint64_t, uint32_t );
+uint64_t backendDeposit( uint64_t, uint64_t );
+uint64_t backendExtract( uint64_t, uint64_t );
+
+
+#endif /* BACKEND_H_ */
@@ -0,0 +1,287 @@
+/******************************************************************************
+ *
+ * Битслайсовый движок DST40 с выбором реализации во время выполнения.
+ *
+ * Реализации:
+ *
+ * u64    -  64 ключа за вызов, переносимая (любой процессор),
+ * sse2   - 128 ключей за вызов, x86/x86-64,
+ * avx2   - 256 ключей за вызов, x86/x86-64,
+ * avx512 - 512 ключей за вызов, x86-64 (AVX-512F),
+ * neon   - 128 ключей за вызов, ARM (Cortex-A9 в HPS).
+ *
+ * Все реализации собираются из одного шаблона bitslice_impl.h
+ * на векторных расширениях GCC, набор инструкций для каждой задаётся
+ * через #pragma GCC target, поэтому отдельные ключи компиляции
+ * для файлов не нужны. NEON-реализация собирается, только если
+ * компилятор запущен с -mfpu=neon.
+ *
+ * dst40engine() возвращает самую быструю реализацию, поддерживаемую
+ * процессором. Реализацию можно выбрать явно через переменную окружения
+ * DST40_ENGINE (например DST40_ENGINE=sse2).
+ *
+ *****************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "bitslice.h"
+
+#if defined(__arm__) && ( defined(__ARM_NEON__) || defined(__ARM_NEON) )
+  #define BS_HAVE_NEON
+  #include <sys/auxv.h>
+  #include <asm/hwcap.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+  #define BS_HAVE_X86
+
+  #if __GNUC__ >= 5                                             // AVX-512 в #pragma target и __builtin_cpu_supports - начиная с GCC 5
+    #define BS_HAVE_AVX512
+  #endif
+#endif
+
+
+// Таблицы истинности функций Fa..Fh (бит n - значение функции на входе n)
+
+#define BS_FA   0xB58C13DA
+#define BS_FB   0x606FF606
+#define BS_FC   0xAA3C1D74
+#define BS_FD   0x3A5C5C3A
+#define BS_FE   0x53CA
+#define BS_FG   0x724E
+#define BS_FH0  0x1DB8                                          // Fh, младший бит
+#define BS_FH1  0x3A5C                                          // Fh, старший бит
+
+
+
+//#############################################################################
+// РЕАЛИЗАЦИИ
+
+//-----------------------------------------------------------------------------
+// u64 - переносимая
+
+#define BS_T        uint64_t
+#define BS_WORDS    1
+#define BS_LOG2     6
+#define BS_FN(x)    x##_u64
+
+#include "bitslice_impl.h"
+
+#undef BS_T
+#undef BS_WORDS
+#undef BS_LOG2
+#undef BS_FN
+
+static int supported_u64( void )
+{
+  return 1;
+}
+
+
+//-----------------------------------------------------------------------------
+// sse2
+
+#ifdef BS_HAVE_X86
+
+#pragma GCC push_options
+#pragma GCC target("sse2")
+
+typedef uint64_t V128_SSE2 __attribute__((vector_size(16)));
+
+#define BS_T        V128_SSE2
+#define BS_WORDS    2
+#define BS_LOG2     7
+#define BS_FN(x)    x##_sse2
+
+#include "bitslice_impl.h"
+
+#undef BS_T
+#undef BS_WORDS
+#undef BS_LOG2
+#undef BS_FN
+
+#pragma GCC pop_options
+
+static int supported_sse2( void )
+{
+  return __builtin_cpu_supports( "sse2" );
+}
+
+
+//-----------------------------------------------------------------------------
+// avx2
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+typedef uint64_t V256_AVX2 __attribute__((vector_size(32)));
+
+#define BS_T        V256_AVX2
+#define BS_WORDS    4
+#define BS_LOG2     8
+#define BS_FN(x)    x##_avx2
+
+#include "bitslice_impl.h"
+
+#undef BS_T
+#undef BS_WORDS
+#undef BS_LOG2
+#undef BS_FN
+
+#pragma GCC pop_options
+
+static int supported_avx2( void )
+{
+  return __builtin_cpu_supports( "avx2" );
+}
+
+#endif
+
+
+//-----------------------------------------------------------------------------
+// avx512
+
+#ifdef BS_HAVE_AVX512
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+
+typedef uint64_t V512_AVX512 __attribute__((vector_size(64)));
+
+#define BS_T        V512_AVX512
+#define BS_WORDS    8
+#define BS_LOG2     9
+#define BS_FN(x)    x##_avx512
+
+#include "bitslice_impl.h"
+
+#undef BS_T
+#undef BS_WORDS
+#undef BS_LOG2
+#undef BS_FN
+
+#pragma GCC pop_options
+
+static int supported_avx512( void )
+{
+  return __builtin_cpu_supports( "avx512f" );
+}
+
+#endif
+
+
+//-----------------------------------------------------------------------------
+// neon
+
+#ifdef BS_HAVE_NEON
+
+typedef uint64_t V128_NEON __attribute__((vector_size(16)));
+
+#define BS_T        V128_NEON
+#define BS_WORDS    2
+#define BS_LOG2     7
+#define BS_FN(x)    x##_neon
+
+#include "bitslice_impl.h"
+
+#undef BS_T
+#undef BS_WORDS
+#undef BS_LOG2
+#undef BS_FN
+
+static int supported_neon( void )
+{
+  return ( getauxval( AT_HWCAP ) & HWCAP_NEON ) != 0;
+}
+
+#endif
+
+
+
+//#############################################################################
+// ТАБЛИЦА РЕАЛИЗАЦИЙ
+//
+// Упорядочена от самой быстрой к самой медленной.
+
+static const DST40_ENGINE _engines[] =
+{
+#ifdef BS_HAVE_AVX512
+  { "avx512", 512, hash_avx512, search_avx512, supported_avx512 },
+#endif
+#ifdef BS_HAVE_X86
+  { "avx2",   256, hash_avx2,   search_avx2,   supported_avx2   },
+  { "sse2",   128, hash_sse2,   search_sse2,   supported_sse2   },
+#endif
+#ifdef BS_HAVE_NEON
+  { "neon",   128, hash_neon,   search_neon,   supported_neon   },
+#endif
+  { "u64",     64, hash_u64,    search_u64,    supported_u64    }
+};
+
+#define ENGINES_COUNT ( sizeof(_engines) / sizeof(_engines[0]) )
+
+
+
+/******************************************************************************
+ * Перебор реализаций, собранных в программу (в том числе не поддерживаемых
+ * текущим процессором).
+ *
+ * Вход:  n - номер реализации.
+ * Выход: Указатель на описатель или NULL, если n за пределами списка.
+ *****************************************************************************/
+
+const DST40_ENGINE *dst40engineList( uint32_t n )
+{
+  return ( n < ENGINES_COUNT ) ? &_engines[n] : NULL;
+}
+
+
+
+/******************************************************************************
+ * Поиск реализации по названию.
+ *
+ * Выход: Указатель на описатель или NULL, если реализация с таким
+ *        названием не собрана или не поддерживается процессором.
+ *****************************************************************************/
+
+const DST40_ENGINE *dst40engineByName( const char *name )
+{
+  uint32_t i;
+
+  for( i=0; i < ENGINES_COUNT; i++ )
+    if( !strcmp( _engines[i].name, name ) )
+      return _engines[i].supported() ? &_engines[i] : NULL;
+
+  return NULL;
+}
+
+
+
+/******************************************************************************
+ * Выбор самой быстрой реализации, поддерживаемой процессором.
+ *
+ * Если задана переменная окружения DST40_ENGINE и реализация с таким
+ * названием доступна - возвращается она.
+ *****************************************************************************/
+
+const DST40_ENGINE *dst40engine( void )
+{
+  static const DST40_ENGINE *best = NULL;
+
+  uint32_t    i;
+  const char *env;
+
+  if( best )
+    return best;
+
+  if( ( env = getenv( "DST40_ENGINE" ) ) != NULL && ( best = dst40engineByName( env ) ) != NULL )
+    return best;
+
+  for( i=0; i < ENGINES_COUNT; i++ )
+    if( _engines[i].supported() )
+      return ( best = &_engines[i] );
+
+  return ( best = &_engines[ENGINES_COUNT-1] );
+}
@@ -0,0 +1,47 @@
+#ifndef BITSLICE_H_
+#define BITSLICE_H_
+
+#include <stdint.h>
+#include "keysched.h"
+
+
+// Максимальное количество ключей, обрабатываемых реализацией за один вызов
+// (AVX-512: 512 бит в векторе).
+
+#define BS_MAX_LANES  512
+
+
+// Описатель одной реализации битслайсового движка DST40.
+//
+// Все реализации дают результат, побитно совпадающий с dst40hash().
+// Реализация обрабатывает lanes ключей за вызов - по одному ключу
+// на каждый бит машинного слова (uint64, SSE2, AVX2, AVX-512, NEON).
+
+typedef struct
+{
+  const char *name;                                             // Название реализации ("u64", "sse2", "avx2", "avx512", "neon")
+  uint32_t    lanes;                                            // Количество ключей, обрабатываемых за один вызов
+
+  // Хэширование lanes произвольных пар запрос/ключ:
+  // response[i] = dst40hash( challenge[i], key[i] ).
+
+  void      (*hash)( const uint64_t *challenge, const uint64_t *key, uint64_t *response );
+
+  // Проверка lanes последовательных ключей key, key+1, ... key+lanes-1
+  // (key = ks->key кратен lanes) на одной паре запрос/ответ.
+  // Расписание ключа берётся из ks - при переборе оно обновляется
+  // keyschedSet(), а не считается заново.
+  // Подходящие ключи записываются в found, возвращается их количество.
+
+  uint32_t  (*search)( uint64_t challenge, uint64_t response, const DST40_KEYSCHED *ks, uint64_t *found );
+
+  int       (*supported)( void );                               // Проверка поддержки реализации текущим процессором (1 - поддерживается)
+} DST40_ENGINE;
+
+
+const DST40_ENGINE *dst40engine( void );
+const DST40_ENGINE *dst40engineByName( const char * );
+const DST40_ENGINE *dst40engineList( uint32_t );
+
+
+#endif /* BITSLICE_H_ */
@@ -0,0 +1,337 @@
+/******************************************************************************
+ *
+ * Шаблон битслайсовой реализации DST40.
+ *
+ * Файл включается в bitslice.c несколько раз - по разу на каждый тип
+ * машинного слова. Перед включением должны быть определены:
+ *
+ * BS_T      - тип слова (uint64_t или векторный тип GCC),
+ * BS_WORDS  - количество 64-битных слов в BS_T,
+ * BS_LOG2   - логарифм по основанию 2 от количества бит в BS_T,
+ * BS_FN(x)  - макрос, добавляющий к имени функции суффикс реализации.
+ *
+ * Битслайсовое представление: 40 бит хэша и 40 бит ключа хранятся
+ * в 40+40 словах BS_T, бит i ключа номер j лежит в бите j слова i.
+ * Все функции Fa..Fh вычисляются логическими операциями над словами,
+ * поэтому за один проход обрабатывается 64*BS_WORDS ключей.
+ *
+ * Сдвиги хэша и ключа выполняются без копирования: хэш лежит
+ * в массиве H[40+2*192] и на раунде i начинается с H[2*i], ключ лежит
+ * в массиве K[40+64] и после s сдвигов РСЛОС начинается с K[s].
+ * Новые биты дописываются в конец текущего окна.
+ *
+ * При переборе последовательных ключей (search) все 104 бита расписания
+ * заполняются заранее, и РСЛОС в цикле раундов не считается: вдвигаемые
+ * биты линейны по ключу, поэтому они равны XOR битов расписания общей
+ * для всех ключей старшей части (ks->ext) и постоянного для реализации
+ * вклада номера ключа в слове (kpat).
+ *
+ *****************************************************************************/
+
+#define BS_ZERO     ( (BS_T){ 0 } )
+#define BS_ONES     ( ~BS_ZERO )
+#define BS_INLINE   static inline __attribute__((always_inline))
+
+
+/******************************************************************************
+ * Табличные функции от 1..5 переменных.
+ *
+ * Вход: t - таблица истинности (бит n - значение функции на входе n),
+ *       xN..x0 - битслайсовые переменные (x0 - младший бит индекса).
+ *
+ * Таблицы Fa..Fh - константы, поэтому после встраивания компилятор
+ * сворачивает мультиплексоры с одинаковыми или константными плечами.
+ *****************************************************************************/
+
+BS_INLINE BS_T BS_FN(mux)( BS_T s, BS_T a, BS_T b )
+{
+  return a ^ ( ( a ^ b ) & s );                                 // s ? b : a
+}
+
+BS_INLINE BS_T BS_FN(lut1)( uint32_t t, BS_T x0 )
+{
+  BS_T r = ( t & 1 ) ? BS_ONES : BS_ZERO;
+
+  if( ( t ^ ( t >> 1 ) ) & 1 )
+    r ^= x0;
+
+  return r;
+}
+
+BS_INLINE BS_T BS_FN(lut2)( uint32_t t, BS_T x1, BS_T x0 )
+{
+  if( ( t & 0x3 ) == ( ( t >> 2 ) & 0x3 ) )
+    return BS_FN(lut1)( t & 0x3, x0 );
+
+  return BS_FN(mux)( x1, BS_FN(lut1)( t & 0x3, x0 ), BS_FN(lut1)( ( t >> 2 ) & 0x3, x0 ) );
+}
+
+BS_INLINE BS_T BS_FN(lut3)( uint32_t t, BS_T x2, BS_T x1, BS_T x0 )
+{
+  if( ( t & 0xF ) == ( ( t >> 4 ) & 0xF ) )
+    return BS_FN(lut2)( t & 0xF, x1, x0 );
+
+  return BS_FN(mux)( x2, BS_FN(lut2)( t & 0xF, x1, x0 ), BS_FN(lut2)( ( t >> 4 ) & 0xF, x1, x0 ) );
+}
+
+BS_INLINE BS_T BS_FN(lut4)( uint32_t t, BS_T x3, BS_T x2, BS_T x1, BS_T x0 )
+{
+  if( ( t & 0xFF ) == ( ( t >> 8 ) & 0xFF ) )
+    return BS_FN(lut3)( t & 0xFF, x2, x1, x0 );
+
+  return BS_FN(mux)( x3, BS_FN(lut3)( t & 0xFF, x2, x1, x0 ), BS_FN(lut3)( ( t >> 8 ) & 0xFF, x2, x1, x0 ) );
+}
+
+BS_INLINE BS_T BS_FN(lut5)( uint32_t t, BS_T x4, BS_T x3, BS_T x2, BS_T x1, BS_T x0 )
+{
+  return BS_FN(mux)( x4, BS_FN(lut4)( t & 0xFFFF, x3, x2, x1, x0 ), BS_FN(lut4)( t >> 16, x3, x2, x1, x0 ) );
+}
+
+
+/******************************************************************************
+ * Один раунд DST40 - битслайсовый аналог block192().
+ *
+ * Вход: h - окно хэша (h[0..39]), k - окно ключа (k[0..39]).
+ * Выход: два новых старших бита хэша записываются в h[40] и h[41].
+ *****************************************************************************/
+
+BS_INLINE void BS_FN(round)( BS_T *h, const BS_T *k )
+{
+  BS_T fa1  = BS_FN(lut5)( BS_FA, k[39], k[31], h[39], h[31], h[23] );
+  BS_T fb2  = BS_FN(lut5)( BS_FB, k[38], k[30], h[38], h[30], h[22] );
+  BS_T fc3  = BS_FN(lut5)( BS_FC, k[23], k[15], k[7],  h[15], h[7]  );
+  BS_T fd4  = BS_FN(lut5)( BS_FD, k[22], k[14], k[6],  h[14], h[6]  );
+
+  BS_T fa5  = BS_FN(lut5)( BS_FA, k[37], k[29], h[37], h[29], h[21] );
+  BS_T fb6  = BS_FN(lut5)( BS_FB, k[36], k[28], h[36], h[28], h[20] );
+  BS_T fc7  = BS_FN(lut5)( BS_FC, k[21], k[13], k[5],  h[13], h[5]  );
+  BS_T fd8  = BS_FN(lut5)( BS_FD, k[20], k[12], k[4],  h[12], h[4]  );
+
+  BS_T fa9  = BS_FN(lut5)( BS_FA, k[35], k[27], h[35], h[27], h[19] );
+  BS_T fb10 = BS_FN(lut5)( BS_FB, k[34], k[26], h[34], h[26], h[18] );
+  BS_T fc11 = BS_FN(lut5)( BS_FC, k[19], k[11], k[3],  h[11], h[3]  );
+  BS_T fd12 = BS_FN(lut5)( BS_FD, k[18], k[10], k[2],  h[10], h[2]  );
+
+  BS_T fa13 = BS_FN(lut5)( BS_FA, k[33], k[25], h[33], h[25], h[17] );
+  BS_T fb14 = BS_FN(lut5)( BS_FB, k[32], k[24], h[32], h[24], h[16] );
+  BS_T fe15 = BS_FN(lut4)( BS_FE, k[17], k[9],  k[1],  h[9]  );
+  BS_T fe16 = BS_FN(lut4)( BS_FE, k[16], k[8],  k[0],  h[8]  );
+
+  BS_T fg1  = BS_FN(lut4)( BS_FG, fa1,  fb2,  fc3,  fd4  );
+  BS_T fg2  = BS_FN(lut4)( BS_FG, fa5,  fb6,  fc7,  fd8  );
+  BS_T fg3  = BS_FN(lut4)( BS_FG, fa9,  fb10, fc11, fd12 );
+  BS_T fg4  = BS_FN(lut4)( BS_FG, fa13, fb14, fe15, fe16 );
+
+  h[40] = BS_FN(lut4)( BS_FH0, fg1, fg2, fg3, fg4 ) ^ h[0];
+  h[41] = BS_FN(lut4)( BS_FH1, fg1, fg2, fg3, fg4 ) ^ h[1];
+}
+
+
+/******************************************************************************
+ * Полный цикл хэширования - 192 раунда.
+ *
+ * Вход:  H[0..39] - запросы, K[0..39] - ключи.
+ * Выход: H[384..423] - итоговые хэши (ответ - биты 16..39).
+ *****************************************************************************/
+
+static void BS_FN(core)( BS_T *H, BS_T *K, int lfsr )
+{
+  uint32_t i;
+  uint32_t cnt;
+  uint32_t s = 0;
+
+  for( i=0, cnt=0; i < 192; i++ )
+  {
+    BS_FN(round)( H + 2*i, K + s );
+
+    if( cnt == 1 )                                              // Сдвиг РСЛОС ключа - каждый третий раунд
+    {
+      if( lfsr )                                                // Иначе K[40..103] уже заполнены
+        K[s+40] = K[s] ^ K[s+2] ^ K[s+19] ^ K[s+21];
+      s++;
+    }
+
+    if( ++cnt == 3 )
+      cnt = 0;
+  }
+}
+
+
+/******************************************************************************
+ * Транспонирование: bits бит из каждого из 64*BS_WORDS чисел src
+ * в битслайсовые слова dst[0..bits-1].
+ *****************************************************************************/
+
+static void BS_FN(load)( BS_T *dst, const uint64_t *src, uint32_t bits )
+{
+  uint32_t b, w, j;
+  uint64_t tmp[BS_WORDS];
+
+  for( b=0; b < bits; b++ )
+  {
+    for( w=0; w < BS_WORDS; w++ )
+    {
+      uint64_t v = 0;
+
+      for( j=0; j < 64; j++ )
+        v |= ( ( src[w*64+j] >> b ) & 1 ) << j;
+
+      tmp[w] = v;
+    }
+
+    memcpy( &dst[b], tmp, sizeof(tmp) );
+  }
+}
+
+
+/******************************************************************************
+ * Обратное транспонирование: bits бит из слов src[0..bits-1]
+ * в 64*BS_WORDS чисел dst.
+ *****************************************************************************/
+
+static void BS_FN(store)( uint64_t *dst, const BS_T *src, uint32_t bits )
+{
+  uint32_t b, w, j;
+  uint64_t tmp[BS_WORDS];
+
+  for( j=0; j < 64*BS_WORDS; j++ )
+    dst[j] = 0;
+
+  for( b=0; b < bits; b++ )
+  {
+    memcpy( tmp, &src[b], sizeof(tmp) );
+
+    for( w=0; w < BS_WORDS; w++ )
+      for( j=0; j < 64; j++ )
+        dst[w*64+j] |= ( ( tmp[w] >> j ) & 1 ) << b;
+  }
+}
+
+
+/******************************************************************************
+ * Хэширование 64*BS_WORDS произвольных пар запрос/ключ.
+ *****************************************************************************/
+
+static void BS_FN(hash)( const uint64_t *challenge, const uint64_t *key, uint64_t *response )
+{
+  BS_T H[40+2*192];
+  BS_T K[40+64];
+
+  BS_FN(load)( H, challenge, 40 );
+  BS_FN(load)( K, key, 40 );
+
+  BS_FN(core)( H, K, 1 );
+
+  BS_FN(store)( response, H + 2*192 + 16, 24 );
+}
+
+
+/******************************************************************************
+ * Расписание номеров ключей в слове (старшие биты ключа - 0) для search.
+ *
+ * Одинаково во всех потоках и строится один раз через pthread_once():
+ * search вызывают сразу несколько потоков, а проверка флага без барьера
+ * на чтение не гарантирует, что на ARM видны и сами данные.
+ *****************************************************************************/
+
+static BS_T           BS_FN(kpat)[40+64];
+static pthread_once_t BS_FN(kpat_once) = PTHREAD_ONCE_INIT;
+
+static void BS_FN(kpatBuild)( void )
+{
+  static const uint64_t lane_bits[6] =                          // Номера ключей внутри 64-битного слова
+  {
+    0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+  };
+
+  BS_T    *kpat = BS_FN(kpat);
+  uint64_t tmp[BS_WORDS];
+  uint32_t b, w;
+
+  for( b=0; b < 40; b++ )
+  {
+    if( b < 6 )
+    {
+      for( w=0; w < BS_WORDS; w++ )
+        tmp[w] = lane_bits[b];
+
+      memcpy( &kpat[b], tmp, sizeof(tmp) );
+    }
+    else if( b < BS_LOG2 )
+    {
+      for( w=0; w < BS_WORDS; w++ )
+        tmp[w] = ( ( w >> ( b - 6 ) ) & 1 ) ? ~0ULL : 0;
+
+      memcpy( &kpat[b], tmp, sizeof(tmp) );
+    }
+    else
+      kpat[b] = BS_ZERO;
+  }
+
+  for( b=0; b < 64; b++ )
+    kpat[b+40] = kpat[b] ^ kpat[b+2] ^ kpat[b+19] ^ kpat[b+21];
+}
+
+
+
+/******************************************************************************
+ * Проверка 64*BS_WORDS последовательных ключей на одной паре запрос/ответ.
+ *
+ * Младшие BS_LOG2 бит ключа задаются номером бита в слове, остальные
+ * биты одинаковы для всех ключей и берутся из ks->key, поэтому
+ * транспонирование не требуется.
+ *****************************************************************************/
+
+static uint32_t BS_FN(search)( uint64_t challenge, uint64_t response, const DST40_KEYSCHED *ks, uint64_t *found )
+{
+  const BS_T *kpat = BS_FN(kpat);
+
+  BS_T H[40+2*192];
+  BS_T K[40+64];
+  BS_T match = BS_ONES;
+
+  uint64_t key = ks->key;
+  uint64_t tmp[BS_WORDS];
+  uint32_t b, w;
+  uint32_t cnt = 0;
+
+  pthread_once( &BS_FN(kpat_once), BS_FN(kpatBuild) );
+
+  for( b=0; b < 40; b++ )
+  {
+    H[b] = ( ( challenge >> b ) & 1 ) ? BS_ONES : BS_ZERO;
+    K[b] = ( b < BS_LOG2 ) ? kpat[b] : ( ( ( key >> b ) & 1 ) ? BS_ONES : BS_ZERO );
+  }
+
+  for( b=0; b < 64; b++ )                                       // Расписание: вклад номера ключа XOR вклад старшей части
+    K[b+40] = ( ( ks->ext >> b ) & 1 ) ? ~kpat[b+40] : kpat[b+40];
+
+  BS_FN(core)( H, K, 0 );
+
+  for( b=0; b < 24; b++ )                                       // Сравниваем 24 бита ответа
+  {
+    if( ( response >> b ) & 1 )
+      match &= H[2*192+16+b];
+    else
+      match &= ~H[2*192+16+b];
+  }
+
+  memcpy( tmp, &match, sizeof(tmp) );
+
+  for( w=0; w < BS_WORDS; w++ )
+  {
+    while( tmp[w] )
+    {
+      found[cnt++] = key + w*64 + __builtin_ctzll( tmp[w] );
+      tmp[w] &= tmp[w] - 1;
+    }
+  }
+
+  return cnt;
+}
+
+
+#undef BS_ZERO
+#undef BS_ONES
+#undef BS_INLINE
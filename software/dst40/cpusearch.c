@@ -0,0 +1,339 @@
+/******************************************************************************
+ *
+ * Программный поиск ключа DST40 на всех ядрах процессора - без FPGA.
+ *
+ * Диапазон ключей [start_key, end_key) делится поровну между потоками.
+ * Каждый поток берёт из своего диапазона порции по CPU_CHUNK ключей
+ * и проверяет их битслайсовым движком (bitslice.c) на первой паре
+ * запрос/ответ. Расписание ключей при переходе к следующей группе
+ * ключей не считается заново, а исправляется (keysched.c).
+ * Поток, у которого диапазон закончился, отбирает
+ * у самого загруженного потока верхнюю половину оставшегося диапазона
+ * (work stealing), поэтому все ядра заняты до самого конца перебора.
+ *
+ * Каждый ключ, подошедший к первой паре, проверяется на второй паре -
+ * так же, как это делает программа при поиске на FPGA. Ключ, подошедший
+ * к обеим парам, считается найденным, и все потоки останавливаются.
+ *
+ *****************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include "dst40hash.h"
+#include "keysched.h"
+#include "bitslice.h"
+#include "cpusearch.h"
+
+
+//#############################################################################
+// ОПРЕДЕЛЕНИЯ
+
+#define CPU_CHUNK         0x10000ULL                            // Порция ключей, выдаваемая потоку за раз (кратна BS_MAX_LANES)
+#define CPU_MAX_THREADS   256                                   // Максимальное количество потоков
+
+// Состояние одного потока
+
+typedef struct
+{
+  pthread_t       thread;
+  pthread_mutex_t lock;                                         // Защищает pos и end
+  uint64_t        pos;                                          // Следующий непроверенный ключ
+  uint64_t        end;                                          // Конец диапазона потока (не включительно)
+} CPU_WORKER;
+
+
+
+//#############################################################################
+// ГЛОБАЛЬНЫЕ ПЕРЕМЕННЫЕ
+
+static struct
+{
+  uint64_t            c1, r1, c2, r2;                           // Пары запрос/ответ
+  const DST40_ENGINE *engine;                                   // Битслайсовый движок
+  uint32_t            threads;                                  // Количество потоков
+
+  CPU_WORKER          workers[CPU_MAX_THREADS];
+
+  volatile uint64_t   done;                                     // Количество проверенных ключей
+  volatile uint32_t   finished;                                 // Количество завершившихся потоков
+  volatile bool       found;                                    // Флаг "ключ найден" - останавливает все потоки
+  uint64_t            key;                                      // Найденный ключ
+  pthread_mutex_t     found_lock;
+} _cpu;
+
+
+
+/******************************************************************************
+ * Количество потоков по умолчанию - по числу ядер процессора.
+ *****************************************************************************/
+
+uint32_t cpuThreads( void )
+{
+  long n = sysconf( _SC_NPROCESSORS_ONLN );
+
+  if( n < 1 )
+    return 1;
+
+  return ( n > CPU_MAX_THREADS ) ? CPU_MAX_THREADS : (uint32_t)n;
+}
+
+
+
+/******************************************************************************
+ * Отбор работы у самого загруженного потока.
+ *
+ * Вход:  self - поток, у которого закончился свой диапазон.
+ * Выход: true - self получил новый диапазон,
+ *        false - отбирать нечего (у всех осталось меньше двух порций).
+ *****************************************************************************/
+
+static bool cpuSteal( CPU_WORKER *self )
+{
+  CPU_WORKER *victim = NULL;
+  uint64_t    max_rest = 0;
+  uint64_t    rest, mid, end;
+  uint32_t    i;
+
+  for( i=0; i < _cpu.threads; i++ )                             // Ищем поток с самым большим остатком
+  {
+    CPU_WORKER *w = &_cpu.workers[i];
+
+    if( w == self )
+      continue;
+
+    pthread_mutex_lock( &w->lock );
+    rest = w->end - w->pos;
+    pthread_mutex_unlock( &w->lock );
+
+    if( rest > max_rest )
+    {
+      max_rest = rest;
+      victim = w;
+    }
+  }
+
+  if( !victim )
+    return false;
+
+  pthread_mutex_lock( &victim->lock );                          // Пока мы искали, остаток мог уменьшиться -
+                                                                // проверяем ещё раз под блокировкой
+  rest = victim->end - victim->pos;
+
+  if( rest < 2 * CPU_CHUNK )
+  {
+    pthread_mutex_unlock( &victim->lock );
+    return false;
+  }
+
+  mid = ( victim->pos + rest / 2 ) & ~( CPU_CHUNK - 1 );        // Отбираем верхнюю половину по границе порции
+  end = victim->end;
+  victim->end = mid;
+
+  pthread_mutex_unlock( &victim->lock );
+
+  pthread_mutex_lock( &self->lock );
+  self->pos = mid;
+  self->end = end;
+  pthread_mutex_unlock( &self->lock );
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * Получение очередной порции ключей [from, to).
+ *
+ * Выход: false - работы больше нет.
+ *****************************************************************************/
+
+static bool cpuTakeChunk( CPU_WORKER *w, uint64_t *from, uint64_t *to )
+{
+  while( 1 )
+  {
+    pthread_mutex_lock( &w->lock );
+
+    if( w->pos < w->end )
+    {
+      *from = w->pos;
+      *to   = ( w->pos & ~( CPU_CHUNK - 1 ) ) + CPU_CHUNK;      // Порции выровнены по CPU_CHUNK
+
+      if( *to > w->end )
+        *to = w->end;
+
+      w->pos = *to;
+      pthread_mutex_unlock( &w->lock );
+      return true;
+    }
+
+    pthread_mutex_unlock( &w->lock );
+
+    if( !cpuSteal( w ) )
+      return false;
+  }
+}
+
+
+
+/******************************************************************************
+ * Регистрация ключа, подошедшего к обеим парам запрос/ответ.
+ *
+ * Если ключи нашлись сразу в нескольких потоках - запоминаем меньший.
+ *****************************************************************************/
+
+static void cpuKeyFound( uint64_t key )
+{
+  pthread_mutex_lock( &_cpu.found_lock );
+
+  if( !_cpu.found || key < _cpu.key )
+    _cpu.key = key;
+
+  _cpu.found = true;
+
+  pthread_mutex_unlock( &_cpu.found_lock );
+}
+
+
+
+/******************************************************************************
+ * Рабочий поток.
+ *****************************************************************************/
+
+static void *cpuWorker( void *arg )
+{
+  CPU_WORKER *w = (CPU_WORKER *)arg;
+  uint64_t    lanes = _cpu.engine->lanes;
+  uint64_t    found[BS_MAX_LANES];
+  uint64_t    from, to, base;
+  uint32_t    i, n;
+  DST40_KEYSCHED ks;
+
+  keyschedInit( &ks, 0 );
+
+  while( !_cpu.found && cpuTakeChunk( w, &from, &to ) )
+  {
+    for( base = from & ~( lanes - 1 ); base < to && !_cpu.found; base += lanes )
+    {
+      keyschedSet( &ks, base );                                 // Поправка расписания предыдущего ключа
+
+      n = _cpu.engine->search( _cpu.c1, _cpu.r1, &ks, found );
+
+      for( i=0; i < n; i++ )
+      {
+        if( found[i] < from || found[i] >= to )                 // Края порции могут быть не выровнены
+          continue;                                             // по количеству ключей в движке
+
+        if( dst40hash( _cpu.c2, found[i] ) == _cpu.r2 )         // Проверка на второй паре запрос/ответ
+          cpuKeyFound( found[i] );
+      }
+    }
+
+    __sync_fetch_and_add( &_cpu.done, to - from );
+  }
+
+  __sync_fetch_and_add( &_cpu.finished, 1 );
+
+  return NULL;
+}
+
+
+
+/******************************************************************************
+ * Поиск ключа на процессоре.
+ *
+ * Вход:  c1, r1     - первая пара запрос/ответ,
+ *        c2, r2     - вторая пара запрос/ответ,
+ *        start_key  - ключ, с которого начинать поиск,
+ *        end_key    - ключ, на котором закончить поиск (не включительно),
+ *        threads    - количество потоков (0 - по числу ядер),
+ *        progress   - функция вывода прогресса (может быть NULL).
+ *
+ * Выход: true - ключ найден и записан в *key,
+ *        false - все ключи перебраны, ключ не найден.
+ *****************************************************************************/
+
+bool cpuSearch( uint64_t c1, uint64_t r1, uint64_t c2, uint64_t r2,
+                uint64_t start_key, uint64_t end_key, uint32_t threads,
+                CPU_PROGRESS progress, uint64_t *key )
+{
+  uint64_t total, part;
+  uint32_t i, ticks;
+
+  if( !threads )
+    threads = cpuThreads();
+
+  if( threads > CPU_MAX_THREADS )
+    threads = CPU_MAX_THREADS;
+
+  if( end_key <= start_key )
+    return false;
+
+  _cpu.c1       = c1;
+  _cpu.r1       = r1;
+  _cpu.c2       = c2;
+  _cpu.r2       = r2;
+  _cpu.engine   = dst40engine();
+  _cpu.threads  = threads;
+  _cpu.done     = 0;
+  _cpu.finished = 0;
+  _cpu.found    = false;
+  _cpu.key      = 0;
+
+  pthread_mutex_init( &_cpu.found_lock, NULL );
+
+  // Делим диапазон поровну между потоками по границам порций
+
+  total = end_key - start_key;
+  part  = ( ( total / threads ) + CPU_CHUNK - 1 ) & ~( CPU_CHUNK - 1 );
+
+  for( i=0; i < threads; i++ )
+  {
+    CPU_WORKER *w = &_cpu.workers[i];
+
+    w->pos = start_key + part * i;
+    w->end = w->pos + part;
+
+    if( w->pos > end_key )
+      w->pos = end_key;
+
+    if( w->end > end_key || i == threads - 1 )                  // Последнему потоку - остаток до конца
+      w->end = end_key;
+
+    pthread_mutex_init( &w->lock, NULL );
+  }
+
+  for( i=0; i < threads; i++ )
+    pthread_create( &_cpu.workers[i].thread, NULL, cpuWorker, &_cpu.workers[i] );
+
+  // Ждём завершения всех потоков, раз в секунду выводим прогресс
+
+  for( ticks=0; _cpu.finished < threads; ticks++ )
+  {
+    struct timespec ts = { 0, 100000000 };                      // 100 мс
+
+    nanosleep( &ts, NULL );
+
+    if( progress && ticks % 10 == 9 )
+      progress( _cpu.done, total );
+  }
+
+  for( i=0; i < threads; i++ )
+  {
+    pthread_join( _cpu.workers[i].thread, NULL );
+    pthread_mutex_destroy( &_cpu.workers[i].lock );
+  }
+
+  pthread_mutex_destroy( &_cpu.found_lock );
+
+  if( progress )
+    progress( _cpu.found ? _cpu.done : total, total );
+
+  if( _cpu.found )
+    *key = _cpu.key;
+
+  return _cpu.found;
+}
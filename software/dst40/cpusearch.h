@@ -0,0 +1,21 @@
+#ifndef CPUSEARCH_H_
+#define CPUSEARCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// Функция вывода прогресса поиска: вызывается раз в секунду
+// из потока, запустившего поиск.
+//
+// done  - количество проверенных ключей,
+// total - общее количество ключей в диапазоне поиска.
+
+typedef void (*CPU_PROGRESS)( uint64_t done, uint64_t total );
+
+
+uint32_t cpuThreads( void );
+bool     cpuSearch( uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint32_t, CPU_PROGRESS, uint64_t * );
+
+
+#endif /* CPUSEARCH_H_ */
@@ -0,0 +1,823 @@
+/******************************************************************************
+ *
+ * Демон поиска ключей DST40: одна FPGA на несколько операторов.
+ *
+ * Демон (dst40 --daemon SOCKET) один раз подключается к FPGA и принимает
+ * задания клиентов (dst40 --submit SOCKET) через Unix-сокет. Задания
+ * выполняются по одному в порядке приоритета, при равном приоритете - в
+ * порядке поступления.
+ *
+ * Вытеснение: если пришло задание с приоритетом выше, чем у выполняемого,
+ * выполняемое останавливается (запись 0 в run), положение перебора
+ * запоминается по счётчику перебора и задание возвращается в очередь.
+ * Когда до него снова дойдёт очередь, перебор продолжится с запомненного
+ * места - загрузкой стартового ключа, как при продолжении по журналу.
+ *
+ * С образом, в котором есть очередь дескрипторов (DST40_CAPS_QUEUE),
+ * следующее задание кладётся в неё заранее, и FPGA переходит к нему
+ * сама, как только выполняемое закончится. Убрать задание из очереди
+ * FPGA можно, только выключив её, поэтому ключ, найденный в ещё идущем
+ * задании, срочное задание и отмена останавливают FPGA, а следующее
+ * задание возвращается в очередь демона.
+ *
+ * Протокол - текстовые строки, числа шестнадцатеричные:
+ *
+ *   клиент -> демон:
+ *     SUBMIT <приоритет> <c1> <r1> <c2> <r2> [start [end]] - новое задание
+ *     CANCEL <номер>                                       - отмена задания
+ *     STATUS                                               - состояние очереди
+ *
+ *   демон -> клиент:
+ *     QUEUED <номер>                 - задание принято
+ *     RESULT <строка результата>     - задание закончено (формат - как у --jobs)
+ *     JOB <номер> <приоритет> <состояние> <c1> <r1> <c2> <r2> <положение> <конец>
+ *     END                            - конец ответа на STATUS
+ *     ERROR <сообщение>
+ *
+ * Задания клиента, отключившегося до их окончания, отменяются.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "dst40hash.h"
+#include "netsearch.h"
+#include "daemon.h"
+
+
+//#############################################################################
+// ОПРЕДЕЛЕНИЯ
+
+#define DAEMON_MAX_CLIENTS  32                                  // Максимальное количество клиентов
+#define DAEMON_POLL_MS      100                                 // Период опроса FPGA во время поиска, мс
+
+// Задание в очереди демона
+
+typedef struct
+{
+  uint32_t id;                                                  // Номер задания
+  int32_t  priority;                                            // Приоритет (больше - срочнее)
+  int32_t  client;                                              // Клиент, приславший задание
+  bool     preempted;                                           // Задание уже выполнялось и было вытеснено
+
+  uint64_t c1, r1, c2, r2;                                      // Пары запрос/ответ
+  uint64_t start_key, end_key;                                  // Диапазон ключей, как его задал клиент
+  uint64_t pos, end;                                            // Младшие биты ключа: продолжать с pos, закончить на end
+  double   time;                                                // Время выполнения до вытеснения, с
+  bool     found;                                               // Ключ найден (задание очереди FPGA может ещё идти)
+  uint64_t key;                                                 // Найденный ключ
+} DAEMON_JOB;
+
+
+
+//#############################################################################
+// ГЛОБАЛЬНЫЕ ПЕРЕМЕННЫЕ
+
+static struct
+{
+  const DST40_BACKEND *backend;
+
+  NET_CONN        clients[DAEMON_MAX_CLIENTS];
+  uint32_t        last_id;                                      // Номер последнего принятого задания
+
+  DAEMON_JOB     *queue;                                        // Ожидающие задания
+  uint32_t        count;
+
+  DAEMON_JOB      current;                                      // Выполняемое задание
+  bool            running;
+  struct timeval  started;                                      // Время запуска выполняемого задания
+
+  bool            fpga_queue;                                   // Задания идут через очередь дескрипторов FPGA
+  DAEMON_JOB      next;                                         // Задание, положенное в очередь FPGA следом за выполняемым
+  bool            ahead;                                        // next лежит в очереди FPGA
+  uint32_t        number;                                       // Номер выполняемого задания в очереди FPGA
+} _daemon;
+
+
+
+/******************************************************************************
+ * Время в секундах, прошедшее с момента t.
+ *****************************************************************************/
+
+static double daemonSince( const struct timeval *t )
+{
+  struct timeval now;
+
+  gettimeofday( &now, NULL );
+
+  return ( now.tv_sec - t->tv_sec ) + ( now.tv_usec - t->tv_usec ) / 1e6;
+}
+
+
+
+/******************************************************************************
+ * Отправка результата задания клиенту (строка - в формате --jobs).
+ *
+ * Вход: job    - задание,
+ *       result - "found", "notfound" или "cancelled",
+ *       key    - найденный ключ.
+ *****************************************************************************/
+
+static void daemonResult( const DAEMON_JOB *job, const char *result, uint64_t key )
+{
+  NET_CONN *conn = &_daemon.clients[job->client];
+  char      key_text[16];
+
+  if( !strcmp( result, "found" ) )
+    sprintf( key_text, "%010llX", key );
+  else
+    strcpy( key_text, "-" );
+
+  printf( "\nJob %u: %s %s\n", job->id, result, key_text );
+
+  if( conn->fd >= 0 )
+    netSend( conn, "RESULT %u %010llX %06llX %010llX %06llX %010llX %010llX %s %s %.3f", job->id, job->c1, job->r1,
+             job->c2, job->r2, job->start_key, job->end_key, result, key_text, job->time );
+}
+
+
+
+/******************************************************************************
+ * Задание для FPGA: с места, до которого дошёл перебор.
+ *****************************************************************************/
+
+static void daemonDesc( const DAEMON_JOB *job, DST40_JOB *fpga )
+{
+  fpga->challenge  = job->c1;
+  fpga->challenge2 = job->c2;
+  fpga->start_key  = job->pos;
+  fpga->end_key    = ( job->end < DST40_KEYS ) ? job->end : 0;
+  fpga->response   = &job->r1;
+  fpga->response2  = &job->r2;
+  fpga->count      = 1;
+}
+
+
+
+/******************************************************************************
+ * Запуск задания на FPGA с места, до которого дошёл перебор.
+ *
+ * Очередь FPGA в этот момент выключена (поиск не идёт), и задание
+ * в ней получает номер 0.
+ *****************************************************************************/
+
+static void daemonStart( void )
+{
+  DAEMON_JOB *job = &_daemon.current;
+  DST40_JOB   fpga;
+
+  daemonDesc( job, &fpga );
+
+  if( _daemon.fpga_queue )
+  {
+    _daemon.backend->push( &fpga );
+    _daemon.number = 0;
+  }
+  else
+  {
+    _daemon.backend->load( &fpga );
+    _daemon.backend->start();
+  }
+
+  gettimeofday( &_daemon.started, NULL );
+  _daemon.running = true;
+
+  printf( "\nJob %u: %s from %010llX\n", job->id, job->preempted ? "resumed" : "started", job->pos );
+}
+
+
+
+/******************************************************************************
+ * Вычитывание FIFO выполняемого задания и следующего, если оно уже
+ * в очереди FPGA (ключ относится к заданию по номеру из FIFO).
+ *
+ * Подошедший ключ записывается в задание. Возвращает true, если найден
+ * ключ выполняемого задания.
+ *****************************************************************************/
+
+static bool daemonDrain( void )
+{
+  DAEMON_JOB  *job;
+  DST40_RESULT result;
+  uint64_t     key;
+  uint32_t     i;
+
+  while( _daemon.backend->result( &result ) )
+  {
+    job = ( _daemon.ahead && ( ( result.job - _daemon.number ) & 0xFFFF ) == 1 ) ? &_daemon.next : &_daemon.current;
+
+    for( i=0; i < DST40_NK; i++ )
+    {
+      key = backendKey( result.key, i );
+
+      if( !( ( result.kernels >> i ) & 1 ) )
+        continue;
+
+      if( !job->found && dst40hash( job->c1, key ) == job->r1 && dst40hash( job->c2, key ) == job->r2 )
+      {
+        job->found = true;
+        job->key   = key;
+      }
+      else if( !job->found )
+        printf( "\nWARNING: FPGA reported wrong key %010llX\n", key );
+    }
+  }
+
+  return _daemon.current.found;
+}
+
+
+
+/******************************************************************************
+ * Выключение очереди FPGA: задание, положенное в неё следом
+ * за выполняемым, возвращается в очередь демона.
+ *****************************************************************************/
+
+static void daemonHalt( void )
+{
+  _daemon.backend->stop();
+  daemonDrain();                                                // Ключи, попавшие в FIFO до остановки
+
+  if( _daemon.ahead )
+  {
+    _daemon.ahead = false;
+    _daemon.queue = realloc( _daemon.queue, ( _daemon.count + 1 ) * sizeof(DAEMON_JOB) );
+    _daemon.queue[_daemon.count++] = _daemon.next;
+  }
+}
+
+
+
+/******************************************************************************
+ * Окончание выполняемого задания: результат - клиенту. Если следующее
+ * задание уже в очереди FPGA, FPGA перешла к нему сама, и оно становится
+ * выполняемым; иначе очередь FPGA выключается.
+ *****************************************************************************/
+
+static void daemonFinish( void )
+{
+  DAEMON_JOB *job = &_daemon.current;
+
+  job->time += daemonSince( &_daemon.started );
+  daemonResult( job, job->found ? "found" : "notfound", job->key );
+
+  if( _daemon.ahead )
+  {
+    _daemon.current = _daemon.next;
+    _daemon.ahead   = false;
+    _daemon.number++;
+
+    gettimeofday( &_daemon.started, NULL );
+    printf( "\nJob %u: %s from %010llX\n", job->id, job->preempted ? "resumed" : "started", job->pos );
+    return;
+  }
+
+  _daemon.running = false;
+
+  if( _daemon.fpga_queue )
+    _daemon.backend->stop();
+}
+
+
+
+/******************************************************************************
+ * Опрос FPGA во время выполнения задания.
+ *
+ * В очереди FPGA задание заканчивается, только когда перебраны все его
+ * ключи, - если ключ найден раньше, очередь выключается.
+ *****************************************************************************/
+
+static void daemonPoll( void )
+{
+  DAEMON_JOB *job = &_daemon.current;
+  uint64_t    flags, position;
+  uint32_t    done = 0;                                         // Выполнено заданий очереди FPGA, начиная с выполняемого
+
+  flags = _daemon.backend->wait( DAEMON_POLL_MS );
+
+  if( _daemon.fpga_queue )
+    done = _daemon.backend->completed() - _daemon.number;       // До FIFO: все ключи выполненных заданий уже в FIFO
+
+  position = _daemon.backend->position();                       // До FIFO: все ключи до position - DST40_LAG уже в FIFO
+
+  daemonDrain();
+
+  if( !_daemon.fpga_queue )
+  {
+    if( job->found || ( flags & DST40_FLAG_DONE ) || position >= job->end + DST40_LAG )
+    {
+      _daemon.backend->stop();
+      daemonDrain();
+      daemonFinish();
+    }
+
+    return;
+  }
+
+  while( _daemon.running && ( done || job->found ) )
+  {
+    if( done )
+      done--;
+    else
+      daemonHalt();
+
+    daemonFinish();
+  }
+}
+
+
+
+/******************************************************************************
+ * Остановка выполняемого задания.
+ *
+ * Вход: requeue - вернуть задание в очередь (вытеснение), иначе - отменить.
+ *
+ * Положение перебора берётся из счётчика до остановки FPGA: после записи
+ * 0 в run счётчик снова показывает стартовый ключ. Задание, положенное
+ * в очередь FPGA следом за выполняемым, возвращается в очередь демона.
+ *****************************************************************************/
+
+static void daemonSuspend( bool requeue )
+{
+  DAEMON_JOB *job = &_daemon.current;
+  uint32_t    done = _daemon.fpga_queue ? _daemon.backend->completed() - _daemon.number : 0;
+  uint64_t    position = _daemon.backend->position();
+
+  if( _daemon.fpga_queue )
+    daemonHalt();
+  else
+  {
+    _daemon.backend->stop();
+    daemonDrain();
+  }
+
+  if( job->found || done )                                      // Ключ нашёлся или задание закончилось в последний момент
+  {
+    daemonFinish();
+    return;
+  }
+
+  _daemon.running = false;
+  job->time += daemonSince( &_daemon.started );
+
+  if( !requeue )
+  {
+    daemonResult( job, "cancelled", 0 );
+    return;
+  }
+
+  if( position > job->pos + DST40_LAG )
+    job->pos = position - DST40_LAG;
+
+  job->preempted = true;
+
+  _daemon.queue = realloc( _daemon.queue, ( _daemon.count + 1 ) * sizeof(DAEMON_JOB) );
+  _daemon.queue[_daemon.count++] = *job;
+
+  printf( "\nJob %u: preempted at %010llX\n", job->id, job->pos );
+}
+
+
+
+/******************************************************************************
+ * Выбор следующего задания: наибольший приоритет, при равном - меньший
+ * номер (раньше пришедшее, в том числе вытесненное).
+ *****************************************************************************/
+
+static uint32_t daemonBest( void )
+{
+  uint32_t i, best = 0;
+
+  for( i=1; i < _daemon.count; i++ )
+    if( _daemon.queue[i].priority > _daemon.queue[best].priority ||
+        ( _daemon.queue[i].priority == _daemon.queue[best].priority && _daemon.queue[i].id < _daemon.queue[best].id ) )
+      best = i;
+
+  return best;
+}
+
+static void daemonNext( void )
+{
+  uint32_t  best;
+  DST40_JOB fpga;
+
+  if( !_daemon.running && _daemon.count )
+  {
+    best = daemonBest();
+
+    _daemon.current = _daemon.queue[best];
+    _daemon.queue[best] = _daemon.queue[--_daemon.count];
+
+    daemonStart();
+  }
+
+  // Следующее задание - в очередь FPGA, если оно не срочнее выполняемого
+  // (срочное вытесняет выполняемое само)
+
+  if( !_daemon.fpga_queue || !_daemon.running || _daemon.ahead || !_daemon.count )
+    return;
+
+  best = daemonBest();
+
+  if( _daemon.queue[best].priority > _daemon.current.priority )
+    return;
+
+  daemonDesc( &_daemon.queue[best], &fpga );
+
+  if( !_daemon.backend->push( &fpga ) )
+    return;
+
+  _daemon.next  = _daemon.queue[best];
+  _daemon.ahead = true;
+  _daemon.queue[best] = _daemon.queue[--_daemon.count];
+
+  printf( "\nJob %u: queued in FPGA after job %u\n", _daemon.next.id, _daemon.current.id );
+}
+
+
+
+/******************************************************************************
+ * Отмена задания (все задания клиента, если id = 0).
+ *
+ * Возвращает true, если что-то отменено.
+ *****************************************************************************/
+
+static bool daemonCancel( int32_t client, uint32_t id )
+{
+  uint32_t i;
+  bool     cancelled = false;
+  bool     current = _daemon.running && _daemon.current.client == client && ( !id || _daemon.current.id == id );
+  bool     next    = _daemon.ahead && _daemon.next.client == client && ( !id || _daemon.next.id == id );
+
+  // Задание из очереди FPGA убирается выключением очереди: оно
+  // возвращается в очередь демона и отменяется там, а выполняемое,
+  // если его не отменяют, вытесняется
+
+  if( current || next )
+  {
+    daemonSuspend( !current );
+    cancelled = current;
+  }
+
+  for( i=0; i < _daemon.count; )
+    if( _daemon.queue[i].client == client && ( !id || _daemon.queue[i].id == id ) )
+    {
+      daemonResult( &_daemon.queue[i], "cancelled", 0 );
+      _daemon.queue[i] = _daemon.queue[--_daemon.count];
+      cancelled = true;
+    }
+    else
+      i++;
+
+  return cancelled;
+}
+
+
+
+/******************************************************************************
+ * Разбор сообщения клиента.
+ *****************************************************************************/
+
+static void daemonMessage( int32_t client, const char *line )
+{
+  NET_CONN  *conn = &_daemon.clients[client];
+  DAEMON_JOB job;
+  uint32_t   i, id;
+  int        n;
+
+  if( !strncmp( line, "SUBMIT ", 7 ) )
+  {
+    memset( &job, 0, sizeof(job) );
+
+    if( sscanf( line + 7, "%d %llx %llx %llx %llx %llx %llx", &job.priority, &job.c1, &job.r1, &job.c2, &job.r2,
+                &job.start_key, &job.end_key ) < 5 )
+    {
+      netSend( conn, "ERROR bad job" );
+      return;
+    }
+
+    job.r1 &= 0xFFFFFF;
+    job.r2 &= 0xFFFFFF;
+
+    if( !job.end_key || job.end_key > 0x10000000000ULL )
+      job.end_key = 0x10000000000ULL;
+
+    // Диапазон в значениях счётчика перебора (как в режиме --jobs)
+
+    job.pos = backendIndex( job.start_key );
+    job.end = backendIndex( job.end_key - 1 ) + 1;
+
+    if( job.end <= job.pos )
+      job.end = DST40_KEYS;
+
+    job.id     = ++_daemon.last_id;
+    job.client = client;
+
+    _daemon.queue = realloc( _daemon.queue, ( _daemon.count + 1 ) * sizeof(DAEMON_JOB) );
+    _daemon.queue[_daemon.count++] = job;
+
+    netSend( conn, "QUEUED %u", job.id );
+    printf( "\nJob %u: queued with priority %d\n", job.id, job.priority );
+
+    // Срочное задание вытесняет выполняемое, а задание, уже положенное
+    // в очередь FPGA, может уступить ему, только если выключить очередь
+
+    if( _daemon.running && ( job.priority > _daemon.current.priority || ( _daemon.ahead && job.priority > _daemon.next.priority ) ) )
+      daemonSuspend( true );
+  }
+  else if( sscanf( line, "CANCEL %u", &id ) == 1 )
+  {
+    if( !id || !daemonCancel( client, id ) )
+      netSend( conn, "ERROR no job %u", id );
+  }
+  else if( !strcmp( line, "STATUS" ) )
+  {
+    if( _daemon.running )
+      netSend( conn, "JOB %u %d running %010llX %06llX %010llX %06llX %010llX %010llX", _daemon.current.id,
+               _daemon.current.priority, _daemon.current.c1, _daemon.current.r1, _daemon.current.c2, _daemon.current.r2,
+               _daemon.backend->position(), _daemon.current.end );
+
+    if( _daemon.ahead )
+      netSend( conn, "JOB %u %d queued %010llX %06llX %010llX %06llX %010llX %010llX", _daemon.next.id, _daemon.next.priority,
+               _daemon.next.c1, _daemon.next.r1, _daemon.next.c2, _daemon.next.r2, _daemon.next.pos, _daemon.next.end );
+
+    for( i=0; i < _daemon.count; i++ )
+      netSend( conn, "JOB %u %d %s %010llX %06llX %010llX %06llX %010llX %010llX", _daemon.queue[i].id,
+               _daemon.queue[i].priority, _daemon.queue[i].preempted ? "preempted" : "queued", _daemon.queue[i].c1,
+               _daemon.queue[i].r1, _daemon.queue[i].c2, _daemon.queue[i].r2, _daemon.queue[i].pos, _daemon.queue[i].end );
+
+    netSend( conn, "END" );
+  }
+  else
+  {
+    n = strlen( line ) > 64 ? 64 : strlen( line );
+    netSend( conn, "ERROR bad command \"%.*s\"", n, line );
+  }
+}
+
+
+
+/******************************************************************************
+ * Подключение к Unix-сокету или его создание.
+ *
+ * Вход: path   - путь к сокету,
+ *       server - создать сокет демона (иначе - подключиться к нему).
+ *
+ * Возвращает сокет или -1 (сообщение уже выведено).
+ *****************************************************************************/
+
+static int daemonSocket( const char *path, bool server )
+{
+  struct sockaddr_un addr;
+  int fd;
+
+  if( strlen( path ) >= sizeof(addr.sun_path) )
+  {
+    printf( "\nERROR: socket path is too long\n" );
+    return -1;
+  }
+
+  memset( &addr, 0, sizeof(addr) );
+  addr.sun_family = AF_UNIX;
+  strcpy( addr.sun_path, path );
+
+  if( ( fd = socket( AF_UNIX, SOCK_STREAM, 0 ) ) < 0 )
+  {
+    perror( path );
+    return -1;
+  }
+
+  if( server )
+  {
+    unlink( path );                                             // Сокет, оставшийся от прошлого запуска
+
+    if( bind( fd, (struct sockaddr *)&addr, sizeof(addr) ) || listen( fd, DAEMON_MAX_CLIENTS ) )
+    {
+      perror( path );
+      close( fd );
+      return -1;
+    }
+  }
+  else if( connect( fd, (struct sockaddr *)&addr, sizeof(addr) ) )
+  {
+    perror( path );
+    close( fd );
+    return -1;
+  }
+
+  return fd;
+}
+
+
+
+/******************************************************************************
+ * Демон поиска.
+ *
+ * Вход: path    - путь к Unix-сокету,
+ *       backend - исполнитель поиска (уже подключен).
+ *
+ * Работает до Ctrl+C. Возвращает false, если сокет не удалось создать.
+ *****************************************************************************/
+
+bool daemonRun( const char *path, const DST40_BACKEND *backend )
+{
+  struct pollfd fds[DAEMON_MAX_CLIENTS + 1];
+  char     line[NET_MAX_LINE];
+  int      listen_fd, fd;
+  uint32_t i;
+
+  memset( &_daemon, 0, sizeof(_daemon) );
+  _daemon.backend    = backend;
+  _daemon.fpga_queue = backend->push && ( _caps.features & DST40_CAPS_QUEUE );
+
+  for( i=0; i < DAEMON_MAX_CLIENTS; i++ )
+    _daemon.clients[i].fd = -1;
+
+  if( ( listen_fd = daemonSocket( path, true ) ) < 0 )
+    return false;
+
+  setvbuf( stdout, NULL, _IOLBF, 0 );                           // Журнал демона обычно пишется в файл
+
+  printf( "\nDaemon: listening on %s%s\n", path, _daemon.fpga_queue ? ", jobs go through the FPGA queue" : "" );
+
+  while( 1 )
+  {
+    daemonNext();
+
+    // Пока идёт поиск, сокеты только проверяем - ждём на FPGA
+
+    fds[0].fd     = listen_fd;
+    fds[0].events = POLLIN;
+
+    for( i=0; i < DAEMON_MAX_CLIENTS; i++ )
+    {
+      fds[i+1].fd     = _daemon.clients[i].fd;
+      fds[i+1].events = POLLIN;
+    }
+
+    poll( fds, DAEMON_MAX_CLIENTS + 1, _daemon.running ? 0 : -1 );
+
+    if( ( fds[0].revents & POLLIN ) && ( fd = accept( listen_fd, NULL, NULL ) ) >= 0 )
+    {
+      for( i=0; i < DAEMON_MAX_CLIENTS && _daemon.clients[i].fd >= 0; i++ );
+
+      if( i == DAEMON_MAX_CLIENTS )
+        close( fd );
+      else
+      {
+        _daemon.clients[i].fd  = fd;
+        _daemon.clients[i].len = 0;
+      }
+    }
+
+    for( i=0; i < DAEMON_MAX_CLIENTS; i++ )
+    {
+      NET_CONN *conn = &_daemon.clients[i];
+
+      if( conn->fd < 0 || fds[i+1].fd != conn->fd || !( fds[i+1].revents & ( POLLIN | POLLHUP | POLLERR ) ) )
+        continue;
+
+      if( !netReceive( conn ) )
+      {
+        netClose( conn );
+        daemonCancel( i, 0 );                                   // Результаты отдавать некому
+        continue;
+      }
+
+      while( conn->fd >= 0 && netLine( conn, line ) )
+        daemonMessage( i, line );
+    }
+
+    if( _daemon.running )
+      daemonPoll();
+  }
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * Клиент демона: отправка заданий и вывод результатов.
+ *
+ * Вход: path     - путь к Unix-сокету демона,
+ *       priority - приоритет заданий,
+ *       lines    - задания из командной строки (формат --job),
+ *       count    - их количество,
+ *       f        - файл заданий (NULL - нет).
+ *
+ * Результаты выводятся в stdout в формате --jobs по мере выполнения
+ * заданий. Возвращает false при ошибке связи с демоном.
+ *****************************************************************************/
+
+bool daemonSubmit( const char *path, int32_t priority, const char **lines, uint32_t count, FILE *f )
+{
+  NET_CONN conn;
+  char     line[NET_MAX_LINE], *p;
+  uint32_t i = 0, pending = 0;
+
+  if( ( conn.fd = daemonSocket( path, false ) ) < 0 )
+    return false;
+
+  conn.len = 0;
+
+  printf( "# job challenge1 response1 challenge2 response2 start_key end_key result key time\n" );
+
+  while( 1 )
+  {
+    if( i < count )
+      p = strcpy( line, lines[i++] );
+    else if( !f || !( p = fgets( line, sizeof(line), f ) ) )
+      break;
+
+    while( *p == ' ' || *p == '\t' )
+      p++;
+
+    p[strcspn( p, "\r\n" )] = 0;
+
+    if( *p == '#' || !*p )
+      continue;
+
+    if( !netSend( &conn, "SUBMIT %d %s", priority, p ) )
+      break;
+
+    pending++;
+  }
+
+  while( pending )
+  {
+    while( !netLine( &conn, line ) )
+      if( !netReceive( &conn ) )
+      {
+        fprintf( stderr, "\nERROR: daemon connection lost\n" );
+        netClose( &conn );
+        return false;
+      }
+
+    if( !strncmp( line, "RESULT ", 7 ) )
+    {
+      printf( "%s\n", line + 7 );
+      fflush( stdout );
+      pending--;
+    }
+    else if( !strncmp( line, "QUEUED ", 7 ) )
+      fprintf( stderr, "Job %s queued\n", line + 7 );
+    else if( !strncmp( line, "ERROR ", 6 ) )
+    {
+      fprintf( stderr, "ERROR: %s\n", line + 6 );
+      pending--;
+    }
+  }
+
+  netClose( &conn );
+  return true;
+}
+
+
+
+/******************************************************************************
+ * Клиент демона: вывод очереди заданий.
+ *
+ * Вход: path - путь к Unix-сокету демона.
+ *****************************************************************************/
+
+bool daemonStatus( const char *path )
+{
+  NET_CONN conn;
+  char     line[NET_MAX_LINE];
+
+  if( ( conn.fd = daemonSocket( path, false ) ) < 0 )
+    return false;
+
+  conn.len = 0;
+
+  if( !netSend( &conn, "STATUS" ) )
+    return false;
+
+  printf( "# job priority state challenge1 response1 challenge2 response2 position end\n" );
+
+  while( 1 )
+  {
+    while( !netLine( &conn, line ) )
+      if( !netReceive( &conn ) )
+      {
+        netClose( &conn );
+        return false;
+      }
+
+    if( !strcmp( line, "END" ) )
+      break;
+
+    if( !strncmp( line, "JOB ", 4 ) )
+      printf( "%s\n", line + 4 );
+  }
+
+  netClose( &conn );
+  return true;
+}
@@ -0,0 +1,18 @@
+#ifndef DAEMON_H_
+#define DAEMON_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "backend.h"
+
+
+// Демон поиска (режим --daemon): держит FPGA подключенной и выполняет
+// задания нескольких клиентов из очереди с приоритетами через Unix-сокет.
+
+bool daemonRun( const char *, const DST40_BACKEND * );
+bool daemonSubmit( const char *, int32_t, const char **, uint32_t, FILE * );
+bool daemonStatus( const char * );
+
+
+#endif /* DAEMON_H_ */
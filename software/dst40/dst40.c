@@ -2,97 +2,1142 @@
  *
  * Программа для поиска ключа DST40.
  *
- * Программа заточена под четырёхъядерный вариант модуля.
+ * Программа работает с образом модуля с любым количеством ядер NK:
+ * параметры образа (NK, размер таблицы ответов NR, глубина конвеера,
+ * частота, возможности) читаются из регистров id и caps при подключении
+ * (backendCaps() в backend.c).
  *
  *----------------------------------------------------------------------------
  *
  * Аппаратная часть модуля DST40 соединена с HPS через мост HPS-to-FPGA.
  *
- * Адресная карта модуля DST40 (четырёхъядерный вариант):
+ * Адресная карта модуля DST40 (полностью, с разрядностями - в заголовке
+ * source/dst40.v, номера регистров - DST40_REG_* в backend.h; L2NK -
+ * логарифм NK):
  *
- * 0x00 - challenge                ( 40 бит,  Чтение/Запись )  Первый запрос
- * 0x08 - response                 ( 24 бита, Чтение/Запись )  Первый ответ
- * 0x10 - start_key                ( 40 бит,  Чтение/Запись )  Ключ, с которого начинать поиск
- * 0x18 - run                      (  1 бит,  Чтение/Запись )  Флаг запуска поиска
+ * 0x00 - challenge                ( 40 бит,      Чтение/Запись )  Первый запрос
+ * 0x08 - response                 ( 24 бита,     Чтение/Запись )  Первый ответ
+ * 0x10 - start_key                ( 40-L2NK бит, Чтение/Запись )  Значение счётчика перебора, с которого начинать поиск
+ * 0x18 - run                      (  1 бит,      Чтение/Запись )  Флаг запуска поиска
  * 0x20 - флаги:
- *        бит 0 - key_found_w      (  1 бит,  Только чтение )  Флаг "ключ найден"
- *        бит 8 - key_not_found_w  (  1 бит,  Только чтение )  Флаг "ключ не найден"
- * 0x28 - key                      ( 38 бит,  Только чтение )  Найденный ключ (младшие биты)
- * 0x30 - kernels                  (  4 бита, Только чтение )  Флаги ядер, нашедших ключ
+ *        бит 0  - found           (  1 бит,      Только чтение )  Флаг "в FIFO есть найденный ключ"
+ *        бит 8  - done            (  1 бит,      Только чтение )  Флаг "все ключи перебраны и проверены"
+ *        бит 16 - overflow        (  1 бит,      Только чтение )  Флаг "перебор приостанавливался"
+ * 0x28 - key                      ( 40-L2NK бит, Только чтение )  Ключ в голове FIFO (значение счётчика перебора)
+ * 0x30 - kernels                  ( NK бит,      Только чтение )  Биты ядер, нашедших ключ
+ * 0x38 - fifo                     (  1 бит,      Только запись )  Запись 1 удаляет ключ из головы FIFO
+ * 0x40 - challenge2               ( 40 бит,      Чтение/Запись )  Второй запрос
+ * 0x48 - response2                ( 24 бита,     Чтение/Запись )  Второй ответ
+ * 0x50 - index                    ( L2NR бит,    Только чтение )  Номер метки для ключа в голове FIFO
+ * 0x58 - count                    ( L2NR+1 бит,  Чтение/Запись )  Количество меток в таблице ответов (1..NR)
+ * 0x60 - position                 ( 41-L2NK бит, Только чтение )  Счётчик перебора, до которого дошёл перебор
+ *                                                                 во всех ядрах
+ * 0x68 - cycles                   ( 48 бит,      Только чтение )  Такты ядер с запуска перебора (0 в простое)
+ * 0x70 - id                       ( 64 бита,     Только чтение )  "DST40", UNROLL и версия образа
+ * 0x78 - caps                     ( 64 бита,     Только чтение )  NK, L2NK, NR, глубина конвеера, частота,
+ *                                                                 возможности (DST40_CAPS_*), глубина FIFO
+ * 0x80 .. 0xA0 - busy, stall,     ( 48 бит,      Только чтение )  Счётчики производительности за проход: такты работы
+ *   hold, refill, restarts                                        ядер, простоя, ожидания FIFO, заполнения конвеера
+ *                                                                 и количество запусков (читаются после остановки)
+ * 0xC0 .. - hits                  ( 32 бита,     Только чтение )  Количество кандидатов по первой паре, по регистру
+ *                                                                 на ядро
+ * 0x140 .. 0x158 - ring_base,     (              Чтение/Запись )  Кольцевой буфер найденных ключей в памяти HPS
+ *   ring, ring_head, ring_tail                                    (ring.h)
+ * 0x160 - end_key                 ( 40-L2NK бит, Чтение/Запись )  Значение счётчика перебора, на котором закончить
+ *                                                                 поиск (0 - до конца)
+ * 0x168 - job                     ( 16 бит,      Только чтение )  Номер задания очереди для ключа в голове FIFO
+ * 0x170 - key_mask                ( 40-L2NK бит, Чтение/Запись )  Маска известных бит ключа (--mask)
+ * 0x178 - key_value               ( 40-L2NK бит, Чтение/Запись )  Значения известных бит ключа
+ * 0x180 .. 0x1B0 - дескриптор     (              Чтение/Запись )  Очередь дескрипторов заданий: запросы, ответы,
+ *   задания, queue, queue_done                                    начальный и конечный ключи, управление, счётчик
+ *                                                                 выполненных заданий
+ * 0x200 .. - responses            ( 48 бит,      Чтение/Запись )  Таблица ответов меток (NR строк): биты 47..24 -
+ *                                                                 второй ответ, биты 23..0 - первый (0x200 =
+ *                                                                 response и response2)
  *
+ * FPGA перебирает ключи без остановок, сама проверяет кандидатов,
+ * подошедших к первой паре запрос/ответ, на второй паре и складывает
+ * ключи, подошедшие к обеим парам, в FIFO. Программа вычитывает FIFO.
+ *
+ * Ответы сравниваются сразу со всей таблицей: ключи до NR меток,
+ * отвечавших на одни и те же запросы, ищутся за один проход перебора.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * Запуск:
+ *
+ * dst40                - поиск на FPGA,
+ * dst40 --cpu [N]      - программный поиск на N потоках процессора (по
+ *                        умолчанию - на всех ядрах), FPGA не используется.
+ * dst40 --batch FILE   - поиск ключей всех меток из файла FILE без
+ *                        диалога с пользователем (совместим с --cpu).
+ *
+ * Формат файла для --batch (числа шестнадцатеричные, '#' - комментарий):
+ *
+ *   <challenge1> <challenge2> [start_key]
+ *   <response1> <response2>                 - по строке на каждую метку
+ *   ...
+ *
+ * На FPGA метки обрабатываются группами по NR (16 в стандартном
+ * образе) за проход перебора, в режиме --cpu - по одной.
+ *
+ * dst40 --backend NAME - выбор исполнителя поиска (backend.h):
+ *                        mmap - FPGA через /dev/mem (по умолчанию на плате),
+ *                        sim  - программная модель FPGA (fpgasim.c),
+ *                        null - пустой исполнитель для замера накладных
+ *                               расходов самой программы.
+ *
+ * dst40 --ring ADDR[:BITS]
+ *                      - найденные ключи получать не через регистры FIFO,
+ *                        а через кольцевой буфер из 2^BITS (по умолчанию
+ *                        2^12) записей по 32 байта по физическому адресу
+ *                        ADDR (шестнадцатеричный, кратен 4096) в памяти,
+ *                        скрытой от Linux (ring.c). FPGA пишет буфер через
+ *                        мост FPGA-to-SDRAM, программа забирает ключи
+ *                        отдельным потоком, не читая регистры FPGA.
+ *
+ * dst40 --mask MASK[:VALUE]
+ *                      - известные биты ключа (шестнадцатеричные маска
+ *                        и значения, например по префиксу производителя):
+ *                        FPGA перебирает только свободные биты, и при k
+ *                        известных битах поиск идёт в 2^k раз быстрее.
+ *                        Прогресс и положение перебора (журнал, START
+ *                        и END заданий) считаются в уменьшенном
+ *                        пространстве. Только для поиска на одной FPGA
+ *                        (образ версии 11 или модель --backend sim).
+ *
+ * dst40 --journal FILE - вести журнал поиска на FPGA (journal.c): положение
+ *                        перебора сохраняется раз в минуту, при каждом
+ *                        найденном ключе и при выходе по Ctrl+C.
+ * dst40 --resume FILE  - продолжить поиск, прерванный Ctrl+C или выключением
+ *                        питания, с места, сохранённого в журнале FILE
+ *                        (журнал продолжает вестись в тот же файл).
+ *
+ * dst40 --job "C1 R1 C2 R2 [START [END]]"
+ *                      - поиск ключа без диалога (можно повторять),
+ * dst40 --jobs FILE    - очередь заданий из файла (FILE = "-" - со
+ *                        стандартного ввода), по заданию в строке в том же
+ *                        формате. Задания выполняются по очереди без
+ *                        переподключения FPGA, результат каждого выводится
+ *                        в stdout одной строкой сразу по его окончании
+ *                        (формат - в runJob()), всё остальное - в stderr.
+ *                        END - конечный ключ (не включительно); на FPGA
+ *                        START и END переводятся в значения счётчика
+ *                        перебора, общего для всех ядер (backendIndex()):
+ *                        точно задают диапазон только у образа
+ *                        с чередованием ядер (--interleave). Если
+ *                        в образе есть очередь дескрипторов, задания
+ *                        кладутся в неё наперёд (runQueue()).
+ * dst40 --daemon SOCKET
+ *                      - демон поиска (daemon.c): держит FPGA подключенной
+ *                        и выполняет задания клиентов из очереди
+ *                        с приоритетами, принимая их через Unix-сокет SOCKET;
+ *                        срочное задание вытесняет выполняемое. Следующее
+ *                        задание лежит в очереди дескрипторов FPGA, если
+ *                        она есть в образе.
+ * dst40 --submit SOCKET [--priority N] (--job ... | --jobs FILE)
+ *                      - отправка заданий демону; результаты выводятся
+ *                        так же, как в режиме --jobs. Чем больше N, тем
+ *                        срочнее задание (по умолчанию 0).
+ * dst40 --queue SOCKET - вывод очереди заданий демона.
+ * dst40 --tmto-build FILE C1 C2 [TABLE [LENGTH [CHAINS]]]
+ *                      - построение радужной таблицы (tmto.c) для пары
+ *                        запросов C1, C2: CHAINS цепочек (по умолчанию
+ *                        2^24) длиной LENGTH (по умолчанию 4096), таблицы
+ *                        с разными номерами TABLE независимы. Таблица
+ *                        обычная радужная, цепочки полной длины (без
+ *                        различимых точек). Файл создаётся до расчёта.
+ * dst40 --tmto-lookup R1 R2 FILE...
+ *                      - поиск ключа по ответам R1, R2 в радужных таблицах
+ *                        (секунды вместо полного перебора).
+ * dst40 --coordinator PORT [--lease BITS]
+ *                      - распределённый поиск на нескольких платах
+ *                        (netsearch.c): программа сама не ищет, а раздаёт
+ *                        исполнителям аренды по 2^BITS ключей на ядро
+ *                        (по умолчанию 2^32) и собирает найденные ключи.
+ *                        Метки - из --batch или из диалога, до 16 штук.
+ * dst40 --worker HOST:PORT
+ *                      - исполнитель распределённого поиска: берёт задание
+ *                        и аренды у координатора и перебирает их на FPGA
+ *                        (или на исполнителе, заданном --backend).
+ *
+ * На хосте без HPS (x86) программа по умолчанию работает в режиме --cpu,
+ * управляющий цикл поиска на FPGA там можно проверить с --backend sim.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <stdbool.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <wchar.h>
+#include <locale.h>
+#include <math.h>
+#include <pthread.h>
+#include "keyboard.h"
+#include "dst40hash.h"
+#include "cpusearch.h"
+#include "backend.h"
+#include "ring.h"
+#include "journal.h"
+#include "netsearch.h"
+#include "daemon.h"
+#include "tmto.h"
+
+
+//#############################################################################
+// ОПРЕДЕЛЕНИЯ
+
+#define JOURNAL_PERIOD    60                                    // Период сохранения журнала, с
+#define END_POLL_MS       100                                   // Период проверки счётчика перебора при заданном конечном ключе, мс
+#define TELEMETRY_PERIOD  10                                    // Период вывода скорости перебора на FPGA, в десятых долях секунды
+#define QUEUE_AHEAD       64                                    // Наибольшее количество заданий --jobs в очереди FPGA и в ожидании места в ней
+
+// Задание режимов --job и --jobs
+
+typedef struct
+{
+  uint32_t no;                                                  // Номер задания
+  uint64_t c1, r1, c2, r2;                                      // Пары запрос/ответ
+  uint64_t start_key, end_key;                                  // Диапазон ключей, как он задан
+  uint64_t start, end;                                          // Тот же диапазон в значениях счётчика перебора
+  uint64_t key;                                                 // Найденный ключ
+  bool     found;
+} JOB_LINE;
+
+
+//#############################################################################
+// ГЛОБАЛЬНЫЕ ПЕРЕМЕННЫЕ
+
+const DST40_BACKEND *_backend = NULL;                           // Исполнитель поиска на FPGA (NULL - не подключен)
+
+pthread_t _main_thread;                                         // Основной поток (Ctrl+C обрабатывается в другом)
+
+time_t _time_start = 0;                                         // Время старта поиска
+
+// Задание на поиск и его журнал
+
+struct
+{
+  DST40_JOURNAL   job;                                          // Метки и положение перебора для каждой из них
+  const char     *name;                                         // Файл журнала (NULL - журнал не ведётся)
+  pthread_mutex_t lock;                                         // Защищает job и текущий проход
+
+  uint32_t        tags[DST40_MAX_NR];                           // Метки текущего прохода
+  uint32_t        count;                                        // Количество меток в текущем проходе (0 - проход не идёт)
+  uint64_t        start;                                        // Ключ, с которого начат текущий проход
+} _job;
+
+// Телеметрия поиска на FPGA: счётчики перебора и тактов опрашиваются
+// по таймеру отдельным потоком - основной поток при этом может спать
+// в ожидании прерывания
+
+struct
+{
+  pthread_t       thread;
+  volatile bool   run;                                          // Поток телеметрии работает
+  uint64_t        start;                                        // Младшие биты ключа, с которых начат проход
+  uint64_t        end;                                          // Младшие биты ключа, до которых идёт проход
+} _telemetry;
+
+// Счётчики производительности FPGA, накопленные за все проходы
+
+struct
+{
+  uint32_t        passes;                                       // Количество проходов
+  uint32_t        known;                                        // Из них проходов, для которых исполнитель знает счётчики
+  double          time;                                         // Время проходов по часам программы, с
+  uint64_t        cycles;                                       // Такты ядер от запуска до окончания перебора
+  DST40_PERF      sum;                                          // Сумма счётчиков (restarts - последнее значение)
+} _perf;
+
+
+
+/******************************************************************************
+ * Сохранение журнала поиска.
+ *
+ * Для меток текущего прохода положение перебора берётся из счётчика
+ * перебора FPGA с отставанием DST40_LAG: все ключи до этого места уже
+ * проверены, а подошедшие из них - вычитаны из FIFO и записаны в журнал.
+ *****************************************************************************/
+
+void checkpoint( void )
+{
+  uint64_t position, pos;
+  uint32_t i;
+
+  if( !_job.name )
+    return;
+
+  pthread_mutex_lock( &_job.lock );
+
+  if( _job.count )
+  {
+    position = _backend->position();
+    pos = ( position > _job.start + DST40_LAG ) ? position - DST40_LAG : _job.start;
+
+    for( i=0; i < _job.count; i++ )
+      if( !_job.job.found[_job.tags[i]] && pos > _job.job.pos[_job.tags[i]] )
+        _job.job.pos[_job.tags[i]] = pos;
+  }
+
+  journalSave( _job.name, &_job.job );
+
+  pthread_mutex_unlock( &_job.lock );
+}
+
+
+
+/******************************************************************************
+ * Поток периодического сохранения журнала.
+ *****************************************************************************/
+
+void *checkpointThread( void *arg )
+{
+  while( 1 )
+  {
+    sleep( JOURNAL_PERIOD );
+    checkpoint();
+  }
+
+  return NULL;
+}
+
+
+
+/******************************************************************************
+ * Вывод сводки загрузки FPGA по счётчикам производительности.
+ *
+ * Доля тактов FPGA во времени проходов показывает накладные расходы
+ * программы (загрузка задания, вычитывание FIFO, перезапуски), а доли
+ * простоя внутри тактов FPGA - упирается ли перебор в сами ядра.
+ *****************************************************************************/
+
+void perfSummary( void )
+{
+  uint32_t i;
+  double   fpga_time;
+
+  if( !_perf.passes )
+    return;
+
+  fpga_time = _perf.cycles / ( DST40_CLOCK_MHZ * 1e6 );
+
+  printf( "\n\nFPGA utilization: %u passes, %.3f s search time", _perf.passes, _perf.time );
+
+  if( _perf.cycles && _perf.time > 0 )
+    printf( ", FPGA time %.3f s (%.1f%%)", fpga_time, 100.0 * fpga_time / _perf.time );
+
+  if( !_perf.known || !_perf.cycles )
+  {
+    printf( "\n" );
+    return;
+  }
+
+  printf( "\n  hashing:              %5.1f%% of FPGA cycles (refill %.1f%%)",
+          100.0 * _perf.sum.busy / _perf.cycles, 100.0 * _perf.sum.refill / _perf.cycles );
+  printf( "\n  candidate stall:      %5.1f%%", 100.0 * _perf.sum.stall / _perf.cycles );
+  printf( "\n  waiting for host:     %5.1f%% (key held, FIFO full)", 100.0 * _perf.sum.hold / _perf.cycles );
+  printf( "\n  candidates by kernel:" );
+
+  for( i=0; i < DST40_NK; i++ )
+    printf( " %llu", _perf.sum.hits[i] );
+
+  printf( "\n  restarts:             %llu since FPGA configuration\n", _perf.sum.restarts );
+}
+
+
+
+/******************************************************************************
+ * Завершение работы программы: по Ctrl+C (из потока interruptThread())
+ * или по окончании работы основного потока.
+ *
+ * Основной поток в момент Ctrl+C может быть внутри исполнителя (ждать
+ * прерывания, опрашивать регистры), поэтому из потока Ctrl+C FPGA
+ * только останавливается: отключать её под основным потоком нельзя,
+ * а mmap и файлы закроет система при выходе.
+ *****************************************************************************/
+
+void exitToLinux( int sig )
+{
+  static pthread_mutex_t exit_lock = PTHREAD_MUTEX_INITIALIZER;
+
+  if( sig != SIGINT )
+    return;
+
+  pthread_mutex_lock( &exit_lock );                             // Второй вызов ждёт, пока первый завершит программу
+
+  // Сохраняем журнал: блокировку журнала держит не этот поток,
+  // её можно дождаться
+  if( _job.name && _backend )
+    checkpoint();
+
+  if( _backend && !pthread_equal( pthread_self(), _main_thread ) )
+    _backend->stop();                                           // Останавливаем FPGA
+  else if( _backend )                                           // Останавливаем FPGA и отключаемся от неё
+    _backend->close();
+
+  perfSummary();
+
+  printf( "\n" );                                               // Переводим строку - чтобы приглашение вывелось в следующей строке
+  echoOnOff( ECHO_ON );                                         // Переводим терминал в канонический режим работы
+  exit( 0 );
+}
+
+
+
+/******************************************************************************
+ * Поток обработки Ctrl+C.
+ *
+ * SIGINT заблокирован во всех потоках программы и принимается только
+ * здесь, через sigwait(): журнал, остановка FPGA и вывод сводки идут
+ * в обычном потоке, а не в обработчике сигнала, где нельзя ни брать
+ * блокировки, ни ждать другие потоки.
+ *****************************************************************************/
+
+void *interruptThread( void *arg )
+{
+  sigset_t set;
+  int      sig;
+
+  sigemptyset( &set );
+  sigaddset( &set, SIGINT );
+
+  while( sigwait( &set, &sig ) || sig != SIGINT );
+
+  exitToLinux( SIGINT );
+
+  return NULL;
+}
+
+
+
+/******************************************************************************
+ * Перехват Ctrl+C: блокирует SIGINT в основном потоке и запускает поток
+ * interruptThread(). Вызывается до подключения FPGA и запуска остальных
+ * потоков - они наследуют маску сигналов и SIGINT не получают.
+ *****************************************************************************/
+
+void catchInterrupt( void )
+{
+  sigset_t  set;
+  pthread_t thread;
+
+  _main_thread = pthread_self();
+
+  sigemptyset( &set );
+  sigaddset( &set, SIGINT );
+  pthread_sigmask( SIG_BLOCK, &set, NULL );
+
+  if( pthread_create( &thread, NULL, interruptThread, NULL ) )
+  {
+    pthread_sigmask( SIG_UNBLOCK, &set, NULL );                 // Без потока Ctrl+C просто завершает программу
+    return;
+  }
+
+  pthread_detach( thread );
+}
+
+
+
+/******************************************************************************
+ * Вывод прогресса программного поиска (вызывается раз в секунду).
+ *
+ * Вход: done  - количество проверенных ключей,
+ *       total - общее количество ключей в диапазоне поиска.
+ *****************************************************************************/
+
+void cpuProgress( uint64_t done, uint64_t total )
+{
+  time_t time_now = time( NULL ) - _time_start;
+
+  printf( "\rChecked: %010llX [%lds] [%lld%%] [%.1f Mkeys/s] ", done, time_now, ( done * 100 ) / total,
+          time_now ? (double)done / time_now / 1e6 : 0.0 );
+  fflush( stdout );
+}
+
+
+
+/******************************************************************************
+ * Поток телеметрии поиска на FPGA.
+ *
+ * Раз в секунду выводит мгновенную и среднюю скорость перебора, загрузку
+ * конвеера (доля тактов, в которые ядра принимали ключи, от возможной
+ * при их свёртке) и оценку
+ * оставшегося времени. Если счётчик перебора за секунду не сдвинулся,
+ * выводится STALLED - плата стоит.
+ *****************************************************************************/
+
+void *telemetryThread( void *arg )
+{
+  uint64_t position, last = _telemetry.start, cycles, eta;
+  double   elapsed, interval, rate_now, rate_avg;
+  uint32_t ticks;
+  struct timeval tv_start, tv_last, tv_now;
+
+  gettimeofday( &tv_start, NULL );
+  tv_last = tv_start;
+
+  while( _telemetry.run )
+  {
+    for( ticks=0; ticks < TELEMETRY_PERIOD && _telemetry.run; ticks++ )
+    {
+      struct timespec ts = { 0, 100000000 };                    // 100 мс
+
+      nanosleep( &ts, NULL );
+    }
+
+    if( !_telemetry.run )
+      break;
+
+    position = _backend->position();
+    cycles   = _backend->cycles();
+    gettimeofday( &tv_now, NULL );
+
+    if( position > _telemetry.end )
+      position = _telemetry.end;
+
+    if( position < last )
+      position = last;
+
+    elapsed  = ( tv_now.tv_sec - tv_start.tv_sec ) + ( tv_now.tv_usec - tv_start.tv_usec ) / 1e6;
+    interval = ( tv_now.tv_sec - tv_last.tv_sec  ) + ( tv_now.tv_usec - tv_last.tv_usec  ) / 1e6;
+    rate_now = interval > 0 ? ( position - last ) * DST40_NK / interval : 0;
+    rate_avg = elapsed  > 0 ? ( position - _telemetry.start ) * DST40_NK / elapsed : 0;
+    eta      = rate_avg > 0 ? ( _telemetry.end - position ) * DST40_NK / rate_avg : 0;
+
+    printf( "\rSearching... [%lds] [%.2f%%] [%.1f Mkeys/s, avg %.1f] ", time( NULL ) - _time_start,
+            100.0 * ( position - _telemetry.start ) / ( _telemetry.end - _telemetry.start ),
+            rate_now / 1e6, rate_avg / 1e6 );
+
+    if( cycles )
+      printf( "[pipe %.1f%%] ", cycles > _caps.depth ? 100.0 * 64 / _caps.unroll * ( position - _telemetry.start ) / ( cycles - _caps.depth ) : 0.0 );
+
+    printf( "[ETA %llu:%02llu:%02llu] %s", eta / 3600, eta / 60 % 60, eta % 60, position == last ? "STALLED " : "" );
+    fflush( stdout );
+
+    last    = position;
+    tv_last = tv_now;
+  }
+
+  return NULL;
+}
+
+
+
+/******************************************************************************
+ * Поиск на FPGA ключей нескольких меток, отвечавших на одни и те же
+ * запросы, за один проход перебора.
+ *
+ * Вход: tags      - номера меток задания _job (до DST40_NR штук),
+ *       n         - количество меток,
+ *       start_key - ключ, с которого начинать поиск,
+ *       end_key   - ключ, до которого вести поиск (не включительно,
+ *                   DST40_KEYS - до конца).
+ *
+ * Стартовый и конечный ключи - значения счётчика перебора (40-L2NK бит),
+ * общего для всех ядер (см. backendIndex()). Образ с регистром
+ * конечного ключа (DST40_CAPS_QUEUE) сам останавливает перебор на нём
+ * и взводит флаг DONE; для старых образов поиск останавливается
+ * программой, как только счётчик перебора уходит за конечный ключ
+ * на DST40_LAG.
+ *
+ * Найденные ключи записываются в задание _job (и в журнал). Поиск
+ * заканчивается, когда найдены ключи всех меток или перебраны все ключи -
+ * тогда метки, для которых ключ не найден, отмечаются как перебранные.
+ *
+ * Возвращает количество тактов ядер за проход (0 - исполнитель его
+ * не знает): после остановки поиска счётчик тактов сбрасывается, поэтому
+ * он читается до остановки.
+ *****************************************************************************/
+
+uint64_t fpgaSearch( const uint32_t *tags, uint32_t n, uint64_t start_key, uint64_t end_key )
+{
+  uint32_t     i, j, found_count = 0;
+  uint64_t     flags;                                           // Флаги текущего состояния FPGA
+  uint64_t     position = 0;                                    // Счётчик перебора (читается только при заданном end_key)
+  uint64_t     cycles;
+  DST40_PERF   perf;
+  struct timeval tv_start, tv_now;
+  uint64_t     r1[DST40_MAX_NR], r2[DST40_MAX_NR];
+  DST40_JOB    job;
+  DST40_RESULT result;
+
+  for( j=0; j < n; j++ )
+  {
+    r1[j] = _job.job.r1[tags[j]];
+    r2[j] = _job.job.r2[tags[j]];
+  }
+
+  // Загружаем исходные данные в FPGA: оба запроса и таблицу ответов
+  // (ключи, оставшиеся в FIFO от прошлого запуска, выбрасываются)
+  job.challenge  = _job.job.c1;
+  job.challenge2 = _job.job.c2;
+  job.start_key  = start_key;
+  job.end_key    = ( end_key < DST40_KEYS ) ? end_key : 0;
+  job.response   = r1;
+  job.response2  = r2;
+  job.count      = n;
+
+  _backend->load( &job );
+
+  // Разрешаем FPGA искать ключ
+  _backend->start();
+
+  pthread_mutex_lock( &_job.lock );                             // С этого момента журнал берёт положение перебора из FPGA
+  memcpy( _job.tags, tags, n * sizeof(uint32_t) );
+  _job.count = n;
+  _job.start = start_key & ( DST40_KEYS - 1 );
+  pthread_mutex_unlock( &_job.lock );
+
+  _telemetry.start = start_key & ( DST40_KEYS - 1 );
+  _telemetry.end   = ( end_key > _telemetry.start ) ? end_key : DST40_KEYS;
+  _telemetry.run   = true;
+  gettimeofday( &tv_start, NULL );
+  pthread_create( &_telemetry.thread, NULL, telemetryThread, NULL );
+
+  printf( "\rSearching... [%lds] ", time( NULL ) - _time_start );
+  fflush( stdout );
+
+  while( 1 )
+  {
+    // Ждём ключа в FIFO или конца перебора. Если задан конечный ключ,
+    // раз в END_POLL_MS проверяем, не дошёл ли до него перебор: счётчик
+    // читаем до FIFO, чтобы все ключи до него успели попасть в FIFO.
+    if( end_key < DST40_KEYS )
+    {
+      flags    = _backend->wait( END_POLL_MS );
+      position = _backend->position();
+    }
+    else
+      flags = _backend->wait( 0 );
+
+    // Вычитываем из FIFO найденные ключи. FPGA уже проверила их на обеих
+    // парах запрос/ответ - здесь проверяем ещё раз программно.
+    while( _backend->result( &result ) )
+    {
+      for( i=0; i < DST40_NK; i++ )
+      {
+        uint64_t full_key = backendKey( result.key, i );
+        uint32_t index    = result.index;
+
+        if( !( ( result.kernels >> i ) & 1 ) )
+          continue;
+
+        if( index < n && dst40hash( job.challenge, full_key ) == r1[index] && dst40hash( job.challenge2, full_key ) == r2[index] )
+        {
+          if( !_job.job.found[tags[index]] )
+          {
+            pthread_mutex_lock( &_job.lock );
+            _job.job.found[tags[index]] = true;
+            _job.job.keys[tags[index]]  = full_key;
+            pthread_mutex_unlock( &_job.lock );
+
+            checkpoint();                                       // Найденный ключ сразу записываем в журнал
+            found_count++;
+          }
+        }
+        else
+          printf( "\n\nWARNING: FPGA reported wrong key %010llX (tag %u)\n\n", full_key, index );
+      }
+    }
+
+    // Выходим из цикла, если найдены ключи всех меток или все ключи
+    // перебраны: к этому моменту все найденные ключи уже вычитаны из FIFO
+    if( found_count == n || ( flags & DST40_FLAG_DONE ) || ( end_key < DST40_KEYS && position >= end_key + DST40_LAG ) )
+    {
+      _telemetry.run = false;
+      pthread_join( _telemetry.thread, NULL );
+
+      cycles = _backend->cycles();                              // До остановки: в простое счётчик тактов сбрасывается
+      _backend->stop();
+
+      // Счётчики производительности после остановки уже не меняются
+      gettimeofday( &tv_now, NULL );
+
+      _perf.passes++;
+      _perf.time   += ( tv_now.tv_sec - tv_start.tv_sec ) + ( tv_now.tv_usec - tv_start.tv_usec ) / 1e6;
+      _perf.cycles += cycles;
+
+      if( _backend->perf( &perf ) )
+      {
+        _perf.known++;
+        _perf.sum.busy    += perf.busy;
+        _perf.sum.stall   += perf.stall;
+        _perf.sum.hold    += perf.hold;
+        _perf.sum.refill  += perf.refill;
+        _perf.sum.restarts = perf.restarts;
+
+        for( j=0; j < DST40_NK; j++ )
+          _perf.sum.hits[j] += perf.hits[j];
+      }
+
+      pthread_mutex_lock( &_job.lock );
+
+      for( j=0; j < n; j++ )
+        if( !_job.job.found[tags[j]] )
+          _job.job.pos[tags[j]] = JOURNAL_DONE;
+
+      _job.count = 0;
+
+      pthread_mutex_unlock( &_job.lock );
+
+      checkpoint();
+
+      return cycles;
+    }
+  }
+}
+
+
+
+/******************************************************************************
+ * Чтение файла меток для режима --batch.
+ *
+ * Вход:  name      - имя файла.
+ * Выход: c1, c2    - запросы,
+ *        start_key - ключ, с которого начинать поиск (0, если не задан),
+ *        r1, r2    - массивы ответов меток (выделяются malloc).
+ *
+ * Возвращает количество меток (0 - ошибка).
+ *****************************************************************************/
+
+uint32_t readBatch( const char *name, uint64_t *c1, uint64_t *c2, uint64_t *start_key, uint64_t **r1, uint64_t **r2 )
+{
+  FILE    *f;
+  char     line[256];
+  uint32_t n = 0, size = 0, line_no = 0;
+  bool     header = false, failed = false;
+
+  *r1 = *r2 = NULL;
+  *start_key = 0;
+
+  if( !( f = fopen( name, "r" ) ) )
+  {
+    perror( name );
+    return 0;
+  }
+
+  while( fgets( line, sizeof(line), f ) )
+  {
+    char *p = line;
+
+    line_no++;
+
+    while( *p == ' ' || *p == '\t' )
+      p++;
+
+    if( *p == '#' || *p == '\n' || *p == '\r' || !*p )            // Пустые строки и комментарии пропускаем
+      continue;
+
+    if( !header )                                               // Первая строка - запросы и стартовый ключ
+    {
+      if( sscanf( p, "%llx %llx %llx", c1, c2, start_key ) < 2 )
+        break;
+
+      header = true;
+      continue;
+    }
+
+    if( n == size )
+    {
+      uint64_t *t1, *t2;
+
+      size = size ? size * 2 : 16;
+
+      if( ( t1 = realloc( *r1, size * sizeof(uint64_t) ) ) )
+        *r1 = t1;
+
+      if( ( t2 = realloc( *r2, size * sizeof(uint64_t) ) ) )
+        *r2 = t2;
+
+      if( !t1 || !t2 )
+      {
+        printf( "\nERROR: %s: out of memory at line %u\n", name, line_no );
+        failed = true;
+        break;
+      }
+    }
+
+    if( sscanf( p, "%llx %llx", &(*r1)[n], &(*r2)[n] ) != 2 )
+      break;
+
+    (*r1)[n] &= 0xFFFFFF;
+    (*r2)[n] &= 0xFFFFFF;
+    n++;
+  }
+
+  if( !failed && !feof( f ) )
+  {
+    printf( "\nERROR: %s: bad line %u\n", name, line_no );
+    failed = true;
+  }
+
+  fclose( f );
+
+  if( failed )
+  {
+    free( *r1 );
+    free( *r2 );
+    *r1 = *r2 = NULL;
+    n = 0;
+  }
+
+  return n;
+}
+
+
+
+/******************************************************************************
+ * Разбор задания режимов --job и --jobs.
+ *
+ * Вход:  no   - номер задания,
+ *        line - задание: <challenge1> <response1> <challenge2>
+ *               <response2> [start_key [end_key]] (числа
+ *               шестнадцатеричные, end_key не включительно,
+ *               0 - до конца),
+ *        out  - поток результатов.
+ * Выход: job  - задание.
+ *
+ * На FPGA диапазон задаётся значениями счётчика перебора: конечное
+ * значение, не лежащее за стартовым, означает "до конца". Ключи
+ * в пределах последнего значения счётчика, а у образов без регистра
+ * конечного ключа - и немного ключей за ним, FPGA тоже проверяет,
+ * и подошедший из них тоже выводится.
+ *
+ * Возвращает 0, если строка пустая или комментарий, -1, если строка
+ * не разобрана (результат error уже выведен в out), и 1, если задание
+ * разобрано.
  *****************************************************************************/
 
-#include <stdio.h>
-#include <stdlib.h>
-#include <unistd.h>
-#include <fcntl.h>
-#include <termios.h>
-#include <time.h>
-#include <sys/mman.h>
-#include "hwlib.h"
-#include "socal/socal.h"
-#include "socal/hps.h"
-#include "socal/alt_gpio.h"
-#include <stdbool.h>
-#include <signal.h>
-#include <sys/time.h>
-#include <wchar.h>
-#include <locale.h>
-#include <math.h>
-#include "keyboard.h"
+int32_t parseJob( uint32_t no, const char *line, JOB_LINE *job, FILE *out )
+{
+  while( *line == ' ' || *line == '\t' )
+    line++;
+
+  if( *line == '#' || *line == '\n' || *line == '\r' || !*line )     // Пустые строки и комментарии пропускаем
+    return 0;
+
+  job->no        = no;
+  job->start_key = 0;
+  job->end_key   = 0;
+  job->key       = 0;
+  job->found     = false;
+
+  if( sscanf( line, "%llx %llx %llx %llx %llx %llx", &job->c1, &job->r1, &job->c2, &job->r2, &job->start_key, &job->end_key ) < 4 )
+  {
+    fprintf( out, "%u - - - - - - error - -\n", no );
+    fflush( out );
+    return -1;
+  }
+
+  job->r1 &= 0xFFFFFF;
+  job->r2 &= 0xFFFFFF;
+
+  if( !job->end_key || job->end_key > 0x10000000000ULL )
+    job->end_key = 0x10000000000ULL;
+
+  job->start = backendIndex( job->start_key );
+  job->end   = backendIndex( job->end_key - 1 ) + 1;
+
+  if( job->end <= job->start )
+    job->end = DST40_KEYS;
+
+  return 1;
+}
+
+
+
+/******************************************************************************
+ * Вывод результата задания в out (формат - в runJob()).
+ *
+ * Вход: job  - задание,
+ *       time - время выполнения, с,
+ *       out  - поток результатов.
+ *****************************************************************************/
+
+void printJob( const JOB_LINE *job, double time, FILE *out )
+{
+  fprintf( out, "%u %010llX %06llX %010llX %06llX %010llX %010llX ", job->no, job->c1, job->r1, job->c2, job->r2, job->start_key, job->end_key );
+
+  if( job->found )
+    fprintf( out, "found %010llX", job->key );
+  else
+    fprintf( out, "notfound -" );
+
+  fprintf( out, " %.3f\n", time );
+  fflush( out );
+}
+
+
+
+/******************************************************************************
+ * Выполнение одного задания режимов --job и --jobs.
+ *
+ * Вход: no          - номер задания,
+ *       line        - задание (формат - в parseJob()),
+ *       cpu_mode    - программный поиск,
+ *       cpu_threads - количество потоков программного поиска,
+ *       out         - поток результатов.
+ *
+ * Результат выводится в out одной строкой сразу по окончании задания:
+ *
+ *   <номер> <c1> <r1> <c2> <r2> <start> <end> found <ключ> <время, с>
+ *   <номер> <c1> <r1> <c2> <r2> <start> <end> notfound - <время, с>
+ *   <номер> - - - - - - error - -              - строка не разобрана
+ *
+ * Возвращает false, если строка пустая или комментарий.
+ *****************************************************************************/
+
+bool runJob( uint32_t no, const char *line, bool cpu_mode, uint32_t cpu_threads, FILE *out )
+{
+  JOB_LINE job;
+  uint64_t pos;
+  uint32_t tag = 0;
+  int32_t  parsed;
+  struct timeval tv_start, tv_now;
+
+  if( ( parsed = parseJob( no, line, &job, out ) ) <= 0 )
+    return parsed != 0;
+
+  printf( "\n\nJob %u: %010llX %06llX %010llX %06llX from %010llX to %010llX\n\n", no, job.c1, job.r1, job.c2, job.r2, job.start_key, job.end_key );
+
+  _time_start = time( NULL );
+  gettimeofday( &tv_start, NULL );
+
+  if( cpu_mode )
+    job.found = cpuSearch( job.c1, job.r1, job.c2, job.r2, job.start_key, job.end_key, cpu_threads, cpuProgress, &job.key );
+  else
+  {
+    pos = job.start;
+
+    _job.job.c1    = job.c1;
+    _job.job.c2    = job.c2;
+    _job.job.n     = 1;
+    _job.job.r1    = &job.r1;
+    _job.job.r2    = &job.r2;
+    _job.job.pos   = &pos;
+    _job.job.keys  = &job.key;
+    _job.job.found = &job.found;
+
+    fpgaSearch( &tag, 1, job.start, job.end );
+  }
+
+  gettimeofday( &tv_now, NULL );
+
+  printJob( &job, ( tv_now.tv_sec - tv_start.tv_sec ) + ( tv_now.tv_usec - tv_start.tv_usec ) / 1e6, out );
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * Вычитывание FIFO заданий, лежащих в очереди дескрипторов FPGA.
+ *
+ * Вход: q    - задания в порядке очереди FPGA,
+ *       n    - их количество,
+ *       base - номер задания q[0] в очереди FPGA.
+ *
+ * Ключ относится к заданию по номеру из FIFO. Как и в fpgaSearch(),
+ * ключ ещё раз проверяется программно; подошедший записывается
+ * в задание.
+ *****************************************************************************/
+
+void drainQueue( JOB_LINE *q, uint32_t n, uint32_t base )
+{
+  DST40_RESULT result;
+  JOB_LINE    *job;
+  uint64_t     key;
+  uint32_t     i;
+
+  while( _backend->result( &result ) )
+  {
+    if( ( ( result.job - base ) & 0xFFFF ) >= n )
+    {
+      printf( "\n\nWARNING: FPGA reported key for unknown job %u\n\n", result.job );
+      continue;
+    }
+
+    job = &q[( result.job - base ) & 0xFFFF];
+
+    for( i=0; i < DST40_NK; i++ )
+    {
+      if( !( ( result.kernels >> i ) & 1 ) )
+        continue;
+
+      key = backendKey( result.key, i );
+
+      if( dst40hash( job->c1, key ) == job->r1 && dst40hash( job->c2, key ) == job->r2 )
+      {
+        if( !job->found )
+        {
+          job->found = true;
+          job->key   = key;
+        }
+      }
+      else
+        printf( "\n\nWARNING: FPGA reported wrong key %010llX (job %u)\n\n", key, job->no );
+    }
+  }
+}
+
+
+
+/******************************************************************************
+ * Выполнение заданий режимов --job и --jobs через очередь дескрипторов
+ * FPGA (образы с DST40_CAPS_QUEUE).
+ *
+ * Вход: lines - задания из командной строки,
+ *       count - их количество,
+ *       f     - файл заданий (NULL - нет),
+ *       out   - поток результатов.
+ *
+ * Задания кладутся в очередь FPGA наперёд, и FPGA переходит от задания
+ * к заданию сама, без перезапуска программой. Следующая строка файла
+ * читается, только когда в очереди FPGA есть место. Результаты
+ * выводятся так же, как в runJob(), по счётчику выполненных заданий;
+ * время задания считается между окончаниями заданий, как их видит
+ * программа.
+ *
+ * Найденный ключ задание очереди не останавливает. Если задание
+ * с найденным ключом ещё идёт, очередь выключается, а задания, которые
+ * FPGA не успела начать, кладутся в неё заново.
+ *
+ * Возвращает количество заданий, как сумма результатов runJob().
+ *****************************************************************************/
+
+uint32_t runQueue( const char **lines, uint32_t count, FILE *f, FILE *out )
+{
+  JOB_LINE q[QUEUE_AHEAD];                                      // Задания: первые pushed - в очереди FPGA (q[0] выполняется),
+                                                                // остальные ждут места в ней
+  uint32_t used = 0, pushed = 0;
+  uint32_t base = 0;                                            // Номер задания q[0] в очереди FPGA
+  uint32_t no = 0, next = 0, done, k;
+  int32_t  parsed;
+  bool     eof = false, stopped;
+  char     line[256];
+  const char *p;
+  DST40_JOB desc;
+  struct timeval tv_head, tv_now;                               // Время начала задания q[0] и текущее
+  double   t;
+
+  _time_start = time( NULL );
+
+  while( 1 )
+  {
+    // Кладём задания в очередь FPGA, пока в ней есть место, и дочитываем
+    // следующие
 
+    while( 1 )
+    {
+      for( ; pushed < used; pushed++ )
+      {
+        desc.challenge  = q[pushed].c1;
+        desc.challenge2 = q[pushed].c2;
+        desc.start_key  = q[pushed].start;
+        desc.end_key    = ( q[pushed].end < DST40_KEYS ) ? q[pushed].end : 0;
+        desc.response   = &q[pushed].r1;
+        desc.response2  = &q[pushed].r2;
+        desc.count      = 1;
+
+        if( !_backend->push( &desc ) )
+          break;
+
+        if( !pushed )
+          gettimeofday( &tv_head, NULL );
+
+        printf( "\nJob %u: %010llX %06llX %010llX %06llX from %010llX to %010llX queued\n", q[pushed].no, q[pushed].c1,
+                q[pushed].r1, q[pushed].c2, q[pushed].r2, q[pushed].start_key, q[pushed].end_key );
+      }
 
-//#############################################################################
-// ОПРЕДЕЛЕНИЯ
+      if( pushed < used || used == QUEUE_AHEAD || eof )
+        break;
 
-// Адреса регистров в схеме DST40
+      if( next < count )
+        p = lines[next++];
+      else if( f && fgets( line, sizeof(line), f ) )
+        p = line;
+      else
+      {
+        eof = true;
+        break;
+      }
 
-#define DST40_CHALLENGE   (_h2f_base+0)
-#define DST40_RESPONSE    (_h2f_base+8)
-#define DST40_START_KEY   (_h2f_base+16)
-#define DST40_RUN         (_h2f_base+24)
-#define DST40_FLAGS       (_h2f_base+32)
-#define DST40_KEY         (_h2f_base+40)
-#define DST40_KERNELS     (_h2f_base+48)
+      if( ( parsed = parseJob( no + 1, p, &q[used], out ) ) )
+        no++;
 
+      if( parsed > 0 )
+        used++;
+    }
 
+    if( !used )
+      return no;
 
-//#############################################################################
-// ГЛОБАЛЬНЫЕ ПЕРЕМЕННЫЕ
+    // Ждём ключа или окончания задания: флаг done у задания очереди
+    // держится один такт, поэтому ждём с ограничением времени. Счётчик
+    // выполненных заданий читаем до FIFO - все ключи этих заданий уже
+    // в FIFO.
 
-int   _dst40_regs_file = 0;
-int   _irq_ctrl_file = 0;
-void* _h2f_base = 0;
+    _backend->wait( END_POLL_MS );
+    done    = _backend->completed() - base;
+    stopped = false;
 
+    drainQueue( q, pushed, base );
 
+    // Ключ найден в задании, которое ещё идёт: выключаем очередь. Ключи,
+    // попавшие в FIFO до выключения, - ещё с прежними номерами заданий.
 
-/******************************************************************************
- * Callback-обработчик кода Ctrl+C - для корректного завершения
- * работы программы.
- *****************************************************************************/
+    if( done < pushed && q[done].found )
+    {
+      _backend->stop();
+      drainQueue( q, pushed, base );
 
-void exitToLinux( int sig )
-{
-  if( sig != SIGINT )
-    return;
+      done++;
+      pushed  = 0;
+      stopped = true;
+    }
 
-  if( _h2f_base )
-  {
-    alt_write_dword( DST40_RUN, 0 );                            // Останавливаем FPGA
+    // Выводим законченные задания. Ключ задания, которое FPGA начала
+    // перед самым выключением очереди, тоже мог успеть найтись - такое
+    // задание тоже закончено.
 
-    if( munmap( _h2f_base, 1024 ) != 0 )                        // Размапливаем регистры модуля DST40
-      printf( "\nERROR: munmap() failed...\n" );
-  }
+    gettimeofday( &tv_now, NULL );
 
-  if( _dst40_regs_file > 0 )                                    // Закрываем файл маппера,
-    close( _dst40_regs_file );                                  // если он был открыт
+    for( k=0; k < used && ( k < done || ( k >= pushed && q[k].found ) ); k++ )
+    {
+      t = ( tv_now.tv_sec - tv_head.tv_sec ) + ( tv_now.tv_usec - tv_head.tv_usec ) / 1e6;
+      tv_head = tv_now;
 
-  if( _irq_ctrl_file > 0 )                                      // Закрываем файл обработчика прерываний,
-    close( _irq_ctrl_file );                                    // если он был открыт
+      printJob( &q[k], t, out );
 
-  printf( "\n" );                                               // Переводим строку - чтобы приглашение вывелось в следующей строке
-  echoOnOff( ECHO_ON );                                         // Переводим терминал в канонический режим работы
-  exit( 0 );
+      _perf.passes++;
+      _perf.time += t;
+    }
+
+    if( k )
+    {
+      memmove( q, q + k, ( used - k ) * sizeof(JOB_LINE) );
+      used  -= k;
+      pushed = ( pushed > k ) ? pushed - k : 0;
+      base  += k;
+    }
+
+    if( stopped )                                               // Включённая заново очередь нумерует задания с нуля
+      base = 0;
+
+    if( pushed )
+    {
+      printf( "\rSearching... [%lds] [job %u] ", time( NULL ) - _time_start, q[0].no );
+      fflush( stdout );
+    }
+  }
 }
 
 
@@ -116,46 +1161,372 @@ void exitToLinux( int sig )
 
 int main( int argc, char** argv )
 {
-  bool  irq_enable = false;                                     // Признак наличия в системе драйвера обработчика прерываний IRQ0
+  bool  cpu_mode = false;                                       // Признак программного поиска (без FPGA)
+  const DST40_BACKEND *backend = &backendMmap;                  // Исполнитель поиска на FPGA
+  uint32_t cpu_threads = 0;                                     // Количество потоков программного поиска (0 - по числу ядер)
+  const char *batch_name = NULL;                                // Файл меток для пакетного режима (NULL - диалог с пользователем)
+  const char *resume_name = NULL;                               // Журнал, по которому продолжается поиск
+  const char *worker_address = NULL;                            // Адрес координатора (режим исполнителя)
+  uint16_t coordinator_port = 0;                                // Порт координатора (0 - не координатор)
+  uint32_t lease_bits = NET_LEASE_BITS;                         // Логарифм по основанию 2 от размера аренды
+  const char *jobs_name = NULL;                                 // Файл заданий для --jobs ("-" - стандартный ввод)
+  const char **job_lines = malloc( argc * sizeof(char *) );     // Задания из командной строки (--job)
+  uint32_t job_count = 0;
+  const char *daemon_path = NULL;                               // Unix-сокет демона (режим --daemon)
+  const char *submit_path = NULL;                               // Unix-сокет демона, которому отправляются задания
+  const char *queue_path = NULL;                                // Unix-сокет демона, очередь которого выводится
+  int32_t  priority = 0;                                        // Приоритет заданий, отправляемых демону
+  const char *tmto_name = NULL;                                 // Файл радужной таблицы для построения
+  uint64_t tmto_args[5] = { 0, 0, 0, TMTO_LENGTH, TMTO_CHAINS };// Запросы, номер таблицы, длина и количество цепочек
+  uint32_t tmto_argc = 0;
+  uint64_t key_mask = 0, key_value = 0;                         // Известные биты ключа (--mask)
+  char   **tmto_files = NULL;                                   // Радужные таблицы для поиска по ответам tmto_args[0..1]
+  uint32_t tmto_count = 0;
+  uint32_t i, j, n = 0, found_count;
 	char  buf[20];
 
-	time_t time_start, time_now;
+  uint64_t c1, r1, c2, r2, start_key = 0;
+  uint64_t *r1s = &r1, *r2s = &r2;                              // Ответы меток (в диалоговом режиме метка одна)
+  uint64_t *keys;                                               // Найденные ключи меток
+  uint64_t cycles;                                              // Количество тактов ядер FPGA за проход
+  struct timeval tv_start, tv_now;
+  bool     *found;                                              // Признаки "ключ метки найден"
+  pthread_t journal_thread;
+
+  // Разбираем командную строку
+
+#ifndef __arm__
+  cpu_mode = true;                                              // На хосте без HPS - только программный поиск
+#endif
+
+  for( i=1; i < argc; i++ )
+  {
+    if( !strcmp( argv[i], "--cpu" ) || !strcmp( argv[i], "-c" ) )
+    {
+      cpu_mode = true;
+
+      if( i + 1 < argc && argv[i+1][0] >= '0' && argv[i+1][0] <= '9' )
+        cpu_threads = atoi( argv[++i] );
+    }
+    else if( ( !strcmp( argv[i], "--batch" ) || !strcmp( argv[i], "-b" ) ) && i + 1 < argc )
+      batch_name = argv[++i];
+    else if( !strcmp( argv[i], "--backend" ) && i + 1 < argc && ( backend = backendByName( argv[i+1] ) ) )
+    {
+      cpu_mode = false;
+      i++;
+    }
+    else if( !strcmp( argv[i], "--ring" ) && i + 1 < argc )
+    {
+      char          *end;
+      unsigned long  base   = strtoul( argv[++i], &end, 16 );
+      uint32_t       l2size = ( *end == ':' ) ? atoi( end + 1 ) : RING_L2SIZE;
+
+      if( ( base & 0xFFF ) || l2size < 1 || l2size > RING_MAX_L2SIZE || ( *end && *end != ':' ) )
+      {
+        printf( "\nERROR: --ring expects a page-aligned hex address and 1..%u size bits\n", RING_MAX_L2SIZE );
+        return 1;
+      }
+
+      backendRing( base, l2size );
+    }
+    else if( !strcmp( argv[i], "--journal" ) && i + 1 < argc )
+      _job.name = argv[++i];
+    else if( !strcmp( argv[i], "--resume" ) && i + 1 < argc )
+      _job.name = resume_name = argv[++i];
+    else if( !strcmp( argv[i], "--coordinator" ) && i + 1 < argc && atoi( argv[i+1] ) > 0 && atoi( argv[i+1] ) < 65536 )
+      coordinator_port = atoi( argv[++i] );
+    else if( !strcmp( argv[i], "--lease" ) && i + 1 < argc && atoi( argv[i+1] ) >= 12 && atoi( argv[i+1] ) <= 40 - DST40_L2NK )
+      lease_bits = atoi( argv[++i] );
+    else if( !strcmp( argv[i], "--kernels" ) && i + 1 < argc && atoi( argv[i+1] ) > 0 && atoi( argv[i+1] ) <= DST40_MAX_NK &&
+             !( atoi( argv[i+1] ) & ( atoi( argv[i+1] ) - 1 ) ) )
+      backendKernels( atoi( argv[++i] ) );                      // Для модели FPGA и координатора - у платы читается из FPGA
+    else if( !strcmp( argv[i], "--interleave" ) )
+      backendInterleave( true );                                // Так же: у платы - бит DST40_CAPS_INTERLEAVE
+    else if( !strcmp( argv[i], "--mask" ) && i + 1 < argc && sscanf( argv[i+1], "%llx:%llx", &key_mask, &key_value ) >= 1 )
+      i++;
+    else if( !strcmp( argv[i], "--job" ) && i + 1 < argc )
+      job_lines[job_count++] = argv[++i];
+    else if( !strcmp( argv[i], "--jobs" ) && i + 1 < argc )
+      jobs_name = argv[++i];
+    else if( !strcmp( argv[i], "--daemon" ) && i + 1 < argc )
+    {
+      daemon_path = argv[++i];
+#ifdef __arm__
+      cpu_mode = false;                                         // Демон ищет на FPGA
+#endif
+    }
+    else if( !strcmp( argv[i], "--submit" ) && i + 1 < argc )
+      submit_path = argv[++i];
+    else if( !strcmp( argv[i], "--queue" ) && i + 1 < argc )
+      queue_path = argv[++i];
+    else if( !strcmp( argv[i], "--priority" ) && i + 1 < argc )
+      priority = atoi( argv[++i] );
+    else if( !strcmp( argv[i], "--tmto-build" ) && i + 3 < argc )
+    {
+      tmto_name = argv[++i];
+
+      for( tmto_argc=0; tmto_argc < 5 && i + 1 < argc && strncmp( argv[i+1], "--", 2 ); tmto_argc++ )
+        tmto_args[tmto_argc] = strtoull( argv[++i], NULL, tmto_argc < 2 ? 16 : 0 );
+    }
+    else if( !strcmp( argv[i], "--tmto-lookup" ) && i + 3 < argc )
+    {
+      tmto_args[0] = strtoull( argv[++i], NULL, 16 );
+      tmto_args[1] = strtoull( argv[++i], NULL, 16 );
+      tmto_files   = &argv[i+1];
+
+      for( tmto_count=0; i + 1 < argc && strncmp( argv[i+1], "--", 2 ); tmto_count++ )
+        i++;
+    }
+    else if( !strcmp( argv[i], "--worker" ) && i + 1 < argc )
+    {
+      worker_address = argv[++i];
+#ifdef __arm__
+      cpu_mode = false;                                         // Исполнитель ищет на FPGA
+#endif
+    }
+    else
+    {
+      printf( "Usage: %s [--cpu [threads]] [--batch file] [--backend mmap|sim|null] [--ring addr[:bits]] [--journal file | --resume file]\n"
+              "       [--kernels n] [--interleave] [--mask mask[:value]] [--coordinator port [--lease bits] | --worker host:port] [--job \"c1 r1 c2 r2 [start [end]]\"] [--jobs file]\n"
+              "       [--daemon socket | --submit socket [--priority n] | --queue socket]\n"
+              "       [--tmto-build file c1 c2 [table [length [chains]]] | --tmto-lookup r1 r2 table...]\n"
+              "       (tmto tables are plain rainbow tables with full-length chains, no distinguished points)\n", argv[0] );
+      return 1;
+    }
+  }
+
+  if( _job.name && ( cpu_mode || coordinator_port || worker_address ) )
+  {
+    printf( "\nERROR: --journal and --resume work only for FPGA search on one board (see --backend)\n" );
+    return 1;
+  }
+
+  if( key_mask && ( cpu_mode || coordinator_port || worker_address || daemon_path || submit_path || resume_name ) )
+  {
+    printf( "\nERROR: --mask works only for FPGA search on one board and can't be used with --resume (the journal keeps it)\n" );
+    return 1;
+  }
+
+  if( worker_address && cpu_mode )
+  {
+    printf( "\nERROR: --worker searches on FPGA only (use --backend sim on a host)\n" );
+    return 1;
+  }
+
+  //------------------------------------------------------------//
+  // Радужные таблицы: построение и поиск ключа по ним          //
+
+  if( tmto_name )
+  {
+    if( tmto_argc < 2 || !tmto_args[3] || !tmto_args[4] )
+    {
+      printf( "\nERROR: --tmto-build needs two challenges, length and chains must not be 0\n" );
+      return 1;
+    }
+
+    return tmtoBuild( tmto_name, tmto_args[0], tmto_args[1], tmto_args[2], tmto_args[3], tmto_args[4], cpu_threads ) ? 0 : 1;
+  }
+
+  if( tmto_count )
+  {
+    uint64_t key;
+
+    for( i=0; i < tmto_count; i++ )
+      if( tmtoLookup( tmto_files[i], tmto_args[0], tmto_args[1], cpu_threads, &key ) )
+      {
+        printf( "\nKEY FOUND: %010llX\n\n", key );
+        return 0;
+      }
+
+    printf( "\nKey not found in tables\n\n" );
+    return 2;
+  }
+
+  //------------------------------------------------------------//
+  // Демон поиска и его клиенты                                 //
+
+  if( daemon_path )
+  {
+    if( cpu_mode )
+    {
+      printf( "\nERROR: --daemon searches on FPGA only (use --backend sim on a host)\n" );
+      return 1;
+    }
+
+    catchInterrupt();
+
+    printf( "\n\nFPGA backend: %s\n\nPress Ctrl+C for exit\n", backend->name );
+
+    if( !backend->open() )
+      return 1;
+
+    _backend = backend;
+
+    daemonRun( daemon_path, backend );
+    exitToLinux( SIGINT );
+  }
+
+  if( queue_path )
+    return daemonStatus( queue_path ) ? 0 : 1;
+
+  if( submit_path )
+  {
+    FILE *f = NULL;
+
+    if( jobs_name && !( f = strcmp( jobs_name, "-" ) ? fopen( jobs_name, "r" ) : stdin ) )
+    {
+      perror( jobs_name );
+      return 1;
+    }
+
+    return daemonSubmit( submit_path, priority, job_lines, job_count, f ) ? 0 : 1;
+  }
+
+  //------------------------------------------------------------//
+  // Очередь заданий без диалога: результаты - в stdout по      //
+  // строке на задание, всё остальное - в stderr. FPGA          //
+  // подключается один раз на всю очередь.                      //
+
+  if( job_count || jobs_name )
+  {
+    FILE *out, *f = NULL;
+    char  line[256];
+
+    if( batch_name || _job.name || coordinator_port || worker_address )
+    {
+      printf( "\nERROR: --job and --jobs can't be used with --batch, --journal, --resume, --coordinator or --worker\n" );
+      return 1;
+    }
+
+    if( jobs_name && !( f = strcmp( jobs_name, "-" ) ? fopen( jobs_name, "r" ) : stdin ) )
+    {
+      perror( jobs_name );
+      return 1;
+    }
+
+    out = fdopen( dup( STDOUT_FILENO ), "w" );
+    dup2( STDERR_FILENO, STDOUT_FILENO );
+
+    catchInterrupt();
+
+    if( !cpu_mode )
+    {
+      if( !backend->open() )
+        return 1;
+
+      _backend = backend;
+
+      if( !backendMask( key_mask, key_value ) )
+        exitToLinux( SIGINT );
+    }
+
+    fprintf( out, "# job challenge1 response1 challenge2 response2 start_key end_key result key time\n" );
+    fflush( out );
+
+    if( !cpu_mode && _backend->push && ( _caps.features & DST40_CAPS_QUEUE ) )
+      n = runQueue( job_lines, job_count, f, out );             // Задания идут через очередь дескрипторов FPGA
+    else
+    {
+      for( i=0, n=0; i < job_count; i++ )
+        n += runJob( n + 1, job_lines[i], cpu_mode, cpu_threads, out );
+
+      while( f && fgets( line, sizeof(line), f ) )              // Задания из файла выполняются по мере чтения
+        n += runJob( n + 1, line, cpu_mode, cpu_threads, out );
+    }
+
+    fclose( out );
+    exitToLinux( SIGINT );
+  }
+
+  //------------------------------------------------------------//
+  // Исполнитель распределённого поиска: задание - от           //
+  // координатора                                               //
+
+  if( worker_address )
+  {
+    catchInterrupt();
 
-  uint64_t c1, r1, c2, r2, start_key;
-  uint64_t key1 = -1;
-  uint64_t key2 = -1;
-  uint64_t kernels1 = 0;
-  uint64_t kernels2 = 0;
-  uint8_t  data_set = 0;                                        // Идентификатор текущего набора данных (0 или FF)
+    printf( "\n\nFPGA backend: %s\n\nPress Ctrl+C for exit\n", backend->name );
 
-  // Флаги текущего состояния FPGA
+    if( !backend->open() )
+      return 1;
 
-  union
+    _backend = backend;
+
+    i = netWorker( worker_address, backend );
+
+    _backend = NULL;                                            // Ctrl+C после этого FPGA уже не трогает
+    backend->close();
+    return i ? 0 : 1;
+  }
+
+  pthread_mutex_init( &_job.lock, NULL );
+
+  //------------------------------------------------------------//
+  // Продолжение поиска по журналу                              //
+
+  if( resume_name )
   {
-    uint64_t Val;
+    if( !journalLoad( resume_name, &_job.job ) )
+      return 1;
+
+    batch_name = resume_name;                                   // Результаты выводим, как в пакетном режиме
+    c1  = _job.job.c1;
+    c2  = _job.job.c2;
+    n   = _job.job.n;
+    r1s = _job.job.r1;
+    r2s = _job.job.r2;
 
-    struct
+    printf( "\n\nResuming from journal \"%s\"", resume_name );
+    printf( "\n\nChallenge1 = %010llX", c1 );
+    printf( "\nChallenge2 = %010llX", c2 );
+    printf( "\nTags       = %u\n", n );
+  }
+
+  //------------------------------------------------------------//
+  // Пакетный режим: метки читаются из файла                    //
+
+  else if( batch_name )
+  {
+    if( !( n = readBatch( batch_name, &c1, &c2, &start_key, &r1s, &r2s ) ) )
     {
-      uint8_t  key_found;
-      uint8_t  key_not_found;
-      uint32_t reserved1;
-      uint8_t  reserved2;
-    };
-  } flags;
+      printf( "\nERROR: no tags in \"%s\"\n", batch_name );
+      return 1;
+    }
+
+    printf( "\n\nChallenge1 = %010llX", c1 );
+    printf( "\nChallenge2 = %010llX", c2 );
+    printf( "\nStart key  = %010llX", start_key );
+    printf( "\nTags       = %u\n", n );
+  }
+
+  if( coordinator_port && n > DST40_NR )
+  {
+    printf( "\nERROR: coordinator takes at most %u tags\n", DST40_NR );
+    return 1;
+  }
 
   // Выключаем вывод нажатых клавиш в терминал
   echoOnOff( ECHO_OFF );
 
   // Устанавливаем свой обработчик нажатий Ctrl+C
-  signal( SIGINT, exitToLinux );
-
-  printf( "\n\nWARNING: Don't forget to load FPGA\n\nPress Ctrl+C for exit\n" );
+  catchInterrupt();
+
+  if( coordinator_port )
+    printf( "\n\nDistributed search: waiting for workers on port %u\n\nPress Ctrl+C for exit\n", coordinator_port );
+  else if( cpu_mode )
+    printf( "\n\nCPU search: %u threads\n\nPress Ctrl+C for exit\n", cpu_threads ? cpu_threads : cpuThreads() );
+  else if( backend == &backendMmap )
+    printf( "\n\nWARNING: Don't forget to load FPGA\n\nPress Ctrl+C for exit\n" );
+  else
+    printf( "\n\nFPGA backend: %s\n\nPress Ctrl+C for exit\n", backend->name );
 
   //------------------------------------------------------------//
   // Запрос входных данных
 
-  while( 1 )
+  while( !batch_name )
   {
+    n = 1;
     c1 = 0;
     r1 = 0;
     c2 = 0;
@@ -198,149 +1569,196 @@ int main( int argc, char** argv )
 
     // Ждём нажатия Y или N - выходим из цикла, если нажали 'Y'
     if( getYN() == 'Y' )
+    {
+      // Выводим "Y" в терминал
+      printf( "Y\n\n" );
       break;
+    }
 
     // Выводим "N" в терминал
     printf( "N\n\n" );
   }
 
-  // Выводим "Y" в терминал
-  printf( "Y\n\n" );
+  // Подключаемся к FPGA (или к её модели): положения перебора зависят
+  // от количества ядер образа
 
-  //------------------------------------------------------------//
-  // Поиск ключа                                                //
+  if( !cpu_mode && !coordinator_port )
+  {
+    if( !backend->open() )
+      exitToLinux( SIGINT );
 
-  // Открываем файл драйвера IRQ
+    _backend = backend;
 
-  if( ( _irq_ctrl_file = open( "/dev/irq-ctrl", O_RDONLY ) ) == -1 )
-    printf( "\nWARNING: IRQ-CTRL driver not found: Cyclic poll flags will be used\n" );
-  else
-    irq_enable = true;
+    if( resume_name && ( _job.job.kernels ? _job.job.kernels : 4 ) != DST40_NK )
+    {
+      printf( "\nERROR: journal was written for %u kernels, FPGA has %u\n", _job.job.kernels ? _job.job.kernels : 4, DST40_NK );
+      exitToLinux( SIGINT );
+    }
 
-  // Маппим регистры модуля DST40 в память
+    if( resume_name && _job.job.interleave != DST40_INTERLEAVE )
+    {
+      printf( "\nERROR: journal was written for %s key layout, FPGA has %s\n", _job.job.interleave ? "interleaved" : "plain",
+              DST40_INTERLEAVE ? "interleaved" : "plain" );
+      exitToLinux( SIGINT );
+    }
 
-  if( ( _dst40_regs_file = open( "/dev/mem", ( O_RDWR | O_SYNC ) ) ) == -1 )
-  {
-    perror( "\nERROR: could not open \"/dev/mem\"\n" );
-    exitToLinux( SIGINT );
+    if( resume_name )
+    {
+      key_mask  = _job.job.mask;
+      key_value = _job.job.value;
+    }
+
+    if( !backendMask( key_mask, key_value ) )
+      exitToLinux( SIGINT );
+
+    _job.job.kernels    = DST40_NK;
+    _job.job.interleave = DST40_INTERLEAVE;
+    _job.job.mask       = key_mask & 0xFFFFFFFFFFULL;
+    _job.job.value      = key_value & key_mask & 0xFFFFFFFFFFULL;
   }
 
-  _h2f_base = mmap( NULL, 1024, ( PROT_READ | PROT_WRITE ), MAP_SHARED, _dst40_regs_file, 0xC0000000 );
+  // Новое задание: ни один ключ не найден, перебор для всех меток
+  // начинается со стартового ключа (на FPGA - со значения счётчика
+  // перебора, на котором проверяется стартовый ключ)
 
-  if( _h2f_base == MAP_FAILED )
+  if( !resume_name )
   {
-    _h2f_base = 0;
-    perror( "\nERROR: mmap() failed\n" );
-    exitToLinux( SIGINT );
+    _job.job.c1    = c1;
+    _job.job.c2    = c2;
+    _job.job.n     = n;
+    _job.job.r1    = r1s;
+    _job.job.r2    = r2s;
+    _job.job.pos   = malloc( n * sizeof(uint64_t) );
+    _job.job.keys  = malloc( n * sizeof(uint64_t) );
+    _job.job.found = malloc( n * sizeof(bool) );
+
+    for( j=0; j < n; j++ )
+    {
+      _job.job.pos[j]   = ( cpu_mode && !coordinator_port ) ? start_key : backendIndex( start_key );
+      _job.job.found[j] = false;
+    }
   }
 
-  printf( "\n\nKey search has been started\n\n" );
+  keys  = _job.job.keys;
+  found = _job.job.found;
 
-  // Запоминаем время старта поиска
-  time_start = time( NULL );
+  //------------------------------------------------------------//
+  // Распределённый поиск: аренды раздаются исполнителям        //
 
-  // Начинаем поиск со стартового ключа
-  key1 = start_key;
+  if( coordinator_port )
+  {
+    printf( "\n\nKey search has been started\n" );
 
-  // Останавливаем FPGA
-  alt_write_dword( DST40_RUN, 0 );
+    gettimeofday( &tv_start, NULL );
 
-  while( 1 )
-  {
-    uint64_t curr_key;
+    if( !netCoordinator( coordinator_port, &_job.job, lease_bits ) )
+      exitToLinux( SIGINT );
 
-    // Загружаем исходные данные в FPGA
-    if( !data_set )
-    {
-      alt_write_dword( DST40_CHALLENGE, c1   );
-      alt_write_dword( DST40_RESPONSE,  r1   );
-      alt_write_dword( DST40_START_KEY, key1 );
-      curr_key = key1;
-    }
-    else
-    {
-      alt_write_dword( DST40_CHALLENGE, c2   );
-      alt_write_dword( DST40_RESPONSE,  r2   );
-      alt_write_dword( DST40_START_KEY, key2 );
-      curr_key = key2;
-    }
+    gettimeofday( &tv_now, NULL );
 
-    // Разрешаем FPGA искать ключ
-    alt_write_dword( DST40_RUN, 1 );
+    printf( "\n\nSearch time: %.6f s", ( tv_now.tv_sec - tv_start.tv_sec ) + ( tv_now.tv_usec - tv_start.tv_usec ) / 1e6 );
+  }
 
-    // Выводим информацию о текущем ключе, времени и прогрессе в терминал
-    time_now = time( NULL ) - time_start;
-    printf( "\rCurrent KEY: %010llX [%lds] [%lld%%] ", curr_key, time_now, ((curr_key * 100) / 0x4000000000) );
-    fflush( stdout );
+  //------------------------------------------------------------//
+  // Программный поиск ключа: метки по очереди                  //
 
-    if( irq_enable )
+  else if( cpu_mode )
+  {
+    for( j=0; j < n; j++ )
     {
-      // Засыпаем до момента прерывания
-      read( _irq_ctrl_file, buf, 1 );
+      if( batch_name )
+        printf( "\n\nTag %u: %06llX %06llX", j, r1s[j], r2s[j] );
 
-      // Считываем флаги из FPGA
-      flags.Val = alt_read_dword( DST40_FLAGS );
-    }
-    else
-    {
-      // Читаем флаги в цикле, пока какой-нибудь флаг не взведётся -
-      // это приводит к полной загрузке одного ядра процессора.
-      do
-      {
-        flags.Val = alt_read_dword( DST40_FLAGS );
-      }
-      while( !flags.Val );
-    }
+      printf( "\n\nKey search has been started\n\n" );
 
-    // Считываем текущий ключ и биты ядер из FPGA
-    if( !data_set )
-    {
-      key2     = alt_read_dword( DST40_KEY );
-      kernels2 = alt_read_dword( DST40_KERNELS );
-    }
-    else
-    {
-      key1     = alt_read_dword( DST40_KEY );
-      kernels1 = alt_read_dword( DST40_KERNELS );
+      _time_start = time( NULL );
+
+      found[j] = cpuSearch( c1, r1s[j], c2, r2s[j], start_key, 0x10000000000ULL, cpu_threads, cpuProgress, &keys[j] );
     }
+  }
 
-    // Останавливаем FPGA
-    alt_write_dword( DST40_RUN, 0 );
+  //------------------------------------------------------------//
+  // Поиск ключа на FPGA: за проход - до DST40_NR меток,        //
+  // для которых ключ ещё не найден и перебор не закончен       //
 
-    // Выходим из цикла, если все ключи перебраны
-    if( flags.key_not_found )
+  else
+  {
+    if( _job.name )
     {
-      time_now = time( NULL ) - time_start;
-      printf( "\rCurrent KEY: 3FFFFFFFFF [%lds] [100%%] ", time_now );
-      printf( "\n\nKey not found\n\n" );
-      exitToLinux( SIGINT );
+      checkpoint();
+      pthread_create( &journal_thread, NULL, checkpointThread, NULL );
     }
 
-    // Если уже выполнены две проверки одного и того-же ключа
-    // с разными парами запрос/ответ и оба раза ключ обнаружен
-    // одним и тем-же ядром, то считаем ключ найденным и выходим.
-    if( key1 == key2 && ( kernels1 & kernels2 ) != 0 )
+    for( j=0; j < n; )
     {
-      uint64_t full_key;
+      uint32_t tags[DST40_MAX_NR], count = 0;
+      uint64_t pass_start = DST40_KEYS;
 
-      switch( kernels1 & kernels2 )
-      {
-        case 2:  full_key = 1;  break;
-        case 4:  full_key = 2;  break;
-        case 8:  full_key = 3;  break;
-        default: full_key = 0;  break;
-      }
+      // Проход начинается с наименьшего из положений перебора его меток:
+      // после продолжения по журналу они могут различаться
 
-      full_key = ( full_key << 38) | key1;
+      for( ; j < n && count < DST40_NR; j++ )
+        if( !found[j] && _job.job.pos[j] < JOURNAL_DONE )
+        {
+          tags[count++] = j;
 
-      printf( "\n\nKEY FOUND: %010llX\n\n", full_key );
-      exitToLinux( SIGINT );
+          if( _job.job.pos[j] < pass_start )
+            pass_start = _job.job.pos[j];
+        }
+
+      if( !count )
+        break;
+
+      if( batch_name )
+        printf( "\n\nTags %u..%u (%u tags) from key %010llX", tags[0], tags[count-1], count, pass_start );
+
+      printf( "\n\nKey search has been started\n\n" );
+
+      // Запоминаем время старта поиска
+      _time_start = time( NULL );
+      gettimeofday( &tv_start, NULL );
+
+      cycles = fpgaSearch( tags, count, pass_start, DST40_KEYS );
+
+      // Время работы программы и время работы ядер FPGA (если исполнитель
+      // его знает) - их разница показывает накладные расходы программы
+      gettimeofday( &tv_now, NULL );
+
+      printf( "\n\nSearch time: %.6f s", ( tv_now.tv_sec - tv_start.tv_sec ) + ( tv_now.tv_usec - tv_start.tv_usec ) / 1e6 );
+
+      if( cycles )
+        printf( ", FPGA time: %.6f s (%llu cycles at %u MHz)", cycles / ( DST40_CLOCK_MHZ * 1e6 ), cycles, DST40_CLOCK_MHZ );
     }
+  }
+
+  //------------------------------------------------------------//
+  // Вывод результатов                                          //
+
+  for( j=0, found_count=0; j < n; j++ )
+    found_count += found[j];
+
+  if( !batch_name )
+  {
+    if( found[0] )
+      printf( "\n\nKEY FOUND: %010llX\n\n", keys[0] );
+    else
+      printf( "\n\nKey not found\n\n" );
+  }
+  else
+  {
+    printf( "\n\n" );
 
-    // Переключаемся на другой набор исходных данных
-    data_set ^= 0xFF;
+    for( j=0; j < n; j++ )
+      if( found[j] )
+        printf( "Tag %u: %06llX %06llX KEY FOUND: %010llX\n", j, r1s[j], r2s[j], keys[j] );
+      else
+        printf( "Tag %u: %06llX %06llX Key not found\n", j, r1s[j], r2s[j] );
+
+    printf( "\nFound %u of %u keys\n", found_count, n );
   }
 
+  exitToLinux( SIGINT );
+
   // Осчастливливаем Eclipse
   return 0;
 }
@@ -0,0 +1,333 @@
+/******************************************************************************
+ *
+ * Скалярная реализация хэш-функции DST40: один ключ за вызов.
+ *
+ * dst40hashRef() - эталон, с которым сверяются все ускоренные
+ * реализации, dst40hash() - быстрая табличная реализация, используемая
+ * для проверки кандидатов.
+ *
+ * Это единственная копия хэша: программа dst40test собирается с этим же
+ * файлом (ссылка dst40hash.c в dst40test/.project, TEST_SRC
+ * в software/Makefile).
+ *
+ *****************************************************************************/
+
+#include <stdint.h>
+#include "dst40hash.h"
+
+
+typedef union
+{
+  uint64_t Val;
+
+  struct
+  {
+    uint8_t b0:1;
+    uint8_t b1:1;
+    uint8_t b2:1;
+    uint8_t b3:1;
+    uint8_t b4:1;
+    uint8_t b5:1;
+    uint8_t b6:1;
+    uint8_t b7:1;
+    uint8_t b8:1;
+    uint8_t b9:1;
+    uint8_t b10:1;
+    uint8_t b11:1;
+    uint8_t b12:1;
+    uint8_t b13:1;
+    uint8_t b14:1;
+    uint8_t b15:1;
+    uint8_t b16:1;
+    uint8_t b17:1;
+    uint8_t b18:1;
+    uint8_t b19:1;
+    uint8_t b20:1;
+    uint8_t b21:1;
+    uint8_t b22:1;
+    uint8_t b23:1;
+    uint8_t b24:1;
+    uint8_t b25:1;
+    uint8_t b26:1;
+    uint8_t b27:1;
+    uint8_t b28:1;
+    uint8_t b29:1;
+    uint8_t b30:1;
+    uint8_t b31:1;
+    uint8_t b32:1;
+    uint8_t b33:1;
+    uint8_t b34:1;
+    uint8_t b35:1;
+    uint8_t b36:1;
+    uint8_t b37:1;
+    uint8_t b38:1;
+    uint8_t b39:1;
+    uint8_t reserved1;
+    uint8_t reserved2;
+    uint8_t reserved3;
+  };
+} WORD40;
+
+
+
+/******************************************************************************
+ * Эталонная реализация.
+ *
+ * Расчёт новых двух старших бит хэша. Таблицы инициализируются на стеке
+ * при каждом вызове, биты индексов собираются по одному через WORD40.
+ * Оставлена для сверки и для сравнения скорости (dst40test --bench).
+ *****************************************************************************/
+
+uint64_t block192Ref( uint64_t hash_in, uint64_t key_in )
+{
+  uint8_t fa[32] = { 0, 1, 0, 1, 1, 0, 1, 1, 1, 1, 0, 0, 1, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 1, 1, 0, 1, 0, 1, 1, 0, 1 };
+  uint8_t fb[32] = { 0, 1, 1, 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 1, 0, 0, 0, 0, 0, 0, 1, 1, 0 };
+  uint8_t fc[32] = { 0, 0, 1, 0, 1, 1, 1, 0, 1, 0, 1, 1, 1, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 0, 1, 0, 1, 0, 1, 0, 1 };
+  uint8_t fd[32] = { 0, 1, 0, 1, 1, 1, 0, 0, 0, 0, 1, 1, 1, 0, 1, 0, 0, 0, 1, 1, 1, 0, 1, 0, 0, 1, 0, 1, 1, 1, 0, 0 };
+  uint8_t fe[16] = { 0, 1, 0, 1, 0, 0, 1, 1, 1, 1, 0, 0, 1, 0, 1, 0 };
+  uint8_t fg[16] = { 0, 1, 1, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 0 };
+  uint8_t fh[16] = { 0, 0, 2, 3, 3, 1, 2, 1, 1, 2, 1, 3, 3, 2, 0, 0 };
+
+  WORD40 hash;
+  WORD40 key;
+
+  hash.Val = hash_in;
+  key.Val  = key_in;
+
+  uint8_t fa1  = fa[ (key.b39 << 4) | (key.b31 << 3) | (hash.b39 << 2) | (hash.b31 << 1) | hash.b23 ];
+  uint8_t fb2  = fb[ (key.b38 << 4) | (key.b30 << 3) | (hash.b38 << 2) | (hash.b30 << 1) | hash.b22 ];
+  uint8_t fc3  = fc[ (key.b23 << 4) | (key.b15 << 3) | (key.b7   << 2) | (hash.b15 << 1) | hash.b7  ];
+  uint8_t fd4  = fd[ (key.b22 << 4) | (key.b14 << 3) | (key.b6   << 2) | (hash.b14 << 1) | hash.b6  ];
+
+  uint8_t fa5  = fa[ (key.b37 << 4) | (key.b29 << 3) | (hash.b37 << 2) | (hash.b29 << 1) | hash.b21 ];
+  uint8_t fb6  = fb[ (key.b36 << 4) | (key.b28 << 3) | (hash.b36 << 2) | (hash.b28 << 1) | hash.b20 ];
+  uint8_t fc7  = fc[ (key.b21 << 4) | (key.b13 << 3) | (key.b5   << 2) | (hash.b13 << 1) | hash.b5  ];
+  uint8_t fd8  = fd[ (key.b20 << 4) | (key.b12 << 3) | (key.b4   << 2) | (hash.b12 << 1) | hash.b4  ];
+
+  uint8_t fa9  = fa[ (key.b35 << 4) | (key.b27 << 3) | (hash.b35 << 2) | (hash.b27 << 1) | hash.b19 ];
+  uint8_t fb10 = fb[ (key.b34 << 4) | (key.b26 << 3) | (hash.b34 << 2) | (hash.b26 << 1) | hash.b18 ];
+  uint8_t fc11 = fc[ (key.b19 << 4) | (key.b11 << 3) | (key.b3   << 2) | (hash.b11 << 1) | hash.b3  ];
+  uint8_t fd12 = fd[ (key.b18 << 4) | (key.b10 << 3) | (key.b2   << 2) | (hash.b10 << 1) | hash.b2  ];
+
+  uint8_t fa13 = fa[ (key.b33 << 4) | (key.b25 << 3) | (hash.b33 << 2) | (hash.b25 << 1) | hash.b17 ];
+  uint8_t fb14 = fb[ (key.b32 << 4) | (key.b24 << 3) | (hash.b32 << 2) | (hash.b24 << 1) | hash.b16 ];
+  uint8_t fe15 = fe[ (key.b17 << 3) | (key.b9  << 2) | (key.b1   << 1) | hash.b9 ];
+  uint8_t fe16 = fe[ (key.b16 << 3) | (key.b8  << 2) | (key.b0   << 1) | hash.b8 ];
+
+  uint8_t fg1  = fg[ (fa1  << 3) | (fb2  << 2) | (fc3  << 1) | fd4  ];
+  uint8_t fg2  = fg[ (fa5  << 3) | (fb6  << 2) | (fc7  << 1) | fd8  ];
+  uint8_t fg3  = fg[ (fa9  << 3) | (fb10 << 2) | (fc11 << 1) | fd12 ];
+  uint8_t fg4  = fg[ (fa13 << 3) | (fb14 << 2) | (fe15 << 1) | fe16 ];
+
+  uint8_t fh1  = fh[ (fg1 << 3) | (fg2 << 2) | (fg3 << 1) | fg4 ];
+
+  uint64_t res = fh1 ^ ( (hash.b1 << 1) | hash.b0 );
+
+  return res;
+}
+
+
+/******************************************************************************
+ * Функция хэширования 40-битного числа по алгоритму DST40 - эталонная
+ * реализация.
+ *****************************************************************************/
+
+uint64_t  dst40hashRef( uint64_t challenge, uint64_t key )
+{
+  uint8_t i;
+  uint8_t cnt;
+
+  uint64_t hash40 = challenge;
+  uint64_t key40  = key;
+
+  for( i=0, cnt=0; i < 192; i++ )
+  {
+    WORD40 tmp;
+
+    hash40 = (block192Ref( hash40, key40 ) << 38) | (hash40 >> 2);
+
+    if( cnt == 1 )
+    {
+      tmp.Val = key40;
+
+      key40 = ( (uint64_t)(tmp.b0 ^ tmp.b2 ^ tmp.b19 ^ tmp.b21) << 39 ) | (key40 >> 1);
+    }
+
+    if( ++cnt == 3 )
+      cnt = 0;
+  }
+
+  return (hash40 >> 16);
+}
+
+
+
+/******************************************************************************
+ * Быстрая реализация.
+ *
+ * Таблицы статические и строятся один раз при первом вызове.
+ * Четвёрки функций Fa, Fb, Fc, Fd (Fa, Fb, Fe, Fe) каждой группы
+ * объединены со следующей за ними Fg в две выборки из таблиц по 1024
+ * элемента:
+ *
+ * _fab[10 бит] - строка таблицы истинности Fg (4 бита) при значениях
+ *                Fa и Fb, вычисленных по индексу,
+ * _fcd[10 бит] - номер бита в этой строке: (Fc << 1) | Fd,
+ * _fee[10 бит] - то же для последней группы: (Fe15 << 1) | Fe16.
+ *
+ * Все функции группы j берут из каждого байта ключа и хэша по два бита
+ * со смещением 6-2j, поэтому индексы собираются словными операциями:
+ * два бита ключа и два бита хэша каждого байта сдвигаются в тетраду
+ *
+ *   w = ( ((key >> s) & 0x0303030303) << 2 ) | ( (hash >> s) & 0x0303030303 ),
+ *
+ * а затем тетрады 4, 3 и половина тетрады 2 образуют индекс _fab,
+ * вторая половина тетрады 2 и тетрады 1, 0 - индекс _fcd/_fee.
+ *****************************************************************************/
+
+static uint8_t _fab[1024];
+static uint8_t _fcd[1024];
+static uint8_t _fee[1024];
+
+static const uint8_t _fh[16] = { 0, 0, 2, 3, 3, 1, 2, 1, 1, 2, 1, 3, 3, 2, 0, 0 };
+
+// Бит n индекса i
+
+#define BIT(i,n)    ( ( (i) >> (n) ) & 1 )
+
+
+/******************************************************************************
+ * Построение объединённых таблиц из таблиц истинности Fa..Fg.
+ *
+ * Таблицы строятся конструктором до main(), пока потоков ещё нет:
+ * dst40hash() одновременно вызывают модель FPGA, потоки программного
+ * поиска и радужных таблиц, и ленивое построение по флагу без барьеров
+ * было бы гонкой.
+ *****************************************************************************/
+
+static void __attribute__((constructor)) buildTables( void )
+{
+  static const uint8_t fa[32] = { 0, 1, 0, 1, 1, 0, 1, 1, 1, 1, 0, 0, 1, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 1, 1, 0, 1, 0, 1, 1, 0, 1 };
+  static const uint8_t fb[32] = { 0, 1, 1, 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 1, 0, 0, 0, 0, 0, 0, 1, 1, 0 };
+  static const uint8_t fc[32] = { 0, 0, 1, 0, 1, 1, 1, 0, 1, 0, 1, 1, 1, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 0, 1, 0, 1, 0, 1, 0, 1 };
+  static const uint8_t fd[32] = { 0, 1, 0, 1, 1, 1, 0, 0, 0, 0, 1, 1, 1, 0, 1, 0, 0, 0, 1, 1, 1, 0, 1, 0, 0, 1, 0, 1, 1, 1, 0, 0 };
+  static const uint8_t fe[16] = { 0, 1, 0, 1, 0, 0, 1, 1, 1, 1, 0, 0, 1, 0, 1, 0 };
+  static const uint8_t fg[16] = { 0, 1, 1, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 0 };
+
+  uint32_t i, n;
+
+  for( i=0; i < 1024; i++ )
+  {
+    // Индекс _fab: 9:k39 8:k38 7:h39 6:h38 5:k31 4:k30 3:h31 2:h30 1:h23 0:h22 (для группы 0)
+
+    uint8_t a = fa[ (BIT(i,9) << 4) | (BIT(i,5) << 3) | (BIT(i,7) << 2) | (BIT(i,3) << 1) | BIT(i,1) ];
+    uint8_t b = fb[ (BIT(i,8) << 4) | (BIT(i,4) << 3) | (BIT(i,6) << 2) | (BIT(i,2) << 1) | BIT(i,0) ];
+
+    // Индекс _fcd: 9:k23 8:k22 7:k15 6:k14 5:h15 4:h14 3:k7 2:k6 1:h7 0:h6 (для группы 0)
+
+    uint8_t c = fc[ (BIT(i,9) << 4) | (BIT(i,7) << 3) | (BIT(i,3) << 2) | (BIT(i,5) << 1) | BIT(i,1) ];
+    uint8_t d = fd[ (BIT(i,8) << 4) | (BIT(i,6) << 3) | (BIT(i,2) << 2) | (BIT(i,4) << 1) | BIT(i,0) ];
+
+    // Индекс _fee: 9:k17 8:k16 7:k9 6:k8 5:h9 4:h8 3:k1 2:k0 (биты 1, 0 не используются)
+
+    uint8_t e15 = fe[ (BIT(i,9) << 3) | (BIT(i,7) << 2) | (BIT(i,3) << 1) | BIT(i,5) ];
+    uint8_t e16 = fe[ (BIT(i,8) << 3) | (BIT(i,6) << 2) | (BIT(i,2) << 1) | BIT(i,4) ];
+
+    _fab[i] = 0;
+
+    for( n=0; n < 4; n++ )
+      _fab[i] |= fg[ (a << 3) | (b << 2) | n ] << n;
+
+    _fcd[i] = (c << 1) | d;
+    _fee[i] = (e15 << 1) | e16;
+  }
+}
+
+
+// Выход Fg группы со смещением s: строка из _fab, бит - из _fcd (_fee)
+
+#define GROUP(s,tab)                                                                          \
+  w = ( ( ( key_in >> (s) ) & 0x0303030303ULL ) << 2 ) | ( ( hash_in >> (s) ) & 0x0303030303ULL ); \
+  g = ( g << 1 ) | ( ( _fab[ ((w >> 26) & 0x3C0) | ((w >> 22) & 0x3C) | ((w >> 16) & 0x3) ]    \
+                       >> tab[ ((w >> 10) & 0x300) | ((w >> 4) & 0xF0) | (w & 0xF) ] ) & 1 );
+
+
+/******************************************************************************
+ * Расчёт новых двух старших бит хэша по таблицам.
+ *****************************************************************************/
+
+static inline uint64_t round192( uint64_t hash_in, uint64_t key_in )
+{
+  uint64_t w;
+  uint32_t g = 0;
+
+  GROUP( 6, _fcd )                                              // Fa1,  Fb2,  Fc3,  Fd4  -> Fg1
+  GROUP( 4, _fcd )                                              // Fa5,  Fb6,  Fc7,  Fd8  -> Fg2
+  GROUP( 2, _fcd )                                              // Fa9,  Fb10, Fc11, Fd12 -> Fg3
+  GROUP( 0, _fee )                                              // Fa13, Fb14, Fe15, Fe16 -> Fg4
+
+  return _fh[g] ^ ( hash_in & 3 );
+}
+
+#undef GROUP
+#undef BIT
+
+
+/******************************************************************************
+ * Расчёт новых двух старших бит хэша.
+ *****************************************************************************/
+
+uint64_t block192( uint64_t hash_in, uint64_t key_in )
+{
+  return round192( hash_in, key_in );
+}
+
+
+/******************************************************************************
+ * Функция хэширования 40-битного числа по алгоритму DST40.
+ *****************************************************************************/
+
+uint64_t  dst40hash( uint64_t challenge, uint64_t key )
+{
+  uint8_t i;
+
+  uint64_t hash40 = challenge;
+  uint64_t key40  = key;
+
+  for( i=0; i < 64; i++ )                                       // 64 тройки раундов: ключ сдвигается
+  {                                                             // после второго раунда каждой тройки
+    hash40 = (round192( hash40, key40 ) << 38) | (hash40 >> 2);
+    hash40 = (round192( hash40, key40 ) << 38) | (hash40 >> 2);
+
+    key40  = ( ( ( key40 ^ (key40 >> 2) ^ (key40 >> 19) ^ (key40 >> 21) ) & 1 ) << 39 ) | (key40 >> 1);
+
+    hash40 = (round192( hash40, key40 ) << 38) | (hash40 >> 2);
+  }
+
+  return (hash40 >> 16);
+}
+
+
+/******************************************************************************
+ * Функция хэширования по заранее посчитанному расписанию ключа.
+ *
+ * Результат совпадает с dst40hash( challenge, ks->key ), но РСЛОС
+ * ключа внутри цикла раундов не считается - при переборе подряд идущих
+ * ключей расписание обновляется keyschedNext().
+ *****************************************************************************/
+
+uint64_t  dst40hashSched( uint64_t challenge, const DST40_KEYSCHED *ks )
+{
+  uint8_t i;
+
+  uint64_t hash40 = challenge;
+
+  for( i=0; i < 64; i++ )                                       // Раунды 3i, 3i+1 - ключ k[i], раунд 3i+2 - k[i+1]
+  {
+    hash40 = (round192( hash40, ks->k[i]   ) << 38) | (hash40 >> 2);
+    hash40 = (round192( hash40, ks->k[i]   ) << 38) | (hash40 >> 2);
+    hash40 = (round192( hash40, ks->k[i+1] ) << 38) | (hash40 >> 2);
+  }
+
+  return (hash40 >> 16);
+}
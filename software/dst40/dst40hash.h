@@ -0,0 +1,15 @@
+#ifndef DST40HASH_H_
+#define DST40HASH_H_
+
+#include <stdint.h>
+#include "keysched.h"
+
+uint64_t block192( uint64_t, uint64_t );
+uint64_t dst40hash( uint64_t, uint64_t );
+uint64_t dst40hashSched( uint64_t, const DST40_KEYSCHED * );
+
+uint64_t block192Ref( uint64_t, uint64_t );
+uint64_t dst40hashRef( uint64_t, uint64_t );
+
+
+#endif /* DST40HASH_H_ */
@@ -0,0 +1,997 @@
+/******************************************************************************
+ *
+ * Программная модель модуля DST40 в FPGA (исполнитель поиска "sim").
+ *
+ * Модель повторяет карту регистров dst40.v и поведение dst40_XX.v,
+ * а хэши считает битслайсовым движком (bitslice.c). Это позволяет
+ * запускать и отлаживать управляющую программу на любом Linux-хосте
+ * без платы.
+ *
+ * Что моделируется:
+ *
+ * 1. Перебор: на каждом такте каждое из DST40_NK ядер проверяет ключ
+ *    { номер ядра, key_reg } (с backendInterleave( true ) - ключ
+ *    { key_reg, номер ядра }, как образ с INTERLEAVE = 1), key_reg растёт
+ *    от стартового значения до конечного (регистр end_key; 0 - до 2^(40-L2NK)).
+ *    Счётчик тактов ведётся по тем же правилам
+ *    (64 такта заполнения конвеера плюс такт на каждое значение
+ *    key_reg), поэтому по нему можно судить о времени работы настоящей
+ *    FPGA на частоте 150 МГц.
+ *
+ * 2. Ключ, подошедший к первой паре какой-либо строки таблицы ответов,
+ *    проверяется на второй паре этой же строки. Ключ, подошедший к обеим,
+ *    кладётся в FIFO вместе с битом ядра и номером младшей подошедшей
+ *    строки - как это делает Verify64.
+ *
+ * 3. Если FIFO заполнено, перебор ждёт, пока программа не заберёт ключ,
+ *    и взводится флаг переполнения - в FPGA при этом так же останавливается
+ *    конвеер.
+ *
+ * 4. Запись 0 в регистр run останавливает перебор и сбрасывает флаги
+ *    done и overflow, содержимое FIFO при этом сохраняется.
+ *
+ * 5. Количество ядер модели задаётся до запуска (backendKernels(),
+ *    опция --kernels), и модель сообщает его через регистры id и caps
+ *    так же, как образ FPGA.
+ *
+ * 6. Счётчики производительности: занятость ядер и заполнение конвеера
+ *    считаются как в FPGA, кандидаты - по ядрам, а время ожидания места
+ *    в FIFO переводится в такты 150 МГц. Регистр кандидата не моделируется,
+ *    поэтому stall всегда 0.
+ *
+ * 7. Кольцевой буфер найденных ключей (опция --ring, ring.h): "память
+ *    HPS" модели - обычный массив, адрес буфера из --ring не используется.
+ *    При включённом буфере ключ пишется прямо в него, минуя FIFO,
+ *    а при заполненном буфере перебор ждёт, как при заполненном FIFO.
+ *
+ * 8. Известные биты ключа (регистры key_mask и key_value, образ версии 11):
+ *    key_reg перебирает номер ключа в уменьшенном пространстве. Если
+ *    младшие биты key_reg свободны, порция значений key_reg - это ключи
+ *    подряд, и они считаются битслайсовым движком как обычно; иначе
+ *    ключи порции считаются по одному (медленно).
+ *
+ * 9. Очередь дескрипторов заданий (регистры 48..54, JobQueue.v): при
+ *    queue_enable = 1 задание берётся из очереди, run не используется.
+ *    Выполненное задание увеличивает queue_done и будит simWait(), как
+ *    прерывание, а следующее запускается сразу; ключ кладётся в FIFO
+ *    вместе с номером задания. Выключение очереди останавливает её
+ *    задание, очищает очередь и обнуляет queue_done.
+ *
+ * Модель считает хэши одним потоком процессора и работает намного
+ * медленнее FPGA: для проверок стартовый ключ стоит задавать недалеко
+ * от искомого.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include "dst40hash.h"
+#include "keysched.h"
+#include "bitslice.h"
+#include "backend.h"
+#include "ring.h"
+
+
+//#############################################################################
+// ОПРЕДЕЛЕНИЯ
+
+#define SIM_L2FIFO        4                                     // Логарифм по основанию 2 от глубины FIFO (как L2FIFO в dst40.v)
+#define SIM_FIFO_SIZE     ( 1 << SIM_L2FIFO )
+#define SIM_L2QUEUE       3                                     // Логарифм по основанию 2 от глубины очереди дескрипторов (L2QUEUE)
+#define SIM_QUEUE_SIZE    ( 1 << SIM_L2QUEUE )
+#define SIM_VERSION       11                                    // Версия "образа" модели (регистр id)
+#define SIM_INDEX_MASK    ( ( 1ULL << ( 40 - DST40_L2NK ) ) - 1 )  // Разрядность key_reg (без старшего бита)
+
+// Запись FIFO найденных ключей
+
+typedef struct
+{
+  uint64_t key;                                                 // Младшие биты ключа
+  uint32_t kernels;                                             // Бит ядра
+  uint32_t index;                                               // Номер строки таблицы ответов
+  uint32_t job;                                                 // Номер задания очереди (младшие 16 бит queue_done)
+} SIM_ENTRY;
+
+// Дескриптор задания очереди (регистры 48..52)
+
+typedef struct
+{
+  uint64_t challenge, challenge2;                               // Запросы
+  uint64_t responses;                                           // Ответы: биты 47..24 - второй, 23..0 - первый
+  uint64_t start_key, end_key;
+} SIM_DESC;
+
+
+
+//#############################################################################
+// ГЛОБАЛЬНЫЕ ПЕРЕМЕННЫЕ
+
+static struct
+{
+  pthread_t       thread;                                       // Поток, изображающий схему FPGA
+  pthread_mutex_t lock;                                         // Защищает всё состояние модели
+  pthread_cond_t  cond;                                         // Сигнал об изменении состояния
+  bool            quit;                                         // Команда завершения потока
+
+  // Регистры, записываемые программой
+
+  uint64_t        challenge, challenge2, start_key, end_key, key_mask, key_value;
+  uint64_t        response[DST40_MAX_NR], response2[DST40_MAX_NR];
+  uint32_t        count;
+  bool            run;
+
+  // Состояние схемы
+
+  bool            active;                                       // Задание захвачено, идёт перебор (run_reg[1] в dst40_XX.v)
+  bool            done;                                         // Все ключи перебраны и проверены
+  bool            overflow;                                     // Перебор приостанавливался
+  uint64_t        cycles;                                       // Количество тактов с момента запуска
+  uint64_t        position;                                     // Счётчик перебора key_reg
+  uint64_t        mask, value;                                  // Маска и значения известных бит, захваченные при запуске
+
+  // Счётчики производительности (обнуляются при запуске, кроме restarts)
+
+  uint64_t        busy, hold, refill, restarts;
+  uint64_t        hits[DST40_MAX_NK];
+  uint64_t        caps;                                         // Регистр caps модели
+
+  SIM_ENTRY       fifo[SIM_FIFO_SIZE];
+  uint32_t        head, tail;                                   // Голова и хвост FIFO (счётчики, не индексы)
+
+  // Кольцевой буфер найденных ключей
+
+  DST40_RECORD   *ring;                                         // "Память HPS" с буфером (NULL - --ring не задан)
+  bool            ring_enable;                                  // Регистры 40..43
+  uint32_t        ring_base, ring_l2size, ring_head, ring_tail;
+  bool            ring_active;                                  // Ключи текущего задания идут через буфер
+
+  // Очередь дескрипторов заданий
+
+  SIM_DESC        desc;                                         // Регистры 48..52
+  SIM_DESC        queue[SIM_QUEUE_SIZE];
+  uint32_t        queue_head, queue_tail;                       // Голова и хвост очереди (счётчики, не индексы)
+  bool            queue_enable;                                 // Регистр queue, бит 0
+  uint32_t        queue_done;                                   // Выполнено заданий с включения очереди
+  bool            queued;                                       // Выполняемое задание взято из очереди
+} _sim;
+
+
+
+/******************************************************************************
+ * Запись в регистр модели (reg - номер 64-битного регистра).
+ *
+ * Вызывается под блокировкой _sim.lock.
+ *****************************************************************************/
+
+static void simWrite( uint32_t reg, uint64_t value )
+{
+  switch( reg )
+  {
+    case DST40_REG_CHALLENGE:  _sim.challenge    = value & 0xFFFFFFFFFFULL; break;
+    case DST40_REG_RESPONSE:   _sim.response[0]  = value & 0xFFFFFF;        break;
+    case DST40_REG_CHALLENGE2: _sim.challenge2   = value & 0xFFFFFFFFFFULL; break;
+    case DST40_REG_RESPONSE2:  _sim.response2[0] = value & 0xFFFFFF;        break;
+    case DST40_REG_COUNT:      _sim.count        = value & ( 2 * DST40_NR - 1 ); break;
+
+    case DST40_REG_START_KEY:
+      _sim.start_key = value & 0xFFFFFFFFFFULL;
+
+      if( !_sim.active )                                        // В ожидании старта key_reg повторяет
+        _sim.position = value & SIM_INDEX_MASK;                 // младшие биты стартового ключа
+      break;
+
+    case DST40_REG_RUN:
+      _sim.run = value & 1;
+
+      if( !_sim.run && !_sim.queue_enable )                     // Останов: схема уходит в ожидание старта
+      {
+        _sim.active   = false;
+        _sim.done     = false;
+        _sim.overflow = false;
+        _sim.cycles   = 0;
+        _sim.position = _sim.start_key & SIM_INDEX_MASK;
+      }
+      break;
+
+    case DST40_REG_FIFO:
+      if( ( value & 1 ) && _sim.head != _sim.tail )
+        _sim.head++;
+      break;
+
+    case DST40_REG_RING_BASE:  _sim.ring_base = value & 0xFFFFFFE0; break;
+    case DST40_REG_RING_TAIL:  _sim.ring_tail = value;              break;
+    case DST40_REG_END_KEY:    _sim.end_key   = value & 0xFFFFFFFFFFULL; break;
+    case DST40_REG_KEY_MASK:   _sim.key_mask  = value & 0xFFFFFFFFFFULL; break;
+    case DST40_REG_KEY_VALUE:  _sim.key_value = value & 0xFFFFFFFFFFULL; break;
+
+    case DST40_REG_DESC:       _sim.desc.challenge  = value & 0xFFFFFFFFFFULL;   break;
+    case DST40_REG_DESC + 1:   _sim.desc.challenge2 = value & 0xFFFFFFFFFFULL;   break;
+    case DST40_REG_DESC + 2:   _sim.desc.responses  = value & 0xFFFFFFFFFFFFULL; break;
+    case DST40_REG_DESC + 3:   _sim.desc.start_key  = value & 0xFFFFFFFFFFULL;   break;
+    case DST40_REG_DESC + 4:   _sim.desc.end_key    = value & 0xFFFFFFFFFFULL;   break;
+
+    case DST40_REG_RING_CTL:
+      _sim.ring_enable = value & 1;
+      _sim.ring_l2size = ( value >> 8 ) & 0x1F;
+      break;
+
+    case DST40_REG_QUEUE:
+      // Дескриптор кладётся, только если очередь уже была включена
+      // и в ней есть место, - как push_i в JobQueue.v
+
+      if( ( value & 0x100 ) && _sim.queue_enable && _sim.queue_tail - _sim.queue_head < SIM_QUEUE_SIZE )
+        _sim.queue[_sim.queue_tail++ % SIM_QUEUE_SIZE] = _sim.desc;
+
+      if( !( value & 1 ) && _sim.queue_enable )                 // Выключение: задание очереди останавливается,
+      {                                                         // очередь очищается
+        if( _sim.queued )
+        {
+          _sim.active   = false;
+          _sim.overflow = false;
+          _sim.cycles   = 0;
+          _sim.position = _sim.start_key & SIM_INDEX_MASK;
+          _sim.queued   = false;
+        }
+
+        _sim.queue_head = _sim.queue_tail;
+        _sim.queue_done = 0;
+      }
+
+      _sim.queue_enable = value & 1;
+      break;
+
+    default:
+      if( reg >= DST40_REG_TABLE && reg < DST40_REG_TABLE + DST40_NR )
+      {
+        _sim.response [reg - DST40_REG_TABLE] = value & 0xFFFFFF;
+        _sim.response2[reg - DST40_REG_TABLE] = ( value >> 24 ) & 0xFFFFFF;
+      }
+  }
+
+  pthread_cond_broadcast( &_sim.cond );
+}
+
+
+
+/******************************************************************************
+ * Чтение регистра модели (reg - номер 64-битного регистра).
+ *
+ * Вызывается под блокировкой _sim.lock.
+ *****************************************************************************/
+
+static uint64_t simRead( uint32_t reg )
+{
+  SIM_ENTRY *e = &_sim.fifo[_sim.head % SIM_FIFO_SIZE];
+
+  switch( reg )
+  {
+    case DST40_REG_CHALLENGE:  return _sim.challenge;
+    case DST40_REG_RESPONSE:   return _sim.response[0];
+    case DST40_REG_START_KEY:  return _sim.start_key;
+    case DST40_REG_RUN:        return _sim.run;
+    case DST40_REG_CHALLENGE2: return _sim.challenge2;
+    case DST40_REG_RESPONSE2:  return _sim.response2[0];
+    case DST40_REG_COUNT:      return _sim.count;
+    case DST40_REG_KEY:        return e->key;
+    case DST40_REG_KERNELS:    return e->kernels;
+    case DST40_REG_INDEX:      return e->index;
+    case DST40_REG_POSITION:   return _sim.position;
+    case DST40_REG_CYCLES:     return _sim.cycles;
+    case DST40_REG_BUSY:       return _sim.busy;
+    case DST40_REG_STALL:      return 0;
+    case DST40_REG_HOLD:       return _sim.hold;
+    case DST40_REG_REFILL:     return _sim.refill;
+    case DST40_REG_RESTARTS:   return _sim.restarts;
+    case DST40_REG_ID:         return ( DST40_MAGIC << 24 ) | ( 64 << 16 ) | SIM_VERSION;  // Ядра модели - полностью развёрнутые
+    case DST40_REG_CAPS:       return _sim.caps;
+    case DST40_REG_RING_BASE:  return _sim.ring_base;
+    case DST40_REG_RING_CTL:   return ( _sim.ring_l2size << 8 ) | _sim.ring_enable;
+    case DST40_REG_RING_HEAD:  return _sim.ring_head;
+    case DST40_REG_RING_TAIL:  return _sim.ring_tail;
+    case DST40_REG_END_KEY:    return _sim.end_key;
+    case DST40_REG_KEY_MASK:   return _sim.key_mask;
+    case DST40_REG_KEY_VALUE:  return _sim.key_value;
+    case DST40_REG_JOB:        return e->job;
+    case DST40_REG_DESC:       return _sim.desc.challenge;
+    case DST40_REG_DESC + 1:   return _sim.desc.challenge2;
+    case DST40_REG_DESC + 2:   return _sim.desc.responses;
+    case DST40_REG_DESC + 3:   return _sim.desc.start_key;
+    case DST40_REG_DESC + 4:   return _sim.desc.end_key;
+    case DST40_REG_QUEUE_DONE: return _sim.queue_done;
+
+    case DST40_REG_QUEUE:
+      return ( SIM_L2QUEUE << 24 ) | ( ( _sim.queue_tail - _sim.queue_head ) << 16 ) |
+             ( _sim.queued && _sim.active ? 0x100 : 0 ) | _sim.queue_enable;
+
+    case DST40_REG_FLAGS:
+      return ( _sim.head != _sim.tail ? DST40_FLAG_FOUND    : 0 ) |
+             ( _sim.done              ? DST40_FLAG_DONE     : 0 ) |
+             ( _sim.overflow          ? DST40_FLAG_OVERFLOW : 0 );
+  }
+
+  if( reg >= DST40_REG_HITS && reg < DST40_REG_HITS + DST40_NK )
+    return _sim.hits[reg - DST40_REG_HITS];
+
+  if( reg >= DST40_REG_TABLE && reg < DST40_REG_TABLE + DST40_NR )
+    return ( _sim.response2[reg - DST40_REG_TABLE] << 24 ) | _sim.response[reg - DST40_REG_TABLE];
+
+  return 0;
+}
+
+
+
+/******************************************************************************
+ * Номер ядра, проверяющего ключ key.
+ *****************************************************************************/
+
+static uint32_t simKernel( uint64_t key )
+{
+  if( DST40_INTERLEAVE )
+    return key & ( DST40_NK - 1 );
+
+  return ( key & 0xFFFFFFFFFFULL ) >> ( 40 - DST40_L2NK );
+}
+
+
+
+/******************************************************************************
+ * Значение key_reg (номер в уменьшенном пространстве), на котором
+ * проверяется ключ key, и ключ ядра kernel при значении index - по маске,
+ * захваченной при запуске.
+ *****************************************************************************/
+
+static uint64_t simIndex( uint64_t key )
+{
+  uint64_t index = DST40_INTERLEAVE ? ( key & 0xFFFFFFFFFFULL ) >> DST40_L2NK : key & SIM_INDEX_MASK;
+
+  return backendExtract( index, _sim.mask );
+}
+
+static uint64_t simKey( uint64_t index, uint32_t kernel )
+{
+  index = backendDeposit( index, _sim.mask ) | _sim.value;
+
+  if( DST40_INTERLEAVE )
+    return ( index << DST40_L2NK ) | kernel;
+
+  return ( (uint64_t)kernel << ( 40 - DST40_L2NK ) ) | index;
+}
+
+
+
+/******************************************************************************
+ * Проверка ключа, подошедшего к первой паре строки row, на второй паре
+ * и запись его в FIFO.
+ *
+ * Как и Verify64, в FIFO кладётся номер младшей строки, подошедшей
+ * к обеим парам, поэтому ключ, найденный по нескольким строкам
+ * с одинаковыми ответами, попадает в FIFO один раз.
+ *
+ * При включённом кольцевом буфере ключ пишется в него, как это делает
+ * RingWriter.v: поля записи, затем её номер.
+ *
+ * Вызывается под блокировкой _sim.lock. Возвращает false, если перебор
+ * был остановлен, пока ключ ждал места в FIFO.
+ *****************************************************************************/
+
+static bool simVerify( const uint64_t *job, uint32_t count, uint64_t key, uint32_t row )
+{
+  uint64_t  h1 = dst40hash( job[0], key );
+  uint64_t  h2 = dst40hash( job[1], key );
+  uint32_t  j;
+  SIM_ENTRY *e;
+  volatile DST40_RECORD *r;
+  struct timespec from, to;
+
+  for( j=0; j < count; j++ )
+    if( job[2+j] == h1 && job[2+DST40_NR+j] == h2 )
+      break;
+
+  if( j != row )                                                // Не подошёл ко второй паре или будет записан по младшей строке
+    return true;
+
+  while( _sim.active && ( _sim.ring_enable && _sim.ring ? ( _sim.ring_head - _sim.ring_tail ) >> _sim.ring_l2size
+                                                         : _sim.tail - _sim.head >= SIM_FIFO_SIZE ) )
+  {
+    _sim.overflow = true;                                       // FIFO заполнено - конвеер стоит
+
+    clock_gettime( CLOCK_MONOTONIC, &from );
+    pthread_cond_wait( &_sim.cond, &_sim.lock );
+    clock_gettime( CLOCK_MONOTONIC, &to );
+
+    _sim.hold += ( ( to.tv_sec - from.tv_sec ) * 1000000000LL + ( to.tv_nsec - from.tv_nsec ) ) * DST40_CLOCK_MHZ / 1000;
+  }
+
+  if( !_sim.active )
+    return false;
+
+  if( _sim.ring_enable && _sim.ring )
+  {
+    r = &_sim.ring[_sim.ring_head & ( ( 1U << _sim.ring_l2size ) - 1 )];
+    r->key     = simIndex( key );
+    r->kernels = 1 << simKernel( key );
+    r->index   = row;
+    r->cycles  = _sim.cycles;
+    r->job     = _sim.queue_done & 0xFFFF;
+
+    __sync_synchronize();                                       // Номер записи - последним
+    r->seq = _sim.ring_head++;
+
+    return true;
+  }
+
+  e = &_sim.fifo[_sim.tail % SIM_FIFO_SIZE];
+  e->key     = simIndex( key );
+  e->kernels = 1 << simKernel( key );
+  e->index   = row;
+  e->job     = _sim.queue_done & 0xFFFF;
+  _sim.tail++;
+
+  pthread_cond_broadcast( &_sim.cond );
+  return true;
+}
+
+
+
+/******************************************************************************
+ * Поток, изображающий схему FPGA.
+ *****************************************************************************/
+
+static void *simFabric( void *arg )
+{
+  const DST40_ENGINE *engine = dst40engine();
+  uint64_t       lanes = engine->lanes;
+  uint64_t       job[2 + 2 * DST40_MAX_NR];                     // Захваченное задание: запросы, ответы 1, ответы 2
+  static uint64_t found[DST40_MAX_NK * DST40_MAX_NR * BS_MAX_LANES];  // Ключи порции, подошедшие к первой паре (в битах 40 и выше - номер строки)
+  uint64_t       part[BS_MAX_LANES];
+  uint64_t       first, last, pos, base, raw, step;
+  uint64_t       hits[DST40_MAX_NK];
+  uint32_t       count, nfree, i, j, k, n;
+  bool           contiguous;                                    // Порция значений key_reg - ключи подряд
+  SIM_DESC      *desc;
+  DST40_KEYSCHED ks;
+
+  keyschedInit( &ks, 0 );
+
+  pthread_mutex_lock( &_sim.lock );
+
+  while( !_sim.quit )
+  {
+    // Ожидание старта: как и в dst40_XX.v, исходные данные захватываются
+    // в момент запуска. При включённой очереди задание - очередной
+    // дескриптор (одна метка), а run не используется.
+
+    if( _sim.queue_enable ? _sim.queue_head == _sim.queue_tail : ( !_sim.run || _sim.done ) )
+    {
+      pthread_cond_wait( &_sim.cond, &_sim.lock );
+      continue;
+    }
+
+    for( j=0; j < DST40_NR; j++ )
+    {
+      job[2+j]          = _sim.response[j];
+      job[2+DST40_NR+j] = _sim.response2[j];
+    }
+
+    if( ( _sim.queued = _sim.queue_enable ) )
+    {
+      desc = &_sim.queue[_sim.queue_head++ % SIM_QUEUE_SIZE];
+
+      job[0]          = desc->challenge;
+      job[1]          = desc->challenge2;
+      job[2]          = desc->responses & 0xFFFFFF;
+      job[2+DST40_NR] = ( desc->responses >> 24 ) & 0xFFFFFF;
+      count           = 1;
+      first           = desc->start_key & SIM_INDEX_MASK;
+      last            = desc->end_key & SIM_INDEX_MASK;
+    }
+    else
+    {
+      job[0] = _sim.challenge;
+      job[1] = _sim.challenge2;
+      count  = _sim.count > DST40_NR ? DST40_NR : _sim.count;
+      first  = _sim.start_key & SIM_INDEX_MASK;
+      last   = _sim.end_key & SIM_INDEX_MASK;
+    }
+
+    _sim.mask  = _sim.key_mask & SIM_INDEX_MASK;
+    _sim.value = _sim.key_value & _sim.mask;
+
+    for( j=0, nfree=40-DST40_L2NK; j < 40 - DST40_L2NK; j++ )   // Свободных бит - столько бит у номера ключа
+      nfree -= ( _sim.mask >> j ) & 1;
+
+    if( !last )
+      last = 1ULL << nfree;
+
+    contiguous = !( _sim.mask & ( lanes - 1 ) );
+
+    _sim.active   = true;
+    _sim.position = first;
+    _sim.cycles = 64;                                           // Заполнение конвеера
+    _sim.busy     = 64;
+    _sim.refill   = 64;
+    _sim.hold     = 0;
+    _sim.restarts++;
+
+    for( i=0; i < DST40_NK; i++ )
+      _sim.hits[i] = 0;
+
+    // Перебор: порция из lanes значений key_reg за раз для каждого ядра
+    // и каждой строки таблицы. Хэши считаются без блокировки. При
+    // чередовании ключи порции всех ядер идут подряд: DST40_NK * lanes
+    // ключей с ( pos << L2NK ), они считаются кусками по lanes.
+    // При маске pos - номер в уменьшенном пространстве, а ключи порции
+    // начинаются со значения key_reg raw.
+
+    for( pos = first & ~( lanes - 1 ); pos < last && _sim.active; pos += lanes )
+    {
+      pthread_mutex_unlock( &_sim.lock );
+
+      n = 0;
+
+      for( i=0; i < DST40_NK; i++ )
+        hits[i] = 0;
+
+      raw = backendDeposit( pos, _sim.mask ) | _sim.value;
+
+      for( i=0; i < DST40_NK; i++ )
+      {
+        if( !contiguous )                                       // Младшие биты известны: ключи порции не подряд
+        {
+          for( k=0; k < lanes; k++ )
+            for( j=0; j < count; j++ )
+              if( pos + k >= first && pos + k < last && dst40hash( job[0], simKey( pos + k, i ) ) == job[2+j] )
+              {
+                found[n++] = simKey( pos + k, i ) | ( (uint64_t)j << 40 );
+                hits[i]++;
+              }
+
+          continue;
+        }
+
+        base = DST40_INTERLEAVE ? ( raw << DST40_L2NK ) + i * lanes : ( (uint64_t)i << ( 40 - DST40_L2NK ) ) | raw;
+        keyschedSet( &ks, base );
+
+        for( j=0; j < count; j++ )
+        {
+          uint32_t m = engine->search( job[0], job[2+j], &ks, part );
+
+          for( k=0; k < m; k++ )                                // Ключи вне [first, last) не проверяются
+            if( simIndex( part[k] ) >= first && simIndex( part[k] ) < last )
+            {
+              found[n++] = part[k] | ( (uint64_t)j << 40 );
+              hits[simKernel( part[k] )]++;
+            }
+        }
+      }
+
+      pthread_mutex_lock( &_sim.lock );
+
+      for( k=0; k < n && _sim.active; k++ )
+        simVerify( job, count, found[k] & 0xFFFFFFFFFFULL, found[k] >> 40 );
+
+      if( _sim.active )
+      {
+        step = ( pos < first ) ? pos + lanes - first : lanes;
+
+        _sim.cycles  += step;
+        _sim.busy    += step;
+        _sim.position = pos + lanes;
+
+        for( i=0; i < DST40_NK; i++ )
+          _sim.hits[i] += hits[i];
+      }
+    }
+
+    if( _sim.active && _sim.queued )                            // Задание очереди выполнено: флаг done не держится,
+    {                                                           // следующее задание запускается сразу
+      _sim.active   = false;
+      _sim.overflow = false;
+      _sim.queued   = false;
+      _sim.queue_done++;
+      pthread_cond_broadcast( &_sim.cond );
+    }
+    else if( _sim.active )                                      // Все ключи перебраны
+    {
+      _sim.done = true;
+      pthread_cond_broadcast( &_sim.cond );
+    }
+  }
+
+  pthread_mutex_unlock( &_sim.lock );
+
+  return NULL;
+}
+
+
+
+/******************************************************************************
+ * sim: запуск модели.
+ *****************************************************************************/
+
+static bool simOpen( void )
+{
+  _sim.quit  = false;
+  _sim.run   = false;
+  _sim.done  = false;
+  _sim.count = 1;
+  _sim.head  = _sim.tail = 0;
+
+  _sim.queue_enable = false;
+  _sim.queued       = false;
+  _sim.queue_head   = _sim.queue_tail = 0;
+  _sim.queue_done   = 0;
+
+  // Параметры "образа" модели: ядер - сколько задано, остальное - как
+  // у образа FPGA
+
+  _sim.caps = (uint64_t)DST40_NK | ( (uint64_t)DST40_L2NK << 8 ) | ( (uint64_t)DST40_NR << 16 ) | ( 64ULL << 24 ) |
+              ( (uint64_t)DST40_CLOCK_MHZ << 32 ) | ( ( DST40_INTERLEAVE ? 0xFFULL : 0x7FULL ) << 48 ) | ( (uint64_t)SIM_L2FIFO << 56 );
+
+  if( !backendCaps( simRead( DST40_REG_ID ), simRead( DST40_REG_CAPS ) ) )
+    return false;
+
+  _sim.ring        = NULL;
+  _sim.ring_enable = false;
+  _sim.ring_active = false;
+
+  if( _ring_l2size && !( _sim.ring = calloc( 1U << _ring_l2size, sizeof(DST40_RECORD) ) ) )
+  {
+    printf( "\nERROR: could not allocate ring buffer\n" );
+    return false;
+  }
+
+  pthread_mutex_init( &_sim.lock, NULL );
+  pthread_cond_init( &_sim.cond, NULL );
+
+  if( pthread_create( &_sim.thread, NULL, simFabric, NULL ) )
+  {
+    printf( "\nERROR: could not start FPGA model thread\n" );
+    pthread_cond_destroy( &_sim.cond );
+    pthread_mutex_destroy( &_sim.lock );
+    free( _sim.ring );
+    return false;
+  }
+
+  printf( "\nFPGA model: %u kernels, %s engine\n", DST40_NK, dst40engine()->name );
+
+  if( _sim.ring )
+    printf( "\nCandidate ring buffer: %u records\n", 1U << _ring_l2size );
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * sim: остановка модели.
+ *****************************************************************************/
+
+static void simClose( void )
+{
+  ringStop();
+
+  pthread_mutex_lock( &_sim.lock );
+  _sim.quit = true;
+  simWrite( DST40_REG_QUEUE, 0 );
+  simWrite( DST40_REG_RUN, 0 );
+  pthread_mutex_unlock( &_sim.lock );
+
+  pthread_join( _sim.thread, NULL );
+
+  pthread_cond_destroy( &_sim.cond );
+  pthread_mutex_destroy( &_sim.lock );
+
+  free( _sim.ring );
+  _sim.ring = NULL;
+}
+
+
+
+/******************************************************************************
+ * sim: доступ к регистрам по номеру для потока кольцевого буфера.
+ *****************************************************************************/
+
+static uint64_t simReadReg( uint32_t reg )
+{
+  uint64_t value;
+
+  pthread_mutex_lock( &_sim.lock );
+  value = simRead( reg );
+  pthread_mutex_unlock( &_sim.lock );
+
+  return value;
+}
+
+static void simWriteReg( uint32_t reg, uint64_t value )
+{
+  pthread_mutex_lock( &_sim.lock );
+  simWrite( reg, value );
+  pthread_mutex_unlock( &_sim.lock );
+}
+
+
+
+/******************************************************************************
+ * sim: загрузка задания - те же записи в регистры, что и у mmap.
+ *****************************************************************************/
+
+static void simLoad( const DST40_JOB *job )
+{
+  uint32_t j;
+
+  pthread_mutex_lock( &_sim.lock );
+
+  simWrite( DST40_REG_RUN, 0 );
+  simWrite( DST40_REG_RING_CTL, 0 );
+  _sim.ring_active = false;
+
+  while( simRead( DST40_REG_FLAGS ) & DST40_FLAG_FOUND )
+    simWrite( DST40_REG_FIFO, 1 );
+
+  simWrite( DST40_REG_CHALLENGE,  job->challenge  );
+  simWrite( DST40_REG_CHALLENGE2, job->challenge2 );
+  simWrite( DST40_REG_START_KEY,  job->start_key  );
+  simWrite( DST40_REG_END_KEY,    job->end_key    );
+  simWrite( DST40_REG_KEY_MASK,   _keymask.mask   );
+  simWrite( DST40_REG_KEY_VALUE,  _keymask.value  );
+  simWrite( DST40_REG_COUNT,      job->count      );
+
+  for( j=0; j < job->count; j++ )
+    simWrite( DST40_REG_TABLE + j, ( job->response2[j] << 24 ) | job->response[j] );
+
+  pthread_mutex_unlock( &_sim.lock );
+}
+
+
+
+/******************************************************************************
+ * sim: запуск и остановка поиска.
+ *****************************************************************************/
+
+static void simRingStart( void )
+{
+  DST40_RING ring;
+
+  if( _sim.ring )
+  {
+    ring.records = _sim.ring;
+    ring.l2size  = _ring_l2size;
+    ring.base    = _ring_base;
+    ring.read    = simReadReg;
+    ring.write   = simWriteReg;
+
+    _sim.ring_active = ringStart( &ring );
+  }
+}
+
+static void simStart( void )
+{
+  simRingStart();
+
+  pthread_mutex_lock( &_sim.lock );
+  simWrite( DST40_REG_RUN, 1 );
+  pthread_mutex_unlock( &_sim.lock );
+}
+
+static void simStop( void )
+{
+  pthread_mutex_lock( &_sim.lock );
+  simWrite( DST40_REG_RUN, 0 );
+  simWrite( DST40_REG_QUEUE, 0 );
+  pthread_mutex_unlock( &_sim.lock );
+
+  ringStop();
+}
+
+
+
+/******************************************************************************
+ * sim: задание в очередь дескрипторов - те же записи, что и у mmap.
+ *****************************************************************************/
+
+static bool simPush( const DST40_JOB *job )
+{
+  bool ok;
+
+  if( !_sim.queue_enable )                                      // Первое задание: очистка FIFO и маска, как при load()
+  {
+    simLoad( job );
+    simRingStart();
+
+    pthread_mutex_lock( &_sim.lock );
+    simWrite( DST40_REG_QUEUE, 1 );
+    pthread_mutex_unlock( &_sim.lock );
+  }
+
+  pthread_mutex_lock( &_sim.lock );
+
+  if( ( ok = ( ( simRead( DST40_REG_QUEUE ) >> 16 ) & 0xFF ) < SIM_QUEUE_SIZE ) )
+  {
+    simWrite( DST40_REG_DESC,     job->challenge  );
+    simWrite( DST40_REG_DESC + 1, job->challenge2 );
+    simWrite( DST40_REG_DESC + 2, ( job->response2[0] << 24 ) | job->response[0] );
+    simWrite( DST40_REG_DESC + 3, job->start_key  );
+    simWrite( DST40_REG_DESC + 4, job->end_key    );
+    simWrite( DST40_REG_QUEUE,    0x101           );
+  }
+
+  pthread_mutex_unlock( &_sim.lock );
+
+  return ok;
+}
+
+
+
+/******************************************************************************
+ * sim: количество выполненных заданий очереди.
+ *****************************************************************************/
+
+static uint32_t simCompleted( void )
+{
+  uint32_t completed;
+
+  if( _sim.ring_active )
+    return ringCompleted();
+
+  pthread_mutex_lock( &_sim.lock );
+  completed = simRead( DST40_REG_QUEUE_DONE );
+  pthread_mutex_unlock( &_sim.lock );
+
+  return completed;
+}
+
+
+
+/******************************************************************************
+ * sim: ожидание ключа в FIFO или конца перебора - аналог прерывания IRQ0
+ * (его взводит и каждое выполненное задание очереди).
+ *****************************************************************************/
+
+static uint64_t simWait( uint32_t timeout )
+{
+  uint64_t        flags;
+  uint32_t        completed;
+  struct timespec until;
+
+  if( _sim.ring_active )
+    return ringWait( timeout );
+
+  clock_gettime( CLOCK_REALTIME, &until );
+  until.tv_sec  += timeout / 1000;
+  until.tv_nsec += ( timeout % 1000 ) * 1000000;
+
+  if( until.tv_nsec >= 1000000000 )
+  {
+    until.tv_sec++;
+    until.tv_nsec -= 1000000000;
+  }
+
+  pthread_mutex_lock( &_sim.lock );
+
+  completed = _sim.queue_done;
+
+  while( ( _sim.run || _sim.queue_enable ) && _sim.queue_done == completed &&
+         !( ( flags = simRead( DST40_REG_FLAGS ) ) & ( DST40_FLAG_FOUND | DST40_FLAG_DONE ) ) )
+  {
+    if( !timeout )
+      pthread_cond_wait( &_sim.cond, &_sim.lock );
+    else if( pthread_cond_timedwait( &_sim.cond, &_sim.lock, &until ) )
+      break;                                                    // Время вышло
+  }
+
+  flags = simRead( DST40_REG_FLAGS );
+
+  pthread_mutex_unlock( &_sim.lock );
+
+  return flags;
+}
+
+
+
+/******************************************************************************
+ * sim: чтение и удаление ключа из головы FIFO.
+ *****************************************************************************/
+
+static bool simResult( DST40_RESULT *result )
+{
+  bool ok;
+
+  if( _sim.ring_active )
+    return ringResult( result );
+
+  pthread_mutex_lock( &_sim.lock );
+
+  if( ( ok = simRead( DST40_REG_FLAGS ) & DST40_FLAG_FOUND ) )
+  {
+    result->key     = simRead( DST40_REG_KEY );
+    result->kernels = simRead( DST40_REG_KERNELS );
+    result->index   = simRead( DST40_REG_INDEX );
+    result->cycles  = 0;
+    result->job     = simRead( DST40_REG_JOB );
+
+    simWrite( DST40_REG_FIFO, 1 );
+  }
+
+  pthread_mutex_unlock( &_sim.lock );
+
+  return ok;
+}
+
+
+
+/******************************************************************************
+ * sim: количество тактов ядер с момента запуска.
+ *****************************************************************************/
+
+static uint64_t simCycles( void )
+{
+  uint64_t cycles;
+
+  pthread_mutex_lock( &_sim.lock );
+  cycles = simRead( DST40_REG_CYCLES );
+  pthread_mutex_unlock( &_sim.lock );
+
+  return cycles;
+}
+
+
+
+/******************************************************************************
+ * sim: счётчики производительности.
+ *****************************************************************************/
+
+static bool simPerf( DST40_PERF *perf )
+{
+  uint32_t i;
+
+  pthread_mutex_lock( &_sim.lock );
+
+  perf->busy     = simRead( DST40_REG_BUSY );
+  perf->stall    = simRead( DST40_REG_STALL );
+  perf->hold     = simRead( DST40_REG_HOLD );
+  perf->refill   = simRead( DST40_REG_REFILL );
+  perf->restarts = simRead( DST40_REG_RESTARTS );
+
+  for( i=0; i < DST40_NK; i++ )
+    perf->hits[i] = simRead( DST40_REG_HITS + i );
+
+  pthread_mutex_unlock( &_sim.lock );
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * sim: счётчик перебора.
+ *****************************************************************************/
+
+static uint64_t simPosition( void )
+{
+  uint64_t position;
+
+  if( _sim.ring_active )
+    return ringPosition();
+
+  pthread_mutex_lock( &_sim.lock );
+  position = simRead( DST40_REG_POSITION );
+  pthread_mutex_unlock( &_sim.lock );
+
+  return position;
+}
+
+
+
+//#############################################################################
+// ОПИСАТЕЛЬ ИСПОЛНИТЕЛЯ
+
+const DST40_BACKEND backendSim =
+{
+  "sim", simOpen, simClose, simLoad, simStart, simStop, simWait, simResult, simCycles, simPerf, simPosition,
+  simPush, simCompleted
+};
@@ -0,0 +1,280 @@
+/******************************************************************************
+ *
+ * Журнал задания на поиск (режимы --journal и --resume).
+ *
+ * Журнал - текстовый файл:
+ *
+ *   challenge <challenge1> <challenge2>
+ *   kernels <количество>                       - ядер FPGA (pos - младшие биты ключа);
+ *                                                нет строки - 4 ядра
+ *   interleave 1                               - pos записаны для образа
+ *                                                с чередованием ядер
+ *                                                (DST40_CAPS_INTERLEAVE)
+ *   mask <маска> <значения>                    - известные биты ключа (--mask):
+ *                                                pos - номер в уменьшенном
+ *                                                пространстве
+ *   tag <response1> <response2> pos <ключ>     - перебор продолжать с ключа
+ *   tag <response1> <response2> found <ключ>   - ключ найден
+ *   tag <response1> <response2> done           - все ключи перебраны, ключ не найден
+ *
+ * Журнал каждый раз пишется целиком во временный файл, который после
+ * fsync() переименовывается в файл журнала. Поэтому при выключении
+ * питания в любой момент на диске остаётся либо старый, либо новый
+ * журнал, но не испорченный.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include "journal.h"
+
+
+//#############################################################################
+// ОПРЕДЕЛЕНИЯ
+
+#define JOURNAL_MAX_NAME  1024                                  // Максимальная длина имени файла журнала
+
+
+
+/******************************************************************************
+ * Запись журнала.
+ *
+ * Вход: name    - имя файла журнала,
+ *       journal - состояние задания.
+ *
+ * Возвращает false при ошибке записи (сообщение уже выведено).
+ *****************************************************************************/
+
+bool journalSave( const char *name, const DST40_JOURNAL *journal )
+{
+  char     tmp[JOURNAL_MAX_NAME + 8];
+  char     dir[JOURNAL_MAX_NAME];
+  FILE    *f;
+  uint32_t i;
+  int      fd;
+  bool     ok;
+
+  if( strlen( name ) >= JOURNAL_MAX_NAME )
+  {
+    printf( "\nERROR: journal name is too long\n" );
+    return false;
+  }
+
+  sprintf( tmp, "%s.tmp", name );
+
+  if( !( f = fopen( tmp, "w" ) ) )
+  {
+    perror( tmp );
+    return false;
+  }
+
+  fprintf( f, "# DST40 search journal\n" );
+  fprintf( f, "challenge %010llX %010llX\n", journal->c1, journal->c2 );
+
+  if( journal->kernels )
+    fprintf( f, "kernels %u\n", journal->kernels );
+
+  if( journal->interleave )
+    fprintf( f, "interleave 1\n" );
+
+  if( journal->mask )
+    fprintf( f, "mask %010llX %010llX\n", journal->mask, journal->value );
+
+  for( i=0; i < journal->n; i++ )
+  {
+    fprintf( f, "tag %06llX %06llX ", journal->r1[i], journal->r2[i] );
+
+    if( journal->found[i] )
+      fprintf( f, "found %010llX\n", journal->keys[i] );
+    else if( journal->pos[i] >= JOURNAL_DONE )
+      fprintf( f, "done\n" );
+    else
+      fprintf( f, "pos %010llX\n", journal->pos[i] );
+  }
+
+  ok = !ferror( f ) && !fflush( f ) && !fsync( fileno( f ) );   // Данные должны лечь на диск до переименования
+  ok = !fclose( f ) && ok;
+
+  if( !ok || rename( tmp, name ) )
+  {
+    perror( tmp );
+    return false;
+  }
+
+  // Переименование - изменение папки: её тоже сбрасываем на диск
+
+  strcpy( dir, name );
+
+  if( ( fd = open( dirname( dir ), O_RDONLY ) ) >= 0 )
+  {
+    fsync( fd );
+    close( fd );
+  }
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * Увеличение массивов меток журнала до size элементов.
+ *
+ * Массивы растут по одному: при нехватке памяти уже увеличенные
+ * остаются в журнале и освобождаются journalFree().
+ *****************************************************************************/
+
+static bool journalGrow( DST40_JOURNAL *journal, uint32_t size )
+{
+  void *p;
+
+  if( !( p = realloc( journal->r1, size * sizeof(uint64_t) ) ) )
+    return false;
+  journal->r1 = p;
+
+  if( !( p = realloc( journal->r2, size * sizeof(uint64_t) ) ) )
+    return false;
+  journal->r2 = p;
+
+  if( !( p = realloc( journal->pos, size * sizeof(uint64_t) ) ) )
+    return false;
+  journal->pos = p;
+
+  if( !( p = realloc( journal->keys, size * sizeof(uint64_t) ) ) )
+    return false;
+  journal->keys = p;
+
+  if( !( p = realloc( journal->found, size * sizeof(bool) ) ) )
+    return false;
+  journal->found = p;
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * Освобождение массивов меток журнала.
+ *****************************************************************************/
+
+static void journalFree( DST40_JOURNAL *journal )
+{
+  free( journal->r1 );
+  free( journal->r2 );
+  free( journal->pos );
+  free( journal->keys );
+  free( journal->found );
+
+  journal->r1 = journal->r2 = journal->pos = journal->keys = NULL;
+  journal->found = NULL;
+  journal->n = 0;
+}
+
+
+
+/******************************************************************************
+ * Чтение журнала.
+ *
+ * Вход:  name    - имя файла журнала.
+ * Выход: journal - состояние задания (массивы выделяются malloc).
+ *
+ * Возвращает false при ошибке (сообщение уже выведено).
+ *****************************************************************************/
+
+bool journalLoad( const char *name, DST40_JOURNAL *journal )
+{
+  FILE    *f;
+  char     line[256], state[16];
+  uint32_t size = 0, line_no = 0, interleave;
+  uint64_t r1, r2, value;
+  bool     header = false, ok = true;
+
+  memset( journal, 0, sizeof(*journal) );
+
+  if( !( f = fopen( name, "r" ) ) )
+  {
+    perror( name );
+    return false;
+  }
+
+  while( ok && fgets( line, sizeof(line), f ) )
+  {
+    line_no++;
+
+    if( line[0] == '#' || line[0] == '\n' || line[0] == '\r' )
+      continue;
+
+    if( !header )                                               // Первая строка - запросы
+    {
+      ok = header = ( sscanf( line, "challenge %llx %llx", &journal->c1, &journal->c2 ) == 2 );
+      continue;
+    }
+
+    if( sscanf( line, "kernels %u", &journal->kernels ) == 1 )
+      continue;
+
+    if( sscanf( line, "mask %llx %llx", &journal->mask, &journal->value ) == 2 )
+      continue;
+
+    if( sscanf( line, "interleave %u", &interleave ) == 1 )
+    {
+      journal->interleave = ( interleave != 0 );
+      continue;
+    }
+
+    value = 0;
+
+    if( sscanf( line, "tag %llx %llx %15s %llx", &r1, &r2, state, &value ) < 3 )
+    {
+      ok = false;
+      break;
+    }
+
+    if( journal->n == size )
+    {
+      size = size ? size * 2 : 16;
+
+      if( !journalGrow( journal, size ) )
+      {
+        printf( "\nERROR: %s: out of memory at line %u\n", name, line_no );
+        fclose( f );
+        journalFree( journal );
+        return false;
+      }
+    }
+
+    journal->r1[journal->n]    = r1;
+    journal->r2[journal->n]    = r2;
+    journal->pos[journal->n]   = 0;
+    journal->keys[journal->n]  = 0;
+    journal->found[journal->n] = false;
+
+    if( !strcmp( state, "found" ) )
+    {
+      journal->found[journal->n] = true;
+      journal->keys[journal->n]  = value;
+    }
+    else if( !strcmp( state, "done" ) )
+      journal->pos[journal->n] = JOURNAL_DONE;
+    else if( !strcmp( state, "pos" ) )
+      journal->pos[journal->n] = value;
+    else
+      ok = false;
+
+    journal->n++;
+  }
+
+  fclose( f );
+
+  if( !ok || !journal->n )
+  {
+    printf( "\nERROR: %s: bad journal (line %u)\n", name, line_no );
+    journalFree( journal );
+    return false;
+  }
+
+  return true;
+}
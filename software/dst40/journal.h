@@ -0,0 +1,35 @@
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// Состояние задания на поиск, сохраняемое в журнал.
+//
+// Для каждой метки хранится либо найденный ключ, либо ключ, с которого
+// продолжать перебор: на FPGA все ядра идут по одному счётчику перебора,
+// поэтому положение перебора - это одно число на метку (значение
+// счётчика, см. backendIndex()).
+
+#define JOURNAL_DONE  0x10000000000ULL                          // Значение pos: перебор для метки закончен, ключ не найден
+
+typedef struct
+{
+  uint64_t  c1, c2;                                             // Запросы
+  uint32_t  n;                                                  // Количество меток
+  uint32_t  kernels;                                            // Количество ядер FPGA, для которого записаны pos (0 - не записано)
+  bool      interleave;                                         // pos записаны для образа с чередованием ядер
+  uint64_t  mask, value;                                        // Известные биты ключа и их значения (mask = 0 - нет)
+  uint64_t *r1, *r2;                                            // Ответы меток на первый и второй запросы
+  uint64_t *pos;                                                // Ключ, с которого продолжать перебор (JOURNAL_DONE - перебор закончен)
+  uint64_t *keys;                                               // Найденные ключи
+  bool     *found;                                              // Признаки "ключ метки найден"
+} DST40_JOURNAL;
+
+
+bool journalSave( const char *, const DST40_JOURNAL * );
+bool journalLoad( const char *, DST40_JOURNAL * );
+
+
+#endif /* JOURNAL_H_ */
@@ -0,0 +1,157 @@
+/******************************************************************************
+ *
+ * Кэш расписания ключей DST40 для перебора последовательных ключей.
+ *
+ * РСЛОС ключа линеен над GF(2): вдвигаемые биты ext являются линейной
+ * функцией ключа, ext( a ^ b ) = ext( a ) ^ ext( b ). Поэтому при переходе
+ * от ключа k к ключу k' расписание не считается заново, а исправляется
+ * на ext( k ^ k' ):
+ *
+ * - для k' = k + 1 разность k ^ k' - это младшие t+1 бит, где t - номер
+ *   младшего нулевого бита k, и поправка берётся из таблицы _next[t]
+ *   одной операцией XOR;
+ * - для произвольного k' поправка собирается из таблицы _basis[b]
+ *   по единичным битам k ^ k' (при шаге 2^n - в среднем два бита).
+ *
+ * Таблицы строятся один раз конструктором до main().
+ *
+ *****************************************************************************/
+
+#include <stdint.h>
+#include "keysched.h"
+
+
+//#############################################################################
+// ОПРЕДЕЛЕНИЯ
+
+#define MASK40    0xFFFFFFFFFFULL
+
+
+
+//#############################################################################
+// ГЛОБАЛЬНЫЕ ПЕРЕМЕННЫЕ
+
+static uint64_t _basis[40];                                     // ext( 1 << b )
+static uint64_t _next[40];                                      // ext( ( 2 << t ) - 1 ) - поправка для k + 1
+
+
+
+/******************************************************************************
+ * Вдвигаемые биты РСЛОС для ключа - прямой расчёт (64 сдвига).
+ *****************************************************************************/
+
+uint64_t keyschedExt( uint64_t key )
+{
+  uint64_t ext = 0;
+  uint32_t s;
+
+  key &= MASK40;
+
+  for( s=0; s < 64; s++ )
+  {
+    key  = ( ( ( key ^ (key >> 2) ^ (key >> 19) ^ (key >> 21) ) & 1 ) << 39 ) | (key >> 1);
+    ext |= ( key >> 39 ) << s;
+  }
+
+  return ext;
+}
+
+
+
+/******************************************************************************
+ * Построение таблиц поправок.
+ *
+ * Вызывается конструктором до main(), как и построение таблиц хэша
+ * в dst40hash.c: keyschedInit() вызывают сразу все потоки cpuWorker(),
+ * а keyschedSet() и keyschedNext() берут таблицы без проверок.
+ *****************************************************************************/
+
+static void __attribute__((constructor)) buildTables( void )
+{
+  uint32_t b;
+
+  for( b=0; b < 40; b++ )
+  {
+    _basis[b] = keyschedExt( 1ULL << b );
+    _next[b]  = ( b ? _next[b-1] : 0 ) ^ _basis[b];
+  }
+}
+
+
+
+/******************************************************************************
+ * Заполнение состояний РСЛОС k[0..64] из key и ext.
+ *****************************************************************************/
+
+static void keyschedFill( DST40_KEYSCHED *ks )
+{
+  uint64_t key = ks->key;
+  uint64_t ext = ks->ext;
+  uint32_t s;
+
+  ks->k[0] = key;
+
+  for( s=1; s < 40; s++ )
+    ks->k[s] = ( ( key >> s ) | ( ext << ( 40 - s ) ) ) & MASK40;
+
+  for( s=40; s <= 64; s++ )
+    ks->k[s] = ( ext >> ( s - 40 ) ) & MASK40;
+}
+
+
+
+/******************************************************************************
+ * Полный расчёт расписания для ключа.
+ *****************************************************************************/
+
+void keyschedInit( DST40_KEYSCHED *ks, uint64_t key )
+{
+  ks->key = key & MASK40;
+  ks->ext = keyschedExt( key );
+
+  keyschedFill( ks );
+}
+
+
+
+/******************************************************************************
+ * Переход к произвольному ключу поправкой уже посчитанного расписания
+ * (ks должно быть заполнено keyschedInit).
+ *****************************************************************************/
+
+void keyschedSet( DST40_KEYSCHED *ks, uint64_t key )
+{
+  uint64_t diff;
+
+  key &= MASK40;
+  diff = ks->key ^ key;
+
+  while( diff )
+  {
+    ks->ext ^= _basis[ __builtin_ctzll( diff ) ];
+    diff &= diff - 1;
+  }
+
+  ks->key = key;
+
+  keyschedFill( ks );
+}
+
+
+
+/******************************************************************************
+ * Переход к следующему ключу (key + 1).
+ *
+ * После последнего ключа FFFFFFFFFF расписание переходит к ключу 0.
+ *****************************************************************************/
+
+void keyschedNext( DST40_KEYSCHED *ks )
+{
+  uint64_t key = ks->key;
+  uint32_t t   = ( key == MASK40 ) ? 39 : __builtin_ctzll( ~key );
+
+  ks->ext ^= _next[t];
+  ks->key  = ( key + 1 ) & MASK40;
+
+  keyschedFill( ks );
+}
@@ -0,0 +1,28 @@
+#ifndef KEYSCHED_H_
+#define KEYSCHED_H_
+
+#include <stdint.h>
+
+
+// Расписание ключей DST40 для одного ключа.
+//
+// За 192 раунда РСЛОС ключа сдвигается 64 раза, на каждом сдвиге слева
+// вдвигается один новый бит. Всё расписание - это 104-битная строка
+// { ext, key }: состояние ключа после s сдвигов - биты s..s+39 этой строки.
+// Раунд i использует состояние k[(i+1)/3].
+
+typedef struct
+{
+  uint64_t key;                                                 // Ключ (40 бит)
+  uint64_t ext;                                                 // Вдвигаемые биты: бит s - бит 39 состояния k[s+1]
+  uint64_t k[65];                                               // Состояния РСЛОС: k[s] - ключ после s сдвигов
+} DST40_KEYSCHED;
+
+
+void     keyschedInit( DST40_KEYSCHED *, uint64_t );
+void     keyschedSet( DST40_KEYSCHED *, uint64_t );
+void     keyschedNext( DST40_KEYSCHED * );
+uint64_t keyschedExt( uint64_t );
+
+
+#endif /* KEYSCHED_H_ */
@@ -0,0 +1,837 @@
+/******************************************************************************
+ *
+ * Распределённый поиск ключа DST40 на нескольких платах.
+ *
+ * Координатор (dst40 --coordinator PORT) делит младшие 40-L2NK бит ключа
+ * от стартового ключа до конца на аренды по 2^NET_LEASE_BITS значений
+ * и раздаёт их исполнителям (dst40 --worker HOST:PORT). Одна аренда
+ * перебирается исполнителем сразу во всех ядрах его FPGA.
+ *
+ * Протокол - текстовые строки по TCP, числа шестнадцатеричные:
+ *
+ *   исполнитель -> координатор:
+ *     HELLO <имя> <ядер> [<чередование>] - подключение (1 - образ с DST40_CAPS_INTERLEAVE)
+ *     PROGRESS <аренда> <ключ>         - все ключи до <ключ> проверены (раз в секунду)
+ *     FOUND <метка> <ключ>             - найден ключ метки
+ *     DONE <аренда>                    - аренда перебрана
+ *
+ *   координатор -> исполнитель:
+ *     JOB <c1> <c2> <n> <r1> <r2> ...  - задание: запросы и ответы n меток
+ *     LEASE <аренда> <начало> <конец>  - перебрать ключи [начало, конец)
+ *     TRIM <аренда> <конец>            - аренда укорочена до <конец>
+ *     STOP                             - поиск закончен
+ *
+ * Перераспределение работы:
+ *
+ * 1. Исполнитель, от которого NET_TIMEOUT секунд нет сообщений или
+ *    который отключился, считается потерянным: непроверенный остаток его
+ *    аренды отдаётся следующему освободившемуся исполнителю.
+ *
+ * 2. Когда новых аренд не осталось, освободившийся исполнитель забирает
+ *    верхнюю половину остатка самой большой из выданных аренд - так
+ *    медленная плата не задерживает окончание перебора (так же делятся
+ *    диапазоны между потоками в cpusearch.c).
+ *
+ * Аренды задаются в значениях счётчика перебора key_reg (40-L2NK бит),
+ * поэтому у всех исполнителей должно быть одинаковое количество ядер
+ * и одинаковая раскладка ключей по ядрам - как задано координатору
+ * (--kernels, по умолчанию 4, и --interleave). Исполнитель с другим
+ * образом отключается.
+ *
+ * Найденный ключ координатор проверяет сам; когда найдены ключи всех
+ * меток или перебраны все ключи, всем исполнителям рассылается STOP.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "dst40hash.h"
+#include "netsearch.h"
+
+
+//#############################################################################
+// ОПРЕДЕЛЕНИЯ
+
+#define NET_MAX_WORKERS   64                                    // Максимальное количество исполнителей
+#define NET_TIMEOUT       30                                    // Время без сообщений, после которого исполнитель считается потерянным, с
+#define NET_POLL_MS       100                                   // Период опроса FPGA и сети исполнителем, мс
+#define NET_CONNECT_TRIES 30                                    // Попыток подключения к координатору (раз в секунду)
+
+// Аренда: участок младших бит ключа [pos, end)
+
+typedef struct
+{
+  uint32_t id;                                                  // Номер аренды (0 - аренды нет)
+  uint64_t pos;                                                 // Ключи до pos уже проверены
+  uint64_t end;                                                 // Конец участка (не включительно)
+} NET_LEASE;
+
+// Исполнитель на стороне координатора
+
+typedef struct
+{
+  NET_CONN  conn;
+  char      name[64];                                           // Имя из HELLO
+  time_t    heard;                                              // Время последнего сообщения
+  NET_LEASE lease;                                              // Текущая аренда
+} NET_WORKER;
+
+
+
+//#############################################################################
+// ОБЩИЕ ФУНКЦИИ (ими пользуется и daemon.c)
+
+/******************************************************************************
+ * Отправка строки протокола (с переводом строки).
+ *
+ * Возвращает false, если соединение разорвано.
+ *****************************************************************************/
+
+bool netSend( NET_CONN *conn, const char *format, ... )
+{
+  char     line[NET_MAX_LINE];
+  va_list  args;
+  uint32_t len, sent = 0;
+  ssize_t  n;
+
+  va_start( args, format );
+  len = vsnprintf( line, sizeof(line) - 1, format, args );
+  va_end( args );
+
+  if( len > sizeof(line) - 2 )
+    len = sizeof(line) - 2;
+
+  line[len++] = '\n';
+
+  while( sent < len )
+  {
+    if( ( n = send( conn->fd, line + sent, len - sent, MSG_NOSIGNAL ) ) <= 0 )
+    {
+      if( n < 0 && errno == EINTR )
+        continue;
+
+      return false;
+    }
+
+    sent += n;
+  }
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * Приём данных, уже пришедших в сокет (вызывается, когда poll() сообщил
+ * о готовности сокета).
+ *
+ * Возвращает false, если соединение разорвано.
+ *****************************************************************************/
+
+bool netReceive( NET_CONN *conn )
+{
+  ssize_t n;
+
+  if( conn->len == sizeof(conn->buf) )                          // Строка длиннее буфера - протокол нарушен
+    return false;
+
+  do
+    n = recv( conn->fd, conn->buf + conn->len, sizeof(conn->buf) - conn->len, 0 );
+  while( n < 0 && errno == EINTR );
+
+  if( n <= 0 )
+    return false;
+
+  conn->len += n;
+  return true;
+}
+
+
+
+/******************************************************************************
+ * Извлечение из буфера соединения очередной полной строки.
+ *
+ * Возвращает false, если полной строки в буфере нет.
+ *****************************************************************************/
+
+bool netLine( NET_CONN *conn, char *line )
+{
+  char    *end = memchr( conn->buf, '\n', conn->len );
+  uint32_t len;
+
+  if( !end )
+    return false;
+
+  len = end - conn->buf;
+  memcpy( line, conn->buf, len );
+  line[len] = 0;
+
+  if( len && line[len-1] == '\r' )
+    line[len-1] = 0;
+
+  conn->len -= len + 1;
+  memmove( conn->buf, end + 1, conn->len );
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * Закрытие соединения.
+ *****************************************************************************/
+
+void netClose( NET_CONN *conn )
+{
+  if( conn->fd >= 0 )
+    close( conn->fd );
+
+  conn->fd  = -1;
+  conn->len = 0;
+}
+
+
+
+//#############################################################################
+// КООРДИНАТОР
+
+static struct
+{
+  DST40_JOURNAL *job;                                           // Задание: метки, найденные ключи
+  uint32_t       found_count;                                   // Количество найденных ключей
+
+  NET_WORKER     workers[NET_MAX_WORKERS];
+  uint32_t       lease_id;                                      // Номер последней выданной аренды
+
+  uint64_t       next;                                          // Начало ещё не выданной части ключей
+  uint64_t       size;                                          // Размер новой аренды
+  NET_LEASE     *orphans;                                       // Остатки аренд потерянных исполнителей
+  uint32_t       orphan_count;
+} _net;
+
+
+
+/******************************************************************************
+ * Количество ещё не проверенных значений младших бит ключа.
+ *****************************************************************************/
+
+static uint64_t coordRemaining( void )
+{
+  uint64_t remaining = DST40_KEYS - _net.next;
+  uint32_t i;
+
+  for( i=0; i < _net.orphan_count; i++ )
+    remaining += _net.orphans[i].end - _net.orphans[i].pos;
+
+  for( i=0; i < NET_MAX_WORKERS; i++ )
+    if( _net.workers[i].conn.fd >= 0 && _net.workers[i].lease.id )
+      remaining += _net.workers[i].lease.end - _net.workers[i].lease.pos;
+
+  return remaining;
+}
+
+
+
+/******************************************************************************
+ * Отключение исполнителя: непроверенный остаток его аренды откладывается
+ * для следующего свободного исполнителя.
+ *****************************************************************************/
+
+static void coordDrop( NET_WORKER *w, const char *reason )
+{
+  if( w->lease.id && w->lease.pos < w->lease.end )
+  {
+    _net.orphans = realloc( _net.orphans, ( _net.orphan_count + 1 ) * sizeof(NET_LEASE) );
+    _net.orphans[_net.orphan_count++] = w->lease;
+  }
+
+  printf( "\nWorker %s %s\n", w->name, reason );
+
+  w->lease.id = 0;
+  netClose( &w->conn );
+}
+
+
+
+/******************************************************************************
+ * Выдача аренды свободному исполнителю.
+ *
+ * Порядок: остатки аренд потерянных исполнителей, новые аренды, верхняя
+ * половина остатка самой большой из выданных аренд.
+ *****************************************************************************/
+
+static void coordAssign( NET_WORKER *w )
+{
+  NET_LEASE  lease;
+  NET_WORKER *big = NULL;
+  uint32_t   i;
+
+  if( _net.orphan_count )
+  {
+    lease = _net.orphans[--_net.orphan_count];
+
+    if( lease.end - lease.pos > _net.size )                     // Большой остаток отдаём по частям
+    {
+      _net.orphans[_net.orphan_count].pos = lease.pos + _net.size;
+      _net.orphan_count++;
+      lease.end = lease.pos + _net.size;
+    }
+  }
+  else if( _net.next < DST40_KEYS )
+  {
+    lease.pos  = _net.next;
+    lease.end  = ( DST40_KEYS - _net.next > _net.size ) ? _net.next + _net.size : DST40_KEYS;
+    _net.next  = lease.end;
+  }
+  else
+  {
+    for( i=0; i < NET_MAX_WORKERS; i++ )
+    {
+      NET_WORKER *o = &_net.workers[i];
+
+      if( o->conn.fd >= 0 && o->lease.id && ( !big || o->lease.end - o->lease.pos > big->lease.end - big->lease.pos ) )
+        big = o;
+    }
+
+    // Делить есть смысл, только если остаток заметно больше отставания
+    // проверки и исполнитель не успеет дойти до середины, пока идёт TRIM
+
+    if( !big || big->lease.end - big->lease.pos < 4 * DST40_LAG || big->lease.end - big->lease.pos < _net.size / 4 )
+      return;
+
+    lease.end = big->lease.end;
+    lease.pos = big->lease.pos + ( big->lease.end - big->lease.pos ) / 2;
+
+    big->lease.end = lease.pos;
+
+    if( !netSend( &big->conn, "TRIM %X %010llX", big->lease.id, big->lease.end ) )
+    {
+      big->lease.end = lease.end;
+      coordDrop( big, "disconnected" );
+      return;
+    }
+  }
+
+  lease.id = ++_net.lease_id;
+  w->lease = lease;
+
+  if( !netSend( &w->conn, "LEASE %X %010llX %010llX", lease.id, lease.pos, lease.end ) )
+    coordDrop( w, "disconnected" );
+}
+
+
+
+/******************************************************************************
+ * Разбор сообщения исполнителя.
+ *****************************************************************************/
+
+static void coordMessage( NET_WORKER *w, const char *line )
+{
+  DST40_JOURNAL *job = _net.job;
+  uint32_t id, tag, j, kernels = 0, interleave = 0;
+  uint64_t value;
+  char     name[64];
+
+  w->heard = time( NULL );
+
+  if( sscanf( line, "HELLO %63s %x %x", name, &kernels, &interleave ) >= 1 )
+  {
+    char msg[NET_MAX_LINE];
+    int  len = sprintf( msg, "JOB %010llX %010llX %X", job->c1, job->c2, job->n );
+
+    strcpy( w->name, name );
+
+    if( kernels && kernels != DST40_NK )                        // Аренды такому исполнителю не подходят
+    {
+      sprintf( msg, "has %u kernels, %u expected (see --kernels)", kernels, DST40_NK );
+      coordDrop( w, msg );
+      return;
+    }
+
+    if( kernels && ( interleave != 0 ) != DST40_INTERLEAVE )
+    {
+      sprintf( msg, "has %s key layout, %s expected (see --interleave)", interleave ? "interleaved" : "plain",
+               DST40_INTERLEAVE ? "interleaved" : "plain" );
+      coordDrop( w, msg );
+      return;
+    }
+
+    for( j=0; j < job->n; j++ )
+      len += sprintf( msg + len, " %06llX %06llX", job->r1[j], job->r2[j] );
+
+    printf( "\nWorker %s connected\n", w->name );
+
+    if( netSend( &w->conn, "%s", msg ) )
+      coordAssign( w );
+    else
+      coordDrop( w, "disconnected" );
+  }
+  else if( sscanf( line, "PROGRESS %x %llx", &id, &value ) == 2 )
+  {
+    if( id == w->lease.id && value > w->lease.pos )
+      w->lease.pos = ( value < w->lease.end ) ? value : w->lease.end;
+  }
+  else if( sscanf( line, "FOUND %x %llx", &tag, &value ) == 2 )
+  {
+    // Исполнителю не верим на слово: ключ должен подходить к обеим парам
+
+    if( tag < job->n && dst40hash( job->c1, value ) == job->r1[tag] && dst40hash( job->c2, value ) == job->r2[tag] )
+    {
+      if( !job->found[tag] )
+      {
+        job->found[tag] = true;
+        job->keys[tag]  = value;
+        _net.found_count++;
+
+        printf( "\nWorker %s: tag %u KEY FOUND: %010llX\n", w->name, tag, value );
+      }
+    }
+    else
+      printf( "\nWARNING: worker %s reported wrong key %010llX (tag %u)\n", w->name, value, tag );
+  }
+  else if( sscanf( line, "DONE %x", &id ) == 1 )
+  {
+    if( id == w->lease.id )
+    {
+      w->lease.id = 0;
+      coordAssign( w );
+    }
+  }
+  else
+    printf( "\nWARNING: worker %s: bad message \"%s\"\n", w->name, line );
+}
+
+
+
+/******************************************************************************
+ * Координатор распределённого поиска.
+ *
+ * Вход: port       - TCP-порт для подключения исполнителей,
+ *       job        - задание (метки задания - до DST40_NR штук, поиск
+ *                    начинается с наименьшего pos[]),
+ *       lease_bits - логарифм по основанию 2 от размера аренды.
+ *
+ * Найденные ключи записываются в задание. Возвращает false, если
+ * координатор не удалось запустить (сообщение уже выведено).
+ *****************************************************************************/
+
+bool netCoordinator( uint16_t port, DST40_JOURNAL *job, uint32_t lease_bits )
+{
+  struct sockaddr_in addr;
+  struct pollfd      fds[NET_MAX_WORKERS + 1];
+  int      listen_fd, fd, one = 1;
+  uint32_t i, j, active;
+  uint64_t total, remaining;
+  time_t   time_start = time( NULL ), now;
+
+  memset( &_net, 0, sizeof(_net) );
+
+  _net.job  = job;
+  _net.size = 1ULL << lease_bits;
+  _net.next = DST40_KEYS;
+
+  for( j=0; j < job->n; j++ )
+  {
+    if( job->found[j] )
+      _net.found_count++;
+    else if( job->pos[j] < _net.next )
+      _net.next = job->pos[j];
+  }
+
+  total = DST40_KEYS - _net.next;
+
+  for( i=0; i < NET_MAX_WORKERS; i++ )
+    _net.workers[i].conn.fd = -1;
+
+  // Открываем порт для исполнителей
+
+  memset( &addr, 0, sizeof(addr) );
+  addr.sin_family      = AF_INET;
+  addr.sin_addr.s_addr = htonl( INADDR_ANY );
+  addr.sin_port        = htons( port );
+
+  if( ( listen_fd = socket( AF_INET, SOCK_STREAM, 0 ) ) < 0 ||
+      setsockopt( listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one) ) ||
+      bind( listen_fd, (struct sockaddr *)&addr, sizeof(addr) ) ||
+      listen( listen_fd, NET_MAX_WORKERS ) )
+  {
+    perror( "\nERROR: coordinator socket" );
+    return false;
+  }
+
+  printf( "\nCoordinator: port %u, lease 2^%u keys per kernel\n\n", port, lease_bits );
+
+  while( _net.found_count < job->n && ( remaining = coordRemaining() ) )
+  {
+    // Ждём подключений и сообщений исполнителей
+
+    fds[0].fd     = listen_fd;
+    fds[0].events = POLLIN;
+
+    for( i=0; i < NET_MAX_WORKERS; i++ )
+    {
+      fds[i+1].fd     = _net.workers[i].conn.fd;
+      fds[i+1].events = POLLIN;
+    }
+
+    poll( fds, NET_MAX_WORKERS + 1, 1000 );
+
+    now = time( NULL );
+
+    if( fds[0].revents & POLLIN )
+    {
+      if( ( fd = accept( listen_fd, NULL, NULL ) ) >= 0 )
+      {
+        for( i=0; i < NET_MAX_WORKERS && _net.workers[i].conn.fd >= 0; i++ );
+
+        if( i == NET_MAX_WORKERS )
+          close( fd );
+        else
+        {
+          memset( &_net.workers[i], 0, sizeof(NET_WORKER) );
+          setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one) );
+          _net.workers[i].conn.fd = fd;
+          _net.workers[i].heard   = now;
+          strcpy( _net.workers[i].name, "?" );
+        }
+      }
+    }
+
+    for( i=0; i < NET_MAX_WORKERS; i++ )
+    {
+      NET_WORKER *w = &_net.workers[i];
+      char        line[NET_MAX_LINE];
+
+      if( w->conn.fd < 0 || fds[i+1].fd != w->conn.fd )         // Подключился только что - опросим в следующий раз
+        continue;
+
+      if( fds[i+1].revents & ( POLLIN | POLLHUP | POLLERR ) )
+      {
+        if( !netReceive( &w->conn ) )
+        {
+          coordDrop( w, "disconnected" );
+          continue;
+        }
+
+        while( w->conn.fd >= 0 && netLine( &w->conn, line ) )
+          coordMessage( w, line );
+      }
+      else if( now - w->heard > NET_TIMEOUT )
+        coordDrop( w, "timed out" );
+    }
+
+    // Свободные исполнители (например, не получившие половину чужой
+    // аренды, пока она была мала) пробуют взять работу ещё раз
+
+    for( i=0, active=0; i < NET_MAX_WORKERS; i++ )
+    {
+      NET_WORKER *w = &_net.workers[i];
+
+      if( w->conn.fd >= 0 && w->name[0] != '?' && !w->lease.id && _net.found_count < job->n )
+        coordAssign( w );
+
+      active += ( w->conn.fd >= 0 && w->lease.id );
+    }
+
+    printf( "\rWorkers: %u [%lds] [%.3f%%] [%.1f Mkeys/s] ", active, now - time_start,
+            total ? 100.0 * ( total - remaining ) / total : 100.0,
+            now > time_start ? (double)( total - remaining ) * DST40_NK / ( now - time_start ) / 1e6 : 0.0 );
+    fflush( stdout );
+  }
+
+  // Поиск закончен: останавливаем всех исполнителей
+
+  for( i=0; i < NET_MAX_WORKERS; i++ )
+    if( _net.workers[i].conn.fd >= 0 )
+    {
+      netSend( &_net.workers[i].conn, "STOP" );
+      netClose( &_net.workers[i].conn );
+    }
+
+  close( listen_fd );
+  free( _net.orphans );
+
+  for( j=0; j < job->n; j++ )                                   // Для ненайденных меток перебор закончен
+    if( !job->found[j] )
+      job->pos[j] = JOURNAL_DONE;
+
+  return true;
+}
+
+
+
+//#############################################################################
+// ИСПОЛНИТЕЛЬ
+
+/******************************************************************************
+ * Подключение к координатору.
+ *
+ * Вход: address - "адрес:порт".
+ *
+ * Координатор может быть ещё не запущен - подключение повторяется раз
+ * в секунду NET_CONNECT_TRIES раз.
+ *****************************************************************************/
+
+static bool workerConnect( NET_CONN *conn, const char *address )
+{
+  char             host[256], *port;
+  struct addrinfo  hints, *list, *ai;
+  uint32_t         try;
+  int              one = 1;
+
+  conn->fd  = -1;
+  conn->len = 0;
+
+  strncpy( host, address, sizeof(host) - 1 );
+  host[sizeof(host) - 1] = 0;
+
+  if( !( port = strrchr( host, ':' ) ) )
+  {
+    printf( "\nERROR: coordinator address must be HOST:PORT\n" );
+    return false;
+  }
+
+  *port++ = 0;
+
+  memset( &hints, 0, sizeof(hints) );
+  hints.ai_family   = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  if( getaddrinfo( host, port, &hints, &list ) )
+  {
+    printf( "\nERROR: unknown coordinator host \"%s\"\n", host );
+    return false;
+  }
+
+  for( try=0; try < NET_CONNECT_TRIES && conn->fd < 0; try++ )
+  {
+    if( try )
+      sleep( 1 );
+
+    for( ai=list; ai && conn->fd < 0; ai=ai->ai_next )
+    {
+      if( ( conn->fd = socket( ai->ai_family, ai->ai_socktype, ai->ai_protocol ) ) < 0 )
+        continue;
+
+      if( connect( conn->fd, ai->ai_addr, ai->ai_addrlen ) )
+        netClose( conn );
+    }
+  }
+
+  freeaddrinfo( list );
+
+  if( conn->fd < 0 )
+  {
+    perror( "\nERROR: could not connect to coordinator" );
+    return false;
+  }
+
+  setsockopt( conn->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one) );
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * Перебор одной аренды на FPGA.
+ *
+ * Вход: conn  - соединение с координатором,
+ *       job   - задание (start_key - начало аренды),
+ *       id    - номер аренды,
+ *       end   - конец аренды.
+ *
+ * FPGA перебирает ключи от начала аренды; как только все ключи до конца
+ * аренды проверены (счётчик перебора ушёл за конец на DST40_LAG), поиск
+ * останавливается. Возвращает false, если пришёл STOP или соединение
+ * разорвано.
+ *****************************************************************************/
+
+static bool workerLease( NET_CONN *conn, const DST40_BACKEND *backend, const DST40_JOB *job, uint32_t id, uint64_t end )
+{
+  char         line[NET_MAX_LINE];
+  struct pollfd pfd;
+  DST40_RESULT result;
+  uint64_t     flags, position, value;
+  uint32_t     i, trim_id;
+  time_t       reported = time( NULL ), now;
+  bool         finished = false, ok = true;
+
+  backend->load( job );
+  backend->start();
+
+  while( !finished )
+  {
+    flags    = backend->wait( NET_POLL_MS );
+    position = backend->position();
+
+    // Аренда перебрана: останавливаем FPGA и дочитываем FIFO
+
+    if( ( flags & DST40_FLAG_DONE ) || position >= end + DST40_LAG )
+    {
+      backend->stop();
+      finished = true;
+    }
+
+    // Найденные ключи проверяем программно и сообщаем координатору
+
+    while( ok && backend->result( &result ) )
+    {
+      for( i=0; i < DST40_NK; i++ )
+      {
+        uint64_t full_key = backendKey( result.key, i );
+
+        if( !( ( result.kernels >> i ) & 1 ) )
+          continue;
+
+        if( result.index < job->count && dst40hash( job->challenge, full_key ) == job->response[result.index] &&
+            dst40hash( job->challenge2, full_key ) == job->response2[result.index] )
+        {
+          printf( "\nTag %u KEY FOUND: %010llX\n", result.index, full_key );
+          ok = ok && netSend( conn, "FOUND %X %010llX", result.index, full_key );
+        }
+        else
+          printf( "\nWARNING: FPGA reported wrong key %010llX (tag %u)\n", full_key, result.index );
+      }
+    }
+
+    // Сообщения координатора: STOP или укорачивание аренды
+
+    pfd.fd     = conn->fd;
+    pfd.events = POLLIN;
+
+    if( ok && poll( &pfd, 1, 0 ) > 0 )
+    {
+      ok = netReceive( conn );
+
+      while( ok && netLine( conn, line ) )
+      {
+        if( !strcmp( line, "STOP" ) )
+          ok = false;
+        else if( sscanf( line, "TRIM %x %llx", &trim_id, &value ) == 2 && trim_id == id && value < end )
+          end = value;
+      }
+    }
+
+    if( !ok )
+    {
+      backend->stop();
+      return false;
+    }
+
+    // Раз в секунду сообщаем, до какого ключа всё проверено
+
+    now = time( NULL );
+
+    if( now != reported && !finished )
+    {
+      value = ( position > job->start_key + DST40_LAG ) ? position - DST40_LAG : job->start_key;
+
+      printf( "\rLease %X: %010llX..%010llX at %010llX ", id, job->start_key, end, value );
+      fflush( stdout );
+
+      if( !netSend( conn, "PROGRESS %X %010llX", id, value ) )
+      {
+        backend->stop();
+        return false;
+      }
+
+      reported = now;
+    }
+  }
+
+  return netSend( conn, "DONE %X", id );
+}
+
+
+
+/******************************************************************************
+ * Исполнитель распределённого поиска.
+ *
+ * Вход: address - адрес координатора "адрес:порт",
+ *       backend - исполнитель поиска (уже подключен).
+ *
+ * Выполняет аренды координатора до команды STOP. Возвращает false, если
+ * связь с координатором потеряна до STOP.
+ *****************************************************************************/
+
+bool netWorker( const char *address, const DST40_BACKEND *backend )
+{
+  NET_CONN  conn;
+  DST40_JOB job;
+  uint64_t  r1[DST40_MAX_NR], r2[DST40_MAX_NR], start, end;
+  char      line[NET_MAX_LINE], name[64], *p;
+  uint32_t  id, n = 0;
+  bool      have_job = false;
+
+  if( !workerConnect( &conn, address ) )
+    return false;
+
+  gethostname( name, sizeof(name) - 16 );
+  name[sizeof(name) - 16] = 0;
+  sprintf( name + strlen( name ), "/%d", (int)getpid() );
+
+  printf( "\nConnected to coordinator %s as %s\n", address, name );
+
+  if( !netSend( &conn, "HELLO %s %X %X", name, DST40_NK, DST40_INTERLEAVE ) )
+    return false;
+
+  while( 1 )
+  {
+    while( !netLine( &conn, line ) )
+      if( !netReceive( &conn ) )
+      {
+        printf( "\nERROR: coordinator connection lost\n" );
+        netClose( &conn );
+        return false;
+      }
+
+    if( !strcmp( line, "STOP" ) )
+      break;
+
+    if( !strncmp( line, "JOB ", 4 ) )
+    {
+      job.challenge  = strtoull( line + 4, &p, 16 );
+      job.challenge2 = strtoull( p, &p, 16 );
+      job.count      = strtoul( p, &p, 16 );
+
+      for( n=0; n < job.count && n < DST40_NR; n++ )
+      {
+        r1[n] = strtoull( p, &p, 16 );
+        r2[n] = strtoull( p, &p, 16 );
+      }
+
+      job.count     = n;
+      job.response  = r1;
+      job.response2 = r2;
+      have_job      = ( n > 0 );
+
+      printf( "\nJob: challenges %010llX %010llX, %u tags\n", job.challenge, job.challenge2, n );
+    }
+    else if( sscanf( line, "LEASE %x %llx %llx", &id, &start, &end ) == 3 && have_job )
+    {
+      job.start_key = start;
+      job.end_key   = end & ( DST40_KEYS - 1 );                 // Аренда до конца диапазона - 0
+
+      if( !workerLease( &conn, backend, &job, id, end ) )
+        break;
+    }
+    else if( strncmp( line, "TRIM ", 5 ) )                      // TRIM уже перебранной аренды не нужен
+      printf( "\nWARNING: bad coordinator message \"%s\"\n", line );
+  }
+
+  printf( "\nSearch stopped\n" );
+  netClose( &conn );
+
+  return true;
+}
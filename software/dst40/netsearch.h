@@ -0,0 +1,41 @@
+#ifndef NETSEARCH_H_
+#define NETSEARCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "backend.h"
+#include "journal.h"
+
+
+// Распределённый поиск на нескольких платах (режимы --coordinator и --worker).
+//
+// Координатор делит пространство младших 40-L2NK бит ключа (одно значение
+// перебирается сразу всеми ядрами FPGA) на участки - аренды - и раздаёт их
+// по TCP исполнителям. Исполнитель перебирает участок на своей FPGA (или её
+// модели) и сообщает о продвижении и найденных ключах.
+
+#define NET_LEASE_BITS    32                                    // Логарифм по основанию 2 от размера аренды по умолчанию
+#define NET_MAX_LINE      512                                   // Максимальная длина строки протокола
+
+
+// Соединение с текстовым построчным протоколом (TCP или Unix-сокет):
+// сокет и буфер принятых, но ещё не разобранных данных
+
+typedef struct
+{
+  int      fd;                                                  // Сокет (-1 - не подключен)
+  char     buf[NET_MAX_LINE];
+  uint32_t len;
+} NET_CONN;
+
+
+bool netCoordinator( uint16_t, DST40_JOURNAL *, uint32_t );
+bool netWorker( const char *, const DST40_BACKEND * );
+
+bool netSend( NET_CONN *, const char *, ... );
+bool netReceive( NET_CONN * );
+bool netLine( NET_CONN *, char * );
+void netClose( NET_CONN * );
+
+
+#endif /* NETSEARCH_H_ */
@@ -0,0 +1,277 @@
+/******************************************************************************
+ *
+ * Поток-потребитель кольцевого буфера найденных ключей (ring.h).
+ *
+ * Без буфера каждый найденный ключ читается через мост HPS-to-FPGA:
+ * флаги, ключ, биты ядер, номер строки и запись в регистр fifo - пять
+ * обращений к FPGA, из них четыре чтения, каждое по микросекунде.
+ * С буфером FPGA сама пишет ключи в память HPS, а программа:
+ *
+ * 1. Опрашивает не регистры, а номер записи в ячейке хвоста буфера:
+ *    запись свежая, когда номер в ней равен хвосту. Опрос идёт в памяти,
+ *    мост HPS-to-FPGA при этом свободен.
+ *
+ * 2. Забирает записи отдельным потоком (единственный читатель буфера
+ *    FPGA) и перекладывает ключи в очередь в обычной памяти процесса,
+ *    из которой их читает метод result() исполнителя (единственный
+ *    читатель очереди). Обе очереди - с одним писателем и одним
+ *    читателем: писатель двигает только голову, читатель - только хвост,
+ *    поэтому блокировки не нужны, достаточно барьеров памяти между
+ *    данными и счётчиком. Управляющий цикл проверяет ключи программно,
+ *    пока FPGA продолжает перебор и пишет следующие.
+ *
+ * 3. Пишет хвост в FPGA одной записью на пачку забранных записей -
+ *    запись в регистр через мост не ждёт ответа.
+ *
+ * Если очередь процесса заполнена, поток перестаёт забирать записи,
+ * буфер FPGA заполняется, и конвеер останавливается, как при заполненном
+ * FIFO: ключи не теряются.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "backend.h"
+#include "ring.h"
+
+
+//#############################################################################
+// ОПРЕДЕЛЕНИЯ
+
+#define RING_QUEUE        256                                   // Размер очереди процесса (степень двойки)
+#define RING_POLL_NS      100000                                // Период опроса буфера, когда он пуст (100 мкс)
+#define RING_WAIT_NS      1000000                               // Период опроса флагов в ringWait() (1 мс)
+
+
+
+//#############################################################################
+// ГЛОБАЛЬНЫЕ ПЕРЕМЕННЫЕ
+
+static struct
+{
+  DST40_RING         ring;                                      // Буфер и доступ к регистрам
+  pthread_t          thread;                                    // Поток-потребитель
+  volatile bool      run;                                       // Команда работы потока
+
+  volatile uint32_t  tail;                                      // Хвост буфера FPGA: следующая ожидаемая запись
+  uint64_t           position;                                  // Счётчик перебора, до которого все ключи уже в очереди
+  uint32_t           completed;                                 // Выполнено заданий очереди дескрипторов, все ключи которых уже в очереди
+
+  DST40_RESULT       queue[RING_QUEUE];                         // Очередь процесса
+  volatile uint32_t  put;                                       // Записано в очередь (пишет поток)
+  volatile uint32_t  get;                                       // Прочитано из очереди (пишет ringResult())
+} _ring;
+
+
+
+/******************************************************************************
+ * Поток-потребитель: перекладывает записи буфера FPGA в очередь процесса.
+ *****************************************************************************/
+
+static void *ringConsumer( void *arg )
+{
+  uint32_t  mask = ( 1U << _ring.ring.l2size ) - 1;
+  uint32_t  tail = _ring.tail;
+  uint32_t  n;
+  volatile DST40_RECORD *record;
+  DST40_RESULT *e;
+  struct timespec ts = { 0, RING_POLL_NS };
+
+  while( _ring.run )
+  {
+    for( n=0; _ring.put - _ring.get < RING_QUEUE; n++ )
+    {
+      record = &_ring.ring.records[tail & mask];
+
+      if( record->seq != tail )                                 // Записи ещё нет
+        break;
+
+      __sync_synchronize();                                     // Поля записи читаем после её номера
+
+      e = &_ring.queue[_ring.put % RING_QUEUE];
+      e->key     = record->key;
+      e->kernels = record->kernels;
+      e->index   = record->index;
+      e->cycles  = record->cycles;
+      e->job     = record->job;
+
+      __sync_synchronize();                                     // Ключ в очереди раньше, чем счётчики
+      _ring.put++;
+      _ring.tail = ++tail;
+    }
+
+    if( n )
+      _ring.ring.write( DST40_REG_RING_TAIL, tail );            // Освобождаем ячейки в FPGA
+    else
+      nanosleep( &ts, NULL );
+  }
+
+  return NULL;
+}
+
+
+
+/******************************************************************************
+ * Запуск приёма ключей через буфер.
+ *
+ * Вызывается до записи 1 в run. Хвост приравнивается голове FPGA,
+ * а все ячейки помечаются номером, который не совпадёт ни с одной
+ * ожидаемой записью, - после перезагрузки FPGA голова начинает
+ * счёт заново, и записи прошлых сеансов не должны выглядеть свежими.
+ * Возвращает false, если поток не запустился (буфер при этом
+ * не включается и ключи остаются в FIFO).
+ *****************************************************************************/
+
+bool ringStart( const DST40_RING *ring )
+{
+  uint32_t head, i;
+
+  _ring.ring = *ring;
+
+  head = (uint32_t) ring->read( DST40_REG_RING_HEAD );
+
+  for( i=0; i < ( 1U << ring->l2size ); i++ )
+    ring->records[i].seq = head - 1;
+
+  __sync_synchronize();
+
+  _ring.tail     = head;
+  _ring.put      = 0;
+  _ring.get      = 0;
+  _ring.position = ring->read( DST40_REG_POSITION );            // В простое - младшие биты стартового ключа
+  _ring.completed = 0;
+  _ring.run      = true;
+
+  ring->write( DST40_REG_RING_TAIL, head );
+  ring->write( DST40_REG_RING_BASE, ring->base );
+
+  if( pthread_create( &_ring.thread, NULL, ringConsumer, NULL ) )
+  {
+    printf( "\nERROR: could not start ring consumer thread\n" );
+    _ring.run = false;
+    return false;
+  }
+
+  ring->write( DST40_REG_RING_CTL, ( ring->l2size << 8 ) | 1 );
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * Остановка потока-потребителя. Буфер в FPGA остаётся включённым -
+ * его выключает загрузка следующего задания.
+ *****************************************************************************/
+
+void ringStop( void )
+{
+  if( !_ring.run )
+    return;
+
+  _ring.run = false;
+  pthread_join( _ring.thread, NULL );
+}
+
+
+
+/******************************************************************************
+ * Ожидание ключа в очереди или конца перебора не дольше timeout мс
+ * (0 - без ограничения). Возвращает флаги, как метод wait().
+ *
+ * Флаг found в регистре флагов при включённом буфере означает
+ * "ключ ещё не записан в буфер", поэтому found берётся из очереди.
+ * Флаг done FPGA взводит, когда все ключи записаны в буфер,
+ * а здесь он возвращается, только когда поток забрал их все.
+ *****************************************************************************/
+
+uint64_t ringWait( uint32_t timeout )
+{
+  uint64_t flags;
+  struct timespec ts = { 0, RING_WAIT_NS };
+
+  while( 1 )
+  {
+    flags = _ring.ring.read( DST40_REG_FLAGS ) & ~DST40_FLAG_FOUND;
+
+    if( ( flags & DST40_FLAG_DONE ) && (uint32_t) _ring.ring.read( DST40_REG_RING_HEAD ) != _ring.tail )
+      flags &= ~DST40_FLAG_DONE;                                // Поток ещё не забрал последние записи
+
+    if( _ring.put != _ring.get )
+      flags |= DST40_FLAG_FOUND;
+
+    if( ( flags & ( DST40_FLAG_FOUND | DST40_FLAG_DONE ) ) || ( timeout && !--timeout ) )
+      return flags;
+
+    nanosleep( &ts, NULL );
+  }
+}
+
+
+
+/******************************************************************************
+ * Чтение ключа из головы очереди (false - очередь пуста).
+ *****************************************************************************/
+
+bool ringResult( DST40_RESULT *result )
+{
+  if( _ring.get == _ring.put )
+    return false;
+
+  __sync_synchronize();                                         // Ключ читаем после счётчика
+
+  *result = _ring.queue[_ring.get % RING_QUEUE];
+
+  __sync_synchronize();                                         // Ячейку освобождаем после чтения
+  _ring.get++;
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * Счётчик перебора с той же гарантией, что и у метода position():
+ * все ключи до него минус DST40_LAG уже в очереди.
+ *
+ * Счётчик читается первым, затем флаг found (ключ ещё в FIFO или
+ * пишется в буфер) и голова. Если флаг снят и поток уже забрал все
+ * записи до головы, значит, всё найденное до счётчика уже в очереди.
+ * Иначе возвращается прошлое такое значение - ключи находятся редко,
+ * поэтому счётчик отстаёт разве что на один опрос.
+ *****************************************************************************/
+
+uint64_t ringPosition( void )
+{
+  uint64_t position = _ring.ring.read( DST40_REG_POSITION );
+
+  if( !( _ring.ring.read( DST40_REG_FLAGS ) & DST40_FLAG_FOUND ) &&
+      (uint32_t) _ring.ring.read( DST40_REG_RING_HEAD ) == _ring.tail )
+    _ring.position = position;
+
+  return _ring.position;
+}
+
+
+
+/******************************************************************************
+ * Количество выполненных заданий очереди дескрипторов с той же гарантией,
+ * что и у метода completed(): все ключи этих заданий уже в очереди.
+ *
+ * FPGA считает задание выполненным, когда его ключи уже записаны
+ * в буфер, поэтому после счётчика читается голова: если поток забрал
+ * все записи до неё, счётчик годится, иначе возвращается прошлое
+ * такое значение.
+ *****************************************************************************/
+
+uint32_t ringCompleted( void )
+{
+  uint32_t completed = _ring.ring.read( DST40_REG_QUEUE_DONE );
+
+  if( (uint32_t) _ring.ring.read( DST40_REG_RING_HEAD ) == _ring.tail )
+    _ring.completed = completed;
+
+  return _ring.completed;
+}
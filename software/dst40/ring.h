@@ -0,0 +1,56 @@
+#ifndef RING_H_
+#define RING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "backend.h"
+
+
+// Кольцевой буфер найденных ключей в памяти HPS (RingWriter.v, регистры
+// 40..43 модуля DST40).
+//
+// FPGA пишет в буфер записи DST40_RECORD через мост FPGA-to-SDRAM
+// и двигает голову (регистр ring_head), программа забирает записи
+// и двигает хвост (регистр ring_tail). Голова и хвост - счётчики записей:
+// запись N лежит в ячейке N mod 2^l2size.
+
+#define RING_L2SIZE       12                                    // Логарифм количества записей буфера по умолчанию
+#define RING_MAX_L2SIZE   20                                    // Наибольший логарифм количества записей
+
+typedef struct
+{
+  uint64_t key;                                                 // Младшие 40-L2NK бит ключа
+  uint32_t kernels;                                             // Биты ядер, нашедших ключ
+  uint32_t index;                                               // Номер строки таблицы ответов
+  uint64_t cycles;                                              // Такт ядер от запуска, на котором ключ найден
+  uint32_t seq;                                                 // Номер записи (значение головы при записи)
+  uint32_t job;                                                 // Номер задания очереди дескрипторов (биты 15..0)
+} DST40_RECORD;
+
+
+// Буфер и доступ к регистрам модуля DST40 (reg - номер 64-битного регистра)
+
+typedef struct
+{
+  volatile DST40_RECORD *records;                               // Буфер: 2^l2size записей
+  uint32_t   l2size;                                            // Логарифм количества записей
+  uint32_t   base;                                              // Физический адрес буфера (для регистра ring_base)
+
+  uint64_t (*read)( uint32_t );                                 // Чтение регистра
+  void     (*write)( uint32_t, uint64_t );                      // Запись регистра
+} DST40_RING;
+
+
+extern uint32_t _ring_base;                                     // Параметры буфера из backendRing()
+extern uint32_t _ring_l2size;
+
+
+bool     ringStart( const DST40_RING * );
+void     ringStop( void );
+uint64_t ringWait( uint32_t );
+bool     ringResult( DST40_RESULT * );
+uint64_t ringPosition( void );
+uint32_t ringCompleted( void );
+
+
+#endif /* RING_H_ */
@@ -0,0 +1,489 @@
+/******************************************************************************
+ *
+ * Радужные таблицы для восстановления ключа по известным запросам.
+ *
+ * Многие считыватели всегда посылают метке одни и те же запросы c1, c2.
+ * Для такой пары запросов ключ можно найти за секунды по заранее
+ * построенной таблице вместо перебора всех 2^40 ключей.
+ *
+ * Функция, которую обращает таблица, - ключ -> 48 бит ответов на оба
+ * запроса: один 24-битный ответ не задаёт ключ (ему соответствуют 2^16
+ * ключей), а второй ответ - это тот самый контекст, который делает
+ * отображение почти взаимно однозначным. Функция редукции столбца j
+ * сворачивает 48 бит ответов в 40-битный ключ и смешивает их с номером
+ * таблицы и столбца (радужная таблица: у каждого столбца своя редукция,
+ * поэтому слияние цепочек возможно только в одном и том же столбце).
+ *
+ * Цепочка: k[0] = начальный ключ, k[j+1] = R_j( h_c1( k[j] ), h_c2( k[j] ) ),
+ * в таблицу пишутся k[0] и k[length]. Таблица - обычная радужная: все
+ * цепочки считаются на полную длину length, без различимых точек
+ * (distinguished points), поэтому при поиске конечный ключ хвоста
+ * ищется в таблице один раз на столбец. Цепочки с одинаковым конечным
+ * ключом слились - из них остаётся одна.
+ *
+ * Поиск по ответам (r1, r2): для каждого столбца j из y = R_j( r1, r2 )
+ * строится хвост цепочки до конца и его конечный ключ ищется в таблице.
+ * Совпавшая цепочка строится заново от начала до столбца j, и если её
+ * ключ в этом столбце даёт ответы r1, r2, это и есть искомый ключ
+ * (иначе - ложная тревога из-за слияния). Поиск стоит length^2 хэшей
+ * на таблицу вместо 2^40.
+ *
+ * Цепочки и при построении таблицы, и при поиске считаются битслайсовым
+ * движком (bitslice.c) по engine->lanes цепочек за раз на всех ядрах
+ * процессора. FPGA здесь не помогает: её конвеер перебирает только
+ * последовательные ключи и не умеет подавать на вход результат
+ * предыдущего хэша.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "dst40hash.h"
+#include "bitslice.h"
+#include "cpusearch.h"
+#include "tmto.h"
+
+
+//#############################################################################
+// ОПРЕДЕЛЕНИЯ
+
+#define TMTO_MASK         0xFFFFFFFFFFULL                       // 40 бит ключа
+#define TMTO_MAX_THREADS  256
+
+
+
+//#############################################################################
+// ГЛОБАЛЬНЫЕ ПЕРЕМЕННЫЕ
+
+static struct
+{
+  const DST40_ENGINE *engine;                                   // Битслайсовый движок
+  uint64_t            c1, c2;                                   // Запросы
+  uint32_t            table;                                    // Номер таблицы
+  uint32_t            length;                                   // Длина цепочки
+
+  TMTO_CHAIN         *chains;                                   // Цепочки таблицы
+  uint64_t            count;                                    // Количество цепочек
+
+  volatile uint64_t   next;                                     // Следующая порция работы (цепочка или столбец)
+  volatile uint64_t   done;                                     // Количество построенных цепочек
+
+  uint64_t            r1, r2;                                   // Искомые ответы
+  volatile bool       found;                                    // Ключ найден - останавливает все потоки
+  uint64_t            key;                                      // Найденный ключ
+  volatile uint64_t   alarms;                                   // Количество ложных тревог
+} _tmto;
+
+
+
+/******************************************************************************
+ * Функция редукции столбца: ответы на оба запроса -> ключ.
+ *****************************************************************************/
+
+static uint64_t tmtoReduce( uint64_t r1, uint64_t r2, uint32_t column )
+{
+  uint64_t x    = ( r2 << 24 ) | r1;
+  uint64_t salt = ( ( (uint64_t)_tmto.table << 32 ) | column ) * 0x9E3779B97F4A7C15ULL;
+
+  return ( x ^ ( x >> 40 ) ^ ( salt >> 24 ) ) & TMTO_MASK;
+}
+
+
+
+/******************************************************************************
+ * Начальный ключ цепочки номер i (умножение на нечётное число по модулю
+ * 2^40 - взаимно однозначно, начальные ключи не повторяются).
+ *****************************************************************************/
+
+static uint64_t tmtoStart( uint64_t i )
+{
+  return ( i * 0x5851F42D4DULL ) & TMTO_MASK;
+}
+
+
+
+/******************************************************************************
+ * Продвижение цепочек по столбцам.
+ *
+ * Вход:  keys  - ключи цепочек (engine->lanes штук),
+ *        col   - столбцы, в которых находятся ключи,
+ *        end   - столбцы, до которых продвигать цепочки,
+ *        n     - количество используемых цепочек (остальные не меняются).
+ * Выход: keys  - ключи цепочек в столбцах end,
+ *        col   - равны end.
+ *
+ * Все цепочки считаются одновременно, по одной на бит машинного слова
+ * движка; цепочки, дошедшие до своего столбца, просто ждут остальных.
+ *****************************************************************************/
+
+static void tmtoWalk( uint64_t *keys, uint32_t *col, const uint32_t *end, uint32_t n )
+{
+  uint64_t c1[BS_MAX_LANES], c2[BS_MAX_LANES];
+  uint64_t r1[BS_MAX_LANES], r2[BS_MAX_LANES];
+  uint32_t l, lanes = _tmto.engine->lanes;
+  bool     active = true;
+
+  for( l=0; l < lanes; l++ )
+  {
+    c1[l] = _tmto.c1;
+    c2[l] = _tmto.c2;
+  }
+
+  while( active )
+  {
+    for( l=0, active=false; l < n && !active; l++ )
+      active = ( col[l] < end[l] );
+
+    if( !active )
+      break;
+
+    _tmto.engine->hash( c1, keys, r1 );
+    _tmto.engine->hash( c2, keys, r2 );
+
+    for( l=0; l < n; l++ )
+      if( col[l] < end[l] )
+      {
+        keys[l] = tmtoReduce( r1[l], r2[l], col[l] );
+        col[l]++;
+      }
+  }
+}
+
+
+
+/******************************************************************************
+ * Поток построения таблицы: берёт по engine->lanes цепочек за раз.
+ *****************************************************************************/
+
+static void *tmtoBuildThread( void *arg )
+{
+  uint64_t keys[BS_MAX_LANES];
+  uint32_t col[BS_MAX_LANES], end[BS_MAX_LANES];
+  uint32_t l, n, lanes = _tmto.engine->lanes;
+  uint64_t i;
+
+  memset( keys, 0, sizeof(keys) );
+
+  while( ( i = __sync_fetch_and_add( &_tmto.next, lanes ) ) < _tmto.count )
+  {
+    n = ( _tmto.count - i < lanes ) ? _tmto.count - i : lanes;
+
+    for( l=0; l < n; l++ )
+    {
+      keys[l] = tmtoStart( i + l );
+      col[l]  = 0;
+      end[l]  = _tmto.length;
+    }
+
+    tmtoWalk( keys, col, end, n );
+
+    for( l=0; l < n; l++ )
+    {
+      _tmto.chains[i+l].start = tmtoStart( i + l );
+      _tmto.chains[i+l].end   = keys[l];
+    }
+
+    __sync_fetch_and_add( &_tmto.done, n );
+  }
+
+  return NULL;
+}
+
+
+
+/******************************************************************************
+ * Сравнение цепочек по конечному ключу (для qsort и bsearch).
+ *****************************************************************************/
+
+static int tmtoCompare( const void *a, const void *b )
+{
+  uint64_t x = ( (const TMTO_CHAIN *)a )->end;
+  uint64_t y = ( (const TMTO_CHAIN *)b )->end;
+
+  return ( x > y ) - ( x < y );
+}
+
+
+
+/******************************************************************************
+ * Построение таблицы.
+ *
+ * Вход: name    - имя файла таблицы,
+ *       c1, c2  - запросы,
+ *       table   - номер таблицы (таблицы с разными номерами независимы),
+ *       length  - длина цепочки,
+ *       count   - количество цепочек,
+ *       threads - количество потоков (0 - по числу ядер).
+ *
+ * Возвращает false при ошибке (сообщение уже выведено).
+ *
+ * Файл открывается и в него пишется пустой заголовок до построения
+ * цепочек, чтобы неверный путь или нехватка места обнаружились сразу,
+ * а не после многочасового расчёта. Настоящий заголовок пишется
+ * последним, поэтому недостроенную таблицу tmtoLookup() не примет.
+ *****************************************************************************/
+
+bool tmtoBuild( const char *name, uint64_t c1, uint64_t c2, uint32_t table, uint32_t length, uint64_t count, uint32_t threads )
+{
+  pthread_t   thread[TMTO_MAX_THREADS];
+  TMTO_HEADER header;
+  FILE       *f;
+  uint64_t    i, n;
+  uint32_t    t;
+  time_t      time_start = time( NULL );
+  bool        ok;
+
+  if( !threads )
+    threads = cpuThreads();
+
+  if( threads > TMTO_MAX_THREADS )
+    threads = TMTO_MAX_THREADS;
+
+  memset( &_tmto, 0, sizeof(_tmto) );
+
+  _tmto.engine = dst40engine();
+  _tmto.c1     = c1 & TMTO_MASK;
+  _tmto.c2     = c2 & TMTO_MASK;
+  _tmto.table  = table;
+  _tmto.length = length;
+  _tmto.count  = count;
+
+  memset( &header, 0, sizeof(header) );
+
+  if( !( f = fopen( name, "wb" ) ) || fwrite( &header, sizeof(header), 1, f ) != 1 || fflush( f ) )
+  {
+    perror( name );
+
+    if( f )
+    {
+      fclose( f );
+      remove( name );
+    }
+
+    return false;
+  }
+
+  if( !( _tmto.chains = malloc( count * sizeof(TMTO_CHAIN) ) ) )
+  {
+    printf( "\nERROR: not enough memory for %llu chains\n", count );
+    fclose( f );
+    remove( name );
+    return false;
+  }
+
+  printf( "\nBuilding table %u: %llu chains x %u keys, %s engine, %u threads\n\n", table, count, length,
+          _tmto.engine->name, threads );
+
+  for( t=0; t < threads; t++ )
+    pthread_create( &thread[t], NULL, tmtoBuildThread, NULL );
+
+  while( _tmto.done < count )
+  {
+    sleep( 1 );
+
+    printf( "\rChains: %llu [%lds] [%lld%%] ", _tmto.done, time( NULL ) - time_start, _tmto.done * 100 / count );
+    fflush( stdout );
+  }
+
+  for( t=0; t < threads; t++ )
+    pthread_join( thread[t], NULL );
+
+  // Сортируем по конечному ключу и выбрасываем слившиеся цепочки
+
+  qsort( _tmto.chains, count, sizeof(TMTO_CHAIN), tmtoCompare );
+
+  for( i=1, n=1; i < count; i++ )
+    if( _tmto.chains[i].end != _tmto.chains[n-1].end )
+      _tmto.chains[n++] = _tmto.chains[i];
+
+  memcpy( header.magic, TMTO_MAGIC, sizeof(header.magic) );
+  header.c1     = _tmto.c1;
+  header.c2     = _tmto.c2;
+  header.table  = table;
+  header.length = length;
+  header.count  = n;
+
+  ok = fwrite( _tmto.chains, sizeof(TMTO_CHAIN), n, f ) == n && !fflush( f ) &&
+       !fseek( f, 0, SEEK_SET ) && fwrite( &header, sizeof(header), 1, f ) == 1;
+  ok = !fclose( f ) && ok;
+
+  free( _tmto.chains );
+
+  if( !ok )
+  {
+    perror( name );
+    remove( name );
+    return false;
+  }
+
+  printf( "\n\nTable %s: %llu unique chains of %llu (%.1f%%), covers about %.3f%% of keys\n", name, n, count,
+          100.0 * n / count, 100.0 * n * length / (double)( TMTO_MASK + 1 ) );
+
+  return true;
+}
+
+
+
+/******************************************************************************
+ * Поток поиска: берёт по engine->lanes столбцов за раз, начиная с последних
+ * (их хвосты короче всего).
+ *****************************************************************************/
+
+static void *tmtoLookupThread( void *arg )
+{
+  uint64_t   keys[BS_MAX_LANES], r1[BS_MAX_LANES], r2[BS_MAX_LANES];
+  uint64_t   c1[BS_MAX_LANES], c2[BS_MAX_LANES];
+  uint32_t   col[BS_MAX_LANES], end[BS_MAX_LANES], at[BS_MAX_LANES];
+  uint32_t   l, n, m, lanes = _tmto.engine->lanes;
+  uint64_t   j0;
+  TMTO_CHAIN probe;
+  const TMTO_CHAIN *chain;
+
+  memset( keys, 0, sizeof(keys) );
+
+  for( l=0; l < lanes; l++ )
+  {
+    c1[l] = _tmto.c1;
+    c2[l] = _tmto.c2;
+  }
+
+  while( !_tmto.found && ( j0 = __sync_fetch_and_add( &_tmto.next, lanes ) ) < _tmto.length )
+  {
+    n = ( _tmto.length - j0 < lanes ) ? _tmto.length - j0 : lanes;
+
+    // Хвосты цепочек: ключ в столбце j + 1 - редукция искомых ответов
+
+    for( l=0; l < n; l++ )
+    {
+      at[l]   = _tmto.length - 1 - ( j0 + l );
+      keys[l] = tmtoReduce( _tmto.r1, _tmto.r2, at[l] );
+      col[l]  = at[l] + 1;
+      end[l]  = _tmto.length;
+    }
+
+    tmtoWalk( keys, col, end, n );
+
+    // Совпавшие конечные ключи: цепочки строим заново до столбца j
+
+    for( l=0, m=0; l < n; l++ )
+    {
+      probe.end = keys[l];
+
+      if( ( chain = bsearch( &probe, _tmto.chains, _tmto.count, sizeof(TMTO_CHAIN), tmtoCompare ) ) )
+      {
+        keys[m] = chain->start;
+        col[m]  = 0;
+        end[m]  = at[l];
+        m++;
+      }
+    }
+
+    if( !m )
+      continue;
+
+    tmtoWalk( keys, col, end, m );
+
+    _tmto.engine->hash( c1, keys, r1 );
+    _tmto.engine->hash( c2, keys, r2 );
+
+    for( l=0; l < m; l++ )
+      if( r1[l] == _tmto.r1 && r2[l] == _tmto.r2 )
+      {
+        _tmto.key   = keys[l];
+        _tmto.found = true;
+      }
+      else
+        __sync_fetch_and_add( &_tmto.alarms, 1 );
+  }
+
+  return NULL;
+}
+
+
+
+/******************************************************************************
+ * Поиск ключа по таблице.
+ *
+ * Вход:  name    - имя файла таблицы,
+ *        r1, r2  - ответы метки на запросы таблицы,
+ *        threads - количество потоков (0 - по числу ядер).
+ * Выход: key     - найденный ключ.
+ *
+ * Возвращает true, если ключ найден.
+ *****************************************************************************/
+
+bool tmtoLookup( const char *name, uint64_t r1, uint64_t r2, uint32_t threads, uint64_t *key )
+{
+  pthread_t          thread[TMTO_MAX_THREADS];
+  const TMTO_HEADER *header;
+  struct stat        st;
+  void              *map;
+  uint32_t           t;
+  int                fd;
+
+  if( !threads )
+    threads = cpuThreads();
+
+  if( threads > TMTO_MAX_THREADS )
+    threads = TMTO_MAX_THREADS;
+
+  if( ( fd = open( name, O_RDONLY ) ) < 0 || fstat( fd, &st ) )
+  {
+    perror( name );
+    return false;
+  }
+
+  if( st.st_size < sizeof(TMTO_HEADER) ||
+      ( map = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0 ) ) == MAP_FAILED )
+  {
+    printf( "\nERROR: %s: bad table\n", name );
+    close( fd );
+    return false;
+  }
+
+  close( fd );
+  header = map;
+
+  if( memcmp( header->magic, TMTO_MAGIC, sizeof(header->magic) ) || !header->length ||
+      header->count > ( st.st_size - sizeof(TMTO_HEADER) ) / sizeof(TMTO_CHAIN) )
+  {
+    printf( "\nERROR: %s: bad table\n", name );
+    munmap( map, st.st_size );
+    return false;
+  }
+
+  memset( &_tmto, 0, sizeof(_tmto) );
+
+  _tmto.engine = dst40engine();
+  _tmto.c1     = header->c1;
+  _tmto.c2     = header->c2;
+  _tmto.table  = header->table;
+  _tmto.length = header->length;
+  _tmto.chains = (TMTO_CHAIN *)( header + 1 );
+  _tmto.count  = header->count;
+  _tmto.r1     = r1 & 0xFFFFFF;
+  _tmto.r2     = r2 & 0xFFFFFF;
+
+  printf( "\nTable %s: challenges %010llX %010llX, table %u, %llu chains x %u keys\n", name, _tmto.c1, _tmto.c2,
+          _tmto.table, _tmto.count, _tmto.length );
+
+  for( t=0; t < threads; t++ )
+    pthread_create( &thread[t], NULL, tmtoLookupThread, NULL );
+
+  for( t=0; t < threads; t++ )
+    pthread_join( thread[t], NULL );
+
+  printf( "False alarms: %llu\n", _tmto.alarms );
+
+  munmap( map, st.st_size );
+
+  *key = _tmto.key;
+  return _tmto.found;
+}
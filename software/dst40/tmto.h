@@ -0,0 +1,41 @@
+#ifndef TMTO_H_
+#define TMTO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// Радужные таблицы (time-memory tradeoff) для меток, которым всегда
+// посылают одни и те же два запроса (режимы --tmto-build и --tmto-lookup).
+// Таблицы обычные радужные: цепочки полной длины, без различимых точек.
+//
+// Файл таблицы: заголовок TMTO_HEADER и за ним count цепочек TMTO_CHAIN,
+// отсортированных по конечному ключу. Все поля - в порядке байт процессора,
+// файл можно отобразить в память mmap() и искать в нём без чтения целиком.
+
+#define TMTO_MAGIC        "DST40TM1"
+#define TMTO_LENGTH       4096                                  // Длина цепочки по умолчанию
+#define TMTO_CHAINS       0x1000000ULL                          // Количество цепочек в таблице по умолчанию
+
+typedef struct
+{
+  char     magic[8];                                            // TMTO_MAGIC
+  uint64_t c1, c2;                                              // Запросы
+  uint32_t table;                                               // Номер таблицы (задаёт функции редукции)
+  uint32_t length;                                              // Длина цепочки
+  uint64_t count;                                               // Количество цепочек
+  uint64_t reserved[3];                                         // До 64 байт
+} TMTO_HEADER;
+
+typedef struct
+{
+  uint64_t end;                                                 // Конечный ключ цепочки
+  uint64_t start;                                               // Начальный ключ цепочки
+} TMTO_CHAIN;
+
+
+bool tmtoBuild( const char *, uint64_t, uint64_t, uint32_t, uint32_t, uint64_t, uint32_t );
+bool tmtoLookup( const char *, uint64_t, uint64_t, uint32_t, uint64_t * );
+
+
+#endif /* TMTO_H_ */
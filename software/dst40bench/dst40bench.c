@@ -0,0 +1,595 @@
+/******************************************************************************
+ *
+ * Регрессионный тест и замер скорости программных реализаций DST40
+ * на хосте (Linux, gcc/clang) - без HPS и без FPGA.
+ *
+ * dst40bench --generate N [seed]  - вывод файла эталонных векторов:
+ *                                   N случайных ключей (плюс ключи из
+ *                                   README и крайние), ответы считаются
+ *                                   эталонной реализацией dst40hashRef();
+ *
+ * dst40bench --verify file        - сверка с файлом всех реализаций:
+ *                                   dst40hashRef(), табличной dst40hash(),
+ *                                   dst40hashSched() по расписанию ключа,
+ *                                   хэша и поиска каждого битслайсового
+ *                                   движка, поддерживаемого процессором,
+ *                                   и многопоточного cpuSearch();
+ *
+ * dst40bench --bench [seconds]    - замер скорости тех же реализаций
+ *                                   (не меньше seconds секунд на каждую,
+ *                                   по умолчанию 1) и масштабирования
+ *                                   cpuSearch() по числу потоков.
+ *
+ * Формат файла векторов - по строке на ключ, шестнадцатеричные числа
+ * через пробел: "ключ запрос1 ответ1 запрос2 ответ2"; строки,
+ * начинающиеся с #, - комментарии.
+ *
+ * Результат замера выводится в CSV (одна строка на реализацию и число
+ * потоков, столбцы не меняются):
+ *
+ *   impl,threads,keys,seconds,keys_per_s,ns_per_key
+ *
+ * ns_per_key - время на ключ по стене часов (для нескольких потоков -
+ * общее, то есть 1e9 / keys_per_s). Файл удобно сохранять от коммита
+ * к коммиту и сравнивать.
+ *
+ * Из папки software: make test - сверка с dst40bench/golden.txt,
+ * make bench - замер.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "dst40hash.h"
+#include "keysched.h"
+#include "bitslice.h"
+#include "cpusearch.h"
+
+
+//#############################################################################
+// ОПРЕДЕЛЕНИЯ
+
+#define BENCH_MAX_VECTORS 4096                                  // Максимальное количество векторов в файле
+#define BENCH_SEARCH_SPAN 20000                                 // Ключей вокруг искомого для проверки cpuSearch()
+#define BENCH_SEARCH_KEYS 4                                     // Сколько векторов проверять через cpuSearch()
+
+typedef struct
+{
+  uint64_t key;                                                 // Ключ
+  uint64_t c1, r1;                                              // Первая пара запрос/ответ
+  uint64_t c2, r2;                                              // Вторая пара запрос/ответ
+} BENCH_VECTOR;
+
+
+
+//#############################################################################
+// ГЛОБАЛЬНЫЕ ПЕРЕМЕННЫЕ
+
+static BENCH_VECTOR _vectors[BENCH_MAX_VECTORS];
+static uint32_t     _count;                                     // Количество загруженных векторов
+static uint32_t     _failed;                                    // Количество несовпадений
+
+static volatile uint64_t _sink;                                 // Не даём компилятору выбросить циклы замера
+
+
+
+//#############################################################################
+// ФУНКЦИИ
+
+/******************************************************************************
+ * Текущее время в секундах (монотонные часы).
+ *****************************************************************************/
+
+static double now( void )
+{
+  struct timespec t;
+
+  clock_gettime( CLOCK_MONOTONIC, &t );
+
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+
+
+/******************************************************************************
+ * Случайное 40-битное число (генератор xorshift64 - одинаковые векторы
+ * при одинаковом seed на любой платформе).
+ *****************************************************************************/
+
+static uint64_t random40( uint64_t *state )
+{
+  uint64_t x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  *state = x;
+
+  return x & 0xFFFFFFFFFFULL;
+}
+
+
+
+/******************************************************************************
+ * Вывод файла эталонных векторов.
+ *****************************************************************************/
+
+static int generate( uint32_t n, uint64_t seed )
+{
+  static const uint64_t fixed[][3] =                            // Ключ и запросы из README, крайние ключи
+  {
+    { 0x0000260000ULL, 1, 2 },
+    { 0x7991F53219ULL, 1, 2 },
+    { 0x0000000000ULL, 0x0000000000ULL, 0xFFFFFFFFFFULL },
+    { 0xFFFFFFFFFFULL, 0x0000000000ULL, 0xFFFFFFFFFFULL },
+  };
+  uint64_t state = seed * 0x9E3779B97F4A7C15ULL + 1;
+  uint64_t key, c1, c2;
+  uint32_t i;
+
+  printf( "# DST40 golden vectors: key challenge1 response1 challenge2 response2 (hex)\n" );
+  printf( "# dst40bench --generate %u %llu (responses by dst40hashRef)\n", n, seed );
+
+  for( i=0; i < sizeof( fixed ) / sizeof( fixed[0] ) + n; i++ )
+  {
+    if( i < sizeof( fixed ) / sizeof( fixed[0] ) )
+    {
+      key = fixed[i][0];
+      c1  = fixed[i][1];
+      c2  = fixed[i][2];
+    }
+    else
+    {
+      key = random40( &state );
+      c1  = random40( &state );
+      c2  = random40( &state );
+    }
+
+    printf( "%010llX %010llX %06llX %010llX %06llX\n", key, c1, dst40hashRef( c1, key ), c2, dst40hashRef( c2, key ) );
+  }
+
+  return 0;
+}
+
+
+
+/******************************************************************************
+ * Загрузка файла эталонных векторов.
+ *****************************************************************************/
+
+static bool loadVectors( const char *name )
+{
+  FILE         *f;
+  char          line[256];
+  BENCH_VECTOR *v;
+
+  if( ( f = fopen( name, "r" ) ) == NULL )
+  {
+    printf( "ERROR: cannot open %s\n", name );
+    return false;
+  }
+
+  _count = 0;
+
+  while( fgets( line, sizeof( line ), f ) && _count < BENCH_MAX_VECTORS )
+  {
+    if( line[0] == '#' || line[0] == '\n' || line[0] == '\r' )
+      continue;
+
+    v = &_vectors[_count];
+
+    if( sscanf( line, "%llx %llx %llx %llx %llx", &v->key, &v->c1, &v->r1, &v->c2, &v->r2 ) != 5 )
+    {
+      printf( "ERROR: %s: bad line \"%s\"\n", name, line );
+      fclose( f );
+      return false;
+    }
+
+    _count++;
+  }
+
+  fclose( f );
+
+  if( !_count )
+    printf( "ERROR: %s: no vectors\n", name );
+
+  return _count != 0;
+}
+
+
+
+/******************************************************************************
+ * Итог сверки одной реализации.
+ *****************************************************************************/
+
+static void report( const char *impl, uint32_t checked, uint32_t errors )
+{
+  printf( "verify %-20s %6u %s\n", impl, checked, errors ? "FAILED" : "ok" );
+
+  _failed += errors;
+}
+
+
+
+/******************************************************************************
+ * Сверка скалярной реализации hash( challenge, key ).
+ *****************************************************************************/
+
+static void verifyScalar( const char *impl, uint64_t (*hash)( uint64_t, uint64_t ) )
+{
+  uint32_t i, errors = 0;
+
+  for( i=0; i < _count; i++ )
+  {
+    if( hash( _vectors[i].c1, _vectors[i].key ) != _vectors[i].r1 || hash( _vectors[i].c2, _vectors[i].key ) != _vectors[i].r2 )
+    {
+      if( !errors )
+        printf( "  %s: key %010llX: %06llX/%06llX instead of %06llX/%06llX\n", impl, _vectors[i].key,
+                hash( _vectors[i].c1, _vectors[i].key ), hash( _vectors[i].c2, _vectors[i].key ), _vectors[i].r1, _vectors[i].r2 );
+      errors++;
+    }
+  }
+
+  report( impl, 2 * _count, errors );
+}
+
+
+
+/******************************************************************************
+ * Сверка хэша по заранее посчитанному расписанию ключа.
+ *****************************************************************************/
+
+static void verifySched( void )
+{
+  DST40_KEYSCHED ks;
+  uint32_t       i, errors = 0;
+
+  for( i=0; i < _count; i++ )
+  {
+    keyschedInit( &ks, _vectors[i].key );
+
+    if( dst40hashSched( _vectors[i].c1, &ks ) != _vectors[i].r1 || dst40hashSched( _vectors[i].c2, &ks ) != _vectors[i].r2 )
+      errors++;
+  }
+
+  report( "sched", 2 * _count, errors );
+}
+
+
+
+/******************************************************************************
+ * Сверка битслайсового движка: хэш произвольных пар (векторы идут
+ * по кругу, lanes за вызов) и поиск по первой паре в группе из lanes
+ * ключей, содержащей ключ вектора.
+ *****************************************************************************/
+
+static void verifyEngine( const DST40_ENGINE *e )
+{
+  static uint64_t challenge[BS_MAX_LANES], key[BS_MAX_LANES], response[BS_MAX_LANES], found[BS_MAX_LANES];
+  DST40_KEYSCHED ks;
+  uint32_t       i, j, n, k, errors;
+  char           impl[32];
+
+  // Хэш: каждый вектор проходит хотя бы раз через каждую половину пар
+
+  errors = 0;
+
+  for( i=0; i < _count; i += e->lanes / 2 )
+  {
+    for( j=0; j < e->lanes; j++ )
+    {
+      k = ( i + j / 2 ) % _count;
+      challenge[j] = ( j & 1 ) ? _vectors[k].c2 : _vectors[k].c1;
+      key[j]       = _vectors[k].key;
+    }
+
+    e->hash( challenge, key, response );
+
+    for( j=0; j < e->lanes; j++ )
+    {
+      k = ( i + j / 2 ) % _count;
+
+      if( response[j] != ( ( j & 1 ) ? _vectors[k].r2 : _vectors[k].r1 ) )
+        errors++;
+    }
+  }
+
+  sprintf( impl, "bs-%s-hash", e->name );
+  report( impl, 2 * _count, errors );
+
+  // Поиск
+
+  errors = 0;
+
+  for( i=0; i < _count; i++ )
+  {
+    keyschedInit( &ks, _vectors[i].key & ~(uint64_t)( e->lanes - 1 ) );
+
+    n = e->search( _vectors[i].c1, _vectors[i].r1, &ks, found );
+
+    for( j=0; j < n && found[j] != _vectors[i].key; j++ )
+      ;
+
+    if( j == n )
+      errors++;
+  }
+
+  sprintf( impl, "bs-%s-search", e->name );
+  report( impl, _count, errors );
+}
+
+
+
+/******************************************************************************
+ * Сверка многопоточного поиска cpuSearch() (движок по умолчанию,
+ * DST40_ENGINE выбирает другой): ключ ищется в диапазоне вокруг него
+ * по обеим парам.
+ *****************************************************************************/
+
+static void verifyCpuSearch( void )
+{
+  uint64_t start, key;
+  uint32_t i, n = 0, errors = 0;
+
+  for( i=0; i < _count && n < BENCH_SEARCH_KEYS; i++ )
+  {
+    if( _vectors[i].key < BENCH_SEARCH_SPAN || _vectors[i].key > 0xFFFFFFFFFFULL - BENCH_SEARCH_SPAN )
+      continue;
+
+    start = _vectors[i].key - BENCH_SEARCH_SPAN / 2;
+
+    if( !cpuSearch( _vectors[i].c1, _vectors[i].r1, _vectors[i].c2, _vectors[i].r2,
+                    start, start + BENCH_SEARCH_SPAN, 0, NULL, &key ) || key != _vectors[i].key )
+      errors++;
+
+    n++;
+  }
+
+  report( "cpusearch", n, errors );
+}
+
+
+
+/******************************************************************************
+ * Сверка всех реализаций с файлом векторов.
+ *****************************************************************************/
+
+static int verify( const char *name )
+{
+  const DST40_ENGINE *e;
+  uint32_t            i;
+
+  if( !loadVectors( name ) )
+    return 1;
+
+  verifyScalar( "ref", dst40hashRef );
+  verifyScalar( "table", dst40hash );
+  verifySched();
+
+  for( i=0; ( e = dst40engineList( i ) ) != NULL; i++ )
+  {
+    if( e->supported() )
+      verifyEngine( e );
+    else
+      printf( "verify bs-%-17s %6s skipped (not supported by this CPU)\n", e->name, "" );
+  }
+
+  verifyCpuSearch();
+
+  printf( "%s\n", _failed ? "FAILED" : "PASSED" );
+
+  return _failed ? 1 : 0;
+}
+
+
+
+/******************************************************************************
+ * Строка результата замера.
+ *****************************************************************************/
+
+static void result( const char *impl, uint32_t threads, uint64_t keys, double seconds )
+{
+  printf( "%s,%u,%llu,%.3f,%.0f,%.3f\n", impl, threads, keys, seconds, keys / seconds, seconds * 1e9 / keys );
+  fflush( stdout );
+}
+
+
+
+/******************************************************************************
+ * Замер скалярной реализации: порции по 2^16 хэшей, пока не пройдёт
+ * seconds секунд.
+ *****************************************************************************/
+
+static double benchScalar( const char *impl, uint64_t (*hash)( uint64_t, uint64_t ), double seconds )
+{
+  uint64_t keys = 0, sum = 0, i;
+  double   t0 = now(), t;
+
+  do
+  {
+    for( i=0; i < 0x10000; i++ )
+      sum += hash( 0x123456789AULL, keys + i );
+
+    keys += 0x10000;
+  }
+  while( ( t = now() - t0 ) < seconds );
+
+  _sink = sum;
+  result( impl, 1, keys, t );
+
+  return keys / t;
+}
+
+
+
+/******************************************************************************
+ * Замер хэша по расписанию: последовательные ключи, расписание
+ * исправляется keyschedNext().
+ *****************************************************************************/
+
+static double benchSched( double seconds )
+{
+  DST40_KEYSCHED ks;
+  uint64_t       keys = 0, sum = 0, i;
+  double         t0 = now(), t;
+
+  keyschedInit( &ks, 0 );
+
+  do
+  {
+    for( i=0; i < 0x10000; i++ )
+    {
+      sum += dst40hashSched( 0x123456789AULL, &ks );
+      keyschedNext( &ks );
+    }
+
+    keys += 0x10000;
+  }
+  while( ( t = now() - t0 ) < seconds );
+
+  _sink = sum;
+  result( "sched", 1, keys, t );
+
+  return keys / t;
+}
+
+
+
+/******************************************************************************
+ * Замер битслайсового движка: хэш произвольных пар и поиск
+ * последовательных ключей (как в cpuSearch(), одним потоком).
+ * Возвращает скорость поиска, ключей/с.
+ *****************************************************************************/
+
+static double benchEngine( const DST40_ENGINE *e, double seconds )
+{
+  static uint64_t challenge[BS_MAX_LANES], key[BS_MAX_LANES], response[BS_MAX_LANES], found[BS_MAX_LANES];
+  DST40_KEYSCHED ks;
+  uint64_t       keys, sum = 0, i;
+  double         t0, t;
+  char           impl[32];
+
+  for( i=0; i < e->lanes; i++ )
+  {
+    challenge[i] = 0x123456789AULL ^ i;
+    key[i]       = i * 0x9E3779B9ULL;
+  }
+
+  keys = 0;
+  t0   = now();
+
+  do
+  {
+    for( i=0; i < 256; i++ )
+    {
+      key[0] = keys + i;
+      e->hash( challenge, key, response );
+      sum += response[0];
+    }
+
+    keys += 256 * e->lanes;
+  }
+  while( ( t = now() - t0 ) < seconds );
+
+  sprintf( impl, "bs-%s-hash", e->name );
+  result( impl, 1, keys, t );
+
+  keys = 0;
+  t0   = now();
+  keyschedInit( &ks, 0 );
+
+  do
+  {
+    for( i=0; i < 256; i++ )
+    {
+      sum += e->search( 0x123456789AULL, 0x5A5A5A, &ks, found );
+      keyschedSet( &ks, ks.key + e->lanes );
+    }
+
+    keys += 256 * e->lanes;
+  }
+  while( ( t = now() - t0 ) < seconds );
+
+  _sink = sum;
+  sprintf( impl, "bs-%s-search", e->name );
+  result( impl, 1, keys, t );
+
+  return keys / t;
+}
+
+
+
+/******************************************************************************
+ * Замер всех реализаций и масштабирования cpuSearch() по потокам:
+ * 1, 2, 4, ... и количество ядер процессора. Размер диапазона для
+ * каждого числа потоков подбирается по скорости одного потока так,
+ * чтобы поиск шёл около seconds секунд.
+ *****************************************************************************/
+
+static int bench( double seconds )
+{
+  const DST40_ENGINE *e;
+  uint64_t            keys, key;
+  uint32_t            i, threads, cores = cpuThreads();
+  double              rate = 0, t0, t;
+
+  printf( "impl,threads,keys,seconds,keys_per_s,ns_per_key\n" );
+
+  benchScalar( "ref", dst40hashRef, seconds );
+  benchScalar( "table", dst40hash, seconds );
+  benchSched( seconds );
+
+  for( i=0; ( e = dst40engineList( i ) ) != NULL; i++ )
+  {
+    if( !e->supported() )
+      continue;
+
+    t = benchEngine( e, seconds );
+
+    if( e == dst40engine() )                                    // Этот движок использует cpuSearch()
+      rate = t;
+  }
+
+  for( threads=1; rate > 0; threads = ( threads * 2 < cores ) ? threads * 2 : cores )
+  {
+    keys = (uint64_t)( rate * threads * seconds ) & ~0xFFFFULL;
+    keys = keys ? keys : 0x10000;
+
+    t0 = now();
+    cpuSearch( 0x123456789AULL, 0x5A5A5A, 0x23456789ABULL, 0xA5A5A5, 0, keys, threads, NULL, &key );
+    t = now() - t0;
+
+    result( "cpusearch", threads, keys, t );
+
+    if( threads == cores )
+      break;
+  }
+
+  return 0;
+}
+
+
+
+/******************************************************************************
+ * Точка входа.
+ *****************************************************************************/
+
+int main( int argc, char **argv )
+{
+  if( argc >= 3 && !strcmp( argv[1], "--generate" ) )
+    return generate( strtoul( argv[2], NULL, 0 ), argc >= 4 ? strtoull( argv[3], NULL, 0 ) : 1 );
+
+  if( argc >= 3 && !strcmp( argv[1], "--verify" ) )
+    return verify( argv[2] );
+
+  if( argc >= 2 && !strcmp( argv[1], "--bench" ) )
+    return bench( argc >= 3 ? atof( argv[2] ) : 1.0 );
+
+  printf( "Usage: %s --generate N [seed] | --verify file | --bench [seconds]\n", argv[0] );
+
+  return 2;
+}
@@ -2,7 +2,9 @@
  *
  * Программа для тестирования работы модуля DST40.
  *
- * Программа заточена под четырёхъядерный вариант схемы FPGA.
+ * Количество ядер NK и положение номера ядра в ключе программа берёт
+ * из регистров id и caps, поэтому работает с любым образом (NK от 1
+ * до 16); образ без этих регистров считается четырёхъядерным.
  *
  * Алгоритм:
  *
@@ -14,24 +16,56 @@
  * 6. Если модуль не нашёл ключ - выводим сообщение об ошибке и переходим на 1.
  * 7. Если модуль нашёл ключ, то считываем его и сравниваем с нашим.
  * 8. Если ключи не совпали, то выводим сообщение об ошибке и переходим на 1.
- * 9. Выводим время, прошедшее с момента старта программы.
- * 10. Опрашиваем клавиатуру.
- * 11. Если нажали ESC, то выходим из программы.
- * 12. Переходим на 1.
+ * 9. Останавливаем перебор и проверяем счётчик кандидатов (hits) ядра,
+ *    нашедшего ключ, - он не может быть нулевым.
+ * 10. Выводим время, прошедшее с момента старта программы.
+ * 11. Опрашиваем клавиатуру.
+ * 12. Если нажали ESC, то выходим из программы.
+ * 13. Переходим на 1.
+ *
+ * Запуск с ключом --bench выполняет вместо этого замер скорости
+ * программного расчёта хэша (нс/хэш) - эталонной реализации
+ * dst40hashRef() и быстрой табличной dst40hash() - и сверяет их
+ * результаты. FPGA при этом не используется.
  *
  *----------------------------------------------------------------------------
  *
- * Адресная карта модуля DST40 (четырёхядерный вариант):
+ * Адресная карта модуля DST40, которой пользуется программа (NK ядер,
+ * L2NK = log2(NK), таблица ответов на NR строк, L2NR = log2(NR);
+ * полная карта - в заголовке source/dst40.v):
  *
- * 0 - challenge                ( 40 бит,  Чтение/Запись )  Первый запрос
- * 1 - response                 ( 24 бита, Чтение/Запись )  Первый ответ
- * 2 - start_key                ( 40 бит,  Чтение/Запись )  Ключ, с которого начинать поиск
- * 3 - run                      (  1 бит,  Чтение/Запись )  Флаг запуска поиска
+ * 0 - challenge                ( 40 бит,      Чтение/Запись )  Первый запрос
+ * 1 - response                 ( 24 бита,     Чтение/Запись )  Первый ответ
+ * 2 - start_key                ( 40 бит,      Чтение/Запись )  Ключ, с которого начинать поиск
+ * 3 - run                      (  1 бит,      Чтение/Запись )  Флаг запуска поиска
  * 4 - флаги:
- *     бит 0 - key_found_w      (  1 бит,  Только чтение )  Флаг "ключ найден"
- *     бит 8 - key_not_found_w  (  1 бит,  Только чтение )  Флаг "ключ не найден"
- * 5 - key                      ( 38 бит,  Только чтение )  Найденный ключ (младшие биты)
- * 6 - kernels                  (  4 бита, Только чтение )  Биты ядер, нашедших ключ
+ *     бит 0  - found           (  1 бит,      Только чтение )  Флаг "в FIFO есть найденный ключ"
+ *     бит 8  - done            (  1 бит,      Только чтение )  Флаг "все ключи перебраны и проверены"
+ *     бит 16 - overflow        (  1 бит,      Только чтение )  Флаг "перебор приостанавливался"
+ * 5 - key                      ( 40-L2NK бит, Только чтение )  Ключ в голове FIFO (без номера ядра)
+ * 6 - kernels                  (      NK бит, Только чтение )  Бит ядра, нашедшего ключ
+ * 7 - fifo                     (  1 бит,      Только запись )  Запись 1 удаляет ключ из головы FIFO
+ * 8 - challenge2               ( 40 бит,      Чтение/Запись )  Второй запрос
+ * 9 - response2                ( 24 бита,     Чтение/Запись )  Второй ответ
+ * 10 - index                   (    L2NR бит, Только чтение )  Номер метки для ключа в голове FIFO
+ * 11 - count                   ( L2NR+1 бит,  Чтение/Запись )  Количество меток в таблице ответов
+ * 12 - position                ( 41-L2NK бит, Только чтение )  Счётчик перебора (ключи без номера ядра)
+ * 13 - cycles                  ( 48 бит,      Только чтение )  Такты ядер с запуска перебора
+ * 14 - id                      ( 64 бита,     Только чтение )  "DST40", UNROLL и версия образа
+ * 15 - caps                    ( 64 бита,     Только чтение )  NK, L2NK, NR, ..., FEATURES
+ * 16..20 - счётчики            ( 48 бит,      Только чтение )  busy, stall, hold, refill, restarts
+ * 24..24+NK-1 - hits           ( 32 бита,     Только чтение )  Кандидаты по первой паре: ядро k - адрес 24+k
+ * 64..64+NR-1 - responses      ( 48 бит,      Чтение/Запись )  Таблица ответов меток (64 = response и response2)
+ *
+ * Номер ядра - старшие L2NK бит ключа, а в образе с битом CAPS_INTERLEAVE
+ * в поле FEATURES - младшие: ядро i проверяет ключ key * NK + i.
+ * Регистры start_key и key задаются ключом без номера ядра.
+ *
+ * Искомый ключ - стартовый, поэтому он первым попадает в FIFO.
+ * Вторая пара запрос/ответ тоже генерируется для этого ключа, так что
+ * заодно проверяется и проверка кандидатов внутри FPGA. FPGA перебор
+ * не останавливает - ключи, накопившиеся в FIFO к моменту остановки,
+ * выбрасываются.
  *
  *****************************************************************************/
 
@@ -42,18 +76,25 @@
 #include <termios.h>
 #include <time.h>
 #include <sys/mman.h>
+#ifdef __arm__
 #include "hwlib.h"
 #include "socal/socal.h"
 #include "socal/hps.h"
 #include "socal/alt_gpio.h"
+#else
+#define alt_write_dword(dest, src)  ( *(volatile uint64_t *)(dest) = (src) )
+#define alt_read_dword(src)         ( *(volatile uint64_t *)(src) )
+#endif
+#include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include <signal.h>
 #include <sys/time.h>
 #include <wchar.h>
 #include <locale.h>
 #include <math.h>
 
-uint64_t  dst40hash( uint64_t, uint64_t );
+#include "../dst40/dst40hash.h"                                 // Хэш - общий с программой dst40
 
 int kbhit( void );
 int getch( void );
@@ -80,24 +121,137 @@ uint64_t getRand40( void )
 
 
 /******************************************************************************
- * Преобразование старших бит ключа в маску бита ядра.
+ * Параметры образа. До чтения регистра caps - четырёхъядерный образ
+ * без регистров id и caps.
+ *****************************************************************************/
+
+#define DST40_MAGIC       0x4453543430ULL                       // "DST40" - биты 63..24 регистра id
+#define CAPS_INTERLEAVE   0x80                                  // Номер ядра - младшие биты ключа
+
+unsigned nk         = 4;                                        // Количество ядер
+unsigned l2nk       = 2;                                        // Логарифм по основанию 2 от nk
+bool     interleave = false;                                    // Номер ядра - младшие биты ключа
+
+
+
+/******************************************************************************
+ * Чтение параметров образа из регистров id (14) и caps (15).
+ *
+ * Вход:  base - регистры модуля DST40,
+ * Выход: false, если образ программой не поддерживается.
+ *****************************************************************************/
+
+bool readCaps( void* base )
+{
+  uint64_t id   = alt_read_dword( base + 8 * 14 );
+  uint64_t caps = alt_read_dword( base + 8 * 15 );
+
+  if( ( id >> 24 ) != DST40_MAGIC )                             // Старый образ - параметры по умолчанию
+    return true;
+
+  nk         = caps & 0xFF;
+  l2nk       = ( caps >> 8 ) & 0xFF;
+  interleave = ( ( caps >> 48 ) & CAPS_INTERLEAVE ) != 0;
+
+  return nk >= 1 && nk <= 16 && nk == ( 1U << l2nk );
+}
+
+
+
+/******************************************************************************
+ * Номер ядра, проверяющего ключ: старшие l2nk бит ключа, а в образе
+ * с CAPS_INTERLEAVE - младшие.
  *
  * Вход:  key - ключ,
- * Выход: Битовая маска ядра.
+ * Выход: Номер ядра.
  *****************************************************************************/
 
-uint64_t getMaskKernel( uint64_t key )
+unsigned getKernel( uint64_t key )
 {
-  uint64_t kernel = key >> 38;
-  uint64_t mask = 1;
+  return interleave ? key & ( nk - 1 ) : key >> ( 40 - l2nk );
+}
+
+
 
-  for( ; kernel > 0; kernel-- )
-    mask <<= 1;
+/******************************************************************************
+ * Ключ без номера ядра - в таком виде его принимает регистр start_key
+ * и выдаёт регистр key.
+ *
+ * Вход:  key - ключ,
+ * Выход: Оставшиеся 40-l2nk бит ключа.
+ *****************************************************************************/
 
-  return mask;
+uint64_t getKernelKey( uint64_t key )
+{
+  return interleave ? key >> l2nk : key & ( ( 1ULL << ( 40 - l2nk ) ) - 1 );
 }
 
 
+/******************************************************************************
+ * Замер скорости функции хэширования.
+ *
+ * Вход:  hash  - функция хэширования,
+ *        count - количество хэшей.
+ * Выход: Время расчёта одного хэша в наносекундах.
+ *****************************************************************************/
+
+double benchHash( uint64_t (*hash)( uint64_t, uint64_t ), uint32_t count )
+{
+  struct timespec t0, t1;
+  uint64_t sum = 0;
+  uint32_t i;
+
+  clock_gettime( CLOCK_MONOTONIC, &t0 );
+
+  for( i=0; i < count; i++ )
+    sum += hash( i * 0x9E3779B9ULL, i * 0x7F4A7C15ULL );
+
+  clock_gettime( CLOCK_MONOTONIC, &t1 );
+
+  if( sum == 1 )                                                // Не даём компилятору выбросить цикл
+    printf( " " );
+
+  return ( ( t1.tv_sec - t0.tv_sec ) * 1e9 + ( t1.tv_nsec - t0.tv_nsec ) ) / count;
+}
+
+
+
+/******************************************************************************
+ * Микро-бенчмарк программного расчёта хэша: эталонная реализация
+ * против быстрой табличной. Перед замером реализации сверяются
+ * на случайных запросах и ключах.
+ *****************************************************************************/
+
+int bench( void )
+{
+  uint32_t i;
+  double   ns_ref, ns_fast;
+
+  for( i=0; i < 10000; i++ )
+  {
+    uint64_t challenge = getRand40();
+    uint64_t key       = getRand40();
+
+    if( dst40hash( challenge, key ) != dst40hashRef( challenge, key ) )
+    {
+      printf( "Error: CHALLENGE=%010llX, KEY=%010llX, RESPONSE=%06llX, RESPONSE_REF=%06llX\n",
+              challenge, key, dst40hash( challenge, key ), dst40hashRef( challenge, key ) );
+      return 1;
+    }
+  }
+
+  ns_ref  = benchHash( dst40hashRef, 100000 );
+  ns_fast = benchHash( dst40hash,    100000 );
+
+  printf( "dst40hashRef: %8.1f ns/hash\n", ns_ref );
+  printf( "dst40hash:    %8.1f ns/hash\n", ns_fast );
+  printf( "Speedup:      %8.2f\n", ns_ref / ns_fast );
+
+  return 0;
+}
+
+
+
 int main( int argc, char** argv )
 {
 	void* h2f_base;
@@ -107,6 +261,8 @@ int main( int argc, char** argv )
 
   uint64_t challenge;
   uint64_t response;
+  uint64_t challenge2;
+  uint64_t response2;
   uint64_t key;
 
   uint64_t testCount = 0;
@@ -131,6 +287,11 @@ int main( int argc, char** argv )
 
   srand( time(NULL) );
 
+  // Замер скорости расчёта хэша - без FPGA
+
+  if( argc > 1 && !strcmp( argv[1], "--bench" ) )
+    return bench();
+
   // Маппим регистры модуля DST40 в память
 
   if( ( fd = open( "/dev/mem", ( O_RDWR | O_SYNC ) ) ) == -1 )
@@ -148,6 +309,18 @@ int main( int argc, char** argv )
     return(1);
   }
 
+  // Параметры образа
+
+  if( !readCaps( h2f_base ) )
+  {
+    printf( "\r\nERROR: unsupported FPGA image\r\n" );
+    munmap( h2f_base, 1024 );
+    close( fd );
+    return( 1 );
+  }
+
+  printf( "\r\nFPGA image: %u kernels%s\r\n", nk, interleave ? ", interleaved" : "" );
+
   printf( "\r\nPress ESC for exit\r\n\r\n" );
   fflush( stdout );
 
@@ -172,13 +345,24 @@ int main( int argc, char** argv )
     // Вычисляем ответ
     response  = dst40hash( challenge, key );
 
+    // Вторая пара запрос/ответ для того же ключа
+    challenge2 = getRand40();
+    response2  = dst40hash( challenge2, key );
+
     // Останавливаем FPGA
     alt_write_dword( h2f_base + 24, 0 );
 
+    // Выбрасываем кандидатов, оставшихся в FIFO от прошлой проверки
+    while( alt_read_dword( h2f_base + 32 ) & 1 )
+      alt_write_dword( h2f_base + 56, 1 );
+
     // Загружаем исходные данные в FPGA
     alt_write_dword( h2f_base +  0, challenge );
     alt_write_dword( h2f_base +  8, response );
-    alt_write_dword( h2f_base + 16, key );
+    alt_write_dword( h2f_base + 16, getKernelKey( key ) );
+    alt_write_dword( h2f_base + 64, challenge2 );
+    alt_write_dword( h2f_base + 72, response2 );
+    alt_write_dword( h2f_base + 88, 1 );                        // Одна метка - строка 0 таблицы ответов
 
     // Разрешаем FPGA искать ключ
     alt_write_dword( h2f_base + 24, 1 );
@@ -200,15 +384,28 @@ int main( int argc, char** argv )
       // Считываем биты ядер, нашедших ключ
       uint64_t kernels = alt_read_dword( h2f_base + 48 );
 
-      // Вычисляем маску ядра, которое должно было найти ключ
-      uint64_t mask = getMaskKernel( key );
+      // Номер ядра, которое должно было найти ключ
+      unsigned kernel = getKernel( key );
+      uint64_t hits;
 
       // Проверяем совпадение найденного ключа с исходным и совпадение номера ядра с требуемым
-      if( result != (key & 0x3FFFFFFFFF) || (kernels & mask) == 0 )
+      if( result != getKernelKey( key ) || ( ( kernels >> kernel ) & 1 ) == 0 )
       {
         printf( "\r\nError: Count=%lld, CHALLENGE=%010llX, RESPONSE=%06llX, KEY=%010llX, KEY_FPGA=%010llX, KERNELS=%lld\r\n", testCount, challenge, response, key, result, kernels );
         errCount++;
       }
+
+      // Останавливаем перебор - счётчики кандидатов корректны только после
+      // остановки - и проверяем счётчик ядра, нашедшего ключ (адрес 24+kernel)
+      alt_write_dword( h2f_base + 24, 0 );
+
+      hits = alt_read_dword( h2f_base + 8 * ( 24 + kernel ) );
+
+      if( hits == 0 )
+      {
+        printf( "\r\nError: Count=%lld, KEY=%010llX, KERNEL=%u, HITS=0\r\n", testCount, key, kernel );
+        errCount++;
+      }
     }
     else if( flags.key_not_found )
     {
@@ -0,0 +1,122 @@
+/******************************************************************************
+
+  FIFO с раздельными тактами записи и чтения.
+
+  Используется для передачи найденных ключей-кандидатов из домена
+  тактов PLL (ядра) в домен тактов FPGA_CLK1_50 (Avalon-MM).
+
+  ПРИМЕЧАНИЯ.
+
+  1. Указатели записи и чтения передаются в чужой домен тактов в коде Грея
+     через два триггера, поэтому флаги full_o и empty_o выставляются
+     с запасом: full_o может держаться на пару тактов дольше, чем FIFO
+     на самом деле заполнено, empty_o - дольше, чем оно на самом деле пусто.
+     Данные при этом не теряются и не читаются дважды.
+
+  2. Выход data_o - голова FIFO, читается без задержки (режим show-ahead):
+     память маленькая и читается комбинаторно. Слово в голове FIFO
+     не меняется, пока empty_o = 0 и не подан строб read_i.
+
+  3. Сброса нет: перед новым запуском FIFO вычитывается программно.
+
+******************************************************************************/
+
+module FifoDC
+#(
+  parameter             WIDTH   = 8,                            // Ширина слова
+  parameter             L2DEPTH = 4                             // Логарифм по основанию 2 от глубины FIFO (не меньше 2)
+)
+(
+  // Запись - домен тактов wclock_i
+
+  input                 wclock_i,                               // Такты записи
+  input                 write_i,                                // Строб записи (игнорируется при full_o = 1)
+  input     [WIDTH-1:0] data_i,                                 // Записываемое слово
+  output                full_o,                                 // Флаг "FIFO заполнено"
+
+  // Чтение - домен тактов rclock_i
+
+  input                 rclock_i,                               // Такты чтения
+  input                 read_i,                                 // Строб чтения: удаление слова из головы FIFO (игнорируется при empty_o = 1)
+  output    [WIDTH-1:0] data_o,                                 // Голова FIFO
+  output                empty_o                                 // Флаг "FIFO пусто"
+);
+
+
+
+//==============================================================//
+// Внутренние провода/регистры
+//==============================================================//
+
+reg     [WIDTH-1:0] mem [0:(1 << L2DEPTH)-1];                   // Память FIFO
+
+// Указатели на один бит шире адреса: старший бит отличает
+// заполненное FIFO от пустого
+
+reg     [L2DEPTH:0] wbin_reg    = 0;                            // Указатель записи (двоичный)
+reg     [L2DEPTH:0] wgray_reg   = 0;                            // Указатель записи (код Грея)
+reg     [L2DEPTH:0] rbin_reg    = 0;                            // Указатель чтения (двоичный)
+reg     [L2DEPTH:0] rgray_reg   = 0;                            // Указатель чтения (код Грея)
+
+reg     [L2DEPTH:0] wq1_rgray_reg = 0;                          // Указатель чтения, синхронизированный с тактами записи
+reg     [L2DEPTH:0] wq2_rgray_reg = 0;
+reg     [L2DEPTH:0] rq1_wgray_reg = 0;                          // Указатель записи, синхронизированный с тактами чтения
+reg     [L2DEPTH:0] rq2_wgray_reg = 0;
+
+
+
+//==============================================================//
+// Комбинаторная схемотехника
+//==============================================================//
+
+wire    [L2DEPTH:0] wbin_next_w  = wbin_reg + { {L2DEPTH{1'b 0}}, write_i & ~full_o };
+wire    [L2DEPTH:0] wgray_next_w = ( wbin_next_w >> 1 ) ^ wbin_next_w;
+
+wire    [L2DEPTH:0] rbin_next_w  = rbin_reg + { {L2DEPTH{1'b 0}}, read_i & ~empty_o };
+wire    [L2DEPTH:0] rgray_next_w = ( rbin_next_w >> 1 ) ^ rbin_next_w;
+
+// FIFO заполнено, если указатели отличаются ровно на глубину FIFO:
+// в коде Грея это два инвертированных старших бита
+
+assign  full_o  = ( wgray_reg == { ~wq2_rgray_reg[L2DEPTH:L2DEPTH-1], wq2_rgray_reg[L2DEPTH-2:0] } );
+
+assign  empty_o = ( rgray_reg == rq2_wgray_reg );
+
+assign  data_o  = mem[ rbin_reg[L2DEPTH-1:0] ];
+
+
+
+//==============================================================//
+// Синхронная схемотехника.
+//==============================================================//
+
+//--------------------------------------------------------------//
+// Запись
+
+always @( posedge wclock_i )
+begin
+  if( write_i && !full_o )
+    mem[ wbin_reg[L2DEPTH-1:0] ] <= data_i;
+
+  wbin_reg  <= wbin_next_w;
+  wgray_reg <= wgray_next_w;
+
+  wq1_rgray_reg <= rgray_reg;                                   // Синхронизируем указатель чтения с тактами записи
+  wq2_rgray_reg <= wq1_rgray_reg;
+end
+
+
+//--------------------------------------------------------------//
+// Чтение
+
+always @( posedge rclock_i )
+begin
+  rbin_reg  <= rbin_next_w;
+  rgray_reg <= rgray_next_w;
+
+  rq1_wgray_reg <= wgray_reg;                                   // Синхронизируем указатель записи с тактами чтения
+  rq2_wgray_reg <= rq1_wgray_reg;
+end
+
+
+endmodule
@@ -0,0 +1,148 @@
+/******************************************************************************
+
+  Очередь дескрипторов заданий.
+
+  Программа кладёт в очередь дескрипторы заданий (запросы, ответы,
+  начальный и конечный ключ), а модуль по одному подаёт их на входы
+  модуля поиска и запускает перебор. Закончив задание, модуль сам
+  останавливает перебор и запускает следующее - без участия программы.
+
+  Дескриптор (data_i, desc_o):
+
+    биты 39..0    - запрос
+    биты 79..40   - второй запрос
+    биты 127..80  - ответы: 127..104 - второй, 103..80 - первый
+    биты 167..128 - начальный ключ (младшие 40-L2NK бит)
+    биты 207..168 - конечный ключ, не включая его (0 - до конца)
+
+  ПРИМЕЧАНИЯ.
+
+  1. Задание закончено, когда взведён done_i: все ключи перебраны,
+     проверены и, если включён кольцевой буфер, записаны в него. Тогда
+     модуль сбрасывает run_o, увеличивает счётчик number_o и на один такт
+     взводит complete_o (прерывание).
+
+  2. Следующий дескриптор выставляется на desc_o, только когда модуль
+     поиска остановился (stopped_i = 1), а run_o взводится на такт позже.
+     Модуль поиска защёлкивает входы в режиме ожидания, а run_o проходит
+     в нём через два триггера, поэтому к запуску входы уже стабильны.
+
+  3. Задания нумеруются с нуля от включения очереди: задание с номером N
+     выполняется, пока number_o = N, поэтому number_o можно класть
+     в FIFO вместе с найденным ключом как номер его задания.
+
+  4. Сброс enable_i останавливает перебор, очищает очередь и обнуляет
+     счётчик number_o. Дескриптор, поданный при выключенной или
+     заполненной очереди, теряется - программа следит за количеством
+     count_o.
+
+******************************************************************************/
+
+module JobQueue
+#(
+  parameter             WIDTH   = 208,                          // Ширина дескриптора
+  parameter             L2DEPTH = 3                             // Логарифм по основанию 2 от глубины очереди
+)
+(
+  input                 clock_i,                                // Такты
+  input                 enable_i,                               // Разрешение работы
+  input                 push_i,                                 // Строб "положить дескриптор в очередь"
+  input     [WIDTH-1:0] data_i,                                 // Дескриптор
+
+  input                 done_i,                                 // Задание выполнено
+  input                 stopped_i,                              // Модуль поиска остановлен
+  output reg            run_o      = 0,                         // Разрешение работы модуля поиска
+  output reg [WIDTH-1:0] desc_o    = 0,                         // Текущий дескриптор
+
+  output    [L2DEPTH:0] count_o,                                // Дескрипторов в очереди (не считая текущего)
+  output                busy_o,                                 // Задание выполняется
+  output reg     [31:0] number_o   = 0,                         // Количество выполненных заданий
+  output reg            complete_o = 0                          // Строб "задание выполнено"
+);
+
+
+
+//==============================================================//
+// Внутренние провода/регистры
+//==============================================================//
+
+localparam              IDLE = 2'd 0;                           // Ожидание дескриптора
+localparam              RUN  = 2'd 1;                           // Перебор
+localparam              STOP = 2'd 2;                           // Ожидание остановки модуля поиска
+
+reg         [WIDTH-1:0] mem [0:(1 << L2DEPTH)-1];               // Память очереди
+
+reg         [L2DEPTH:0] wr_reg    = 0;                          // Указатель записи
+reg         [L2DEPTH:0] rd_reg    = 0;                          // Указатель чтения
+reg               [1:0] state_reg = IDLE;                       // Состояние
+
+wire                    full_w = ( count_o == ( 1 << L2DEPTH ) );
+
+
+
+//==============================================================//
+// Комбинаторная схемотехника
+//==============================================================//
+
+assign count_o = wr_reg - rd_reg;
+
+assign busy_o  = ( state_reg != IDLE );
+
+
+
+//==============================================================//
+// Синхронная схемотехника
+//==============================================================//
+
+always @( posedge clock_i )
+begin
+
+  complete_o <= 0;
+
+  if( push_i && !full_w && enable_i )                           // Запись дескриптора в очередь
+  begin
+    mem[wr_reg[L2DEPTH-1:0]] <= data_i;
+    wr_reg <= wr_reg + 1;
+  end
+
+  if( !enable_i )                                               // Очередь выключена: останавливаем перебор
+  begin                                                         // и очищаем очередь
+    state_reg <= IDLE;
+    run_o     <= 0;
+    number_o  <= 0;
+    rd_reg    <= wr_reg;
+  end
+
+  else case( state_reg )
+
+    IDLE:                                                       // Выставляем следующий дескриптор
+      if( wr_reg != rd_reg && stopped_i )
+      begin
+        desc_o    <= mem[rd_reg[L2DEPTH-1:0]];
+        rd_reg    <= rd_reg + 1;
+        state_reg <= RUN;
+      end
+
+    RUN:
+    begin
+      run_o <= 1;
+
+      if( run_o && done_i )                                     // Задание выполнено
+      begin
+        run_o      <= 0;
+        number_o   <= number_o + 32'd 1;
+        complete_o <= 1;
+        state_reg  <= STOP;
+      end
+    end
+
+    default:                                                    // Ждём, пока модуль поиска остановится
+      if( stopped_i )                                           // и сбросит флаг "все ключи перебраны"
+        state_reg <= IDLE;
+
+  endcase
+
+end
+
+
+endmodule
@@ -2,31 +2,92 @@
 
   Одно ядро DST40 для использования в массиве из XX ядер (больше одного).
 
+  Хэш считается UNROLL последовательными модулями Block64 (по три раунда
+  за такт каждый) - UNROLL должно быть делителем 64:
+
+  - UNROLL = 64: полная развёртка, 64-тактовый конвеер принимает новый
+    ключ на каждом такте (load_i всегда 1);
+
+  - UNROLL < 64: свёрнутое ядро. Выход последнего модуля заворачивается
+    на вход первого, и каждый ключ проходит по кольцу 64 / UNROLL раз.
+    В кольце одновременно находится UNROLL ключей, поэтому ядро принимает
+    UNROLL новых ключей за 64 такта (load_i = 1 на первых UNROLL тактах
+    из каждых 64), а результат ключа появляется на выходе через 64 такта
+    после его приёма - в такте, когда load_i снова 1. Ядро занимает
+    примерно в 64 / UNROLL раз меньше места, во столько же раз медленнее.
+
+  Регистры конвеера стоят через RPS раундов (RPS = 1, 2, 3 или 6, модуль
+  Stage40): при RPS = 3 это те же модули Block64, при меньшем RPS путь
+  между регистрами короче (выше Fmax), но ступеней больше. Размер ядра
+  UNROLL по-прежнему считается в модулях Block64 (по три раунда), так что
+  в кольце RING = UNROLL * 3 / RPS ступеней, а хэш одного ключа
+  считается за DEPTH = 192 / RPS тактов. В формулах выше 64 тактов
+  заменяются на DEPTH, UNROLL принимаемых ключей - на RING.
+
+  Полностью развёрнутое ядро (UNROLL = 64) не ведёт собственный ключ:
+  ключи ступеней приходят на keys_i из общего расписания KeySched40
+  (с нулевыми старшими битами), и к ним добавляется константа ядра
+  от ADDRESS. В свёрнутом ядре ключи идут по кольцу вместе с хэшем
+  и проходят его несколько раз, константа у ступени не одна - там
+  ключ по-прежнему свой.
+
+  При INTERLEAVE = 1 номер ядра ADDRESS - не старшие, а младшие биты
+  ключа: ядро проверяет ключ key_i * NK + ADDRESS. Константа ядра при
+  полной развёртке считается от младших бит так же.
+
 ******************************************************************************/
 
 module KernelXX
 #(
-  parameter             NK = 2,                                 // Количество хэширующих ядер в составе модуля
   parameter             L2NK = 1,                               // Логарифм по основанию 2 от количества ядер
-  parameter  [L2NK-1:0] ADDRESS = 0                             // Адрес ядра (а фактически - старшие биты ключа)
+  parameter [(L2NK ? L2NK : 1)-1:0] ADDRESS = 0,               // Адрес ядра (а фактически - старшие биты ключа)
+  parameter             NR = 2,                                 // Размер таблицы ожидаемых ответов
+  parameter             UNROLL = 64,                            // Количество модулей Block64 (делитель 64)
+  parameter             RPS = 3,                                // Раундов на ступень конвеера (1, 2, 3 или 6)
+  parameter             INTERLEAVE = 0,                         // 1 - номер ядра в младших битах ключа
+  parameter             RING = UNROLL * 3 / RPS                 // Ступеней в ядре (UNROLL * 3 должно делиться на RPS)
 )
 (
   input                 clock_i,                                // Такты
   input                 run_i,                                  // Разрешение работы
+  input                 load_i,                                 // Приём нового ключа (0 - ключи идут по кольцу ещё раз)
   input     [39-L2NK:0] key_i,                                  // Ключ
+  input  [40*RING-1:0]  keys_i,                                 // Общее расписание ключей (при UNROLL = 64): ступень i - биты 40*i+39..40*i
   input          [39:0] challenge_i,                            // Запрос
-  input          [23:0] response_i,                             // Ожидаемый ответ
-  output                comparator_o                            // Выход компаратора (1 - результат совпал с ожидаемым ответом)
+  input     [NR*24-1:0] responses_i,                            // Таблица ожидаемых ответов (ответ j - биты 24*j+23..24*j)
+  input        [NR-1:0] enables_i,                              // Разрешения строк таблицы ответов
+  output       [NR-1:0] match_o                                 // Выходы компараторов (бит j - результат совпал с ответом j)
 );
 
 
 
 
+//==============================================================//
+// Функции
+//==============================================================//
+
+//--------------------------------------------------------------//
+// Ключ после n обновлений (как в KeySched40)                   //
+
+function [39:0] keyConst;
+  input  [39:0] key;
+  input integer n;
+  integer       j;
+  begin
+    keyConst = key;
+    for( j=0; j < n; j=j+1 )
+      keyConst = { keyConst[0] ^ keyConst[2] ^ keyConst[19] ^ keyConst[21], keyConst[39:1] };
+  end
+endfunction
+
+
+
 //==============================================================//
 // Внутренние провода/регистры
 //==============================================================//
 
-wire  [39:0] last_hash_w;
+wire  [39:0] address_w;                                         // Номер ядра на своём месте в ключе
+wire  [39:0] full_key_w;                                        // Ключ ядра
 
 
 
@@ -35,58 +96,140 @@ wire  [39:0] last_hash_w;
 //==============================================================//
 
 //--------------------------------------------------------------//
-// Блок из 64 последовательных модулей Block64                  //
+// Номер ядра в ключе (у единственного ядра его нет)            //
+
+generate
+
+  if( INTERLEAVE && L2NK )
+  begin: _low_
+    assign address_w  = { {40-L2NK{1'b0}}, ADDRESS };
+    assign full_key_w = { key_i, ADDRESS };
+  end
+  else if( L2NK )
+  begin: _high_
+    assign address_w  = { ADDRESS, {40-L2NK{1'b0}} };
+    assign full_key_w = { ADDRESS, key_i };
+  end
+  else
+  begin: _single_
+    assign address_w  = { 39'd 0, ADDRESS };                    // ADDRESS = 0
+    assign full_key_w = key_i;
+  end
+
+endgenerate
+
+
+//--------------------------------------------------------------//
+// Блок из RING последовательных ступеней по RPS раундов. При   //
+// полной развёртке ключи ступеней берутся из keys_i, а свои    //
+// регистры ключей остаются без нагрузки и убираются            //
 
 genvar i;
 
 generate
 
-  for( i=0; i < 64; i=i+1 )
-  begin: blk64
+  for( i=0; i < RING; i=i+1 )
+  begin: stg
 
     wire [39:0] hash_w;
     wire [39:0] key_w;
 
-    if( !i )
-    begin
-      Block64 BLOCK64_INST
+    if( UNROLL == 64 )
+    begin: _full_
+      wire [39:0] in_hash_w;                                    // Входной хэш ступени
+      wire        unused_w = &{ 1'b0, key_w, hash_w[15:0] };    // Ключ ступени и младшие биты хэша на выходе ядра не нужны
+
+      if( !i )
+      begin: _first_
+        assign in_hash_w = challenge_i;
+      end
+      else
+      begin: _next_
+        assign in_hash_w = stg[i-1].hash_w;
+      end
+
+      Stage40
+      #(
+        .ROUNDS   ( RPS ),
+        .PHASE    ( ( i * RPS ) % 3 )
+      )
+      STAGE40_INST
       (
-        .clock_i  ( clock_i ),                                  // Такты
-        .run_i    ( run_i ),                                    // Разрешение работы
-        .hash_i   ( challenge_i ),                              // Входной хэш (такт 0)
-        .key_i    ( { ADDRESS, key_i } ),                       // Входной ключ (такт 0)
+        .clock_i  ( clock_i ),
+        .run_i    ( run_i ),
+        .hash_i   ( in_hash_w ),
+        .key_i    ( keys_i[40*i +: 40] ^                        // Общий ключ ступени + константа ядра
+                    keyConst( address_w, ( i*RPS + 1 ) / 3 ) ),
         .hash_o   ( hash_w ),
-        .key_o    ( key_w )
+        .key_o    ( key_w )                                     // Не используется
       );
     end
-    else if( i < 63 )
-    begin
-      Block64 BLOCK64_INST
+    else if( !i )
+    begin: _first_
+      Stage40
+      #(
+        .ROUNDS   ( RPS )
+      )
+      STAGE40_INST
       (
-        .clock_i  ( clock_i ),
-        .run_i    ( run_i ),
-        .hash_i   ( blk64[i-1].hash_w ),
-        .key_i    ( blk64[i-1].key_w  ),
+        .clock_i  ( clock_i ),                                  // Такты
+        .run_i    ( run_i ),                                    // Разрешение работы
+        .hash_i   ( load_i ? challenge_i : stg[RING-1].hash_w ),    // Входной хэш (такт 0)
+        .key_i    ( load_i ? full_key_w  : stg[RING-1].key_w  ),    // Входной ключ (такт 0)
         .hash_o   ( hash_w ),
         .key_o    ( key_w )
       );
     end
     else
-    begin
-      Block64 BLOCK64_INST
+    begin: _next_
+      Stage40
+      #(
+        .ROUNDS   ( RPS ),
+        .PHASE    ( ( i * RPS ) % 3 )                           // Номер первого раунда ступени по модулю 3
+      )
+      STAGE40_INST
       (
         .clock_i  ( clock_i ),
         .run_i    ( run_i ),
-        .hash_i   ( blk64[i-1].hash_w ),
-        .key_i    ( blk64[i-1].key_w  ),
-        .hash_o   ( last_hash_w )
+        .hash_i   ( stg[i-1].hash_w ),
+        .key_i    ( stg[i-1].key_w  ),
+        .hash_o   ( hash_w ),
+        .key_o    ( key_w )
       );
     end
   end
+
+endgenerate
+
+
+//--------------------------------------------------------------//
+// Входы, не нужные ядру при выбранной развёртке                //
+
+generate
+
+  if( UNROLL == 64 )
+  begin: _full_
+    wire unused_w = &{ 1'b0, load_i, full_key_w };
+  end
+  else
+  begin: _fold_
+    wire unused_w = &{ 1'b0, keys_i, address_w };
+  end
+
 endgenerate
 
 
-assign comparator_o = ( response_i == last_hash_w[39:16] );
+//--------------------------------------------------------------//
+// Сравнение результата со всеми ответами таблицы               //
+
+generate
+
+  for( i=0; i < NR; i=i+1 )
+  begin: _match_
+    assign match_o[i] = enables_i[i] && ( responses_i[24*i +: 24] == stg[RING-1].hash_w[39:16] );
+  end
+
+endgenerate
 
 
 endmodule
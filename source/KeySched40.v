@@ -0,0 +1,99 @@
+/******************************************************************************
+
+  Общее расписание ключей DST40 для всех ядер модуля.
+
+  Ключи ядер отличаются только старшими битами ADDRESS, а обновление
+  ключа в DST40 линейно (сдвиг с XOR), поэтому ключ любого ядра на любом
+  раунде - это ключ с нулевыми старшими битами на том же раунде XOR
+  константа, зависящая только от ADDRESS и количества обновлений
+  (функция keyConst ниже). Модуль один раз прогоняет по конвееру ключ
+  с нулевыми старшими битами, а ядра берут ключи ступеней отсюда
+  и добавляют свою константу - она сводится к инверсии входов таблиц
+  раунда и места не занимает. Собственные регистры ключей в ядрах
+  остаются без нагрузки и убираются синтезатором.
+
+  При чередовании ядер (INTERLEAVE в dst40_XX.v) номер ядра - младшие
+  биты ключа, и на вход приходит ключ с нулевыми младшими битами:
+  линейность от этого не зависит.
+
+  Ступени повторяют конвеер ядра (см. KernelXX.v): RING ступеней
+  по RPS раундов, регистры работают по тому же run_i.
+
+******************************************************************************/
+
+module KeySched40
+#(
+  parameter             RPS  = 3,                               // Раундов на ступень (1, 2, 3 или 6)
+  parameter             RING = 192 / RPS                        // Ступеней в конвеере
+)
+(
+  input                 clock_i,                                // Такты
+  input                 run_i,                                  // Разрешение работы
+  input          [39:0] key_i,                                  // Ключ (биты номера ядра - нулевые)
+  output [40*RING-1:0]  keys_o                                  // Ключи на входах ступеней: ступень i - биты 40*i+39..40*i
+);
+
+
+
+//==============================================================//
+// Функции
+//==============================================================//
+
+//--------------------------------------------------------------//
+// Ключ после n обновлений                                      //
+
+function [39:0] keyConst;
+  input  [39:0] key;
+  input integer n;
+  integer       j;
+  begin
+    keyConst = key;
+    for( j=0; j < n; j=j+1 )
+      keyConst = { keyConst[0] ^ keyConst[2] ^ keyConst[19] ^ keyConst[21], keyConst[39:1] };
+  end
+endfunction
+
+
+
+//==============================================================//
+// Внутренние провода/регистры
+//==============================================================//
+
+reg [40*RING-41:0] keys_reg = 0;                                // Выходы ступеней (кроме последней - её ключ не нужен)
+
+
+
+//==============================================================//
+// Комбинаторная схемотехника
+//==============================================================//
+
+assign keys_o = { keys_reg, key_i };                            // Вход ступени i - выход ступени i-1
+
+
+
+//==============================================================//
+// Синхронная схемотехника.
+//==============================================================//
+
+//--------------------------------------------------------------//
+// Ступень i начинается с раунда i * RPS; ключ обновляется      //
+// после раундов 1, 4, 7, ..., то есть за ступень столько раз,  //
+// сколько таких раундов среди i * RPS .. i * RPS + RPS - 1     //
+
+genvar i;
+
+generate
+
+  for( i=0; i < RING-1; i=i+1 )
+  begin: stg
+
+    always @( posedge clock_i )
+      if( run_i )
+        keys_reg[40*i +: 40] <= keyConst( keys_o[40*i +: 40], ( i*RPS + RPS + 1 ) / 3 - ( i*RPS + 1 ) / 3 );
+
+  end
+
+endgenerate
+
+
+endmodule
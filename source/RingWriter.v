@@ -0,0 +1,131 @@
+/******************************************************************************
+
+  Запись найденных ключей в кольцевой буфер в памяти HPS.
+
+  Модуль забирает ключи из головы FIFO найденных ключей и пишет их
+  в кольцевой буфер из 2^l2size_i записей по 32 байта в DDR3 HPS через
+  мост FPGA-to-SDRAM (порт f2h_sdram0, Avalon-MM 64 бита). Программа
+  читает записи прямо из памяти и не обращается за каждым ключом
+  к регистрам через мост HPS-to-FPGA.
+
+  Запись буфера (4 слова по 64 бита, одна пачка - burst):
+
+    слово 0 - data_i[63:0]     ключ (младшие 40-L2NK бит)
+    слово 1 - data_i[127:64]   биты 31..0 - биты ядер, 63..32 - номер строки таблицы
+    слово 2 - data_i[191:128]  такт PLL от запуска, на котором ключ найден
+    слово 3 - биты 31..0 - номер записи head_o, 63..32 - data_i[223:192]
+              (номер задания очереди дескрипторов)
+
+  ПРИМЕЧАНИЯ.
+
+  1. Голова head_o и хвост tail_i - счётчики записей, а не индексы:
+     запись с номером N лежит в ячейке N mod 2^l2size_i. Голова считает
+     записанные модулем записи, хвост пишет программа, забрав запись.
+     Буфер полон, когда head_o - tail_i = 2^l2size_i: тогда ключи ждут
+     в FIFO, а при заполненном FIFO останавливается конвеер - ключи
+     не теряются.
+
+  2. Голова не сбрасывается ни при запуске, ни при выключении модуля.
+     Перед запуском программа приравнивает хвост голове, а номер записи
+     в слове 3 отличает свежую запись от оставшейся с прошлых проходов:
+     программа читает запись, только когда номер в ней совпал с хвостом.
+
+  3. Слово с номером записи идёт в пачке последним, а пачка из 32 байт,
+     выровненная на 32 байта, пишется в DDR3 одной транзакцией, поэтому
+     по совпавшему номеру остальные слова записи уже в памяти.
+
+  4. Записанная пачка не прерывается: сброс enable_i останавливает
+     модуль только после конца текущей записи (idle_o = 1).
+
+******************************************************************************/
+
+module RingWriter
+(
+  input                 clock_i,                                // Такты
+  input                 enable_i,                               // Разрешение работы
+  input          [31:0] base_i,                                 // Физический адрес буфера в памяти HPS (кратен 32)
+  input           [4:0] l2size_i,                               // Логарифм по основанию 2 от количества записей буфера
+  input          [31:0] tail_i,                                 // Хвост: количество записей, забранных программой
+  output reg     [31:0] head_o = 0,                             // Голова: количество записанных записей
+  output                idle_o,                                 // Флаг "запись не идёт"
+
+  // FIFO найденных ключей
+
+  input                 empty_i,                                // FIFO пусто
+  input         [223:0] data_i,                                 // Голова FIFO - слова 0..2 и старшая половина слова 3
+  output                read_o,                                 // Удаление ключа из головы FIFO
+
+  // Avalon-MM master порта FPGA-to-SDRAM
+
+  output         [28:0] address_o,                              // Адрес 64-битного слова
+  output          [7:0] burstcount_o,                           // Длина пачки
+  output         [63:0] writedata_o,                            // Данные
+  output          [7:0] byteenable_o,                           // Биты разрешения записи
+  output                write_o,                                // Строб записи
+  input                 waitrequest_i                           // Порт занят
+);
+
+
+
+//==============================================================//
+// Внутренние провода/регистры
+//==============================================================//
+
+reg                     busy_reg   = 0;                         // Идёт запись пачки
+reg               [1:0] beat_reg   = 0;                         // Номер слова в пачке
+reg             [223:0] record_reg = 0;                         // Записываемые слова 0..2 и старшая половина слова 3
+reg              [28:0] address_reg = 0;                        // Адрес записи
+
+wire             [31:0] used_w  = head_o - tail_i;              // Записей, ещё не забранных программой
+wire                    free_w  = ( used_w >> l2size_i ) == 0;  // В буфере есть место
+wire             [26:0] slot_w  = head_o[26:0] & ( ( 27'd 1 << l2size_i ) - 27'd 1 );  // Ячейка для следующей записи
+wire                    unused_w = &{ 1'b 0, base_i[2:0] };     // Адрес буфера кратен 32
+
+
+
+//==============================================================//
+// Комбинаторная схемотехника
+//==============================================================//
+
+assign read_o       = !busy_reg && enable_i && !empty_i && free_w;
+
+assign idle_o       = !busy_reg;
+
+assign address_o    = address_reg;
+assign burstcount_o = 8'd 4;
+assign byteenable_o = 8'h FF;
+assign write_o      = busy_reg;
+assign writedata_o  = ( beat_reg == 2'd 3 ) ? { record_reg[223:192], head_o } : record_reg[{ beat_reg, 6'd 0 } +: 64];
+
+
+
+//==============================================================//
+// Синхронная схемотехника
+//==============================================================//
+
+always @( posedge clock_i )
+begin
+
+  if( read_o )                                                  // Забираем ключ из FIFO и начинаем пачку
+  begin
+    busy_reg    <= 1;
+    beat_reg    <= 0;
+    record_reg  <= data_i;
+    address_reg <= base_i[31:3] + { slot_w, 2'b00 };
+  end
+
+  else if( busy_reg && !waitrequest_i )                         // Слово принято портом
+  begin
+    beat_reg <= beat_reg + 2'd 1;
+
+    if( beat_reg == 2'd 3 )                                     // Последнее слово - запись в буфере
+    begin
+      busy_reg <= 0;
+      head_o   <= head_o + 32'd 1;
+    end
+  end
+
+end
+
+
+endmodule
@@ -0,0 +1,178 @@
+/******************************************************************************
+
+  Один раунд DST40 - комбинаторно.
+
+  Из раундов собираются ступени конвеера Stage40 с любым количеством
+  раундов между регистрами. Ключ в DST40 обновляется после каждого
+  третьего раунда (после раундов 1, 4, 7, ... - как в Block64), поэтому
+  обновлять ли его после этого раунда, задаёт параметр UPDATE.
+
+******************************************************************************/
+
+module Round40
+#(
+  parameter             UPDATE = 0                              // 1 - после раунда ключ обновляется
+)
+(
+  input          [39:0] hash_i,                                 // Входной хэш
+  input          [39:0] key_i,                                  // Входной ключ
+  output         [39:0] hash_o,                                 // Хэш после раунда
+  output         [39:0] key_o                                   // Ключ для следующего раунда
+);
+
+
+//==============================================================//
+// Внутренние провода/регистры
+//==============================================================//
+
+wire    [3:0] hi_w;                                             // Входная шина H
+wire    [1:0] ho_w;                                             // Выходная шина H
+
+wire    [3:0] g1i_w;                                            // Входная шина G1
+wire    [3:0] g2i_w;                                            // Входная шина G2
+wire    [3:0] g3i_w;                                            // Входная шина G3
+wire    [3:0] g4i_w;                                            // Входная шина G4
+
+
+
+//==============================================================//
+// Комбинаторная схемотехника
+//==============================================================//
+
+//--------------------------------------------------------------//
+// Функции раунда                                               //
+
+Fh H_INST
+(
+  .in           ( hi_w ),
+  .out          ( ho_w )
+);
+
+Fg G1_INST
+(
+  .in           ( g1i_w ),
+  .out          ( hi_w[3] )
+);
+
+Fg G2_INST
+(
+  .in           ( g2i_w ),
+  .out          ( hi_w[2] )
+);
+
+Fg G3_INST
+(
+  .in           ( g3i_w ),
+  .out          ( hi_w[1] )
+);
+
+Fg G4_INST
+(
+  .in           ( g4i_w ),
+  .out          ( hi_w[0] )
+);
+
+Fa F1_INST
+(
+  .in           ( { key_i[39], key_i[31], hash_i[39], hash_i[31], hash_i[23] } ),
+  .out          ( g1i_w[3] )
+);
+
+Fb F2_INST
+(
+  .in           ( { key_i[38], key_i[30], hash_i[38], hash_i[30], hash_i[22] } ),
+  .out          ( g1i_w[2] )
+);
+
+Fa F5_INST
+(
+  .in           ( { key_i[37], key_i[29], hash_i[37], hash_i[29], hash_i[21] } ),
+  .out          ( g2i_w[3] )
+);
+
+Fb F6_INST
+(
+  .in           ( { key_i[36], key_i[28], hash_i[36], hash_i[28], hash_i[20] } ),
+  .out          ( g2i_w[2] )
+);
+
+Fa F9_INST
+(
+  .in           ( { key_i[35], key_i[27], hash_i[35], hash_i[27], hash_i[19] } ),
+  .out          ( g3i_w[3] )
+);
+
+Fb F10_INST
+(
+  .in           ( { key_i[34], key_i[26], hash_i[34], hash_i[26], hash_i[18] } ),
+  .out          ( g3i_w[2] )
+);
+
+Fa F13_INST
+(
+  .in           ( { key_i[33], key_i[25], hash_i[33], hash_i[25], hash_i[17] } ),
+  .out          ( g4i_w[3] )
+);
+
+Fb F14_INST
+(
+  .in           ( { key_i[32], key_i[24], hash_i[32], hash_i[24], hash_i[16] } ),
+  .out          ( g4i_w[2] )
+);
+
+Fc F3_INST
+(
+  .in           ( { key_i[23], key_i[15], key_i[7], hash_i[15], hash_i[7] } ),
+  .out          ( g1i_w[1] )
+);
+
+Fd F4_INST
+(
+  .in           ( { key_i[22], key_i[14], key_i[6], hash_i[14], hash_i[6] } ),
+  .out          ( g1i_w[0] )
+);
+
+Fc F7_INST
+(
+  .in           ( { key_i[21], key_i[13], key_i[5], hash_i[13], hash_i[5] } ),
+  .out          ( g2i_w[1] )
+);
+
+Fd F8_INST
+(
+  .in           ( { key_i[20], key_i[12], key_i[4], hash_i[12], hash_i[4] } ),
+  .out          ( g2i_w[0] )
+);
+
+Fc F11_INST
+(
+  .in           ( { key_i[19], key_i[11], key_i[3], hash_i[11], hash_i[3] } ),
+  .out          ( g3i_w[1] )
+);
+
+Fd F12_INST
+(
+  .in           ( { key_i[18], key_i[10], key_i[2], hash_i[10], hash_i[2] } ),
+  .out          ( g3i_w[0] )
+);
+
+Fe F15_INST
+(
+  .in           ( { key_i[17], key_i[9], key_i[1], hash_i[9] } ),
+  .out          ( g4i_w[1] )
+);
+
+Fe F16_INST
+(
+  .in           ( { key_i[16], key_i[8], key_i[0], hash_i[8] } ),
+  .out          ( g4i_w[0] )
+);
+
+//--------------------------------------------------------------//
+// Результат раунда                                             //
+
+assign hash_o = { ho_w ^ hash_i[1:0], hash_i[39:2] };
+assign key_o  = UPDATE ? { key_i[0] ^ key_i[2] ^ key_i[19] ^ key_i[21], key_i[39:1] } : key_i;
+
+
+endmodule
@@ -0,0 +1,115 @@
+/******************************************************************************
+
+  Ступень конвеера DST40: ROUNDS раундов между регистрами.
+
+  ROUNDS = 3 и PHASE = 0 - это ровно модуль Block64, он и используется.
+  Остальные варианты собираются из раундов Round40: меньше раундов
+  на ступень - короче комбинаторный путь и выше допустимая частота,
+  но больше ступеней (и регистров) на тот же хэш.
+
+  PHASE - номер первого раунда ступени по модулю 3: от него зависит,
+  после каких раундов ступени обновляется ключ.
+
+******************************************************************************/
+
+module Stage40
+#(
+  parameter             ROUNDS = 3,                             // Раундов на ступень (1, 2, 3 или 6)
+  parameter             PHASE  = 0                              // Номер первого раунда по модулю 3
+)
+(
+  input                 clock_i,                                // Такты
+  input                 run_i,                                  // Разрешение работы
+  input          [39:0] hash_i,                                 // Входной хэш
+  input          [39:0] key_i,                                  // Входной ключ
+  output         [39:0] hash_o,                                 // Выходной хэш (через такт)
+  output         [39:0] key_o                                   // Выходной ключ (через такт)
+);
+
+
+
+//==============================================================//
+// Комбинаторная схемотехника
+//==============================================================//
+
+genvar r;
+
+generate
+
+  if( ROUNDS == 3 && PHASE == 0 )
+  begin: _block64_
+
+    Block64 BLOCK64_INST
+    (
+      .clock_i  ( clock_i ),
+      .run_i    ( run_i   ),
+      .hash_i   ( hash_i  ),
+      .key_i    ( key_i   ),
+      .hash_o   ( hash_o  ),
+      .key_o    ( key_o   )
+    );
+
+  end
+  else
+  begin: _rounds_
+
+    reg    [39:0] hash_out_reg = 0;
+    reg    [39:0] key_out_reg  = 0;
+
+    //------------------------------------------------------------//
+    // Цепочка раундов                                            //
+
+    for( r=0; r < ROUNDS; r=r+1 )
+    begin: rnd
+
+      wire [39:0] in_hash_w;                                    // Вход раунда
+      wire [39:0] in_key_w;
+      wire [39:0] hash_w;                                       // Выход раунда
+      wire [39:0] key_w;
+
+      if( !r )
+      begin: _first_
+        assign in_hash_w = hash_i;
+        assign in_key_w  = key_i;
+      end
+      else
+      begin: _next_
+        assign in_hash_w = rnd[r-1].hash_w;
+        assign in_key_w  = rnd[r-1].key_w;
+      end
+
+      Round40
+      #(
+        .UPDATE   ( ( PHASE + r ) % 3 == 1 )                    // Ключ обновляется после раундов 1, 4, 7, ...
+      )
+      ROUND40_INST
+      (
+        .hash_i   ( in_hash_w ),
+        .key_i    ( in_key_w  ),
+        .hash_o   ( hash_w    ),
+        .key_o    ( key_w     )
+      );
+
+    end
+
+    //------------------------------------------------------------//
+    // Защёлкивание результата в регистры                         //
+
+    always @( posedge clock_i )
+    begin
+      if( run_i )
+      begin
+        hash_out_reg <= rnd[ROUNDS-1].hash_w;
+        key_out_reg  <= rnd[ROUNDS-1].key_w;
+      end
+    end
+
+    assign hash_o = hash_out_reg;
+    assign key_o  = key_out_reg;
+
+  end
+
+endgenerate
+
+
+endmodule
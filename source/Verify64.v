@@ -0,0 +1,157 @@
+/******************************************************************************
+
+  Последовательный хэшер DST40 для проверки ключей-кандидатов
+  на второй паре запрос/ответ.
+
+  В отличие от ядра KernelXX, в котором 64 модуля Block64 образуют
+  конвеер, здесь используется один модуль Block64, выход которого
+  заворачивается обратно на вход. Хэш одного ключа считается за 64 такта,
+  зато схема занимает в 64 раза меньше места. Этого с запасом хватает:
+  при 24-битном ответе кандидат по первой паре появляется в среднем
+  раз в 2^24 / NK тактов.
+
+  При RPS < 3 раундов на ступень (см. KernelXX.v) вместо Block64 в кольцо
+  ставятся три ступени Stage40 - через столько ступеней повторяется
+  расписание обновления ключа. Хэш тогда считается за DEPTH = 192 / RPS
+  тактов, а путь между регистрами не длиннее, чем в ядрах.
+
+  ПРИМЕЧАНИЯ.
+
+  1. Строб start_i загружает ключ и запускает расчёт (игнорируется,
+     пока busy_o = 1).
+
+  2. Через DEPTH тактов после start_i взводится флаг done_o, и до следующего
+     start_i на выходе response_o держится ответ для проверяемого ключа.
+     Сравнение с ожидаемыми ответами выполняется снаружи: так один
+     расчёт проверяет ключ сразу по всей таблице ответов.
+
+******************************************************************************/
+
+module Verify64
+#(
+  parameter             RPS   = 3,                              // Раундов на ступень (1, 2, 3 или 6)
+  parameter             DEPTH = 192 / RPS,                      // Тактов на хэш одного ключа
+  parameter             V     = ( RPS % 3 ) ? 3 : 1             // Ступеней в кольце
+)
+(
+  input                 clock_i,                                // Такты
+  input                 start_i,                                // Строб запуска проверки ключа
+  input          [39:0] key_i,                                  // Проверяемый ключ (полный)
+  input          [39:0] challenge_i,                            // Запрос
+  output                busy_o,                                 // Флаг "идёт расчёт"
+  output                done_o,                                 // Флаг "расчёт закончен"
+  output         [23:0] response_o                              // Ответ для проверяемого ключа (валиден при done_o = 1)
+);
+
+
+
+//==============================================================//
+// Внутренние провода/регистры
+//==============================================================//
+
+reg           [7:0] count_reg = 0;                              // Количество пройденных кольцом тактов
+reg                 busy_reg  = 0;                              // Флаг "идёт расчёт"
+reg                 done_reg  = 0;                              // Флаг "расчёт закончен"
+
+wire                count_done_w = ( count_reg == DEPTH[7:0] ); // Пройдено DEPTH тактов
+
+wire                load_w = start_i & ~busy_reg;               // Загрузка нового ключа
+
+
+
+//==============================================================//
+// Комбинаторная схемотехника
+//==============================================================//
+
+assign  busy_o  = busy_reg;
+assign  done_o  = done_reg;
+assign  response_o = stg[V-1].hash_w[39:16];                   // Выход последней ступени кольца
+
+
+
+//--------------------------------------------------------------//
+// Кольцо из V ступеней (при RPS = 3 - один модуль Block64):   //
+// на такте загрузки на вход подаются запрос и ключ, дальше -   //
+// выход последней ступени                                      //
+
+wire                run_w = load_w | ( busy_reg & ~count_done_w );  // Работает DEPTH тактов, начиная с такта загрузки
+
+genvar i;
+
+generate
+
+  for( i=0; i < V; i=i+1 )
+  begin: stg
+
+    wire [39:0] hash_w;                                         // Выход ступени
+    wire [39:0] key_w;
+
+    if( !i )
+    begin: _first_
+      Stage40
+      #(
+        .ROUNDS   ( RPS )
+      )
+      STAGE40_INST
+      (
+        .clock_i  ( clock_i                                   ),  // Такты
+        .run_i    ( run_w                                     ),
+        .hash_i   ( load_w ? challenge_i : stg[V-1].hash_w    ),  // Входной хэш
+        .key_i    ( load_w ? key_i       : stg[V-1].key_w     ),  // Входной ключ
+        .hash_o   ( hash_w                                    ),
+        .key_o    ( key_w                                     )
+      );
+    end
+    else
+    begin: _next_
+      Stage40
+      #(
+        .ROUNDS   ( RPS ),
+        .PHASE    ( ( i * RPS ) % 3 )
+      )
+      STAGE40_INST
+      (
+        .clock_i  ( clock_i                                   ),
+        .run_i    ( run_w                                     ),
+        .hash_i   ( stg[i-1].hash_w                           ),
+        .key_i    ( stg[i-1].key_w                            ),
+        .hash_o   ( hash_w                                    ),
+        .key_o    ( key_w                                     )
+      );
+    end
+
+  end
+
+endgenerate
+
+
+
+//==============================================================//
+// Синхронная схемотехника.
+//==============================================================//
+
+always @( posedge clock_i )
+begin
+
+  if( load_w )                                                  // Загрузка: первые RPS раундов выполняются
+  begin                                                         // уже на этом такте
+    count_reg <= 1;
+    busy_reg  <= 1;
+    done_reg  <= 0;
+  end
+
+  else if( busy_reg )
+  begin
+    if( count_done_w )                                          // Пройдено DEPTH тактов - результат на выходе кольца
+    begin
+      busy_reg <= 0;
+      done_reg <= 1;
+    end
+    else
+      count_reg <= count_reg + 8'd 1;
+  end
+
+end
+
+
+endmodule
@@ -2,19 +2,72 @@
 
   Модуль DST40.
 
-  Версия 3: с развёрнутым циклом хэширования, преобразованным в 64-тактовый
-            конвеер.
+  Версия 11: с развёрнутым циклом хэширования, преобразованным в конвеер,
+             проверкой кандидатов на второй паре запрос/ответ
+             внутри FPGA, FIFO найденных ключей и таблицей ответов
+             для одновременного поиска ключей нескольких меток.
+             Параметры образа (количество ядер и т.д.) читаются из
+             регистров id и caps, поэтому одна и та же программа работает
+             с образами с любым NK.
+
+  Изменения по версиям (поле VERSION регистра id):
+
+     7 - регистры id и caps, количество ядер NK и свёртка ядра UNROLL
+         задаются параметрами;
+     8 - регистры конвеера через RPS раундов (п. 6), глубина конвеера -
+         в поле DEPTH регистра caps;
+     9 - кольцевой буфер найденных ключей в памяти HPS (п. 8);
+    10 - конечный ключ и очередь дескрипторов заданий (п. 9);
+    11 - перебор только свободных бит ключа под маской (п. 10).
+         Раскладка ключей по ядрам (INTERLEAVE, п. 6) версию не меняет -
+         она видна по биту CAPS_INTERLEAVE.
 
   1. Интерфейс с пользователем реализован на стороне HPS.
 
-  2. Вторая проверка ключа с другими запросом/ответом запускается программно
-     процессором HPS.
-     
-  3. Флаг прерывания IRQ0 взводится в момент взведения любого из флагов -
-     ключ найден или ключ не найден, а сбрасывается записью в любой
+  2. Совпадение ответа не останавливает перебор: ключ-кандидат,
+     подошедший к первой паре запрос/ответ, проверяется на второй паре
+     последовательным хэшером внутри FPGA (Verify64), а конвеер
+     продолжает работать. Ключ, подошедший к обеим парам, вместе с битом
+     нашедшего его ядра кладётся в FIFO, которое вычитывает HPS.
+     Ложные срабатывания по первой паре (~2^16 за полный перебор)
+     до HPS не доходят.
+
+  3. Если новый кандидат появился, пока предыдущий ещё проверяется,
+     конвеер приостанавливается до освобождения места (кандидаты
+     не теряются), а факт приостановки запоминается во флаге
+     переполнения до следующего запуска.
+
+  4. Вместо одной пары ответов можно задать таблицу из count (до NR)
+     пар ответов разных меток на одни и те же два запроса. Все метки
+     ищутся за один проход перебора, а вместе с найденным ключом в FIFO
+     кладётся номер строки таблицы, к которой он подошёл. Строка 0
+     таблицы совпадает с регистрами response и response2.
+
+  5. Флаг прерывания IRQ0 взводится, пока в FIFO есть найденные ключи или
+     когда перебраны все ключи, а сбрасывается записью в любой
      Avalon-регистр.
 
-  4. HPS пишет/читает регистры с исходными данными через мост Avalon MM,
+  6. Количество ядер NK и количество модулей Block64 в ядре UNROLL
+     задают компромисс между площадью и скоростью: свёрнутое ядро
+     (UNROLL < 64) в 64 / UNROLL раз меньше и во столько же раз
+     медленнее полностью развёрнутого. Скрипт source/sweep.tcl собирает
+     проект для нескольких пар NK:UNROLL и сводит в таблицу занятые ALM,
+     Fmax и скорость перебора.
+
+     Параметр INTERLEAVE = 1 меняет раскладку ключей по ядрам: ядро i
+     проверяет ключи key_reg * NK + i (номер ядра - младшие биты ключа),
+     поэтому любой непрерывный диапазон ключей перебирают все ядра сразу.
+     Регистры start_key, end_key, position и key при этом задаются
+     в единицах key_reg (ключ / NK), а полный ключ - key * NK + номер
+     ядра. Раскладку программа узнаёт по биту CAPS_INTERLEAVE.
+
+     Параметр RPS задаёт, через сколько раундов стоят регистры конвеера
+     (1, 2, 3 или 6; 3 - исходные модули Block64). Глубина конвеера при
+     этом DEPTH = 192 / RPS тактов (поле DEPTH регистра caps), а ключей
+     за такт столько же, так что меньший RPS окупается, только если
+     поднимает Fmax выше частоты PLL. Скрипт перебирает и RPS.
+
+  7. HPS пишет/читает регистры с исходными данными через мост Avalon MM,
      подключенный к мосту HPS-FPGA шириной 64 бита.
      Адресация регистров выполняется блоками по 8 байт на 1 адрес.
      При чтении регистров неиспользуемые старшие биты зануляются,
@@ -27,10 +80,91 @@
      2 - start_key                ( 40 бит,      Чтение/Запись )  Ключ, с которого начинать поиск
      3 - run                      (  1 бит,      Чтение/Запись )  Флаг запуска поиска
      4 - флаги:
-         бит 0 - key_found_w      (       1 бит, Только чтение )  Флаг "ключ найден"
-         бит 8 - key_not_found_w  (       1 бит, Только чтение )  Флаг "ключ не найден"
-     5 - key                      ( 40-L2NK бит, Только чтение )  Найденный ключ (младшие биты)
-     6 - kernels                  (      NK бит, Только чтение )  Биты ядер, нашедших ключ
+         бит 0  - found_w         (       1 бит, Только чтение )  Флаг "в FIFO есть найденный ключ"
+                                                                  (или ключ ещё пишется в кольцевой буфер)
+         бит 8  - done_reg        (       1 бит, Только чтение )  Флаг "все ключи перебраны и проверены"
+         бит 16 - overflow_reg    (       1 бит, Только чтение )  Флаг "перебор приостанавливался"
+     5 - key                      ( 40-L2NK бит, Только чтение )  Ключ в голове FIFO (младшие биты)
+     6 - kernels                  (      NK бит, Только чтение )  Бит ядра, нашедшего ключ в голове FIFO
+     7 - fifo                     (       1 бит, Только запись )  Запись 1 в бит 0 удаляет ключ из головы FIFO
+     8 - challenge2               ( 40 бит,      Чтение/Запись )  Второй запрос
+     9 - response2                ( 24 бита,     Чтение/Запись )  Второй ответ
+    10 - index                    (    L2NR бит, Только чтение )  Номер строки таблицы ответов для ключа в голове FIFO
+    11 - count                    ( L2NR+1 бит,  Чтение/Запись )  Количество используемых строк таблицы ответов (1..NR)
+    12 - position                 ( 41-L2NK бит, Только чтение )  Счётчик перебора key_reg: младшие биты ключей,
+                                                                  до которых дошёл перебор во всех ядрах
+    13 - cycles                   ( 48 бит,      Только чтение )  Счётчик тактов PLL от запуска до окончания перебора
+    14 - id                       ( 64 бита,     Только чтение )  Идентификатор: биты 63..24 - "DST40", 23..16 - UNROLL,
+                                                                  15..0 - VERSION
+    15 - caps                     ( 64 бита,     Только чтение )  Параметры образа:
+         биты 7..0   - NK                                         количество ядер
+         биты 15..8  - L2NK                                       старшие биты ключа, задаваемые номером ядра
+         биты 23..16 - NR                                         размер таблицы ответов
+         биты 31..24 - DEPTH                                      глубина конвеера, тактов
+         биты 47..32 - CLOCK_MHZ                                  частота тактов ядер, МГц
+         биты 55..48 - FEATURES                                   возможности (CAPS_* ниже)
+         биты 63..56 - L2FIFO                                     логарифм глубины FIFO найденных ключей
+    16 - busy                     ( 48 бит,      Только чтение )  Такты PLL, в которые ядра хэшировали
+    17 - stall                    ( 48 бит,      Только чтение )  Такты простоя из-за занятого регистра кандидата
+    18 - hold                     ( 48 бит,      Только чтение )  Такты ожидания места в FIFO (ожидания HPS)
+    19 - refill                   ( 48 бит,      Только чтение )  Такты заполнения конвеера после запуска
+    20 - restarts                 ( 32 бита,     Только чтение )  Количество запусков с момента конфигурации FPGA
+    24 .. 24+NK-1 - hits          ( 32 бита,     Только чтение )  Количество кандидатов по первой паре у ядра
+                                                                  Счётчики 16..24+NK-1 обнуляются при запуске
+                                                                  и корректны только после остановки (run = 0)
+    40 - ring_base                ( 32 бита,     Чтение/Запись )  Физический адрес кольцевого буфера в памяти HPS
+                                                                  (кратен 32)
+    41 - ring:
+         бит 0      - ring_enable ( 1 бит,       Чтение/Запись )  Найденные ключи пишутся в кольцевой буфер
+         биты 12..8 - ring_l2size ( 5 бит,       Чтение/Запись )  Логарифм количества записей буфера
+    42 - ring_head                ( 32 бита,     Только чтение )  Количество записей, записанных в буфер
+    43 - ring_tail                ( 32 бита,     Чтение/Запись )  Количество записей, забранных программой
+    44 - end_key                  ( 40 бит,      Чтение/Запись )  Ключ, на котором закончить поиск (не включая его,
+                                                                  0 - до конца)
+    45 - job                      ( 16 бит,      Только чтение )  Номер задания очереди для ключа в голове FIFO
+    46 - key_mask                 ( 40-L2NK бит, Чтение/Запись )  Маска известных бит ключа (в единицах key_reg)
+    47 - key_value                ( 40-L2NK бит, Чтение/Запись )  Значения известных бит ключа
+    48 - desc_challenge           ( 40 бит,      Чтение/Запись )  Дескриптор задания: запрос
+    49 - desc_challenge2          ( 40 бит,      Чтение/Запись )  второй запрос
+    50 - desc_responses           ( 48 бит,      Чтение/Запись )  ответы: биты 47..24 - второй, 23..0 - первый
+    51 - desc_start_key           ( 40 бит,      Чтение/Запись )  начальный ключ
+    52 - desc_end_key             ( 40 бит,      Чтение/Запись )  конечный ключ (не включая его, 0 - до конца)
+    53 - queue:
+         бит 0       - queue_enable ( 1 бит,     Чтение/Запись )  Задания берутся из очереди дескрипторов
+         бит 8       - push       ( 1 бит,       Только запись )  Запись 1 кладёт дескриптор 48..52 в очередь
+         бит 8       - busy       ( 1 бит,       Только чтение )  Задание из очереди выполняется
+         биты 23..16 - count      ( 8 бит,       Только чтение )  Дескрипторов в очереди (не считая выполняемого)
+         биты 31..24 - L2QUEUE    ( 8 бит,       Только чтение )  Логарифм глубины очереди
+    54 - queue_done               ( 32 бита,     Только чтение )  Количество выполненных заданий с включения очереди
+    64 .. 64+NR-1 - responses     ( 48 бит,      Чтение/Запись )  Строка таблицы ответов: биты 47..24 - второй ответ,
+                                                                  биты 23..0 - первый ответ
+
+  8. Вместо чтения FIFO через регистры 5, 6, 10 и 7 найденные ключи
+     можно получать через кольцевой буфер в памяти HPS (RingWriter.v):
+     при ring_enable = 1 модуль сам забирает ключи из FIFO и пишет их
+     через мост FPGA-to-SDRAM записями по 32 байта вместе с номером
+     записи и тактом находки, а программа читает их из памяти и двигает
+     хвост ring_tail. Флаг done в этом режиме взводится, когда все
+     найденные ключи уже записаны в буфер (ring_head больше не изменится).
+
+  9. Перебор идёт от start_key до end_key (младшие биты, end_key
+     не включается; 0 - до конца диапазона ядра). Вместо регистров 0..3
+     задания можно класть в очередь дескрипторов (JobQueue.v): программа
+     заполняет регистры 48..52 и пишет 1 в бит 8 регистра queue,
+     а при queue_enable = 1 модуль сам запускает задания одно за другим.
+     Регистры run, challenge, response и т.д. при этом не используются,
+     таблица ответов - тоже (дескриптор задаёт одну метку). Каждое
+     выполненное задание увеличивает счётчик queue_done и взводит флаг
+     прерывания, а найденный ключ кладётся в FIFO вместе с номером
+     задания (регистр job).
+
+ 10. Образ версии 11 перебирает только свободные биты ключа: единицы
+     key_mask задают известные биты, key_value - их значения (в единицах
+     key_reg, как start_key; см. dst40_XX.v). start_key, end_key,
+     position и key тогда - номер ключа в уменьшенном пространстве
+     из 2^(свободных бит) ключей, и при k известных битах перебор идёт
+     в 2^k раз быстрее. Маска общая для заданий из регистров и из очереди.
+     Нулевая маска - обычный перебор.
 
 ******************************************************************************/
 
@@ -111,8 +245,31 @@ module dst40
 // Параметры
 //==============================================================//
 
-parameter NK   = 4;                                             // Количество ядер в составе модуля
+parameter NK   = 4;                                             // Количество ядер в составе модуля (степень 2, от 1 до 16)
 parameter L2NK = log2(NK);                                      // Логарифм по основанию 2 от NK
+parameter L2FIFO = 4;                                           // Логарифм по основанию 2 от глубины FIFO найденных ключей
+parameter NR   = 16;                                            // Размер таблицы ответов (не меньше 2, не больше 64)
+parameter L2NR = log2(NR);                                      // Логарифм по основанию 2 от NR
+parameter UNROLL    = 64;                                       // Модулей Block64 в ядре: 64 - полная развёртка, меньше - свёрнутое ядро
+parameter RPS       = 3;                                        // Раундов на ступень конвеера: 1, 2, 3 или 6 (UNROLL * 3 делится на RPS)
+parameter DEPTH     = 192 / RPS;                                // Глубина конвеера ядра, тактов
+parameter CLOCK_MHZ = 150;                                      // Частота тактов PLL, МГц (должна совпадать с настройкой pll.v)
+parameter INTERLEAVE = 0;                                       // 1 - ядро i проверяет ключи key_reg * NK + i (номер ядра - младшие биты)
+parameter L2QUEUE   = 3;                                        // Логарифм по основанию 2 от глубины очереди дескрипторов
+parameter VERSION   = 11;                                       // Версия образа (регистр id)
+
+// Возможности образа (биты поля FEATURES регистра caps)
+
+parameter CAPS_VERIFY   = 8'h 01;                               // Проверка кандидатов на второй паре внутри FPGA
+parameter CAPS_TABLE    = 8'h 02;                               // Таблица ответов нескольких меток
+parameter CAPS_POSITION = 8'h 04;                               // Счётчик перебора (регистр 12)
+parameter CAPS_CYCLES   = 8'h 08;                               // Счётчик тактов (регистр 13)
+parameter CAPS_PERF     = 8'h 10;                               // Счётчики производительности (регистры 16..)
+parameter CAPS_RING     = 8'h 20;                               // Кольцевой буфер найденных ключей в памяти HPS (регистры 40..43)
+parameter CAPS_QUEUE    = 8'h 40;                               // Конечный ключ и очередь дескрипторов заданий (регистры 44..54)
+parameter CAPS_INTERLEAVE = 8'h 80;                             // Номер ядра - младшие биты ключа (параметр INTERLEAVE)
+parameter FEATURES      = CAPS_VERIFY | CAPS_TABLE | CAPS_POSITION | CAPS_CYCLES | CAPS_PERF | CAPS_RING | CAPS_QUEUE |
+                          ( INTERLEAVE ? CAPS_INTERLEAVE : 8'h 00 );
 
 
 
@@ -133,6 +290,20 @@ function integer log2;
   end
 endfunction
 
+//--------------------------------------------------------------//
+// Из кода Грея в двоичный                                      //
+
+function [47:0] grayToBin;
+  input  [47:0] gray;
+  integer       j;
+  begin
+    grayToBin[47] = gray[47];
+
+    for( j=46; j >= 0; j=j-1 )
+      grayToBin[j] = grayToBin[j+1] ^ gray[j];
+  end
+endfunction
+
 
 
 //==============================================================//
@@ -156,19 +327,154 @@ wire        [7:0] mmb_byteenable_w;                             // Биты ра
 // Исходные данные - записываются процессором HPS               //
 
 reg        [39:0] challenge_reg   = 0;                          // Запрос
-reg        [23:0] response_reg    = 0;                          // Ответ
+reg        [39:0] challenge2_reg  = 0;                          // Второй запрос
+reg        [23:0] response_mem  [0:NR-1];                       // Таблица ответов на первый запрос (строка 0 - регистр response)
+reg        [23:0] response2_mem [0:NR-1];                       // Таблица ответов на второй запрос (строка 0 - регистр response2)
+reg      [L2NR:0] count_reg       = 1;                          // Количество используемых строк таблицы
 reg        [39:0] start_key_reg   = 0;                          // Стартовый ключ
+reg        [39:0] end_key_reg     = 0;                          // Конечный ключ (0 - до конца)
+reg        [39:0] key_mask_reg    = 0;                          // Маска известных бит ключа
+reg        [39:0] key_value_reg   = 0;                          // Значения известных бит ключа
 reg               run_reg         = 0;                          // Разрешение работы ядер
 
 // Результаты поиска                                            //
 
-wire              key_found_w;                                  // Флаг "Ключ найден"
-wire              key_not_found_w;                              // Флаг "Работа завершена - ключ не найден"
-wire     [NK-1:0] kernels_w;                                    // Биты, показывающие какое ядро (или ядра), нашло ключ
-wire  [39-L2NK:0] result_w;                                     // Найденный ключ
+wire              key_found_w;                                  // Строб "найден ключ" (такты PLL)
+wire              key_not_found_w;                              // Флаг "Работа завершена - все ключи перебраны и проверены" (такты PLL)
+wire              overflow_w;                                   // Флаг "конвеер приостанавливался" (такты PLL)
+wire     [NK-1:0] kernels_w;                                    // Бит ядра, нашедшего ключ
+wire  [39-L2NK:0] result_w;                                     // Найденный ключ (младшие биты)
+wire   [L2NR-1:0] index_w;                                      // Номер строки таблицы ответов для найденного ключа
+
+wire  [NR*48-1:0] responses_w;                                  // Таблица ответов одной шиной
+
+// FIFO найденных ключей                                        //
+
+wire              fifo_full_w;                                  // FIFO заполнено (такты PLL)
+wire              fifo_empty_w;                                 // FIFO пусто (такты FPGA_CLK1_50)
+wire [L2NR+NK+103-L2NK:0] fifo_head_w;                          // Голова FIFO: { job, cycles, index, kernels, key }
+wire              fifo_pop_w;                                   // Удаление ключа из головы FIFO
+wire       [47:0] stamp_gray_w = fifo_head_w[L2NR+NK+87-L2NK:L2NR+NK+40-L2NK];  // Такт находки ключа в голове FIFO в коде Грея
+wire       [15:0] job_w        = fifo_head_w[L2NR+NK+103-L2NK:L2NR+NK+88-L2NK]; // Номер задания ключа в голове FIFO
+wire       [47:0] stamp_bin_w  = grayToBin( stamp_gray_w );     // Он же в двоичном коде
+
+// Кольцевой буфер найденных ключей в памяти HPS                //
+
+reg        [31:0] ring_base_reg   = 0;                          // Физический адрес буфера
+reg               ring_enable_reg = 0;                          // Ключи из FIFO пишутся в буфер
+reg         [4:0] ring_l2size_reg = 0;                          // Логарифм количества записей буфера
+reg        [31:0] ring_tail_reg   = 0;                          // Хвост: записи, забранные программой
+wire       [31:0] ring_head_w;                                  // Голова: записанные записи
+wire              ring_idle_w;                                  // Запись в буфер не идёт
+wire              ring_pop_w;                                   // Удаление ключа из головы FIFO модулем записи
+
+wire       [28:0] sdram_address_w;                              // Порт FPGA-to-SDRAM
+wire        [7:0] sdram_burstcount_w;
+wire       [63:0] sdram_writedata_w;
+wire        [7:0] sdram_byteenable_w;
+wire              sdram_write_w;
+wire              sdram_waitrequest_w;
+
+wire              found_w = !fifo_empty_w || !ring_idle_w;      // Флаг "в FIFO есть ключ или ключ пишется в буфер"
+wire              done_w = done_reg[2] &&                       // Все ключи перебраны, проверены и, если включён
+                           ( !ring_enable_reg || ( fifo_empty_w && ring_idle_w ) );  // кольцевой буфер, записаны в него
+
+// Очередь дескрипторов заданий
+
+reg        [39:0] desc_challenge_reg  = 0;                      // Дескриптор, который кладётся в очередь
+reg        [39:0] desc_challenge2_reg = 0;
+reg        [47:0] desc_responses_reg  = 0;
+reg        [39:0] desc_start_key_reg  = 0;
+reg        [39:0] desc_end_key_reg    = 0;
+reg               queue_enable_reg    = 0;                      // Задания берутся из очереди
+wire              queue_push_w;                                 // Строб "положить дескриптор в очередь"
+wire      [207:0] queue_desc_w;                                 // Выполняемый дескриптор
+wire              queue_run_w;                                  // Разрешение работы ядер от очереди
+wire    [L2QUEUE:0] queue_count_w;                              // Дескрипторов в очереди
+wire              queue_busy_w;                                 // Задание из очереди выполняется
+wire       [31:0] queue_done_w;                                 // Количество выполненных заданий
+wire              queue_complete_w;                             // Строб "задание выполнено"
+
+// Входы модуля поиска: регистры или дескриптор из очереди
+
+wire       [39:0] job_challenge_w  = queue_enable_reg ? queue_desc_w[39:0]    : challenge_reg;
+wire       [39:0] job_challenge2_w = queue_enable_reg ? queue_desc_w[79:40]   : challenge2_reg;
+wire  [NR*48-1:0] job_responses_w  = queue_enable_reg ? { {NR*48-48{1'b0}}, queue_desc_w[127:80] } : responses_w;
+wire     [L2NR:0] job_count_w      = queue_enable_reg ? { {L2NR{1'b0}}, 1'b1 } : count_reg;
+wire       [39:0] job_start_key_w  = queue_enable_reg ? queue_desc_w[167:128] : start_key_reg;
+wire       [39:0] job_end_key_w    = queue_enable_reg ? queue_desc_w[207:168] : end_key_reg;
+wire              job_run_w        = queue_enable_reg ? queue_run_w           : run_reg;
+
+reg         [2:0] done_reg     = 0;                             // Флаг "все ключи перебраны", синхронизированный с FPGA_CLK1_50
+reg         [1:0] overflow_reg = 0;                             // Флаг переполнения FIFO, синхронизированный с FPGA_CLK1_50
+
+wire  [40-L2NK:0] position_w;                                   // Счётчик перебора в коде Грея (такты PLL)
+reg   [40-L2NK:0] position_gray_reg [0:1];                      // Он же, синхронизированный с FPGA_CLK1_50
+wire       [47:0] position_bin_w = grayToBin( { {7+L2NK{1'b 0}}, position_gray_reg[1] } );  // Он же в двоичном коде
+
+wire       [47:0] cycles_w;                                     // Счётчик тактов в коде Грея (такты PLL)
+reg        [47:0] cycles_gray_reg [0:1];                        // Он же, синхронизированный с FPGA_CLK1_50
+wire       [47:0] cycles_bin_w = grayToBin( cycles_gray_reg[1] );  // Он же в двоичном коде
+
+wire       [47:0] busy_w;                                       // Счётчики производительности (такты PLL)
+wire       [47:0] stall_w;
+wire       [47:0] hold_w;
+wire       [47:0] refill_w;
+wire  [NK*32-1:0] hits_w;
+wire       [31:0] restarts_w;
+reg        [47:0] busy_reg     = 0;                             // Они же, защёлкнутые на тактах FPGA_CLK1_50
+reg        [47:0] stall_reg    = 0;
+reg        [47:0] hold_reg     = 0;
+reg        [47:0] refill_reg   = 0;
+reg   [NK*32-1:0] hits_reg     = 0;
+reg        [31:0] restarts_reg = 0;
+
+localparam  [6:0] HITS       = 7'd 24;                          // Адрес счётчика кандидатов ядра 0
+
+wire              hits_sel_w = ( mmb_address_w >= HITS ) &&     // Обращение к счётчикам кандидатов
+                               ( mmb_address_w < HITS + NK[6:0] );
+wire       [31:0] hits_read_w;                                  // Счётчик ядра mmb_address_w - HITS
 
 reg               irq_reg = 0;                                  // Флаг прерывания
 
+// Идентификатор и параметры образа                             //
+
+wire        [7:0] caps_nk_w       = NK[7:0];
+wire        [7:0] caps_l2nk_w     = L2NK[7:0];
+wire        [7:0] caps_nr_w       = NR[7:0];
+wire        [7:0] caps_depth_w    = DEPTH[7:0];
+wire       [15:0] caps_clock_w    = CLOCK_MHZ[15:0];
+wire        [7:0] caps_features_w = FEATURES[7:0];
+wire        [7:0] caps_l2fifo_w   = L2FIFO[7:0];
+wire        [7:0] caps_l2queue_w  = L2QUEUE[7:0];
+wire        [7:0] unroll_w        = UNROLL[7:0];
+wire       [15:0] version_w       = VERSION[15:0];
+
+wire       [63:0] id_w   = { 40'h 4453543430, unroll_w, version_w };  // "DST40", свёртка ядер и версия
+wire       [63:0] caps_w = { caps_l2fifo_w, caps_features_w, caps_clock_w, caps_depth_w,
+                             caps_nr_w, caps_l2nk_w, caps_nk_w };
+
+wire              table_w = ( mmb_address_w >= 7'd 64 ) &&      // Обращение к таблице ответов
+                            ( { 1'b 0, mmb_address_w } < 8'd 64 + NR[7:0] );
+wire   [L2NR-1:0] row_w   = mmb_address_w[L2NR-1:0];            // Номер строки таблицы
+
+integer           n;
+
+initial
+  for( n=0; n < NR; n=n+1 )
+  begin
+    response_mem[n]  = 0;
+    response2_mem[n] = 0;
+  end
+
+initial
+begin
+  position_gray_reg[0] = 0;
+  position_gray_reg[1] = 0;
+  cycles_gray_reg[0]   = 0;
+  cycles_gray_reg[1]   = 0;
+end
+
 
 
 //==============================================================//
@@ -179,7 +485,47 @@ assign GPIO_0 = 36'h ZZZZZZZZZ;
 assign GPIO_1 = 36'h ZZZZZZZZZ;
 
 assign LED[7:1] = 7'b 0000000;
-assign LED[0]   = key_found_w;
+assign LED[0]   = ~fifo_empty_w;
+
+wire   unused_w = &{ 1'b 0, KEY, SW };                          // Кнопки и переключатели не используются
+
+
+
+//--------------------------------------------------------------//
+// Таблица ответов одной шиной для модуля поиска                //
+
+genvar i;
+
+generate
+
+  for( i=0; i < NR; i=i+1 )
+  begin: _responses_
+    assign responses_w[48*i +: 48] = { response2_mem[i], response_mem[i] };
+  end
+
+endgenerate
+
+
+
+//--------------------------------------------------------------//
+// Счётчик кандидатов для чтения: номер ядра - адрес минус 24   //
+// по модулю NK. База 24 выровнена на NK только при NK <= 8,    //
+// поэтому вычитание нужно и при NK = 16 (адреса 24..39)        //
+
+generate
+
+  if( L2NK )
+  begin: _hits_
+    wire [L2NK-1:0] kernel_w = mmb_address_w[L2NK-1:0] - HITS[L2NK-1:0];
+
+    assign hits_read_w = hits_reg[{ kernel_w, 5'd 0 } +: 32];
+  end
+  else
+  begin: _hits1_                                                // Одно ядро
+    assign hits_read_w = hits_reg;
+  end
+
+endgenerate
 
 
 
@@ -201,19 +547,120 @@ pll PLL_INST
 dst40_XX
 #(
   .NK               ( NK   ),
-  .L2NK             ( L2NK )
+  .L2NK             ( L2NK ),
+  .NR               ( NR   ),
+  .L2NR             ( L2NR ),
+  .UNROLL           ( UNROLL ),
+  .RPS              ( RPS  ),
+  .INTERLEAVE       ( INTERLEAVE )
 )
 DST40_XX_INST
 (
   .clock_i          ( pll_clock_main_w        ),                // Такты
-  .challenge_i      ( challenge_reg           ),                // Запрос
-  .response_i       ( response_reg            ),                // Ответ
-  .start_key_i      ( start_key_reg           ),                // Стартовый ключ
-  .run_i            ( run_reg                 ),                // Разрешение работы ядер
-  .key_found_o      ( key_found_w             ),                // Флаг "ключ найден"
-  .key_not_found_o  ( key_not_found_w         ),                // Флаг "ключ не найден"
-  .kernels_o        ( kernels_w               ),                // Биты, показывающие какое ядро (или ядра), нашло ключ
-  .key_o            ( result_w                )                 // Найденный ключ (младшие биты)
+  .challenge_i      ( job_challenge_w         ),                // Запрос
+  .challenge2_i     ( job_challenge2_w        ),                // Второй запрос
+  .responses_i      ( job_responses_w         ),                // Таблица ответов
+  .count_i          ( job_count_w             ),                // Количество используемых строк таблицы
+  .start_key_i      ( job_start_key_w         ),                // Стартовый ключ
+  .end_key_i        ( job_end_key_w           ),                // Конечный ключ
+  .key_mask_i       ( key_mask_reg            ),                // Маска известных бит ключа
+  .key_value_i      ( key_value_reg           ),                // Значения известных бит ключа
+  .run_i            ( job_run_w               ),                // Разрешение работы ядер
+  .hold_i           ( fifo_full_w             ),                // Некуда положить найденный ключ
+  .key_found_o      ( key_found_w             ),                // Строб "найден ключ"
+  .key_not_found_o  ( key_not_found_w         ),                // Флаг "все ключи перебраны и проверены"
+  .kernels_o        ( kernels_w               ),                // Бит ядра, нашедшего ключ
+  .key_o            ( result_w                ),                // Найденный ключ (младшие биты)
+  .index_o          ( index_w                 ),                // Номер строки таблицы ответов
+  .overflow_o       ( overflow_w              ),                // Флаг "конвеер приостанавливался"
+  .position_o       ( position_w              ),                // Счётчик перебора в коде Грея
+  .cycles_o         ( cycles_w                ),                // Счётчик тактов в коде Грея
+  .busy_o           ( busy_w                  ),                // Счётчики производительности
+  .stall_o          ( stall_w                 ),
+  .hold_o           ( hold_w                  ),
+  .refill_o         ( refill_w                ),
+  .hits_o           ( hits_w                  ),
+  .restarts_o       ( restarts_w              )
+);
+
+
+//--------------------------------------------------------------//
+// FIFO найденных ключей: пишется на тактах PLL, читается через //
+// Avalon-MM на тактах FPGA_CLK1_50                             //
+
+FifoDC
+#(
+  .WIDTH            ( L2NR + NK + 104 - L2NK ),
+  .L2DEPTH          ( L2FIFO         )
+)
+FIFO_INST
+(
+  .wclock_i         ( pll_clock_main_w            ),            // Такты записи
+  .write_i          ( key_found_w                 ),            // Ключ найден - кладём в FIFO
+  .data_i           ( { queue_done_w[15:0], cycles_w, index_w, kernels_w, result_w } ),
+  .full_o           ( fifo_full_w                 ),
+
+  .rclock_i         ( FPGA_CLK1_50                ),            // Такты чтения
+  .read_i           ( fifo_pop_w                  ),            // Удаление по записи в регистр 7 или модулем записи в буфер
+  .data_o           ( fifo_head_w                 ),
+  .empty_o          ( fifo_empty_w                )
+);
+
+
+//--------------------------------------------------------------//
+// Запись найденных ключей в кольцевой буфер в памяти HPS       //
+
+RingWriter RING_INST
+(
+  .clock_i          ( FPGA_CLK1_50                ),            // Такты
+  .enable_i         ( ring_enable_reg             ),            // Разрешение работы
+  .base_i           ( ring_base_reg               ),            // Адрес буфера
+  .l2size_i         ( ring_l2size_reg             ),            // Размер буфера
+  .tail_i           ( ring_tail_reg               ),            // Хвост (пишет программа)
+  .head_o           ( ring_head_w                 ),            // Голова
+  .idle_o           ( ring_idle_w                 ),            // Запись не идёт
+
+  .empty_i          ( fifo_empty_w                ),            // FIFO найденных ключей
+  .data_i           ( { 32'b0, job_w, stamp_bin_w,
+                        { 32 - L2NR{1'b0} }, fifo_head_w[L2NR+NK+39-L2NK:NK+40-L2NK],
+                        { 32 - NK{1'b0} }, fifo_head_w[NK+39-L2NK:40-L2NK],
+                        { {L2NK+24{1'b0}}, fifo_head_w[39-L2NK:0] } } ),
+  .read_o           ( ring_pop_w                  ),
+
+  .address_o        ( sdram_address_w             ),            // Порт FPGA-to-SDRAM
+  .burstcount_o     ( sdram_burstcount_w          ),
+  .writedata_o      ( sdram_writedata_w           ),
+  .byteenable_o     ( sdram_byteenable_w          ),
+  .write_o          ( sdram_write_w               ),
+  .waitrequest_i    ( sdram_waitrequest_w         )
+);
+
+
+//--------------------------------------------------------------//
+// Очередь дескрипторов заданий                                 //
+
+JobQueue
+#(
+  .WIDTH            ( 208                         ),
+  .L2DEPTH          ( L2QUEUE                     )
+)
+QUEUE_INST
+(
+  .clock_i          ( FPGA_CLK1_50                ),            // Такты
+  .enable_i         ( queue_enable_reg            ),            // Разрешение работы
+  .push_i           ( queue_push_w                ),            // Запись 1 в бит 8 регистра 53
+  .data_i           ( { desc_end_key_reg, desc_start_key_reg, desc_responses_reg,
+                        desc_challenge2_reg, desc_challenge_reg } ),
+
+  .done_i           ( done_w                      ),            // Задание выполнено
+  .stopped_i        ( !done_reg[2]                ),            // Модуль поиска остановлен
+  .run_o            ( queue_run_w                 ),            // Разрешение работы ядер
+  .desc_o           ( queue_desc_w                ),            // Выполняемый дескриптор
+
+  .count_o          ( queue_count_w               ),
+  .busy_o           ( queue_busy_w                ),
+  .number_o         ( queue_done_w                ),
+  .complete_o       ( queue_complete_w            )
 );
 
 
@@ -318,6 +765,14 @@ soc_system SOC_INST
 	.mm_bridge_read                         ( mmb_read_w          ),  // Строб чтения
 	.mm_bridge_byteenable                   ( mmb_byteenable_w    ),  // Биты разрешения записи
 
+  // FPGA-to-SDRAM: запись кольцевого буфера найденных ключей
+  .hps_0_f2h_sdram0_data_address          ( sdram_address_w     ),  // Адрес 64-битного слова
+  .hps_0_f2h_sdram0_data_burstcount       ( sdram_burstcount_w  ),  // Длина пачки
+  .hps_0_f2h_sdram0_data_waitrequest      ( sdram_waitrequest_w ),  // Порт занят
+  .hps_0_f2h_sdram0_data_writedata        ( sdram_writedata_w   ),  // Данные
+  .hps_0_f2h_sdram0_data_byteenable       ( sdram_byteenable_w  ),  // Биты разрешения записи
+  .hps_0_f2h_sdram0_data_write            ( sdram_write_w       ),  // Строб записи
+
   // IRQ
   .irq0_irq                               ( { 31'd 0, irq_reg } )   // Прерывание IRQ0
 );
@@ -330,16 +785,62 @@ soc_system SOC_INST
 // Неиспользуемые старшие биты зануляются, что упрощает
 // дальнейшее использование данных в программе.
 
-assign mmb_readdata_w = ( mmb_address_w == 7'd 0 ) ? {           24'b0, challenge_reg                      } :
-                        ( mmb_address_w == 7'd 1 ) ? {           40'b0, response_reg                       } :
-                        ( mmb_address_w == 7'd 2 ) ? {           24'b0, start_key_reg                      } :
-                        ( mmb_address_w == 7'd 3 ) ? {           63'b0, run_reg                            } :
-                        ( mmb_address_w == 7'd 4 ) ? {           55'b0, key_not_found_w, 7'b0, key_found_w } :
-                        ( mmb_address_w == 7'd 5 ) ? { {L2NK+24{1'b0}}, result_w                           } :
-                        ( mmb_address_w == 7'd 6 ) ? {   {64-NK{1'b0}}, kernels_w                          } :
+assign mmb_readdata_w = ( mmb_address_w == 7'd 0 ) ? {           24'b0, challenge_reg                                         } :
+                        ( mmb_address_w == 7'd 1 ) ? {           40'b0, response_mem[0]                                       } :
+                        ( mmb_address_w == 7'd 2 ) ? {           24'b0, start_key_reg                                         } :
+                        ( mmb_address_w == 7'd 3 ) ? {           63'b0, run_reg                                               } :
+                        ( mmb_address_w == 7'd 4 ) ? { 47'b0, overflow_reg[1], 7'b0, done_w,      7'b0, found_w       } :
+                        ( mmb_address_w == 7'd 5 ) ? { {L2NK+24{1'b0}}, fifo_head_w[39-L2NK:0]                        } :
+                        ( mmb_address_w == 7'd 6 ) ? {   {64-NK{1'b0}}, fifo_head_w[NK+39-L2NK:40-L2NK]               } :
+                        ( mmb_address_w == 7'd 8 ) ? {           24'b0, challenge2_reg                                        } :
+                        ( mmb_address_w == 7'd 9 ) ? {           40'b0, response2_mem[0]                                      } :
+                        ( mmb_address_w == 7'd10 ) ? { {64-L2NR{1'b0}}, fifo_head_w[L2NR+NK+39-L2NK:NK+40-L2NK]        } :
+                        ( mmb_address_w == 7'd11 ) ? { {63-L2NR{1'b0}}, count_reg                                     } :
+                        ( mmb_address_w == 7'd12 ) ? {           16'b0, position_bin_w                                } :
+                        ( mmb_address_w == 7'd13 ) ? {           16'b0, cycles_bin_w                                  } :
+                        ( mmb_address_w == 7'd14 ) ? id_w                                                               :
+                        ( mmb_address_w == 7'd15 ) ? caps_w                                                             :
+                        ( mmb_address_w == 7'd16 ) ? {           16'b0, busy_reg                                      } :
+                        ( mmb_address_w == 7'd17 ) ? {           16'b0, stall_reg                                     } :
+                        ( mmb_address_w == 7'd18 ) ? {           16'b0, hold_reg                                      } :
+                        ( mmb_address_w == 7'd19 ) ? {           16'b0, refill_reg                                    } :
+                        ( mmb_address_w == 7'd20 ) ? {           32'b0, restarts_reg                                  } :
+                        ( mmb_address_w == 7'd40 ) ? {           32'b0, ring_base_reg                                 } :
+                        ( mmb_address_w == 7'd41 ) ? { 51'b0, ring_l2size_reg, 7'b0, ring_enable_reg                } :
+                        ( mmb_address_w == 7'd42 ) ? {           32'b0, ring_head_w                                   } :
+                        ( mmb_address_w == 7'd43 ) ? {           32'b0, ring_tail_reg                                 } :
+                        ( mmb_address_w == 7'd44 ) ? {           24'b0, end_key_reg                                   } :
+                        ( mmb_address_w == 7'd45 ) ? {           48'b0, job_w                                         } :
+                        ( mmb_address_w == 7'd46 ) ? {           24'b0, key_mask_reg                                  } :
+                        ( mmb_address_w == 7'd47 ) ? {           24'b0, key_value_reg                                 } :
+                        ( mmb_address_w == 7'd48 ) ? {           24'b0, desc_challenge_reg                            } :
+                        ( mmb_address_w == 7'd49 ) ? {           24'b0, desc_challenge2_reg                           } :
+                        ( mmb_address_w == 7'd50 ) ? {           16'b0, desc_responses_reg                            } :
+                        ( mmb_address_w == 7'd51 ) ? {           24'b0, desc_start_key_reg                            } :
+                        ( mmb_address_w == 7'd52 ) ? {           24'b0, desc_end_key_reg                              } :
+                        ( mmb_address_w == 7'd53 ) ? { 32'b0, caps_l2queue_w, {7-L2QUEUE{1'b0}}, queue_count_w,
+                                                       7'b0, queue_busy_w, 7'b0, queue_enable_reg                     } :
+                        ( mmb_address_w == 7'd54 ) ? {           32'b0, queue_done_w                                  } :
+                        ( hits_sel_w             ) ? {           32'b0, hits_read_w                                   } :
+                        ( table_w                ) ? { 16'b0, response2_mem[row_w], response_mem[row_w]               } :
                         0;
 
 
+//--------------------------------------------------------------//
+// Удаление ключа из головы FIFO - записью 1 в бит 0            //
+// регистра 7, а при включённом кольцевом буфере - модулем      //
+// записи в буфер                                               //
+
+assign fifo_pop_w = ring_enable_reg ? ring_pop_w :
+                    mmb_write_w && ( mmb_address_w == 7'd 7 ) && mmb_byteenable_w[0] && mmb_writedata_w[0];
+
+
+//--------------------------------------------------------------//
+// Дескриптор кладётся в очередь записью 1 в бит 8 регистра 53  //
+
+assign queue_push_w = mmb_write_w && ( mmb_address_w == 7'd 53 ) && mmb_byteenable_w[1] && mmb_writedata_w[8];
+
+
 
 //==============================================================//
 // Синхронная схемотехника.
@@ -348,6 +849,28 @@ assign mmb_readdata_w = ( mmb_address_w == 7'd 0 ) ? {           24'b0, challeng
 always @( posedge FPGA_CLK1_50 )
 begin
 
+  // Синхронизируем флаги из домена тактов PLL с нашими тактами.
+  // Указатель записи FIFO синхронизируется цепочкой из двух триггеров
+  // и меняется не позже флага "все ключи перебраны", а флаг проходит
+  // через три триггера - поэтому, когда он взведён, все найденные ключи
+  // уже видны в FIFO.
+
+  done_reg     <= { done_reg[1:0], key_not_found_w };
+  overflow_reg <= { overflow_reg[0], overflow_w };
+
+  position_gray_reg[0] <= position_w;                           // Счётчик перебора меняется не больше чем на единицу за такт,
+  position_gray_reg[1] <= position_gray_reg[0];                 // поэтому в коде Грея его достаточно пропустить через два триггера
+
+  cycles_gray_reg[0]   <= cycles_w;                             // Счётчик тактов - так же
+  cycles_gray_reg[1]   <= cycles_gray_reg[0];
+
+  busy_reg     <= busy_w;                                       // Счётчики производительности в режиме ожидания не меняются,
+  stall_reg    <= stall_w;                                      // поэтому после остановки их достаточно защёлкнуть
+  hold_reg     <= hold_w;                                       // одним триггером (во время перебора значения
+  refill_reg   <= refill_w;                                     // могут быть несогласованными)
+  hits_reg     <= hits_w;
+  restarts_reg <= restarts_w;
+
   //------------------------------------------------------------//
   // Запись в регистры через интерфейс Avalon-MM                //
   //
@@ -377,18 +900,18 @@ begin
         challenge_reg[39:32] <= mmb_writedata_w[39:32];
     end
 
-    // Запись в регистр response_reg
+    // Запись в регистр response (строка 0 таблицы ответов)
 
     else if( mmb_address_w == 7'd 1 )
     begin
       if( mmb_byteenable_w[0] )
-        response_reg[7:0]   <= mmb_writedata_w[7:0];
+        response_mem[0][7:0]   <= mmb_writedata_w[7:0];
 
       if( mmb_byteenable_w[1] )
-        response_reg[15:8]  <= mmb_writedata_w[15:8];
+        response_mem[0][15:8]  <= mmb_writedata_w[15:8];
 
       if( mmb_byteenable_w[2] )
-        response_reg[23:16] <= mmb_writedata_w[23:16];
+        response_mem[0][23:16] <= mmb_writedata_w[23:16];
     end
 
     // Запись в регистр start_key_reg
@@ -418,6 +941,182 @@ begin
       if( mmb_byteenable_w[0] )
         run_reg <= mmb_writedata_w[0];
     end
+
+    // Запись в регистр challenge2_reg
+
+    else if( mmb_address_w == 7'd 8 )
+    begin
+      if( mmb_byteenable_w[0] )
+        challenge2_reg[7:0]   <= mmb_writedata_w[7:0];
+
+      if( mmb_byteenable_w[1] )
+        challenge2_reg[15:8]  <= mmb_writedata_w[15:8];
+
+      if( mmb_byteenable_w[2] )
+        challenge2_reg[23:16] <= mmb_writedata_w[23:16];
+
+      if( mmb_byteenable_w[3] )
+        challenge2_reg[31:24] <= mmb_writedata_w[31:24];
+
+      if( mmb_byteenable_w[4] )
+        challenge2_reg[39:32] <= mmb_writedata_w[39:32];
+    end
+
+    // Запись в регистр response2 (строка 0 таблицы ответов)
+
+    else if( mmb_address_w == 7'd 9 )
+    begin
+      if( mmb_byteenable_w[0] )
+        response2_mem[0][7:0]   <= mmb_writedata_w[7:0];
+
+      if( mmb_byteenable_w[1] )
+        response2_mem[0][15:8]  <= mmb_writedata_w[15:8];
+
+      if( mmb_byteenable_w[2] )
+        response2_mem[0][23:16] <= mmb_writedata_w[23:16];
+    end
+
+    // Запись в регистр count_reg
+
+    else if( mmb_address_w == 7'd 11 )
+    begin
+      if( mmb_byteenable_w[0] )
+        count_reg <= mmb_writedata_w[L2NR:0];
+    end
+
+    // Запись в регистры кольцевого буфера
+
+    else if( mmb_address_w == 7'd 40 )
+    begin
+      if( mmb_byteenable_w[0] )
+        ring_base_reg[7:0]   <= { mmb_writedata_w[7:5], 5'b0 };
+
+      if( mmb_byteenable_w[1] )
+        ring_base_reg[15:8]  <= mmb_writedata_w[15:8];
+
+      if( mmb_byteenable_w[2] )
+        ring_base_reg[23:16] <= mmb_writedata_w[23:16];
+
+      if( mmb_byteenable_w[3] )
+        ring_base_reg[31:24] <= mmb_writedata_w[31:24];
+    end
+
+    else if( mmb_address_w == 7'd 41 )
+    begin
+      if( mmb_byteenable_w[0] )
+        ring_enable_reg <= mmb_writedata_w[0];
+
+      if( mmb_byteenable_w[1] )
+        ring_l2size_reg <= mmb_writedata_w[12:8];
+    end
+
+    else if( mmb_address_w == 7'd 43 )
+    begin
+      if( mmb_byteenable_w[0] )
+        ring_tail_reg[7:0]   <= mmb_writedata_w[7:0];
+
+      if( mmb_byteenable_w[1] )
+        ring_tail_reg[15:8]  <= mmb_writedata_w[15:8];
+
+      if( mmb_byteenable_w[2] )
+        ring_tail_reg[23:16] <= mmb_writedata_w[23:16];
+
+      if( mmb_byteenable_w[3] )
+        ring_tail_reg[31:24] <= mmb_writedata_w[31:24];
+    end
+
+    // Запись в регистр end_key_reg
+
+    else if( mmb_address_w == 7'd 44 )
+    begin
+      for( n=0; n < 5; n=n+1 )
+        if( mmb_byteenable_w[n] )
+          end_key_reg[8*n +: 8] <= mmb_writedata_w[8*n +: 8];
+    end
+
+    // Запись в регистры маски известных бит ключа
+
+    else if( mmb_address_w == 7'd 46 )
+    begin
+      for( n=0; n < 5; n=n+1 )
+        if( mmb_byteenable_w[n] )
+          key_mask_reg[8*n +: 8] <= mmb_writedata_w[8*n +: 8];
+    end
+
+    else if( mmb_address_w == 7'd 47 )
+    begin
+      for( n=0; n < 5; n=n+1 )
+        if( mmb_byteenable_w[n] )
+          key_value_reg[8*n +: 8] <= mmb_writedata_w[8*n +: 8];
+    end
+
+    // Запись в регистры дескриптора задания
+
+    else if( mmb_address_w == 7'd 48 )
+    begin
+      for( n=0; n < 5; n=n+1 )
+        if( mmb_byteenable_w[n] )
+          desc_challenge_reg[8*n +: 8] <= mmb_writedata_w[8*n +: 8];
+    end
+
+    else if( mmb_address_w == 7'd 49 )
+    begin
+      for( n=0; n < 5; n=n+1 )
+        if( mmb_byteenable_w[n] )
+          desc_challenge2_reg[8*n +: 8] <= mmb_writedata_w[8*n +: 8];
+    end
+
+    else if( mmb_address_w == 7'd 50 )
+    begin
+      for( n=0; n < 6; n=n+1 )
+        if( mmb_byteenable_w[n] )
+          desc_responses_reg[8*n +: 8] <= mmb_writedata_w[8*n +: 8];
+    end
+
+    else if( mmb_address_w == 7'd 51 )
+    begin
+      for( n=0; n < 5; n=n+1 )
+        if( mmb_byteenable_w[n] )
+          desc_start_key_reg[8*n +: 8] <= mmb_writedata_w[8*n +: 8];
+    end
+
+    else if( mmb_address_w == 7'd 52 )
+    begin
+      for( n=0; n < 5; n=n+1 )
+        if( mmb_byteenable_w[n] )
+          desc_end_key_reg[8*n +: 8] <= mmb_writedata_w[8*n +: 8];
+    end
+
+    // Включение очереди (бит 8 - строб queue_push_w)
+
+    else if( mmb_address_w == 7'd 53 )
+    begin
+      if( mmb_byteenable_w[0] )
+        queue_enable_reg <= mmb_writedata_w[0];
+    end
+
+    // Запись строки таблицы ответов
+
+    else if( table_w )
+    begin
+      if( mmb_byteenable_w[0] )
+        response_mem[row_w][7:0]    <= mmb_writedata_w[7:0];
+
+      if( mmb_byteenable_w[1] )
+        response_mem[row_w][15:8]   <= mmb_writedata_w[15:8];
+
+      if( mmb_byteenable_w[2] )
+        response_mem[row_w][23:16]  <= mmb_writedata_w[23:16];
+
+      if( mmb_byteenable_w[3] )
+        response2_mem[row_w][7:0]   <= mmb_writedata_w[31:24];
+
+      if( mmb_byteenable_w[4] )
+        response2_mem[row_w][15:8]  <= mmb_writedata_w[39:32];
+
+      if( mmb_byteenable_w[5] )
+        response2_mem[row_w][23:16] <= mmb_writedata_w[47:40];
+    end
     
     irq_reg <= 0;                                               // По любой записи в любой регистр сбрасываем флаг прерывания
 
@@ -425,11 +1124,14 @@ begin
   else
   begin
 
-    if( run_reg && ( key_found_w || key_not_found_w ) )         // Если поиск запущен и взвёлся любой из битов результата поиска,
+    if( job_run_w && ( !fifo_empty_w || done_w ) )              // Если поиск запущен и в FIFO есть ключ или все ключи перебраны,
       irq_reg <= 1;                                             // то взводим флаг прерывания.
 
   end
 
+  if( queue_complete_w )                                        // Выполненное задание из очереди взводит флаг прерывания
+    irq_reg <= 1;                                               // даже одновременно с записью в регистр
+
 end
 
 
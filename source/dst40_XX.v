@@ -8,43 +8,247 @@
      по отношению к нашему модулю. Поэтому для исключения сбоев выполняется
      синхронизация этого сигнала с нашими тактами.
 
+  2. Совпадение ответа на первой паре запрос/ответ не останавливает
+     перебор: ключ-кандидат запоминается в регистре кандидата, а ядра
+     продолжают работать. Кандидаты из регистра по одному (по каждому
+     из нашедших их ядер) проверяются на второй паре запрос/ответ
+     последовательным хэшером Verify64.
+
+  3. Ключ, подошедший к обеим парам, выставляется на выходы key_o
+     и kernels_o при key_found_o = 1 и забирается в этом же такте
+     (в FIFO). Если его некуда положить (hold_i = 1), проверка
+     следующего кандидата ждёт освобождения места.
+
+  4. Конвеер приостанавливается, только если по первой паре найден новый
+     кандидат, а регистр кандидата ещё занят. Такая приостановка
+     запоминается во флаге overflow_o до следующего запуска.
+
+  5. Флаг key_not_found_o взводится, когда перебраны все ключи
+     и проверены все кандидаты. Перебор идёт от start_key_i до end_key_i
+     (младшие биты, end_key_i не включается; 0 - до конца диапазона ядра),
+     а в режиме ожидания флаг сброшен.
+
+  6. Вместо одного ожидаемого ответа используется таблица из NR пар
+     ответов (ответ на первый и на второй запрос) для разных меток
+     с одним и тем же запросом. Используются первые count_i строк.
+     Каждое ядро сравнивает результат сразу со всеми строками, поэтому
+     все метки ищутся за один проход перебора. Номер строки, к которой
+     подошёл ключ, выставляется на выход index_o вместе с key_o.
+
+  7. Текущее значение счётчика перебора key_reg выдаётся на выход
+     position_o в коде Грея: за такт он меняется не больше чем на единицу,
+     поэтому его можно безопасно пересинхронизировать на другие такты
+     цепочкой триггеров. Все ключи ядер с младшими битами меньше
+     key_reg - RING уже сравнены с ответами.
+
+  8. Счётчик тактов cycles_reg считает такты от запуска до окончания
+     перебора (включая такты, когда конвеер стоял) и так же в коде Грея
+     выдаётся на выход cycles_o. Вместе со счётчиком перебора он
+     показывает скорость перебора и простои конвеера.
+
+  9. Счётчики производительности раскладывают такты прохода по причинам:
+     busy_o - ядра хэшируют (run_w = 1), stall_o - конвеер стоит из-за
+     занятого регистра кандидата, hold_o - найденный ключ ждёт места
+     в FIFO (то есть ждёт HPS), refill_o - заполнение конвеера после
+     запуска (tick_reg < DEPTH). hits_o - количество кандидатов по первой
+     паре у каждого ядра, restarts_o - количество запусков с момента
+     конфигурации FPGA. Счётчики обнуляются при запуске (кроме restarts_o)
+     и не меняются в режиме ожидания, поэтому после остановки их можно
+     читать из другого домена тактов без кода Грея.
+
+ 10. Ядра могут быть свёрнутыми (UNROLL < 64, см. KernelXX.v): тогда
+     счётчик фазы phase_reg отсчитывает 64 такта работы ядер, ядра
+     принимают новые ключи на первых UNROLL тактах из 64 (load_w = 1),
+     и в этих же тактах на их выходах - результаты ключей, принятых
+     64 такта назад (на UNROLL значений key_reg раньше). Перебор
+     при этом идёт в 64 / UNROLL раз медленнее, зато ядер можно
+     поставить больше.
+
+ 11. Регистры конвеера могут стоять через RPS = 1, 2, 3 или 6 раундов
+     (см. KernelXX.v): тогда хэш считается за DEPTH = 192 / RPS тактов,
+     в кольце свёрнутого ядра RING = UNROLL * 3 / RPS ступеней, и во всех
+     формулах выше 64 такта заменяются на DEPTH, а UNROLL ключей - на RING.
+     Скорость перебора на такт от RPS не зависит, меняется только Fmax.
+
+ 12. Полностью развёрнутые ядра не хранят ключи в своих конвеерах:
+     общий конвеер ключей KeySched40 считает расписание для ключа
+     с нулевыми старшими битами, а каждое ядро добавляет к нему
+     константу своего номера (см. KeySched40.v). Это экономит 40 * DEPTH
+     регистров на ядро ценой разветвления шин ключей на все ядра.
+
+ 13. При INTERLEAVE = 1 ядро i проверяет ключ key_reg * NK + i, то есть
+     номер ядра - младшие биты ключа, а key_reg - старшие 40-L2NK бит.
+     Все ядра тогда работают внутри любого непрерывного диапазона
+     ключей, а не каждое в своей четверти (при NK = 4) пространства.
+     Стартовый и конечный ключи, счётчик перебора и key_o по-прежнему
+     задаются в единицах key_reg; полный ключ собирает программа.
+
+ 14. Известные биты ключа задаются маской key_mask_i и значением
+     key_value_i (в единицах key_reg: единицы маски - известные биты).
+     Счётчик key_reg тогда перебирает только свободные биты: ядра
+     получают ключ mkey_reg, в котором на месте свободных бит по порядку
+     стоят биты key_reg, а на месте известных - биты key_value_i.
+     mkey_reg растёт вместе с key_reg маскированным инкрементом
+     ( ( mkey | маска ) + 1 ) & ~маска | значение - тот же сумматор, что
+     и у key_reg, поэтому на частоту это не влияет. Стартовый и конечный
+     ключи, счётчик перебора и key_o задаются в единицах key_reg, то есть
+     номером в уменьшенном пространстве (end_key_i = 0 - до
+     2^(свободных бит)); перевод в ключ ядер нужен только
+     для кандидата на входе Verify64 (keyDeposit). При нулевой маске
+     mkey_reg = key_reg.
+
 ******************************************************************************/
 
 module dst40_XX
 #(
   parameter           NK   = 2,                                 // Количество хэширующих ядер в составе модуля
-  parameter           L2NK = 1                                  // Логарифм по основанию 2 от количества ядер
+  parameter           L2NK = 1,                                 // Логарифм по основанию 2 от количества ядер
+  parameter           NR   = 2,                                 // Размер таблицы ожидаемых ответов
+  parameter           L2NR = 1,                                 // Логарифм по основанию 2 от размера таблицы ответов
+  parameter           UNROLL = 64,                              // Количество модулей Block64 в ядре (делитель 64)
+  parameter           RPS  = 3,                                 // Раундов на ступень конвеера (1, 2, 3 или 6)
+  parameter           INTERLEAVE = 0,                           // 1 - номер ядра в младших битах ключа (ядро i: key_reg * NK + i)
+  parameter           DEPTH = 192 / RPS,                        // Тактов на хэш одного ключа
+  parameter           RING = UNROLL * 3 / RPS                   // Ступеней в ядре
 )
 (
   input               clock_i,                                  // Такты
   input        [39:0] challenge_i,                              // Запрос
-  input        [23:0] response_i,                               // Ответ
+  input        [39:0] challenge2_i,                             // Второй запрос
+  input   [NR*48-1:0] responses_i,                              // Таблица ответов: строка j - биты 48*j+47..48*j = { ответ 2, ответ 1 }
+  input      [L2NR:0] count_i,                                  // Количество используемых строк таблицы ответов
   input        [39:0] start_key_i,                              // Стартовый ключ
+  input        [39:0] end_key_i,                                // Конечный ключ, не включая его (0 - до конца)
+  input        [39:0] key_mask_i,                               // Маска известных бит ключа (в единицах key_reg)
+  input        [39:0] key_value_i,                              // Значения известных бит ключа
   input               run_i,                                    // Разрешение поиска ключа
-  output              key_found_o,                              // Флаг "ключ найден"
-  output              key_not_found_o,                          // Флаг "работа закончена - ключ не найден"
-  output     [NK-1:0] kernels_o,                                // Биты компараторов: 1 укажет на ядро, нашедшее ключ (или несколько 1 укажет на несколько ядер)
-  output  [39-L2NK:0] key_o                                     // Результат поиска: младшие биты найденного ключа
+  input               hold_i,                                   // Некуда положить найденный ключ (FIFO заполнено)
+  output              key_found_o,                              // Строб "найден ключ" (подошёл к обеим парам, валиден один такт)
+  output              key_not_found_o,                          // Флаг "работа закончена - все ключи перебраны и проверены"
+  output     [NK-1:0] kernels_o,                                // Бит ядра, нашедшего ключ
+  output  [39-L2NK:0] key_o,                                    // Результат поиска: младшие биты найденного ключа
+  output   [L2NR-1:0] index_o,                                  // Номер строки таблицы ответов, к которой подошёл ключ
+  output              overflow_o,                               // Флаг "конвеер приостанавливался из-за занятого регистра кандидата"
+  output  [40-L2NK:0] position_o,                               // Счётчик перебора key_reg в коде Грея
+  output       [47:0] cycles_o,                                 // Счётчик тактов от запуска в коде Грея
+  output       [47:0] busy_o,                                   // Такты работы ядер
+  output       [47:0] stall_o,                                  // Такты простоя из-за занятого регистра кандидата
+  output       [47:0] hold_o,                                   // Такты ожидания места в FIFO
+  output       [47:0] refill_o,                                 // Такты заполнения конвеера
+  output  [NK*32-1:0] hits_o,                                   // Кандидаты по первой паре: ядро n - биты 32*n+31..32*n
+  output       [31:0] restarts_o                                // Количество запусков
 );
 
 
 
+//==============================================================//
+// Функции
+//==============================================================//
+
+//--------------------------------------------------------------//
+// Для каждого бита ключа - номер бита key_reg, который в нём   //
+// стоит (для известных бит не используется)                    //
+
+function [6*(40-L2NK)-1:0] keyRanks;
+  input  [39-L2NK:0] mask;
+  integer            j, c;
+  begin
+    c = 0;
+    for( j=0; j < 40-L2NK; j=j+1 )
+    begin
+      keyRanks[6*j +: 6] = c[5:0];
+      if( !mask[j] )
+        c = c + 1;
+    end
+  end
+endfunction
+
+//--------------------------------------------------------------//
+// Ключ из номера в уменьшенном пространстве: биты index        //
+// по порядку на свободных местах, value - на известных         //
+
+function [39-L2NK:0] keyDeposit;
+  input  [39-L2NK:0] index;
+  input  [39-L2NK:0] mask;
+  input  [39-L2NK:0] value;
+  input [6*(40-L2NK)-1:0] ranks;
+  integer            j;
+  begin
+    for( j=0; j < 40-L2NK; j=j+1 )
+      keyDeposit[j] = mask[j] ? value[j] : index[ranks[6*j +: 6]];
+  end
+endfunction
+
+
+
 //==============================================================//
 // Внутренние провода/регистры
 //==============================================================//
 
+localparam              L2NKW = L2NK ? L2NK : 1;              // Разрядность номера ядра (у одного ядра - 1 бит)
+localparam  [40-L2NK:0] RING_KEY = { {9-L2NK{1'b 0}}, RING[31:0] };  // RING в разрядности key_reg
+
 // Текущие рабочие регистры
 
 reg   [40-L2NK:0] key_reg         = 0;                          // Перебираемые ключи
+reg   [40-L2NK:0] end_reg         = 0;                          // Значение key_reg, на котором перебор закончен (конечный ключ + RING)
+reg   [39-L2NK:0] mkey_reg        = 0;                          // Ключ ядер: key_reg, разложенный по свободным битам маски
+reg   [39-L2NK:0] mask_reg        = 0;                          // Маска известных бит
+reg   [39-L2NK:0] value_reg       = 0;                          // Значения известных бит
+reg [6*(40-L2NK)-1:0] ranks_reg   = 0;                          // Номера бит key_reg для свободных бит ключа (по 6 бит)
+reg         [5:0] free_reg        = 0;                          // Количество свободных бит
 reg        [39:0] challenge_reg   = 0;                          // Текущий запрос
-reg        [23:0] response_reg    = 0;                          // Текущий ответ
+reg        [39:0] challenge2_reg  = 0;                          // Текущий второй запрос
+reg   [NR*24-1:0] responses_reg   = 0;                          // Текущие ответы на первый запрос
+reg   [NR*24-1:0] responses2_reg  = 0;                          // Текущие ответы на второй запрос
+reg      [NR-1:0] enables_reg     = 0;                          // Разрешения строк таблицы ответов
 reg         [1:0] run_reg         = 0;                          // Регистр для синхронизации сигнала RUN с нашими тактами
 
-reg         [6:0] tick_reg = 0;                                 // Номер текущего такта
+reg         [7:0] tick_reg = 0;                                 // Номер текущего такта
+reg         [7:0] phase_reg       = 0;                          // Фаза свёрнутых ядер (такты работы по модулю DEPTH)
+reg               overflow_reg    = 0;                          // Флаг "конвеер приостанавливался из-за занятого регистра кандидата"
+reg   [40-L2NK:0] position_reg    = 0;                          // Счётчик перебора в коде Грея
+reg        [47:0] cycles_reg      = 0;                          // Счётчик тактов от запуска
+reg        [47:0] cycles_gray_reg = 0;                          // Он же в коде Грея
+
+// Счётчики производительности
+
+reg        [47:0] busy_reg        = 0;                          // Такты работы ядер
+reg        [47:0] stall_reg       = 0;                          // Такты простоя из-за занятого регистра кандидата
+reg        [47:0] hold_reg        = 0;                          // Такты ожидания места в FIFO
+reg        [47:0] refill_reg      = 0;                          // Такты заполнения конвеера
+reg   [NK*32-1:0] hits_reg        = 0;                          // Кандидаты по первой паре по ядрам
+reg        [31:0] restarts_reg    = 0;                          // Количество запусков
+
+// Регистр кандидата (совпадение по первой паре)
+
+reg      [NK-1:0] cand_kernels_reg = 0;                         // Ядра, нашедшие кандидата и ещё не проверенные (0 - регистр свободен)
+reg   [39-L2NK:0] cand_key_reg     = 0;                         // Младшие биты кандидата
+reg   [NK*NR-1:0] cand_matches_reg = 0;                         // Строки таблицы, совпавшие по первой паре (NR бит на ядро)
+
+// Проверка на второй паре
+
+reg               ver_active_reg   = 0;                         // Verify64 проверяет ключ или держит результат
+reg      [NK-1:0] ver_kernel_reg   = 0;                         // Бит ядра проверяемого ключа
+reg   [39-L2NK:0] ver_key_reg      = 0;                         // Младшие биты проверяемого ключа
+reg      [NR-1:0] ver_matches_reg  = 0;                         // Строки таблицы, совпавшие у проверяемого ключа по первой паре
+
+reg    [L2NKW-1:0] cand_index_w;                                // Номер младшего ядра из cand_kernels_reg
+reg      [NR-1:0] cand_row_w;                                   // Его строки из cand_matches_reg
+reg    [L2NR-1:0] ver_index_w;                                  // Номер младшей строки, совпавшей по обеим парам
+integer           n, m, r, k;
 
 // Результаты хэширования
 
-wire     [NK-1:0] comparators_w;                                // Результаты работы ядер (валидны только начиная с такта 64)
+wire  [NK*NR-1:0] matches_w;                                    // Результаты работы ядер по строкам таблицы (валидны только начиная с такта DEPTH)
+wire     [NK-1:0] comparators_w;                                // Ядра, у которых совпала хотя бы одна строка
+wire     [NR-1:0] matches2_w;                                   // Строки, второй ответ которых совпал с результатом Verify64
+wire       [23:0] ver_response_w;                               // Ответ Verify64 для проверяемого ключа
+
+wire [40*RING-1:0] keys_w;                                      // Общее расписание ключей по ступеням ядер
+
+wire  [39-L2NK:0] cand_mkey_w = keyDeposit( cand_key_reg, mask_reg, value_reg, ranks_reg );  // Ключ ядер кандидата
+wire       [39:0] cand_full_w;                                  // Полный ключ кандидата
 
 
 
@@ -52,24 +256,182 @@ wire     [NK-1:0] comparators_w;                                // Резуль
 // Комбинаторная схемотехника
 //==============================================================//
 
-wire    key_found_w     = ( tick_reg[6] && comparators_w != 0 );// Флаг "ключ найден": 1 если ключ найден
+wire    keys_done_w     = ( key_reg >= end_reg );               // Флаг "все ключи перебраны" (и ещё RING ключей - из конвеера)
 
-wire    key_not_found_w = key_reg[40-L2NK] & key_reg[6];        // Флаг "работа закончена - ключ не найден"
+wire    tick_done_w     = ( tick_reg == DEPTH[7:0] );           // Конвеер заполнен
 
-wire    run_w = run_reg[1] & ~key_found_o & ~key_not_found_o;   // Разрешение работы ядер
+wire    load_w          = ( phase_reg < RING[7:0] );            // Ядра принимают новые ключи (при полной развёртке - всегда)
 
-assign  key_found_o     = key_found_w;                          // Вывод флага "ключ найден" в порт key_found_o
-assign  key_not_found_o = key_not_found_w;                      // Флаг "ключ не найден": 1 если все ключи перебраны и ключ не найден
-assign  key_o           = key_reg[39-L2NK:0] - 40'd 64;         // Вывод в порт key_o младших бит найденного ключа
-assign  kernels_o       = comparators_w;                        // Биты ядер, нашедших ключ
+wire    match_w         = run_reg[1] && tick_done_w &&          // Совпадение по первой паре: выход конвеера валиден
+                          load_w &&                             // (у свёрнутых ядер - только в тактах приёма)
+                          !keys_done_w &&                       // и относится к ключу из диапазона перебора
+                          comparators_w != 0;
+
+wire    stall_w = match_w && cand_kernels_reg != 0;             // Кандидата некуда положить - ждём
+
+wire    run_w = run_reg[1] & ~stall_w & ~keys_done_w;           // Разрешение работы ядер
+
+wire    ver_busy_w;                                             // Verify64 занят расчётом
+wire    ver_start_w     = run_reg[1] && !ver_active_reg &&      // Запуск проверки очередного кандидата
+                          !ver_busy_w && cand_kernels_reg != 0;
+wire    ver_done_w;                                             // Verify64 закончил расчёт
+wire    ver_match_w     = ( ver_matches_reg &                   // Ключ подошёл к обеим парам хотя бы одной строки
+                            matches2_w ) != 0;
+
+wire    key_found_w     = ver_active_reg &&                     // Ключ подошёл к обеим парам
+                          ver_done_w && ver_match_w;
+
+wire    key_not_found_w = run_reg[1] && keys_done_w &&          // Все ключи перебраны и все кандидаты проверены
+                          cand_kernels_reg == 0 && !ver_active_reg;
+
+assign  key_found_o     = key_found_w;                          // Вывод строба "найден ключ" в порт key_found_o
+assign  key_not_found_o = key_not_found_w;                      // Флаг "ключ не найден": 1 если все ключи перебраны и проверены
+assign  key_o           = ver_key_reg;                          // Вывод в порт key_o младших бит найденного ключа
+assign  kernels_o       = ver_kernel_reg;                       // Бит ядра, нашедшего ключ
+assign  index_o         = ver_index_w;                          // Номер строки таблицы ответов
+assign  overflow_o      = overflow_reg;
+assign  position_o      = position_reg;
+assign  cycles_o        = cycles_gray_reg;
+assign  busy_o          = busy_reg;
+assign  stall_o         = stall_reg;
+assign  hold_o          = hold_reg;
+assign  refill_o        = refill_reg;
+assign  hits_o          = hits_reg;
+assign  restarts_o      = restarts_reg;
+
+generate
+
+  if( L2NK )                                                    // Старшие L2NK бит ключей на входах - номер ядра,
+  begin: _unused_                                               // перебору они не нужны
+    wire unused_w = &{ 1'b 0, start_key_i[39:40-L2NK], end_key_i[39:40-L2NK],
+                              key_mask_i [39:40-L2NK], key_value_i[39:40-L2NK] };
+  end
+
+endgenerate
 
 
 
 //--------------------------------------------------------------//
-// Блок из XX ядер                                              //
+// Номер младшего ядра, нашедшего кандидата                     //
+
+always @(*)
+begin
+  cand_index_w = 0;
+  cand_row_w   = 0;
+
+  for( n=NK-1; n >= 0; n=n-1 )
+    if( cand_kernels_reg[n] )
+    begin
+      cand_index_w = n[L2NKW-1:0];
+      cand_row_w   = cand_matches_reg[NR*n +: NR];
+    end
+end
+
+
+
+//--------------------------------------------------------------//
+// Номер младшей строки таблицы, подошедшей по обеим парам      //
+
+always @(*)
+begin
+  ver_index_w = 0;
+
+  for( m=NR-1; m >= 0; m=m-1 )
+    if( ver_matches_reg[m] && matches2_w[m] )
+      ver_index_w = m[L2NR-1:0];
+end
+
+
+
+//--------------------------------------------------------------//
+// Проверка кандидатов на второй паре запрос/ответ              //
+
+generate
+
+  if( !L2NK )
+  begin: _single_                                               // Одно ядро: номера в ключе нет
+    assign cand_full_w = cand_mkey_w;
+  end
+  else
+  begin: _kernels_                                              // Номер ядра - младшие или старшие биты
+    assign cand_full_w = INTERLEAVE ? { cand_mkey_w, cand_index_w } : { cand_index_w, cand_mkey_w };
+  end
+
+endgenerate
+
+Verify64
+#(
+  .RPS            ( RPS )
+)
+VERIFY64_INST
+(
+  .clock_i        ( clock_i                                         ),  // Такты
+  .start_i        ( ver_start_w                                     ),  // Запуск проверки
+  .key_i          ( cand_full_w                                     ),  // Полный ключ кандидата
+  .challenge_i    ( challenge2_reg                                  ),  // Второй запрос
+  .busy_o         ( ver_busy_w                                      ),
+  .done_o         ( ver_done_w                                      ),
+  .response_o     ( ver_response_w                                  )
+);
 
 genvar i;
 
+generate
+
+  for( i=0; i < NR; i=i+1 )
+  begin: _match2_
+    assign matches2_w[i] = ver_done_w && ( responses2_reg[24*i +: 24] == ver_response_w );
+  end
+
+endgenerate
+
+
+
+//--------------------------------------------------------------//
+// Общее расписание ключей для полностью развёрнутых ядер       //
+
+generate
+
+  if( UNROLL == 64 )
+  begin: _keysched_
+
+    wire [39:0] sched_key_w;                                    // Ключ ядер с нулями на месте номера ядра
+
+    if( !L2NK )
+    begin: _single_
+      assign sched_key_w = mkey_reg;
+    end
+    else
+    begin: _kernels_
+      assign sched_key_w = INTERLEAVE ? { mkey_reg, {L2NK{1'b0}} } : { {L2NK{1'b0}}, mkey_reg };
+    end
+
+    KeySched40
+    #(
+      .RPS            ( RPS  ),
+      .RING           ( RING )
+    )
+    KEYSCHED40_INST
+    (
+      .clock_i        ( clock_i                                  ),  // Такты
+      .run_i          ( run_w                                    ),  // Разрешение работы (как у ядер)
+      .key_i          ( sched_key_w                              ),  // Ключ без номера ядра
+      .keys_o         ( keys_w                                   )
+    );
+
+  end
+  else
+  begin: _no_keysched_
+    assign keys_w = 0;                                          // Свёрнутые ядра ведут ключи сами
+  end
+
+endgenerate
+
+
+
+//--------------------------------------------------------------//
+// Блок из XX ядер                                              //
+
 generate
 
   for( i=0; i < NK; i=i+1 )
@@ -77,20 +439,28 @@ generate
 
     KernelXX
     #(
-      .NK             ( NK   ),                                 // Количество ядер
       .L2NK           ( L2NK ),                                 // Логарифм по основанию 2 от количества ядер
-      .ADDRESS        ( i    )                                  // Номер ядра - фактически старшие биты ключа
+      .ADDRESS        ( i    ),                                 // Номер ядра - старшие биты ключа (младшие при INTERLEAVE = 1)
+      .NR             ( NR   ),                                 // Размер таблицы ответов
+      .UNROLL         ( UNROLL ),                               // Количество модулей Block64
+      .RPS            ( RPS  ),                                 // Раундов на ступень конвеера
+      .INTERLEAVE     ( INTERLEAVE )                            // Номер ядра в младших битах ключа
     )
     KERNEL32_INST
     (
       .clock_i        ( clock_i            ),                   // Такты для конвеера
       .run_i          ( run_w              ),                   // Разрешение работы ядер
-      .key_i          ( key_reg[39-L2NK:0] ),                   // Ключ
+      .load_i         ( load_w             ),                   // Приём нового ключа
+      .key_i          ( mkey_reg           ),                   // Ключ
+      .keys_i         ( keys_w             ),                   // Общее расписание ключей
       .challenge_i    ( challenge_reg      ),                   // Запрос
-      .response_i     ( response_reg       ),                   // Ожидаемый ответ
-      .comparator_o   ( comparators_w[i]   )                    // Выход компаратора (1 - результат совпал с ожидаемым ответом)
+      .responses_i    ( responses_reg      ),                   // Таблица ожидаемых ответов
+      .enables_i      ( enables_reg        ),                   // Разрешения строк таблицы
+      .match_o        ( matches_w[NR*i +: NR] )                 // Выходы компараторов по строкам таблицы
     );
 
+    assign comparators_w[i] = ( matches_w[NR*i +: NR] != 0 );
+
   end
 
 endgenerate
@@ -109,15 +479,76 @@ begin
 
   run_reg <= { run_reg[0], run_i };                             // Синхронизируем входной сигнал run_i с нашими тактами
 
+  position_reg <= key_reg ^ ( key_reg >> 1 );                   // Счётчик перебора в код Грея
+  cycles_gray_reg <= cycles_reg ^ ( cycles_reg >> 1 );          // Счётчик тактов в код Грея
+
   // Перебор ключей
 
   if( run_reg[1] )                                              // Выполняем поиск ключа пока разрешено.
   begin
-    if( !tick_reg[6] )                                          // Инкрементируем номер такта, пока он не достигнет числа 64:
+    if( !tick_done_w )                                          // Инкрементируем номер такта, пока он не достигнет DEPTH:
       tick_reg <= tick_reg + 1;                                 // начиная с этого момента выходные данные считаются валидными.
 
-    if( !key_not_found_w && !key_found_w )                      // Выполняем работу по поиску только если перебраны не все ключи
-      key_reg <= key_reg + 40'd 1;                              // и не найден подходящий ключ.
+    if( run_w )                                                 // Выполняем работу по поиску, пока перебраны не все ключи
+    begin                                                       // и конвеер не приостановлен.
+      phase_reg <= ( phase_reg == DEPTH[7:0] - 8'd 1 ) ? 8'd 0 : phase_reg + 8'd 1;
+
+      if( load_w )
+      begin
+        key_reg  <= key_reg + 1;
+        mkey_reg <= ( ( mkey_reg | mask_reg ) + 1 ) & ~mask_reg | value_reg;
+      end
+    end
+
+    if( stall_w )
+      overflow_reg <= 1;
+
+    if( !key_not_found_w )                                      // Такты считаем до окончания перебора
+      cycles_reg <= cycles_reg + 48'd 1;
+
+    // Счётчики производительности
+
+    if( run_w )
+      busy_reg <= busy_reg + 48'd 1;
+
+    if( stall_w )
+      stall_reg <= stall_reg + 48'd 1;
+
+    if( ver_active_reg && ver_done_w && ver_match_w && hold_i )
+      hold_reg <= hold_reg + 48'd 1;
+
+    if( !tick_done_w )
+      refill_reg <= refill_reg + 48'd 1;
+
+    if( match_w && !stall_w )
+      for( k=0; k < NK; k=k+1 )
+        if( comparators_w[k] )
+          hits_reg[32*k +: 32] <= hits_reg[32*k +: 32] + 32'd 1;
+
+    // Регистр кандидата: запись нового кандидата или передача
+    // очередного ядра на проверку (одновременно не бывает -
+    // при занятом регистре конвеер стоит)
+
+    if( match_w && !stall_w )
+    begin
+      cand_kernels_reg <= comparators_w;
+      cand_matches_reg <= matches_w;
+      cand_key_reg     <= key_reg[39-L2NK:0] - RING_KEY[39-L2NK:0];
+    end
+    else if( ver_start_w )
+      cand_kernels_reg[cand_index_w] <= 0;
+
+    // Проверка на второй паре
+
+    if( ver_start_w )
+    begin
+      ver_active_reg <= 1;
+      ver_kernel_reg <= cand_kernels_reg & -cand_kernels_reg;   // Младший единичный бит - ядро cand_index_w
+      ver_key_reg    <= cand_key_reg;
+      ver_matches_reg <= cand_row_w;
+    end
+    else if( ver_active_reg && ver_done_w && ( !ver_match_w || !hold_i ) )
+      ver_active_reg <= 0;                                      // Результат отрицательный или забран в FIFO
   end
 
   // Ожидание старта                                            // В режиме ожидания готовим схему к старту поиска
@@ -125,9 +556,38 @@ begin
   else
   begin
     tick_reg      <= 0;                                         // Обнуляем номер такта (очищаем очередь конвеера)
+    phase_reg     <= 0;
+    cycles_reg    <= 0;
+
+    if( run_reg[0] )                                            // Последний такт ожидания перед запуском:
+    begin                                                       // обнуляем счётчики производительности
+      busy_reg     <= 0;
+      stall_reg    <= 0;
+      hold_reg     <= 0;
+      refill_reg   <= 0;
+      hits_reg     <= 0;
+      restarts_reg <= restarts_reg + 32'd 1;
+    end
+
+    overflow_reg  <= 0;
     challenge_reg <= challenge_i;
-    response_reg  <= response_i;
+    challenge2_reg   <= challenge2_i;
+    for( r=0; r < NR; r=r+1 )
+    begin
+      responses_reg [24*r +: 24] <= responses_i[48*r +: 24];
+      responses2_reg[24*r +: 24] <= responses_i[48*r+24 +: 24];
+      enables_reg[r]             <= ( r[L2NR:0] < count_i );
+    end
+    cand_kernels_reg <= 0;
+    ver_active_reg   <= 0;
     key_reg       <= { 1'b 0, start_key_i[39-L2NK:0] };
+    end_reg       <= ( end_key_i[39-L2NK:0] ? { 1'b 0, end_key_i[39-L2NK:0] } : { {40-L2NK{1'b 0}}, 1'b 1 } << free_reg ) + RING_KEY;
+
+    mask_reg      <= key_mask_i[39-L2NK:0];                     // Маска разбирается за два такта: номера бит
+    value_reg     <= key_value_i[39-L2NK:0] & key_mask_i[39-L2NK:0];  // и количество свободных бит - по уже
+    ranks_reg     <= keyRanks( key_mask_i[39-L2NK:0] );         // защёлкнутой маске (входы стоят дольше)
+    free_reg      <= ranks_reg[6*(39-L2NK) +: 6] + { 5'b 0, !mask_reg[39-L2NK] };
+    mkey_reg      <= keyDeposit( start_key_i[39-L2NK:0], mask_reg, value_reg, ranks_reg );
   end
 end
 
@@ -0,0 +1,180 @@
+#******************************************************************************
+#
+#  Перебор вариантов образа DST40: количество ядер NK и количество модулей
+#  Block64 в ядре UNROLL (64 - полная развёртка, меньше - свёрнутое ядро),
+#  а также количество раундов на ступень конвеера RPS (по умолчанию 3).
+#
+#  Запуск из папки проекта (там, где dst40.qpf):
+#
+#    quartus_sh -t source/sweep.tcl [NK:UNROLL[:RPS] ...]
+#
+#  Для каждого варианта проект собирается полностью. Параметры задаются
+#  через set_parameter и после перебора удаляются - dst40.qsf остаётся
+#  прежним. Из отчётов берутся занятые ALM и Fmax тактов ядер (PLL),
+#  и считается скорость перебора:
+#
+#    ключей/с = NK * UNROLL / 64 * частота
+#
+#  (от RPS не зависит: меньший RPS даёт только более высокую Fmax)
+#
+#  на частоте PLL (если тайминг на ней выполнен) и на Fmax - вторая
+#  показывает, сколько можно получить, подняв частоту PLL. Результаты
+#  выводятся таблицей и пишутся в output_files/sweep.csv, собранные
+#  образы сохраняются как output_files/sweep/dst40_<NK>x<UNROLL>r<RPS>.sof.
+#
+#  Сборка одного варианта занимает десятки минут - список лучше
+#  задавать явно.
+#
+#******************************************************************************
+
+package require ::quartus::project
+package require ::quartus::flow
+
+set clock_mhz 150                                               ;# Частота PLL (CLOCK_MHZ в dst40.v)
+set configs   { 4:64 4:64:2 4:64:1 8:32 8:16 16:16 16:8 }       ;# Варианты по умолчанию
+
+
+
+#------------------------------------------------------------------------------
+# Занятые ALM из output_files/dst40.fit.summary (-1 - нет отчёта)
+
+proc readAlms {} {
+  if { [catch { open output_files/dst40.fit.summary r } f] } {
+    return -1
+  }
+
+  set text [read $f]
+  close $f
+
+  if { [regexp {Logic utilization \(in ALMs\)\s*:\s*([0-9,]+)\s*/\s*([0-9,]+)} $text -> used total] } {
+    return [list [string map {, ""} $used] [string map {, ""} $total]]
+  }
+
+  return -1
+}
+
+
+
+#------------------------------------------------------------------------------
+# Наименьшая по всем моделям Restricted Fmax тактов PLL
+# из output_files/dst40.sta.rpt, МГц (0 - нет отчёта)
+
+proc readFmax {} {
+  if { [catch { open output_files/dst40.sta.rpt r } f] } {
+    return 0
+  }
+
+  set fmax 0
+
+  while { [gets $f line] >= 0 } {
+    if { [regexp {^;\s*([0-9.]+) MHz\s*;\s*([0-9.]+) MHz\s*;\s*([^;]*PLL_INST[^;]*);} $line -> raw restricted clock] } {
+      if { $fmax == 0 || $restricted < $fmax } {
+        set fmax $restricted
+      }
+    }
+  }
+
+  close $f
+  return $fmax
+}
+
+
+
+#------------------------------------------------------------------------------
+# Перебор вариантов
+
+if { [llength $argv] } {
+  set configs $argv
+}
+
+file mkdir output_files/sweep
+
+project_open dst40 -revision dst40
+
+set results {}
+
+foreach config $configs {
+  set rps 3
+
+  if { ![regexp {^([0-9]+):([0-9]+)(?::([0-9]+))?$} $config -> nk unroll rps_arg] || $unroll < 1 || $unroll > 64 || 64 % $unroll } {
+    puts "Skipping \"$config\": expected NK:UNROLL\[:RPS\], UNROLL must divide 64"
+    continue
+  }
+
+  if { $rps_arg ne "" } {
+    set rps $rps_arg
+  }
+
+  if { [lsearch { 1 2 3 6 } $rps] < 0 || $unroll * 3 % $rps } {
+    puts "Skipping \"$config\": RPS must be 1, 2, 3 or 6 and divide UNROLL * 3"
+    continue
+  }
+
+  puts "\n=== NK = $nk, UNROLL = $unroll, RPS = $rps ===\n"
+
+  set_parameter -name NK     $nk
+  set_parameter -name UNROLL $unroll
+  set_parameter -name RPS    $rps
+
+  file delete output_files/dst40.fit.summary output_files/dst40.sta.rpt
+
+  if { [catch { execute_flow -compile } error] } {
+    puts "Compilation failed: $error"
+    lappend results [list $nk $unroll $rps -1 -1 0]
+    continue
+  }
+
+  set alms [readAlms]
+  set fmax [readFmax]
+
+  file copy -force output_files/dst40.sof output_files/sweep/dst40_${nk}x${unroll}r${rps}.sof
+
+  lappend results [list $nk $unroll $rps [lindex $alms 0] [lindex $alms end] $fmax]
+}
+
+set_parameter -name NK     -remove
+set_parameter -name UNROLL -remove
+set_parameter -name RPS    -remove
+export_assignments
+project_close
+
+
+
+#------------------------------------------------------------------------------
+# Сводная таблица
+
+set csv [open output_files/sweep.csv w]
+puts $csv "nk,unroll,rps,alms,alms_total,fmax_mhz,keys_per_s_pll,keys_per_s_fmax"
+
+puts "\n  NK UNROLL RPS     ALMs  Fmax, MHz  Mkeys/s @ $clock_mhz MHz  Mkeys/s @ Fmax"
+
+set best ""
+set best_rate 0
+
+foreach r $results {
+  lassign $r nk unroll rps alms total fmax
+
+  set per_cycle [expr { $nk * $unroll / 64.0 }]               ;# Ключей за такт всеми ядрами
+  set rate_fmax [expr { $per_cycle * $fmax * 1e6 }]
+  set rate_pll  [expr { $fmax >= $clock_mhz ? $per_cycle * $clock_mhz * 1e6 : 0 }]
+
+  if { $alms < 0 } {
+    puts [format "%4d %6d %3d  %s" $nk $unroll $rps "does not fit / failed"]
+  } else {
+    puts [format "%4d %6d %3d %8d %10.1f %19s %15.1f" $nk $unroll $rps $alms $fmax \
+          [expr { $rate_pll ? [format "%.1f" [expr { $rate_pll / 1e6 }]] : "timing failed" }] [expr { $rate_fmax / 1e6 }]]
+
+    if { $rate_pll > $best_rate } {
+      set best_rate $rate_pll
+      set best "NK = $nk, UNROLL = $unroll, RPS = $rps"
+    }
+  }
+
+  puts $csv "$nk,$unroll,$rps,$alms,$total,$fmax,[expr { round( $rate_pll ) }],[expr { round( $rate_fmax ) }]"
+}
+
+close $csv
+
+if { $best ne "" } {
+  puts [format "\nBest at %d MHz: %s (%.1f Mkeys/s)" $clock_mhz $best [expr { $best_rate / 1e6 }]]
+}